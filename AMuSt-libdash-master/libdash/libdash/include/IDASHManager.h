@@ -35,6 +35,15 @@ namespace dash
              */
             virtual mpd::IMPD* Open (char *path) = 0;
 
+            /**
+             *  Returns a pointer to dash::mpd::IMPD object representing the the information found in the MPD document held in memory
+             *  @param      buffer  The (uncompressed) MPD document
+             *  @param      size    The size of \em buffer in bytes
+             *  @param      url     The URI the MPD was retrieved from, used to resolve relative URLs
+             *  @return     a pointer to an dash::mpd::IMPD object
+             */
+            virtual mpd::IMPD* OpenBuffer (const char *buffer, int size, const char *url) = 0;
+
             /**
              *  Frees allocated memory and deletes the DashManager
              */
@@ -100,6 +100,15 @@ namespace dash
                  */
                 virtual ISegment*           GetMediaSegmentFromNumber   (const std::vector<IBaseUrl *>& baseurls, const std::string& representationID, uint32_t bandwidth, uint32_t number) const = 0;
 
+                /**
+                 *  Returns the Media template with its identifiers replaced, i.e. the (relative) URI of a Media Segment, without resolving it against any Base URL.
+                 *  @param      representationID    a string containing the representation ID that will replace the identifier \em \$RepresentationID\$ in the Media template.
+                 *  @param      bandwidth           an integer specifying the bandwidth that will replace the identifier \em \$Bandwidth\$ in the Media template.
+                 *  @param      number              an integer specifying the desired Segment number that will replace the identifier \em \$Number\$ in the Media template.
+                 *  @return     a string containing the URI of the Media Segment
+                 */
+                virtual std::string         GetMediaURIFromNumber       (const std::string& representationID, uint32_t bandwidth, uint32_t number) const = 0;
+
                 /**
                  *  Returns a pointer to a dash::mpd::ISegment object that represents a Index Segment and can be downloaded.
                  *  @param      baseurls            a vector of pointers to dash::mpd::IBaseUrl objects that represent the path to the Index Segment (template).
@@ -32,6 +32,7 @@
 #include <iostream>
 #include <string>
 #include <map>
+#include <vector>
 #include <memory>
 #include <stdlib.h>
 
@@ -42,6 +43,15 @@
 using namespace dash::mpd;
 
 
+namespace dash
+{
+namespace mpd
+{
+class SegmentURL;
+}
+}
+
+
 namespace dash
 {
 namespace player
@@ -71,22 +81,53 @@ public:
 
   virtual void SetAvailableRepresentations(std::map<std::string, IRepresentation*>* availableRepresentations);
 
+  // the URL of the next segment to download, NULL if there is none for now; the returned
+  // object belongs to the adaptation logic and, for a SegmentTemplate, is only valid until
+  // the next call of GetNextSegment, callers must not keep it
   virtual ISegmentURL*
   GetNextSegment(unsigned int* requested_segment_number, const dash::mpd::IRepresentation** usedRepresentation, bool* hasDownloadedAllSegments);
   unsigned int getTotalSegments();
 
+  // for representations with a SegmentTemplate, the number of segments follows from the
+  // duration of the presentation, which is not known to the adaptation logic
+  void SetTotalSegments(unsigned int totalSegments);
+
   virtual bool hasMinBufferLevel(const dash::mpd::IRepresentation* rep);
 
+  // the representation with the lowest bandwidth
   IRepresentation*
   GetLowestRepresentation();
 
+  // the representation with the highest bandwidth below bitrate, NULL if there is none
+  IRepresentation*
+  GetHighestRepresentationBelow(double bitrate);
+
+  // the representation with the lowest bandwidth above bitrate, NULL if there is none
+  IRepresentation*
+  GetNextHigherRepresentation(double bitrate);
+
 protected:
+  // the URL of segment segmentNumber of rep; for a SegmentTemplate the URL is computed on
+  // demand into one object shared by all calls, so the returned object is only valid until
+  // the next call of GetSegmentURL (and thus of GetNextSegment)
+  ISegmentURL*
+  GetSegmentURL(const IRepresentation* rep, unsigned int segmentNumber);
+
   MultimediaPlayer* m_multimediaPlayer;
   RepresentationsMap* m_availableRepresentations;
 
+  // the available representations sorted by bandwidth (ascending), representations with the
+  // same bandwidth keep the order of their ids; built once by SetAvailableRepresentations
+  std::vector<IRepresentation*> m_bitrateLadder;
+
+  unsigned int m_totalSegments;
+  dash::mpd::SegmentURL* m_templateSegmentURL;
+
   static AdaptationLogic _staticLogic;
 
   AdaptationLogic()
+    : m_totalSegments(0),
+      m_templateSegmentURL(NULL)
   {
     ENSURE_ADAPTATION_LOGIC_REGISTERED(AdaptationLogic);
   }
@@ -100,7 +100,27 @@ protected:
 
   MBuffer buff;
 
+  // running buffer levels, kept up to date by addToBuffer and consumeFromBuffer
+  struct BufferLevel
+  {
+    double seconds;
+    unsigned int segments;
+
+    BufferLevel()
+    {
+      seconds = 0.0;
+      segments = 0;
+    }
+  };
+
+  double bufferedSeconds; // sum of the first (by repId) entry of each buffered segment
+  std::map<std::string /*Representation*/, BufferLevel> bufferedSecondsByRep;
+
+  void addBufferLevel(const std::string& repId, double duration);
+  void removeBufferLevel(const std::string& repId, double duration);
+
   BufferRepresentationEntry getHighestConsumableRepresentation(int segmentNumber);
+  BufferRepresentationEntry getHighestConsumableRepresentation(const BufferRepresentationEntryMap& map);
 
 };
 }
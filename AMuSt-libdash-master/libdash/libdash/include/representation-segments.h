@@ -0,0 +1,56 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DASH_REPRESENTATION_SEGMENTS
+#define DASH_REPRESENTATION_SEGMENTS
+
+#include <string>
+
+#include "libdash.h"
+
+
+namespace dash
+{
+namespace player
+{
+
+/*
+ * Addressing of the media segments of a representation, whether the MPD lists every
+ * segment (SegmentList) or describes all of them with a SegmentTemplate, e.g.
+ * media="repr_$RepresentationID$_seg_$Number$.264". Segment numbers start at 0 for both.
+ */
+
+// duration of one segment of rep in seconds, 0 if rep has neither a SegmentList nor a SegmentTemplate
+double
+GetSegmentDuration(const dash::mpd::IRepresentation* rep);
+
+// number of segments in the SegmentList of rep, 0 if rep uses a SegmentTemplate
+// (the number of segments then follows from the duration of the presentation)
+unsigned int
+GetNumberOfListedSegments(const dash::mpd::IRepresentation* rep);
+
+// whether the segments of rep are described by a SegmentTemplate
+bool
+HasSegmentTemplate(const dash::mpd::IRepresentation* rep);
+
+// the media URI of segment segmentNumber of rep, relative to the base URL
+std::string
+GetSegmentMediaURI(const dash::mpd::IRepresentation* rep, unsigned int segmentNumber);
+
+}
+}
+
+#endif // DASH_REPRESENTATION_SEGMENTS
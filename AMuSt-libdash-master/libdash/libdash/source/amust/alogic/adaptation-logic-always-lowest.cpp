@@ -44,7 +44,7 @@ AlwaysLowestAdaptationLogic::GetNextSegment(unsigned int *requested_segment_numb
   *usedRepresentation = rep;
   *requested_segment_number = currentSegmentNumber;
   *hasDownloadedAllSegments = false;
-  return rep->GetSegmentList()->GetSegmentURLs().at(currentSegmentNumber++);
+  return GetSegmentURL(rep, currentSegmentNumber++);
 }
 
 }
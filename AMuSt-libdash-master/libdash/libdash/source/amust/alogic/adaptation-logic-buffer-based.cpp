@@ -21,6 +21,8 @@
 #include "adaptation-logic-buffer-based.h"
 #include "multimedia-player.h"
 
+#include <algorithm>
+
 
 namespace dash
 {
@@ -56,48 +58,17 @@ BufferBasedAdaptationLogic::GetNextSegment(unsigned int *requested_segment_numbe
 
     if (this->m_multimediaPlayer->GetBufferLevel() < 8) {
       // whatever representation it is, decrease it
-      double highest_bitrate = 0.0;
-
-      RepresentationsMap::iterator it;
-
-      // for (auto& keyValue : *(this->m_availableRepresentations))
-      for ( it = m_availableRepresentations->begin(); it != m_availableRepresentations->end(); it++)
-      {
-        const IRepresentation* rep = it->second;
-        // std::cerr << "Rep=" << keyValue.first << " has bitrate " << rep->GetBandwidth() << std::endl;
-        if (rep->GetBandwidth() < speed_of_last_rep && rep->GetBandwidth() < cur_download_speed)
-        {
-          if (rep->GetBandwidth() > highest_bitrate)
-          {
-            useRep = rep;
-            highest_bitrate = rep->GetBandwidth();
-          }
-        }
-      }
-
+      const IRepresentation* rep = GetHighestRepresentationBelow(std::min(speed_of_last_rep, cur_download_speed));
+      if (rep != NULL)
+        useRep = rep;
     } else if (this->m_multimediaPlayer->GetBufferLevel() < 14) {
       // stay at this representation, do not modify userep
     } else { // >= 16
       // time to increase to the next best representation
       fprintf(stderr, "trying to increase from %f\n", speed_of_last_rep);
-      double highest_bitrate = 999999999.99;
-
-      RepresentationsMap::iterator it;
-
-      // for (auto& keyValue : *(this->m_availableRepresentations))
-      for ( it = m_availableRepresentations->begin(); it != m_availableRepresentations->end(); it++)
-      {
-        const IRepresentation* rep = it->second;
-        // std::cerr << "Rep=" << keyValue.first << " has bitrate " << rep->GetBandwidth() << std::endl;
-        if (rep->GetBandwidth() > speed_of_last_rep && rep->GetBandwidth() < cur_download_speed)
-        {
-          if (rep->GetBandwidth() < highest_bitrate)
-          {
-            useRep = rep;
-            highest_bitrate = rep->GetBandwidth();
-          }
-        }
-      }
+      const IRepresentation* rep = GetNextHigherRepresentation(speed_of_last_rep);
+      if (rep != NULL && rep->GetBandwidth() < cur_download_speed)
+        useRep = rep;
     }
   }
 
@@ -114,7 +85,7 @@ BufferBasedAdaptationLogic::GetNextSegment(unsigned int *requested_segment_numbe
   lastUsedRep = useRep;
 
 
-  return useRep->GetSegmentList()->GetSegmentURLs().at(currentSegmentNumber++);
+  return GetSegmentURL(useRep, currentSegmentNumber++);
 }
 
 }
@@ -53,24 +53,7 @@ DASHJSAdaptationLogic::GetNextSegment(unsigned int *requested_segment_number,
 
   double weighted_download_speed = (0.35*previousDownloadSpeed + 0.65*cur_download_speed);
 
-  double highest_bitrate = 0.0;
-
-  RepresentationsMap::iterator it;
-
-  // for (auto& keyValue : *(this->m_availableRepresentations))
-  for ( it = m_availableRepresentations->begin(); it != m_availableRepresentations->end(); it++)
-  {
-    const IRepresentation* rep = it->second;
-    // std::cerr << "Rep=" << keyValue.first << " has bitrate " << rep->GetBandwidth() << std::endl;
-    if (rep->GetBandwidth() < weighted_download_speed*factor)
-    {
-      if (rep->GetBandwidth() > highest_bitrate)
-      {
-        useRep = rep;
-        highest_bitrate = rep->GetBandwidth();
-      }
-    }
-  }
+  useRep = GetHighestRepresentationBelow(weighted_download_speed*factor);
 
   if (useRep == NULL) // fallback
     useRep = GetLowestRepresentation();
@@ -85,7 +68,7 @@ DASHJSAdaptationLogic::GetNextSegment(unsigned int *requested_segment_number,
   // remember previousDownloadSpeed
   previousDownloadSpeed = weighted_download_speed;
 
-  return useRep->GetSegmentList()->GetSegmentURLs().at(currentSegmentNumber++);
+  return GetSegmentURL(useRep, currentSegmentNumber++);
 }
 
 }
@@ -44,30 +44,19 @@ GuidedAdaptationLogic::GetNextSegment(unsigned int *requested_segment_number, co
   }
 
 
-  const IRepresentation* useRep = NULL;
-
-  double highest_bitrate = 0.0;
+  const IRepresentation* useRep = GetHighestRepresentationBelow(last_download_speed);
 
   RepresentationsMap::iterator it;
 
   //find out the request id
   const IRepresentation* rep=m_availableRepresentations->begin()->second;
-  std::string uri=rep->GetSegmentList()->GetSegmentURLs().at(0)->GetMediaURI();
-  std::string range=rep->GetSegmentList()->GetSegmentURLs().at(0)->GetMediaRange();
+  std::string uri=GetSegmentURL(rep, 0)->GetMediaURI();
+  std::string range=GetSegmentURL(rep, 0)->GetMediaRange();
 
   // for (auto& keyValue : *(this->m_availableRepresentations))
   for ( it = m_availableRepresentations->begin(); it != m_availableRepresentations->end(); it++)
   {
     std::cout << it->first << " " << uri << " " << range << " " << it->second->GetBandwidth() << std::endl;
-    const IRepresentation* rep = it->second;
-    if (rep->GetBandwidth() < last_download_speed)
-    {
-      if (rep->GetBandwidth() > highest_bitrate)
-      {
-        useRep = rep;
-        highest_bitrate = rep->GetBandwidth();
-      }
-    }
   }
   exit(0);
   if (useRep == NULL)
@@ -77,7 +66,7 @@ GuidedAdaptationLogic::GetNextSegment(unsigned int *requested_segment_number, co
   *usedRepresentation = useRep;
   *requested_segment_number = currentSegmentNumber;
   *hasDownloadedAllSegments = false;
-  return useRep->GetSegmentList()->GetSegmentURLs().at(currentSegmentNumber++);
+  return GetSegmentURL(useRep, currentSegmentNumber++);
 }
 }
 
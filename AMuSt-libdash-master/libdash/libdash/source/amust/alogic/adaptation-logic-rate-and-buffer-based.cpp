@@ -60,24 +60,7 @@ RateAndBufferBasedAdaptationLogic::GetNextSegment(unsigned int *requested_segmen
 
   double last_download_speed = this->m_multimediaPlayer->GetLastDownloadBitRate();
 
-  double highest_bitrate = 0.0;
-
-  RepresentationsMap::iterator it;
-
-  // for (auto& keyValue : *(this->m_availableRepresentations))
-  for ( it = m_availableRepresentations->begin(); it != m_availableRepresentations->end(); it++)
-  {
-    const IRepresentation* rep = it->second;
-    // std::cerr << "Rep=" << keyValue.first << " has bitrate " << rep->GetBandwidth() << std::endl;
-    if (rep->GetBandwidth() < last_download_speed*factor)
-    {
-      if (rep->GetBandwidth() > highest_bitrate)
-      {
-        useRep = rep;
-        highest_bitrate = rep->GetBandwidth();
-      }
-    }
-  }
+  useRep = GetHighestRepresentationBelow(last_download_speed*factor);
 
   if (useRep == NULL) // fallback
     useRep = GetLowestRepresentation();
@@ -88,7 +71,7 @@ RateAndBufferBasedAdaptationLogic::GetNextSegment(unsigned int *requested_segmen
   *usedRepresentation = useRep;
   *requested_segment_number = currentSegmentNumber;
   *hasDownloadedAllSegments = false;
-  return useRep->GetSegmentList()->GetSegmentURLs().at(currentSegmentNumber++);
+  return GetSegmentURL(useRep, currentSegmentNumber++);
 }
 
 }
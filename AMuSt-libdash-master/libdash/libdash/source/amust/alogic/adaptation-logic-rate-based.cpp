@@ -45,24 +45,7 @@ RateBasedAdaptationLogic::GetNextSegment(unsigned int *requested_segment_number,
 
   const IRepresentation* useRep = NULL;
 
-  double highest_bitrate = 0.0;
-
-
-  RepresentationsMap::iterator it;
-
-  // for (auto& keyValue : *(this->m_availableRepresentations))
-  for ( it = m_availableRepresentations->begin(); it != m_availableRepresentations->end(); it++)
-  {
-    const IRepresentation* rep = it->second;
-    if (rep->GetBandwidth() < last_download_speed)
-    {
-      if (rep->GetBandwidth() > highest_bitrate)
-      {
-        useRep = rep;
-        highest_bitrate = rep->GetBandwidth();
-      }
-    }
-  }
+  useRep = GetHighestRepresentationBelow(last_download_speed);
 
   if (useRep == NULL)
     useRep = GetLowestRepresentation();
@@ -71,7 +54,7 @@ RateBasedAdaptationLogic::GetNextSegment(unsigned int *requested_segment_number,
   *usedRepresentation = useRep;
   *requested_segment_number = currentSegmentNumber;
   *hasDownloadedAllSegments = false;
-  return useRep->GetSegmentList()->GetSegmentURLs().at(currentSegmentNumber++);
+  return GetSegmentURL(useRep, currentSegmentNumber++);
 }
 }
 
@@ -20,6 +20,7 @@
 #include <stdlib.h>
 
 #include "adaptation-logic-svc-buffer-based.h"
+#include "representation-segments.h"
 
 #include "multimedia-player.h"
 
@@ -57,7 +58,7 @@ AbstractSVCBufferBasedAdaptationLogic::GetNextSegment(unsigned int* requested_se
         *requested_segment_number = next_segment_number;
         *usedRepresentation = m_orderdByDepIdReps[i];
         *hasDownloadedAllSegments = false;
-        return m_orderdByDepIdReps[i]->GetSegmentList()->GetSegmentURLs().at(next_segment_number);
+        return GetSegmentURL(m_orderdByDepIdReps[i], next_segment_number);
       }
       else
         *hasDownloadedAllSegments = true;
@@ -81,7 +82,7 @@ AbstractSVCBufferBasedAdaptationLogic::GetNextSegment(unsigned int* requested_se
         *requested_segment_number = next_segment_number;
         *usedRepresentation = m_orderdByDepIdReps[i];
         *hasDownloadedAllSegments = false;
-        return m_orderdByDepIdReps[i]->GetSegmentList()->GetSegmentURLs().at(next_segment_number);
+        return GetSegmentURL(m_orderdByDepIdReps[i], next_segment_number);
       }
       else
         *hasDownloadedAllSegments = true;
@@ -104,7 +105,7 @@ AbstractSVCBufferBasedAdaptationLogic::GetNextSegment(unsigned int* requested_se
       *requested_segment_number = next_segment_number;
       *usedRepresentation = m_orderdByDepIdReps[i];
       *hasDownloadedAllSegments = false;
-      return m_orderdByDepIdReps[i]->GetSegmentList()->GetSegmentURLs().at(next_segment_number);
+      return GetSegmentURL(m_orderdByDepIdReps[i], next_segment_number);
     }
     else
       *hasDownloadedAllSegments = true;
@@ -121,8 +122,7 @@ AbstractSVCBufferBasedAdaptationLogic::SetAvailableRepresentations(std::map<std:
   orderRepresentationsByDepIds();
 
   //calc typical segment duration (we assume all reps have the same duration..)
-  segment_duration = (double) m_orderdByDepIdReps.begin()->second->GetSegmentList()->GetDuration();
-  segment_duration /= (double) m_orderdByDepIdReps.begin()->second->GetSegmentList()->GetTimescale ();
+  segment_duration = GetSegmentDuration(m_orderdByDepIdReps.begin()->second);
 }
 
 //this functions classifies reps into layers depending on the DepIds.
@@ -20,6 +20,7 @@
 #include <stdlib.h>
 
 #include "adaptation-logic-svc-rate-based.h"
+#include "representation-segments.h"
 
 namespace dash
 {
@@ -68,21 +69,9 @@ SVCRateBasedAdaptationLogic::GetNextSegment(unsigned int *requested_segment_numb
     //const IRepresentation* useRep = GetLowestRepresentation();
     int layerForRep = 0;
 
-    double highest_bitrate = 0.0;
-    for (std::map<int /*level/layer*/, IRepresentation*>::iterator it = m_orderdByDepIdReps.begin (); it != m_orderdByDepIdReps.end (); ++it)
-    {
-      const IRepresentation* rep = it->second;
-      //std::cerr << "Rep=" << keyValue.first << " has bitrate " << rep->GetBandwidth() << std::endl;
-      if (rep->GetBandwidth() < max_allowed_bitrate)
-      {
-        if (rep->GetBandwidth() > highest_bitrate)
-        {
-          //useRep = rep;
-          layerForRep = it->first;
-          highest_bitrate = rep->GetBandwidth();
-        }
-      }
-    }
+    const IRepresentation* rep = GetHighestRepresentationBelow(max_allowed_bitrate);
+    if (rep != NULL && m_layerOfRep.find(rep) != m_layerOfRep.end())
+      layerForRep = m_layerOfRep[rep];
 
     for(int i = layerForRep; i >= 0; i--)
       repsForCurSegment.push (m_orderdByDepIdReps[i]);
@@ -106,7 +95,7 @@ SVCRateBasedAdaptationLogic::GetNextSegment(unsigned int *requested_segment_numb
   if(repsForCurSegment.empty ())
     curSegmentNumber++; // then increase segment number
 
-  return (*usedRepresentation)->GetSegmentList()->GetSegmentURLs().at(*requested_segment_number);
+  return GetSegmentURL(*usedRepresentation, *requested_segment_number);
 }
 
 void SVCRateBasedAdaptationLogic::updateEMA ()
@@ -160,8 +149,7 @@ SVCRateBasedAdaptationLogic::SetAvailableRepresentations(std::map<std::string, I
   orderRepresentationsByDepIds();
 
   //calc typical segment duration (we assume all reps have the same duration..)
-  segment_duration = (double) m_orderdByDepIdReps.begin()->second->GetSegmentList()->GetDuration();
-  segment_duration /= (double) m_orderdByDepIdReps.begin()->second->GetSegmentList()->GetTimescale ();
+  segment_duration = GetSegmentDuration(m_orderdByDepIdReps.begin()->second);
 }
 
 //this functions classifies reps into layers depending on the DepIds.
@@ -176,6 +164,7 @@ void SVCRateBasedAdaptationLogic::orderRepresentationsByDepIds()
   //fprintf(stderr, "reps.size()=%d\n",reps.size ());
 
   m_orderdByDepIdReps.clear ();
+  m_layerOfRep.clear ();
   int level = 0;
 
   while(reps.size () > 0)
@@ -197,6 +186,7 @@ void SVCRateBasedAdaptationLogic::orderRepresentationsByDepIds()
         return;
       }
     }
+    m_layerOfRep[lowest->second] = level;
     m_orderdByDepIdReps[level++] = lowest->second;
     selectedReps[lowest->first] = lowest->second;
     reps.erase (lowest);
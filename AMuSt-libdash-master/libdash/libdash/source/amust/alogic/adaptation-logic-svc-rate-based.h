@@ -75,6 +75,7 @@ protected:
   bool hasMinBufferLevel();
 
   std::map<int /*level/layer*/, IRepresentation*> m_orderdByDepIdReps;
+  std::map<const IRepresentation*, int /*level/layer*/> m_layerOfRep;
 
   //unsigned int getNextNeededSegmentNumber(int layer);
   unsigned int curSegmentNumber;
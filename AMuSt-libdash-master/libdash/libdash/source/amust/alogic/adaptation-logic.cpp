@@ -20,6 +20,10 @@
 
 #include "adaptation-logic.h"
 #include "multimedia-player.h"
+#include "representation-segments.h"
+#include "../../mpd/SegmentURL.h"
+
+#include <algorithm>
 
 
 namespace dash
@@ -29,15 +33,35 @@ namespace player
 ENSURE_ADAPTATION_LOGIC_INITIALIZED(AdaptationLogic)
 
 
+static bool BandwidthBelow(const IRepresentation* rep, double bitrate)
+{
+  return rep->GetBandwidth() < bitrate;
+}
+
+static bool BandwidthAbove(double bitrate, const IRepresentation* rep)
+{
+  return bitrate < rep->GetBandwidth();
+}
+
+static bool CompareBandwidth(const IRepresentation* a, const IRepresentation* b)
+{
+  return a->GetBandwidth() < b->GetBandwidth();
+}
+
+
 AdaptationLogic::AdaptationLogic(MultimediaPlayer* mPlayer)
 {
   this->m_multimediaPlayer = mPlayer;
+  this->m_availableRepresentations = NULL;
+  this->m_totalSegments = 0;
+  this->m_templateSegmentURL = NULL;
 }
 
 
 
 AdaptationLogic::~AdaptationLogic()
 {
+  delete m_templateSegmentURL;
 
 }
 
@@ -46,6 +70,33 @@ void
 AdaptationLogic::SetAvailableRepresentations(std::map<std::string, IRepresentation*>* availableRepresentations)
 {
   this->m_availableRepresentations = availableRepresentations;
+
+  m_bitrateLadder.clear();
+  for(RepresentationsMap::iterator it = availableRepresentations->begin(); it != availableRepresentations->end(); ++it)
+    m_bitrateLadder.push_back(it->second);
+
+  std::stable_sort(m_bitrateLadder.begin(), m_bitrateLadder.end(), CompareBandwidth);
+
+  // we assume that in all represntation the same amount of segments exists..
+  m_totalSegments = m_bitrateLadder.empty() ? 0 : GetNumberOfListedSegments(m_bitrateLadder.front());
+}
+
+void
+AdaptationLogic::SetTotalSegments(unsigned int totalSegments)
+{
+  m_totalSegments = totalSegments;
+}
+
+ISegmentURL*
+AdaptationLogic::GetSegmentURL(const IRepresentation* rep, unsigned int segmentNumber)
+{
+  if(!HasSegmentTemplate(rep))
+    return rep->GetSegmentList()->GetSegmentURLs().at(segmentNumber);
+
+  if(m_templateSegmentURL == NULL)
+    m_templateSegmentURL = new dash::mpd::SegmentURL();
+  m_templateSegmentURL->SetMediaURI(GetSegmentMediaURI(rep, segmentNumber));
+  return m_templateSegmentURL;
 }
 
 
@@ -63,13 +114,35 @@ AdaptationLogic::GetNextSegment(unsigned int *requested_segment_number, const da
 IRepresentation*
 AdaptationLogic::GetLowestRepresentation()
 {
-    return (this->m_availableRepresentations->begin()->second);
+  if(m_bitrateLadder.empty())
+    return NULL;
+  return m_bitrateLadder.front();
+}
+
+IRepresentation*
+AdaptationLogic::GetHighestRepresentationBelow(double bitrate)
+{
+  std::vector<IRepresentation*>::iterator it = std::lower_bound(m_bitrateLadder.begin(), m_bitrateLadder.end(), bitrate, BandwidthBelow);
+  if(it == m_bitrateLadder.begin())
+    return NULL;
+
+  // of several representations with that bandwidth, use the first one
+  double bandwidth = (*(it - 1))->GetBandwidth();
+  return *std::lower_bound(m_bitrateLadder.begin(), it, bandwidth, BandwidthBelow);
+}
+
+IRepresentation*
+AdaptationLogic::GetNextHigherRepresentation(double bitrate)
+{
+  std::vector<IRepresentation*>::iterator it = std::upper_bound(m_bitrateLadder.begin(), m_bitrateLadder.end(), bitrate, BandwidthAbove);
+  if(it == m_bitrateLadder.end())
+    return NULL;
+  return *it;
 }
 
-// we assume that in all represntation the same amount of segments exists..
 unsigned int AdaptationLogic::getTotalSegments()
 {
-  return m_availableRepresentations->begin()->second->GetSegmentList ()->GetSegmentURLs().size();
+  return m_totalSegments;
 }
 
 bool AdaptationLogic::hasMinBufferLevel(const dash::mpd::IRepresentation* rep)
@@ -73,7 +73,7 @@ SVCNoAdaptationLogic::GetNextSegment(unsigned int *requested_segment_number, con
     *requested_segment_number = next_segment_number;
     *usedRepresentation = m_orderdByDepIdReps[chosen_layer];
     *hasDownloadedAllSegments = false;
-    return m_orderdByDepIdReps[chosen_layer]->GetSegmentList()->GetSegmentURLs().at(next_segment_number);
+    return GetSegmentURL(m_orderdByDepIdReps[chosen_layer], next_segment_number);
   }
 
   *hasDownloadedAllSegments = true;
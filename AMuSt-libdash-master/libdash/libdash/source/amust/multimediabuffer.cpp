@@ -20,6 +20,7 @@
 
 
 #include "multimediabuffer.h"
+#include "representation-segments.h"
 
 #include <stdio.h>
 
@@ -31,11 +32,13 @@ MultimediaBuffer::MultimediaBuffer(unsigned int maxBufferedSeconds)
 
   toBufferSegmentNumber = 0;
   toConsumeSegmentNumber = 0;
+  bufferedSeconds = 0.0;
 }
 
 MultimediaBuffer::~MultimediaBuffer()
 {
   buff.clear();
+  bufferedSecondsByRep.clear();
 }
 
 bool MultimediaBuffer::addToBuffer(unsigned int segmentNumber, const dash::mpd::IRepresentation* usedRepresentation, float experiencedDownloadBitrate)
@@ -47,8 +50,7 @@ bool MultimediaBuffer::addToBuffer(unsigned int segmentNumber, const dash::mpd::
   //fprintf(stderr, "toBufferSegmentNumber=%d < segmentNumber=%d\n",toBufferSegmentNumber,segmentNumber);
 
   //determine segment duration
-  double duration = (double) usedRepresentation->GetSegmentList()->GetDuration();
-  duration /= (double) usedRepresentation->GetSegmentList()->GetTimescale ();
+  double duration = GetSegmentDuration(usedRepresentation);
 
   // Check if segment has depIds
   if(usedRepresentation->GetDependencyId ().size() > 0)
@@ -58,7 +60,7 @@ bool MultimediaBuffer::addToBuffer(unsigned int segmentNumber, const dash::mpd::
     if(it == buff.end ())
       return false;
 
-    BufferRepresentationEntryMap map = it->second;
+    const BufferRepresentationEntryMap& map = it->second;
 
     for(std::vector<std::string>::const_iterator k = usedRepresentation->GetDependencyId ().begin ();
         k !=  usedRepresentation->GetDependencyId ().end (); k++)
@@ -89,7 +91,19 @@ bool MultimediaBuffer::addToBuffer(unsigned int segmentNumber, const dash::mpd::
   entry.bitrate_bit_s = usedRepresentation->GetBandwidth ();
   entry.experienced_bitrate_bit_s = (unsigned int) experiencedDownloadBitrate;
 
-  buff[segmentNumber][usedRepresentation->GetId ()] = entry;
+  BufferRepresentationEntryMap& segment = buff[segmentNumber];
+  double firstDuration = segment.empty() ? 0.0 : segment.begin()->second.segmentDuration;
+
+  BufferRepresentationEntryMap::iterator existing = segment.find (entry.repId);
+  if(existing != segment.end ())
+    removeBufferLevel(entry.repId, existing->second.segmentDuration);
+
+  segment[entry.repId] = entry;
+  addBufferLevel(entry.repId, duration);
+
+  // the new entry might have replaced the first one of this segment
+  bufferedSeconds += segment.begin()->second.segmentDuration - firstDuration;
+
   toBufferSegmentNumber++;
   return true;
 }
@@ -97,8 +111,7 @@ bool MultimediaBuffer::addToBuffer(unsigned int segmentNumber, const dash::mpd::
 bool MultimediaBuffer::enoughSpaceInLayeredBuffer(unsigned int segmentNumber, const dash::mpd::IRepresentation* usedRepresentation)
 {
   //determine segment duration
-  double duration = (double) usedRepresentation->GetSegmentList()->GetDuration();
-  duration /= (double) usedRepresentation->GetSegmentList()->GetTimescale ();
+  double duration = GetSegmentDuration(usedRepresentation);
 
   if(isFull(usedRepresentation->GetId (),duration))
     return false;
@@ -110,8 +123,7 @@ bool MultimediaBuffer::enoughSpaceInLayeredBuffer(unsigned int segmentNumber, co
 bool MultimediaBuffer::enoughSpaceInTotalBuffer(unsigned int segmentNumber, const dash::mpd::IRepresentation* usedRepresentation)
 {
   //determine segment duration
-  double duration = (double) usedRepresentation->GetSegmentList()->GetDuration();
-  duration /= (double) usedRepresentation->GetSegmentList()->GetTimescale ();
+  double duration = GetSegmentDuration(usedRepresentation);
 
   if(isFull(duration))
     return false;
@@ -145,29 +157,36 @@ bool MultimediaBuffer::isEmpty()
 /** get buffered seconds from all segments */
 double MultimediaBuffer::getBufferedSeconds()
 {
-  double bufferSize = 0.0;
-
-  for(MBuffer::iterator it = buff.begin (); it != buff.end (); ++it)
-    bufferSize += it->second.begin()->second.segmentDuration;
-
-  //fprintf(stderr, "BufferSize for lowestRep = %f\n", bufferSize);
-  return bufferSize;
+  return bufferedSeconds;
 }
 
 /** get buffered seconds only from segments belonging to the representation id repId */
 double MultimediaBuffer::getBufferedSeconds(std::string repId)
 {
-  double bufferSize = 0.0;
-  for(MBuffer::iterator it = buff.begin (); it != buff.end (); ++it)
-  {
-    BufferRepresentationEntryMap::iterator k = it->second.find(repId);
-    if(k != it->second.end())
-    {
-      bufferSize += k->second.segmentDuration;
-    }
-  }
-  //fprintf(stderr, "BufferSize for rep[%s] = %f\n", repId.c_str (),bufferSize);
-  return bufferSize;
+  std::map<std::string, BufferLevel>::iterator it = bufferedSecondsByRep.find(repId);
+  if(it == bufferedSecondsByRep.end())
+    return 0.0;
+  return it->second.seconds;
+}
+
+void MultimediaBuffer::addBufferLevel(const std::string& repId, double duration)
+{
+  BufferLevel& level = bufferedSecondsByRep[repId];
+  level.seconds += duration;
+  level.segments++;
+}
+
+void MultimediaBuffer::removeBufferLevel(const std::string& repId, double duration)
+{
+  std::map<std::string, BufferLevel>::iterator it = bufferedSecondsByRep.find(repId);
+  if(it == bufferedSecondsByRep.end())
+    return;
+
+  // drop the counter with its last segment, so no rounding error is left behind
+  if(--it->second.segments == 0)
+    bufferedSecondsByRep.erase(it);
+  else
+    it->second.seconds -= duration;
 }
 
 unsigned int MultimediaBuffer::getHighestBufferedSegmentNr(std::string repId)
@@ -199,8 +218,16 @@ MultimediaBuffer::BufferRepresentationEntry MultimediaBuffer::consumeFromBuffer(
     return entryConsumed;
   }
 
-  entryConsumed = getHighestConsumableRepresentation(toConsumeSegmentNumber);
+  entryConsumed = getHighestConsumableRepresentation(it->second);
+
+  bufferedSeconds -= it->second.begin()->second.segmentDuration;
+  for(BufferRepresentationEntryMap::iterator k = it->second.begin (); k != it->second.end (); ++k)
+    removeBufferLevel(k->first, k->second.segmentDuration);
+
   buff.erase (it);
+  if(buff.empty ())
+    bufferedSeconds = 0.0;
+
   toConsumeSegmentNumber++;
   return entryConsumed;
 }
@@ -216,11 +243,16 @@ MultimediaBuffer::BufferRepresentationEntry MultimediaBuffer::getHighestConsumab
     return consumableEntry;
   }
 
-  BufferRepresentationEntryMap map = it->second;
+  return getHighestConsumableRepresentation(it->second);
+}
+
+MultimediaBuffer::BufferRepresentationEntry MultimediaBuffer::getHighestConsumableRepresentation(const BufferRepresentationEntryMap& map)
+{
+  BufferRepresentationEntry consumableEntry;
 
   //find entry with most depIds.
   unsigned int most_depIds = 0;
-  for(BufferRepresentationEntryMap::iterator k = map.begin (); k != map.end (); ++k)
+  for(BufferRepresentationEntryMap::const_iterator k = map.begin (); k != map.end (); ++k)
   {
     if(most_depIds <= k->second.depIds.size())
     {
@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "representation-segments.h"
+
+
+namespace dash
+{
+namespace player
+{
+
+double
+GetSegmentDuration(const dash::mpd::IRepresentation* rep)
+{
+  const dash::mpd::IMultipleSegmentBase* segments = rep->GetSegmentList();
+  if(segments == NULL)
+    segments = rep->GetSegmentTemplate();
+  if(segments == NULL)
+    return 0.0;
+
+  return (double) segments->GetDuration() / (double) segments->GetTimescale();
+}
+
+unsigned int
+GetNumberOfListedSegments(const dash::mpd::IRepresentation* rep)
+{
+  if(rep->GetSegmentList() == NULL)
+    return 0;
+  return rep->GetSegmentList()->GetSegmentURLs().size();
+}
+
+bool
+HasSegmentTemplate(const dash::mpd::IRepresentation* rep)
+{
+  return rep->GetSegmentList() == NULL && rep->GetSegmentTemplate() != NULL;
+}
+
+std::string
+GetSegmentMediaURI(const dash::mpd::IRepresentation* rep, unsigned int segmentNumber)
+{
+  if(rep->GetSegmentList() != NULL)
+    return rep->GetSegmentList()->GetSegmentURLs().at(segmentNumber)->GetMediaURI();
+
+  const dash::mpd::ISegmentTemplate* segmentTemplate = rep->GetSegmentTemplate();
+  return segmentTemplate->GetMediaURIFromNumber(rep->GetId(), rep->GetBandwidth(),
+                                                segmentTemplate->GetStartNumber() + segmentNumber);
+}
+
+}
+}
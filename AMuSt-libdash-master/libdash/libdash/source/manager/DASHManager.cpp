@@ -28,6 +28,16 @@ IMPD*           DASHManager::Open   (char *path)
 	// fprintf(stderr, "\nMPD: %s\n", path);
     DOMParser parser(path);
 
+    return this->Parse(parser);
+}
+IMPD*           DASHManager::OpenBuffer (const char *buffer, int size, const char *url)
+{
+    DOMParser parser(url, buffer, size);
+
+    return this->Parse(parser);
+}
+IMPD*           DASHManager::Parse  (DOMParser &parser)
+{
     uint32_t fetchTime = Time::GetCurrentUTCTimeInSec();
 
     if (!parser.Parse())
@@ -27,8 +27,12 @@ namespace dash
             DASHManager             ();
             virtual ~DASHManager    ();
 
-            mpd::IMPD*  Open    (char *path);
-            void        Delete  ();
+            mpd::IMPD*  Open        (char *path);
+            mpd::IMPD*  OpenBuffer  (const char *buffer, int size, const char *url);
+            void        Delete      ();
+
+        private:
+            mpd::IMPD*  Parse       (xml::DOMParser &parser);
     };
 }
 
@@ -69,6 +69,10 @@ ISegment*           SegmentTemplate::GetMediaSegmentFromNumber      (const std::
 {
     return ToSegment(this->media, baseurls, representationID, bandwidth, dash::metrics::MediaSegment, number);
 }
+std::string         SegmentTemplate::GetMediaURIFromNumber          (const std::string& representationID, uint32_t bandwidth, uint32_t number) const
+{
+    return ReplaceParameters(this->media, representationID, bandwidth, number, 0);
+}
 ISegment*           SegmentTemplate::GetIndexSegmentFromNumber      (const std::vector<IBaseUrl *>& baseurls, const std::string& representationID, uint32_t bandwidth, uint32_t number) const
 {
     return ToSegment(this->index, baseurls, representationID, bandwidth, dash::metrics::IndexSegment, number);
@@ -17,7 +17,18 @@ using namespace dash::helpers;
 DOMParser::DOMParser    (std::string url) :
            url          (url),
            reader       (NULL),
-           root         (NULL)
+           root         (NULL),
+           buffer       (NULL),
+           size         (0)
+{
+    this->Init();
+}
+DOMParser::DOMParser    (std::string url, const char *buffer, int size) :
+           url          (url),
+           reader       (NULL),
+           root         (NULL),
+           buffer       (buffer),
+           size         (size)
 {
     this->Init();
 }
@@ -33,7 +44,10 @@ Node*   DOMParser::GetRootNode              () const
 }
 bool    DOMParser::Parse                    ()
 {
-    this->reader = xmlReaderForFile(this->url.c_str(), NULL, 0);
+    if(this->buffer != NULL)
+        this->reader = xmlReaderForMemory(this->buffer, this->size, this->url.c_str(), NULL, 0);
+    else
+        this->reader = xmlReaderForFile(this->url.c_str(), NULL, 0);
 
     if(this->reader == NULL)
         return false;
@@ -35,6 +35,7 @@ namespace dash
         {
             public:
                 DOMParser           (std::string url);
+                DOMParser           (std::string url, const char *buffer, int size);
                 virtual ~DOMParser  ();
 
                 bool    Parse       ();
@@ -45,6 +46,8 @@ namespace dash
                 xmlTextReaderPtr    reader;
                 Node                *root;
                 std::string         url;
+                const char          *buffer;
+                int                 size;
 
                 void    Init                    ();
                 Node*   ProcessNode             ();
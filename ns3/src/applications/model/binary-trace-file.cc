@@ -0,0 +1,173 @@
+#include "binary-trace-file.h"
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+
+#include <string.h>
+
+NS_LOG_COMPONENT_DEFINE ("BinaryTraceFile");
+
+namespace ns3
+{
+
+static const char MAGIC[8] = { 'N', 'S', '3', 'T', 'R', 'A', 'C', 'E' };
+static const uint32_t VERSION = 1;
+static const char BINARY_SUFFIX[] = ".bin";
+
+
+BinaryTraceFile::BinaryTraceFile(const std::string& file, uint32_t batchBytes)
+  : m_batchBytes(batchBytes)
+{
+  m_file = fopen(file.c_str(), "wb");
+  if (m_file == NULL)
+  {
+    NS_LOG_ERROR("File " << file << " cannot be opened for writing");
+    return;
+  }
+
+  // the batch is the only buffer, stdio does not need to buffer again
+  setvbuf(m_file, NULL, _IONBF, 0);
+
+  m_batch.reserve(m_batchBytes + 1024);
+  m_batch.insert(m_batch.end(), MAGIC, MAGIC + sizeof(MAGIC));
+  m_batch.insert(m_batch.end(), (const uint8_t*) &VERSION, (const uint8_t*) &VERSION + sizeof(VERSION));
+}
+
+BinaryTraceFile::~BinaryTraceFile()
+{
+  if (m_file != NULL)
+  {
+    Flush();
+    fclose(m_file);
+  }
+}
+
+bool
+BinaryTraceFile::IsOpen() const
+{
+  return m_file != NULL;
+}
+
+void
+BinaryTraceFile::Write(uint8_t type, const void* payload, uint16_t size)
+{
+  if (m_file == NULL)
+    return;
+
+  size_t offset = m_batch.size();
+  m_batch.resize(offset + sizeof(type) + sizeof(size) + size);
+  m_batch[offset] = type;
+  memcpy(&m_batch[offset + sizeof(type)], &size, sizeof(size));
+  memcpy(&m_batch[offset + sizeof(type) + sizeof(size)], payload, size);
+
+  if (m_batch.size() >= m_batchBytes)
+    Flush();
+}
+
+uint16_t
+BinaryTraceFile::Intern(const std::string& value)
+{
+  std::map<std::string, uint16_t>::iterator it = m_strings.find(value);
+  if (it != m_strings.end())
+    return it->second;
+
+  NS_ASSERT_MSG(m_strings.size() < 0xffff, "Too many distinct strings in trace");
+  uint16_t index = (uint16_t) m_strings.size();
+  m_strings[value] = index;
+
+  // the string record is the index followed by the characters
+  std::vector<uint8_t> payload(sizeof(index) + value.size());
+  memcpy(&payload[0], &index, sizeof(index));
+  memcpy(&payload[sizeof(index)], value.data(), value.size());
+  Write(STRING_RECORD, &payload[0], (uint16_t) payload.size());
+  return index;
+}
+
+void
+BinaryTraceFile::Flush()
+{
+  if (m_file == NULL || m_batch.empty())
+    return;
+
+  if (fwrite(&m_batch[0], 1, m_batch.size(), m_file) != m_batch.size())
+    NS_LOG_ERROR("Writing " << m_batch.size() << " bytes of trace failed");
+  m_batch.clear();
+}
+
+bool
+BinaryTraceFile::IsBinaryFileName(const std::string& file)
+{
+  size_t suffix = sizeof(BINARY_SUFFIX) - 1;
+  return file.size() > suffix && file.compare(file.size() - suffix, suffix, BINARY_SUFFIX) == 0;
+}
+
+
+BinaryTraceReader::BinaryTraceReader(const std::string& file)
+{
+  m_file = fopen(file.c_str(), "rb");
+  if (m_file == NULL)
+    return;
+
+  char magic[sizeof(MAGIC)];
+  uint32_t version;
+  if (fread(magic, 1, sizeof(magic), m_file) != sizeof(magic) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0
+      || fread(&version, 1, sizeof(version), m_file) != sizeof(version) || version != VERSION)
+  {
+    NS_LOG_ERROR("File " << file << " is not a binary trace file of version " << VERSION);
+    fclose(m_file);
+    m_file = NULL;
+  }
+}
+
+BinaryTraceReader::~BinaryTraceReader()
+{
+  if (m_file != NULL)
+    fclose(m_file);
+}
+
+bool
+BinaryTraceReader::IsOpen() const
+{
+  return m_file != NULL;
+}
+
+bool
+BinaryTraceReader::Next(uint8_t* type, std::vector<uint8_t>* payload)
+{
+  if (m_file == NULL)
+    return false;
+
+  while (true)
+  {
+    uint16_t size;
+    if (fread(type, 1, sizeof(*type), m_file) != sizeof(*type) || fread(&size, 1, sizeof(size), m_file) != sizeof(size))
+      return false;
+
+    payload->resize(size);
+    if (size > 0 && fread(&(*payload)[0], 1, size, m_file) != size)
+    {
+      NS_LOG_WARN("Truncated record at the end of the trace");
+      return false;
+    }
+
+    if (*type != BinaryTraceFile::STRING_RECORD)
+      return true;
+
+    uint16_t index;
+    if (size < sizeof(index))
+      return false;
+    memcpy(&index, &(*payload)[0], sizeof(index));
+    if (index >= m_strings.size())
+      m_strings.resize(index + 1);
+    m_strings[index].assign((const char*) &(*payload)[sizeof(index)], size - sizeof(index));
+  }
+}
+
+const std::string&
+BinaryTraceReader::GetString(uint32_t index) const
+{
+  static const std::string unknown;
+  return index < m_strings.size() ? m_strings[index] : unknown;
+}
+
+} // namespace ns3
@@ -0,0 +1,92 @@
+#ifndef BINARY_TRACE_FILE
+#define BINARY_TRACE_FILE
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace ns3
+{
+
+/**
+ * \brief Trace file of compact binary records, written in large batches
+ *
+ * The file starts with a magic and a version, followed by records of a one byte type,
+ * a two byte payload size and the payload, in host byte order. Strings that repeat
+ * (e.g., representation ids) are interned: the first use writes a string record and
+ * later records refer to it by its index.
+ *
+ * Records are appended to an in-memory batch, which is written with a single fwrite
+ * once it exceeds the batch size and when the file is destroyed. All tracers installed
+ * with one file name share one BinaryTraceFile, so records stay in the order of the events.
+ */
+class BinaryTraceFile
+{
+public:
+  static const uint8_t STRING_RECORD = 0;
+
+  BinaryTraceFile(const std::string& file, uint32_t batchBytes = 64 * 1024);
+  ~BinaryTraceFile();
+
+  bool IsOpen() const;
+
+  /**
+   * \brief Append a record of the given type (STRING_RECORD is reserved)
+   */
+  void Write(uint8_t type, const void* payload, uint16_t size);
+
+  /**
+   * \brief Get the index of value, writing a string record if it is used for the first time
+   */
+  uint16_t Intern(const std::string& value);
+
+  void Flush();
+
+  /**
+   * \brief Whether a trace file name asks for binary records rather than text
+   */
+  static bool IsBinaryFileName(const std::string& file);
+
+private:
+  FILE* m_file;
+  uint32_t m_batchBytes;
+  std::vector<uint8_t> m_batch;
+  std::map<std::string, uint16_t> m_strings;
+};
+
+
+/**
+ * \brief Reads the records of a BinaryTraceFile back, resolving interned strings
+ */
+class BinaryTraceReader
+{
+public:
+  BinaryTraceReader(const std::string& file);
+  ~BinaryTraceReader();
+
+  /**
+   * \brief Whether the file could be opened and has the magic of a binary trace file
+   */
+  bool IsOpen() const;
+
+  /**
+   * \brief Read the next record other than a string record
+   * \returns false at the end of the file or on a truncated record
+   */
+  bool Next(uint8_t* type, std::vector<uint8_t>* payload);
+
+  const std::string& GetString(uint32_t index) const;
+
+private:
+  FILE* m_file;
+  std::vector<std::string> m_strings;
+};
+
+} // namespace ns3
+
+
+#endif /* BINARY_TRACE_FILE */
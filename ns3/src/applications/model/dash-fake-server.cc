@@ -41,6 +41,7 @@
 #include "ns3/string.h"
 #include "ns3/pointer.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/mp-tcp-socket-base.h"
 
@@ -91,6 +92,10 @@ DASHFakeServerApplication::GetTypeId (void)
                    StringValue("localhost"),
                    MakeStringAccessor(&DASHFakeServerApplication::m_hostName),
                    MakeStringChecker())
+    .AddAttribute("SegmentTemplate", "Describe the segments of each representation with a SegmentTemplate instead of listing every segment in a SegmentList",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&DASHFakeServerApplication::m_segmentTemplate),
+                   MakeBooleanChecker())
     .AddTraceSource("ThroughputTracer", "Trace Throughput statistics of this server",
                       MakeTraceSourceAccessor(&DASHFakeServerApplication::m_throughputTrace))
                     ;
@@ -253,7 +258,10 @@ DASHFakeServerApplication::ImportDASHRepresentations (std::string mpdMetaDataFil
             NS_LOG_DEBUG ("Representation ID = "<<repr_id.c_str()<<", height = "<<repr_height.c_str()<<", bitrate = " <<repr_bitrate.c_str());
             mpdData << "<Representation id=\"" << repr_id << "\" codecs=\"avc1\" mimeType=\"video/mp4\"" <<
                  " width=\"" << repr_width << "\" height=\"" << repr_height << "\" startWithSAP=\"1\" bandwidth=\"" << (iBitrate*1000) << "\">" << std::endl;
-            mpdData << "<SegmentList duration=\"" << segment_duration << "\">" << std::endl;
+            if (m_segmentTemplate)
+              mpdData << "<SegmentTemplate media=\"repr_$RepresentationID$_seg_$Number$.264\" duration=\"" << segment_duration << "\" startNumber=\"0\"/>" << std::endl;
+            else
+              mpdData << "<SegmentList duration=\"" << segment_duration << "\">" << std::endl;
 
 
 	    //JEREMIE: modify the size of each segment according to bit rate variation 
@@ -285,11 +293,14 @@ DASHFakeServerApplication::ImportDASHRepresentations (std::string mpdMetaDataFil
               m_fileSizes[m_metaDataContentDirectory + segmentFileName.str()] = iSegmentSize;
 
               m_virtualFiles.push_back(m_metaDataContentDirectory + segmentFileName.str());
-              mpdData << "<SegmentURL media=\"" <<  "repr_" << repr_id << "_seg_" << i << ".264" << "\"/> " << std::endl;
+              if (!m_segmentTemplate)
+                mpdData << "<SegmentURL media=\"" <<  "repr_" << repr_id << "_seg_" << i << ".264" << "\"/> " << std::endl;
               //fprintf(stderr, "SegmentName=%s\n", (m_metaDataContentDirectory + segmentFileName.str()).c_str());
             }
 
-            mpdData << "</SegmentList>" << std::endl << "</Representation>" << std::endl;
+            if (!m_segmentTemplate)
+              mpdData << "</SegmentList>" << std::endl;
+            mpdData << "</Representation>" << std::endl;
           }
         }
        }
@@ -459,7 +470,7 @@ DASHFakeServerApplication::StartApplication (void)
     NS_LOG_INFO ("Adding " << SSMpdFilename.str().c_str() << " to m_fileSizes with size " << compressedMpdData.size());
 
 
-    m_mpdFileContents[SSMpdFilename.str()] = compressedMpdData;
+    m_contentCache.Add(SSMpdFilename.str(), compressedMpdData);
 
     video_id++;
   }
@@ -510,7 +521,7 @@ DASHFakeServerApplication::ConnectionAccepted (Ptr<Socket> s, const Address& add
 
   uint64_t socket_id = RegisterSocket(socket);
 
-  m_activeClients[socket_id] = new HttpServerFakeVirtualClientSocket(socket_id, "/", m_fileSizes, m_virtualFiles, m_mpdFileContents,
+  m_activeClients[socket_id] = new HttpServerFakeVirtualClientSocket(socket_id, "/", m_fileSizes, m_virtualFiles, m_contentCache,
                   MakeCallback(&DASHFakeServerApplication::FinishedCallback, this));
 
   NS_LOG_DEBUG (socket << " " << Simulator::Now () << " Successful socket id : " << socket_id << " Connection Accepted From " << address);
@@ -104,7 +104,7 @@ private:
   std::map<std::string, long> m_fileSizes;
   std::vector<std::string> m_virtualFiles;
 
-  std::map<std::string, std::string> m_mpdFileContents;
+  HttpContentCache m_contentCache;
 
   uint64_t m_lastSocketID;
 
@@ -134,6 +134,7 @@ private:
   std::string m_mpdMetaDataFiles;
   std::string m_metaDataContentDirectory;
   std::string m_hostName;
+  bool m_segmentTemplate; //!< Describe segments with a SegmentTemplate instead of a SegmentList
   Address m_listeningAddress;
 
   EventId m_reportStatsTimer;
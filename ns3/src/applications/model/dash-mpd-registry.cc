@@ -0,0 +1,297 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "dash-mpd-registry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <set>
+
+#include "ns3/log.h"
+#include "ns3/string.h"
+
+#include "representation-segments.h"
+
+
+NS_LOG_COMPONENT_DEFINE("DashMpdRegistry");
+
+using namespace dash::mpd;
+
+namespace ns3 {
+
+// The maps only hold weak pointers, an MPD removes itself when it is destroyed. They are never
+// deleted so that MPDs still referenced during static teardown can unregister safely.
+static std::map<std::string, DashMpd*>*
+MpdsByUrl()
+{
+  static std::map<std::string, DashMpd*>* mpds = new std::map<std::string, DashMpd*>();
+  return mpds;
+}
+
+static std::map<uint64_t, DashMpd*>*
+MpdsByContent()
+{
+  static std::map<uint64_t, DashMpd*>* mpds = new std::map<uint64_t, DashMpd*>();
+  return mpds;
+}
+
+// 64 bit FNV-1a
+static uint64_t
+HashContent(const std::string& content)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for (std::string::const_iterator it = content.begin(); it != content.end(); ++it)
+  {
+    hash ^= (uint8_t) *it;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// seconds of an xs:duration like PT1H2M3.5S, days and larger units are not supported
+static double
+ParseDuration(const std::string& duration)
+{
+  double seconds = 0.0;
+  std::string::size_type pos = duration.find('T');
+  if (pos == std::string::npos)
+    return 0.0;
+
+  const char* it = duration.c_str() + pos + 1;
+  while (*it != '\0')
+  {
+    char* end;
+    double value = strtod(it, &end);
+    if (end == it)
+      break;
+
+    switch (*end)
+    {
+      case 'H': seconds += value * 3600.0; break;
+      case 'M': seconds += value * 60.0; break;
+      case 'S': seconds += value; break;
+      default: return seconds;
+    }
+    it = end + 1;
+  }
+  return seconds;
+}
+
+static bool
+CompareBandwidth(const DashMpd::Representation& a, const DashMpd::Representation& b)
+{
+  return a.bandwidth < b.bandwidth;
+}
+
+
+DashMpd::DashMpd(IMPD* mpd, const std::string& content, uint64_t contentHash)
+  : m_mpd(mpd),
+    m_adaptationSet(NULL),
+    m_isLayered(false),
+    m_nSegments(0),
+    m_segmentDuration(0.0),
+    m_content(content),
+    m_contentHash(contentHash)
+{
+  NS_LOG_FUNCTION(this << contentHash);
+
+  if (mpd->GetPeriods().size() == 0 || mpd->GetPeriods().at(0)->GetAdaptationSets().size() == 0)
+    return;
+
+  // we are assuming there is only 1 period and 1 adaptation set
+  m_adaptationSet = mpd->GetPeriods().at(0)->GetAdaptationSets().at(0);
+
+  std::vector<IRepresentation*> reps = m_adaptationSet->GetRepresentation();
+  std::map<std::string, IRepresentation*> repsById;
+
+  for (std::vector<IRepresentation*>::iterator it = reps.begin(); it != reps.end(); ++it)
+  {
+    Representation entry;
+    entry.rep = *it;
+    entry.id = (*it)->GetId();
+    entry.bandwidth = (*it)->GetBandwidth();
+    entry.width = (*it)->GetWidth();
+    entry.height = (*it)->GetHeight();
+    m_representations.push_back(entry);
+    repsById[entry.id] = *it;
+  }
+
+  // representations with the same bandwidth keep their order from the MPD
+  std::stable_sort(m_representations.begin(), m_representations.end(), CompareBandwidth);
+
+  for (std::vector<Representation>::iterator it = m_representations.begin(); it != m_representations.end(); ++it)
+  {
+    const std::vector<std::string>& dependencyIds = it->rep->GetDependencyId();
+    for (std::vector<std::string>::const_iterator dep = dependencyIds.begin(); dep != dependencyIds.end(); ++dep)
+    {
+      std::map<std::string, IRepresentation*>::iterator found = repsById.find(*dep);
+      if (found == repsById.end())
+      {
+        NS_LOG_WARN("Representation " << it->id << " depends on unknown representation " << *dep);
+        continue;
+      }
+      it->dependencies.push_back(found->second);
+    }
+
+    if (dependencyIds.size() > 0)
+      m_isLayered = true;
+  }
+
+  if (m_representations.empty())
+    return;
+
+  // we assume that all representations have the same segments
+  IRepresentation* rep = m_representations.front().rep;
+  m_segmentDuration = dash::player::GetSegmentDuration(rep);
+  if (dash::player::HasSegmentTemplate(rep))
+  {
+    double duration = ParseDuration(mpd->GetMediaPresentationDuration());
+    if (m_segmentDuration > 0.0)
+      m_nSegments = (uint32_t) std::ceil(duration / m_segmentDuration);
+  }
+  else
+  {
+    m_nSegments = dash::player::GetNumberOfListedSegments(rep);
+  }
+}
+
+DashMpd::~DashMpd()
+{
+  NS_LOG_FUNCTION(this);
+  DashMpdRegistry::Unregister(this);
+  delete m_mpd;
+}
+
+IMPD*
+DashMpd::GetMpd() const
+{
+  return m_mpd;
+}
+
+IAdaptationSet*
+DashMpd::GetAdaptationSet() const
+{
+  return m_adaptationSet;
+}
+
+const std::vector<DashMpd::Representation>&
+DashMpd::GetRepresentations() const
+{
+  return m_representations;
+}
+
+const DashMpd::Representation*
+DashMpd::FindRepresentation(const std::string& id) const
+{
+  for (std::vector<Representation>::const_iterator it = m_representations.begin(); it != m_representations.end(); ++it)
+  {
+    if (it->id == id)
+      return &(*it);
+  }
+  return NULL;
+}
+
+bool
+DashMpd::IsLayered() const
+{
+  return m_isLayered;
+}
+
+uint32_t
+DashMpd::GetNSegments() const
+{
+  return m_nSegments;
+}
+
+double
+DashMpd::GetSegmentDuration() const
+{
+  return m_segmentDuration;
+}
+
+
+Ptr<DashMpd>
+DashMpdRegistry::Get(const std::string& url, const std::string& content)
+{
+  std::map<std::string, DashMpd*>::iterator byUrl = MpdsByUrl()->find(url);
+  if (byUrl != MpdsByUrl()->end())
+    return Ptr<DashMpd>(byUrl->second);
+
+  NS_LOG_FUNCTION(url << content.size());
+
+  // the mpd might be gziped, if not, we use it as is
+  std::string xml;
+  try
+  {
+    xml = zlib_decompress_string(content);
+  }
+  catch(std::exception& e)
+  {
+    NS_LOG_DEBUG(e.what() << " Assuming file was not zipped!");
+    xml = content;
+  }
+
+  uint64_t hash = HashContent(xml);
+  std::map<uint64_t, DashMpd*>::iterator byContent = MpdsByContent()->find(hash);
+  if (byContent != MpdsByContent()->end() && byContent->second->m_content == xml)
+  {
+    NS_LOG_DEBUG("MPD " << url << " has the same content as " << byContent->second->m_urls.at(0));
+    byContent->second->m_urls.push_back(url);
+    (*MpdsByUrl())[url] = byContent->second;
+    return Ptr<DashMpd>(byContent->second);
+  }
+
+  dash::IDASHManager *manager = CreateDashManager();
+  IMPD* parsed = manager->OpenBuffer(xml.data(), xml.size(), url.c_str());
+
+  // We don't need the manager anymore...
+  manager->Delete();
+
+  if (parsed == NULL)
+    return 0;
+
+  Ptr<DashMpd> mpd = Ptr<DashMpd>(new DashMpd(parsed, xml, hash), false);
+  mpd->m_urls.push_back(url);
+  (*MpdsByUrl())[url] = PeekPointer(mpd);
+  // on a hash collision the MPD already registered keeps the content slot
+  if (byContent == MpdsByContent()->end())
+    (*MpdsByContent())[hash] = PeekPointer(mpd);
+  return mpd;
+}
+
+uint32_t
+DashMpdRegistry::GetNMpds()
+{
+  // count distinct MPDs, an MPD whose hash collided is only registered by URL
+  std::set<DashMpd*> mpds;
+  for (std::map<std::string, DashMpd*>::iterator it = MpdsByUrl()->begin(); it != MpdsByUrl()->end(); ++it)
+    mpds.insert(it->second);
+  return mpds.size();
+}
+
+void
+DashMpdRegistry::Unregister(DashMpd* mpd)
+{
+  for (std::vector<std::string>::iterator it = mpd->m_urls.begin(); it != mpd->m_urls.end(); ++it)
+    MpdsByUrl()->erase(*it);
+  std::map<uint64_t, DashMpd*>::iterator byContent = MpdsByContent()->find(mpd->m_contentHash);
+  if (byContent != MpdsByContent()->end() && byContent->second == mpd)
+    MpdsByContent()->erase(byContent);
+}
+
+} // namespace ns3
@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DASH_MPD_REGISTRY_H
+#define DASH_MPD_REGISTRY_H
+
+#include <string>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include "libdash.h"
+
+
+namespace ns3 {
+
+/**
+ * @ingroup http-apps
+ * @brief A parsed MPD and the representation table of its (first) adaptation set
+ *
+ * Instances are obtained from DashMpdRegistry and shared by all consumers streaming
+ * the same MPD, they must be treated as read-only.
+ */
+class DashMpd : public SimpleRefCount<DashMpd>
+{
+public:
+  struct Representation
+  {
+    dash::mpd::IRepresentation* rep;
+    std::string id;
+    uint32_t bandwidth;
+    uint32_t width;
+    uint32_t height;
+    std::vector<dash::mpd::IRepresentation*> dependencies; ///< \brief the representations listed in dependencyId
+  };
+
+  ~DashMpd();
+
+  dash::mpd::IMPD*
+  GetMpd() const;
+
+  /// \brief the first adaptation set of the first period, NULL if there is none
+  dash::mpd::IAdaptationSet*
+  GetAdaptationSet() const;
+
+  /// \brief all representations of the adaptation set, sorted by bandwidth (ascending)
+  const std::vector<Representation>&
+  GetRepresentations() const;
+
+  /// \brief the representation with the given id, NULL if there is none
+  const Representation*
+  FindRepresentation(const std::string& id) const;
+
+  /// \brief whether any representation depends on another one (e.g., SVC)
+  bool
+  IsLayered() const;
+
+  /**
+   * \brief number of segments of each representation
+   *
+   * Taken from the SegmentList, or for a SegmentTemplate, derived from the
+   * mediaPresentationDuration of the MPD and the segment duration.
+   */
+  uint32_t
+  GetNSegments() const;
+
+  /// \brief duration of one segment in seconds
+  double
+  GetSegmentDuration() const;
+
+private:
+  friend class DashMpdRegistry;
+
+  DashMpd(dash::mpd::IMPD* mpd, const std::string& content, uint64_t contentHash);
+
+  dash::mpd::IMPD* m_mpd;
+  dash::mpd::IAdaptationSet* m_adaptationSet;
+  std::vector<Representation> m_representations;
+  bool m_isLayered;
+  uint32_t m_nSegments;
+  double m_segmentDuration;
+
+  std::string m_content; ///< \brief the decompressed document, to rule out hash collisions
+  uint64_t m_contentHash;
+  std::vector<std::string> m_urls; ///< \brief the URLs this MPD is registered under
+};
+
+
+/**
+ * @ingroup http-apps
+ * @brief Process-wide registry of parsed MPDs
+ *
+ * MPDs are looked up by URL, or by a hash of the (decompressed) document if the same
+ * content was already received under another URL. The registry does not hold a reference
+ * itself, an MPD is released once the last consumer using it drops its pointer.
+ */
+class DashMpdRegistry
+{
+public:
+  /**
+   * \brief Get the MPD downloaded from url
+   * \param url the URL the MPD was requested from
+   * \param content the body of the response, either gziped or plain XML
+   * \returns the shared MPD, or 0 if content could not be parsed
+   */
+  static Ptr<DashMpd>
+  Get(const std::string& url, const std::string& content);
+
+  /// \brief number of MPDs currently alive
+  static uint32_t
+  GetNMpds();
+
+private:
+  friend class DashMpd;
+
+  static void
+  Unregister(DashMpd* mpd);
+};
+
+} // namespace ns3
+
+#endif // DASH_MPD_REGISTRY_H
@@ -36,6 +36,11 @@ DASHPlayerTracer::InstallAll(const std::string& file)
 {
   using namespace std;
 
+  if (BinaryTraceFile::IsBinaryFileName(file)) {
+    Install(NodeContainer::GetGlobal(), boost::shared_ptr<BinaryTraceFile>(new BinaryTraceFile(file)));
+    return;
+  }
+
   std::list< Ptr< DASHPlayerTracer > > tracers;
 
   boost::shared_ptr<std::ofstream> os(new std::ofstream());
@@ -66,6 +71,11 @@ DASHPlayerTracer::Install(const NodeContainer& nodes, const std::string& file)
 {
   using namespace std;
 
+  if (BinaryTraceFile::IsBinaryFileName(file)) {
+    Install(nodes, boost::shared_ptr<BinaryTraceFile>(new BinaryTraceFile(file)));
+    return;
+  }
+
   std::list< Ptr< DASHPlayerTracer > > tracers;
 
 
@@ -98,6 +108,11 @@ DASHPlayerTracer::Install(Ptr<Node> node, const std::string& file)
 {
   using namespace std;
 
+  if (BinaryTraceFile::IsBinaryFileName(file)) {
+    Install(NodeContainer(node), boost::shared_ptr<BinaryTraceFile>(new BinaryTraceFile(file)));
+    return;
+  }
+
   std::list< Ptr< DASHPlayerTracer > > tracers;
 
   boost::shared_ptr<std::ofstream> os(new std::ofstream());
@@ -128,6 +143,27 @@ DASHPlayerTracer::Install(Ptr<Node> node, boost::shared_ptr<std::ofstream> outpu
   return trace;
 }
 
+void
+DASHPlayerTracer::Install(const NodeContainer& nodes, boost::shared_ptr<BinaryTraceFile> trace)
+{
+  if (!trace->IsOpen()) {
+    NS_LOG_ERROR("Binary trace file cannot be opened for writing. Tracing disabled");
+    return;
+  }
+
+  for (NodeContainer::Iterator node = nodes.Begin(); node != nodes.End(); node++) {
+    m_allTracers.push_back(Install(*node, trace));
+  }
+}
+
+Ptr<DASHPlayerTracer>
+DASHPlayerTracer::Install(Ptr<Node> node, boost::shared_ptr<BinaryTraceFile> trace)
+{
+  NS_LOG_DEBUG("Node: " << node->GetId());
+
+  return CreateObject<DASHPlayerTracer>(trace, node);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
@@ -159,9 +195,30 @@ DASHPlayerTracer::DASHPlayerTracer(boost::shared_ptr<std::ofstream> os, const st
   Connect();
 }
 
+DASHPlayerTracer::DASHPlayerTracer(boost::shared_ptr<BinaryTraceFile> trace, Ptr<Node> node)
+  : m_nodePtr(node)
+  , m_trace(trace)
+{
+  std::stringstream node_id_str;
+  node_id_str << m_nodePtr->GetId();
+
+  m_node = node_id_str.str();
+  m_nodeIndex = m_trace->Intern(m_node);
+
+  if (node->GetNApplications() == 1)
+  {
+    node->GetApplication(0)->TraceConnectWithoutContext ("PlayerTracer", MakeCallback(&DASHPlayerTracer::ConsumeStats,
+                                             this));
+  } else {
+    Connect();
+  }
+}
+
 DASHPlayerTracer::~DASHPlayerTracer()
 {
-  m_os->close();
+  // the binary trace file is flushed and closed once its last tracer is gone
+  if (m_os)
+    m_os->close();
 };
 
 void
@@ -174,7 +231,7 @@ DASHPlayerTracer::Connect()
 }
 
 void
-DASHPlayerTracer::PrintHeader(std::ofstream& os) const
+DASHPlayerTracer::PrintHeader(std::ostream& os)
 {
   os << "Time"
      << ","
@@ -195,29 +252,37 @@ DASHPlayerTracer::PrintHeader(std::ofstream& os) const
      << "SegmentDepIds"*/;
 }
 
+void
+DASHPlayerTracer::PrintRecord(std::ostream& os, const Record& record, const std::string& node,
+                              const std::string& representationId)
+{
+  os << record.time << "," << node << "," << record.userId << "," << record.videoId << ","
+     << record.segmentNr << "," << representationId << ","
+     << record.segmentExperiencedBitrate << "," << record.bufferLevel << "," << record.stallingTime << "\n";
+}
+
 void
 DASHPlayerTracer::ConsumeStats(Ptr<ns3::Application> app, unsigned int userId, unsigned int videoId,
                                unsigned int segmentNr, std::string representationId,
                                unsigned int segmentExperiencedBitrate,
-                               unsigned int stallingTime, unsigned int bufferLevel/*,
-                               std::vector<std::string> dependencyIds*/)
+                               unsigned int stallingTime, unsigned int bufferLevel)
 {
-  std::string depIdStr = "";
-
-  //Vitalii: removed that
-  /*
-  for(std::vector<std::string>::iterator it = dependencyIds.begin(); it != dependencyIds.end(); it++ )
-  {
-    if(depIdStr.compare ("") == 0)
-      depIdStr.append(*it);
-    else
-      depIdStr.append (","+*it);
+  Record record;
+  record.time = Simulator::Now().ToDouble(Time::S);
+  record.userId = userId;
+  record.videoId = videoId;
+  record.segmentNr = segmentNr;
+  record.segmentExperiencedBitrate = segmentExperiencedBitrate;
+  record.bufferLevel = bufferLevel;
+  record.stallingTime = stallingTime;
+
+  if (m_trace) {
+    record.node = m_nodeIndex;
+    record.representationId = m_trace->Intern(representationId);
+    m_trace->Write(RECORD_TYPE, &record, sizeof(record));
+  } else {
+    PrintRecord(*m_os, record, m_node, representationId);
   }
-  */
-
-  (*m_os) << Simulator::Now().ToDouble(Time::S) << "," << m_node << "," << userId << "," << videoId << ","/*<< app->GetId() << "\t"*/
-        << segmentNr << "," << representationId << ","
-        << segmentExperiencedBitrate << "," << bufferLevel << "," << stallingTime /*<< "," << depIdStr*/ << "\n";
 }
 
 
@@ -11,9 +11,12 @@
 #include "ns3/event-id.h"
 #include "ns3/core-module.h"
 #include "ns3/trace-source-accessor.h"
+#include "binary-trace-file.h"
 
 #include <boost/shared_ptr.hpp>
 
+#include <ostream>
+
 
 using namespace std;
 
@@ -29,13 +32,35 @@ class Packet;
  */
 class DASHPlayerTracer : public ns3::Object {
 public:
+  /**
+   * @brief Type of the records in binary trace files
+   */
+  static const uint8_t RECORD_TYPE = 1;
+
+  /**
+   * @brief Binary record of a consumed segment, strings are indices of interned strings
+   */
+  struct Record
+  {
+    double time;
+    uint32_t node;
+    uint32_t userId;
+    uint32_t videoId;
+    uint32_t segmentNr;
+    uint32_t representationId;
+    uint32_t segmentExperiencedBitrate;
+    uint32_t bufferLevel;
+    uint32_t stallingTime;
+  };
+
   static void
   Destroy();
 
   /**
    * @brief Helper method to install tracers on all simulation nodes
    *
-   * @param file File to which traces will be written.  If filename is -, then std::out is used
+   * @param file File to which traces will be written.  If filename is -, then std::out is used.
+   *             If filename ends with .bin, binary records are written (see BinaryTraceFile)
    *
    * @returns a tuple of reference to output stream and list of tracers. !!! Attention !!! This
    *tuple needs to be preserved
@@ -90,6 +115,15 @@ public:
   static Ptr<DASHPlayerTracer>
   Install(Ptr<Node> node, boost::shared_ptr<std::ofstream> os);
 
+  /**
+   * @brief Helper method to install a tracer writing binary records on a specific simulation node
+   *
+   * @param node  Node on which to install tracer
+   * @param trace Binary trace file, shared by the tracers of all nodes
+   */
+  static Ptr<DASHPlayerTracer>
+  Install(Ptr<Node> node, boost::shared_ptr<BinaryTraceFile> trace);
+
   /**
    * @brief Trace constructor that attaches to all applications on the node using node's pointer
    * @param os    reference to the output stream
@@ -104,6 +138,13 @@ public:
    */
   DASHPlayerTracer(boost::shared_ptr<std::ofstream> os, const std::string& node);
 
+  /**
+   * @brief Trace constructor that writes binary records of all applications on the node
+   * @param trace binary trace file
+   * @param node  pointer to the node
+   */
+  DASHPlayerTracer(boost::shared_ptr<BinaryTraceFile> trace, Ptr<Node> node);
+
   /**
    * @brief Destructor
    */
@@ -114,10 +155,22 @@ public:
    *
    * @param os reference to output stream
    */
-  void
-  PrintHeader(std::ofstream& os) const;
+  static void
+  PrintHeader(std::ostream& os);
+
+  /**
+   * @brief Print a record as a line of the text trace
+   *
+   * @param node             name or id of the node
+   * @param representationId id of the representation of the segment
+   */
+  static void
+  PrintRecord(std::ostream& os, const Record& record, const std::string& node, const std::string& representationId);
 
 private:
+  static void
+  Install(const NodeContainer& nodes, boost::shared_ptr<BinaryTraceFile> trace);
+
   void
   Connect();
 
@@ -132,6 +185,8 @@ private:
   Ptr<Node> m_nodePtr;
 
   boost::shared_ptr<std::ofstream> m_os;
+  boost::shared_ptr<BinaryTraceFile> m_trace;
+  uint32_t m_nodeIndex; //!< interned name of the node in m_trace
 
 };
 
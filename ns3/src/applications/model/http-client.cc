@@ -85,6 +85,10 @@ HttpClientApplication::GetTypeId (void)
                    StringValue(""),
                    MakeStringAccessor(&HttpClientApplication::m_outFile),
                    MakeStringChecker())
+    .AddAttribute("KeepContent", "Keep the downloaded file in memory, see m_content (default: false)",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&HttpClientApplication::m_keepContent),
+                   MakeBooleanChecker())
     .AddAttribute("KeepAlive", "Whether or not the connection should be re-used every time (default: false)",
                    BooleanValue(false),
                    MakeBooleanAccessor(&HttpClientApplication::m_keepAlive),
@@ -109,7 +113,13 @@ HttpClientApplication::HttpClientApplication ()
   m_socket = 0;
   lastDownloadBitrate = -1;
 
-  _tmpbuffer = NULL; // init this thing
+  m_active = false;
+  m_currentState = TcpSocket::CLOSED;
+  m_sentGetRequest = false;
+  m_finished_download = false;
+
+  m_keepContent = false;
+  m_responseParser.SetBodyCallback (MakeCallback (&HttpClientApplication::OnBodyReceived, this));
 
   m_tried_connecting = 0;
   m_success_connecting = 0;
@@ -120,12 +130,6 @@ HttpClientApplication::~HttpClientApplication()
 {
   NS_LOG_FUNCTION (this);
   //m_socket = 0;
-
-  if (_tmpbuffer != NULL)
-  {
-   ///fprintf(stderr, "tmpbuffer is still not empty...\n");
-    free(_tmpbuffer);
-  }
 }
 
 double
@@ -224,11 +228,11 @@ HttpClientApplication::TryEstablishConnection (void)
       if (Ipv4Address::IsMatchingType(m_peerAddress) == true)
       {
         m_socket->Bind();
-        int errno = m_socket->Connect (InetSocketAddress (Ipv4Address::ConvertFrom(m_peerAddress), m_peerPort));
+        int ret = m_socket->Connect (InetSocketAddress (Ipv4Address::ConvertFrom(m_peerAddress), m_peerPort));
         m_socket->SetFlowId(0);
         m_socket->SetDupAckThresh(0);
 
-        NS_LOG_DEBUG("Binding to Ipv4:" << Ipv4Address::ConvertFrom(m_peerAddress) << ":" << m_peerPort << ", errno=" << errno);
+        NS_LOG_DEBUG("Binding to Ipv4:" << Ipv4Address::ConvertFrom(m_peerAddress) << ":" << m_peerPort << ", ret=" << ret);
 
       }
       else if (Ipv6Address::IsMatchingType(m_peerAddress) == true)
@@ -274,25 +278,11 @@ HttpClientApplication::StartApplication (void)
 {
   NS_LOG_FUNCTION (this);
 
-  // only re-init tmpbuffer if it is null
-  if (_tmpbuffer == NULL)
-  {
-    _tmpbuffer = (uint8_t*)malloc(sizeof(uint8_t)* 128*1024); // 128 kB
-  }
-
-
   // mark this app as active
   m_active = true;
   _start_time = Simulator::Now ().GetMilliSeconds ();
 
-  // Create OutFile
-  if (!m_outFile.empty())
-  {
-   ///fprintf(stderr, "Client(%d): Creating outfile %s\n", node_id, m_outFile.c_str());
-    // (re)create outfile
-    FILE* fp = fopen(m_outFile.c_str(), "w");
-    fclose(fp);
-  }
+  PrepareContent();
 
  ///fprintf(stderr, "Establishing connection (time=%f)...\n",Simulator::Now().GetSeconds());
   TryEstablishConnection();
@@ -303,6 +293,20 @@ HttpClientApplication::StartApplication (void)
   //ReportStats();
 }
 
+void
+HttpClientApplication::PrepareContent (void)
+{
+  // (re)create the outfile, it stays open (and buffered) until the application stops
+  if (!m_outFile.empty())
+  {
+    if (m_outStream.is_open())
+      m_outStream.close();
+    m_outStream.open(m_outFile.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+  }
+
+  m_content.clear();
+}
+
 void
 HttpClientApplication::ReportStats()
 {
@@ -312,19 +316,6 @@ HttpClientApplication::ReportStats()
 
   m_currentStatsTrace(this, this->m_fileToRequest, bytes_recv_last_timespan);
 
-
-  std::stringstream cwnd_trace_filename;
-  cwnd_trace_filename << "traces/cwnd_" << node_id << ".csv";
-
-  FILE* fp = fopen(cwnd_trace_filename.str().c_str(), "a");
-
- ///fprintf(fp, "Client(%d):Time=%f,bytes_recv=%d,bytes_sent=%d,cwnd=%d;finished_download=%d-%ld;tried_connect=%d;failed_connect=%d;success_connect=%d\n",
-      // node_id, Simulator::Now().GetSeconds(), bytes_recv_last_timespan, bytes_sent_last_timespan, cur_cwnd, m_finished_download, _finished_time, m_tried_connecting, m_failed_connecting, m_success_connecting);
-
-
-          fclose(fp);
-
-
   m_lastStatsReportedBytesRecv = m_bytesRecv;
   m_lastStatsReportedBytesSent = m_bytesSent;
 
@@ -366,16 +357,16 @@ HttpClientApplication::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-
-  if (_tmpbuffer != NULL)
-  {
-    free(_tmpbuffer);
-    _tmpbuffer = NULL;
-  }
+  if (m_outStream.is_open())
+    m_outStream.close();
 
   m_active = false;
 
-  if (m_socket != 0 && !m_keepAlive)
+  // responses still to come would be taken for the reply to the next request, so the connection cannot be reused
+  bool responsesPending = !m_finished_download || !m_pipelinedRequests.empty();
+  m_pipelinedRequests.clear();
+
+  if (m_socket != 0 && (!m_keepAlive || responsesPending))
   {
    ///fprintf(stderr, "Client(%d): Socket is open, closing it...\n", node_id);
     m_socket->Close ();
@@ -442,10 +433,22 @@ HttpClientApplication::DoSendGetRequest (Ptr<Socket> s, uint32_t txSpace)
 
   m_downloadStartedTrace(this, this->m_fileToRequest);
 
+  m_responseParser.Reset();
+
+  if (m_currentState != 0)
+    SendGetRequest (localSocket, m_fileToRequest);
+  else
+    StopApplication ();
+}
+
+
+void
+HttpClientApplication::SendGetRequest (Ptr<MpTcpSocketBase> localSocket, const std::string& fileToRequest)
+{
   // Create HTTP 1.1 compatible request
   std::stringstream requestSS;
- ///fprintf(stderr, "Client(%d, %f): Executing  'GET %s'\n", node_id, Simulator::Now().GetSeconds(), m_fileToRequest.c_str());
-  requestSS << "GET " << m_fileToRequest << " HTTP/1.1" << CRLF;
+ ///fprintf(stderr, "Client(%d, %f): Executing  'GET %s'\n", node_id, Simulator::Now().GetSeconds(), fileToRequest.c_str());
+  requestSS << "GET " << fileToRequest << " HTTP/1.1" << CRLF;
   requestSS << "Host: " << m_hostName << CRLF;
   //requestSS << "Pragma: no-cache" << CRLF;
   //requestSS << "Cache-Control: no-cache" << CRLF;
@@ -464,9 +467,6 @@ HttpClientApplication::DoSendGetRequest (Ptr<Socket> s, uint32_t txSpace)
   requestSS << CRLF;
 
 
-  m_is_first_packet = true;
-
-
   std::string requestString = requestSS.str();
   //fprintf(stderr, "Creating Request String:\n%s\n------------\n", requestString.c_str());
 
@@ -483,13 +483,8 @@ HttpClientApplication::DoSendGetRequest (Ptr<Socket> s, uint32_t txSpace)
   // so that tags added to the packet can be sent as well
   m_txTrace (p);
   // localSocket->MpTcpSocketBase::Send (p);
-  if (m_currentState != 0)
-  {
-    localSocket->MpTcpSocketBase::FillBuffer (buffer, requestString.length());
-    localSocket->MpTcpSocketBase::SendBufferedData ();
-  }
-  else
-    StopApplication ();
+  localSocket->MpTcpSocketBase::FillBuffer (buffer, requestString.length());
+  localSocket->MpTcpSocketBase::SendBufferedData ();
 
   m_bytesSent += requestString.length();
 
@@ -512,111 +507,54 @@ HttpClientApplication::DoSendGetRequest (Ptr<Socket> s, uint32_t txSpace)
 }
 
 
-void
-HttpClientApplication::CancelDownload()
+bool
+HttpClientApplication::CanPipelineRequest () const
 {
-  // next time the client receives something, we cancel the socket
-  do_cancel_socket = true;
+  return m_active && m_keepAlive && m_socket != 0 && m_currentState == TcpSocket::ESTABLISHED
+         && m_sentGetRequest && !m_finished_download;
 }
 
 
-uint32_t
-HttpClientApplication::ParseResponseHeader(const uint8_t* buffer, size_t len, int* realStatusCode, unsigned int* contentLength)
+bool
+HttpClientApplication::PipelineRequest (const std::string& fileToRequest)
 {
-/*
-  HTTP/1.1 200 OKCRLF
-  Content-Type: text/xml; charset=utf-8CRLF
-  Content-Length: {len}CRLFCRLF;
-  */
-
-  NS_LOG_DEBUG ("Client("<<node_id<<"): Parsing Response Header of length " << len);
-  const char* strbuffer = (const char*) buffer;
+  NS_LOG_FUNCTION (this << fileToRequest);
 
-  //fprintf(stderr, "header=\n%s\n", buffer);
+  if (!CanPipelineRequest())
+    return false;
 
-  // should start with a HTTP response
-  if (strncmp(strbuffer, "HTTP/1.1",8) == 0)
-  {
-    const char* statusCode = &strbuffer[9];
-    // find next space
-    char needle[2];
-    needle[0] = ' ';
-    needle[1] = '\0';
-    const char *p = strstr(statusCode, (const char*)needle);
-    if (p)
-    {
-      int pos = p - statusCode;
-
-      char actualStatusCode[4];
-
-      strncpy(actualStatusCode, statusCode,pos);
-      actualStatusCode[3] = '\0';
+  m_downloadStartedTrace(this, fileToRequest);
+  m_pipelinedRequests.push_back(fileToRequest);
+  SendGetRequest(m_socket, fileToRequest);
+  return true;
+}
 
-      int iStatusCode = atoi(actualStatusCode);
 
-      if (iStatusCode == 404)
-      {
-       ///fprintf(stderr, "Client(%d): ParseHeader: Status Code 404, not found!\n", node_id);
-      } else
-      {
-        // find Content-Length
-        char needle2[17];
-        strcpy(needle2, "Content-Length: ");
-        needle2[16] = '\0';
-        p = strstr(statusCode, needle2);
-
-        if (p)
-        {
-          const char* strContentLength = &statusCode[p-statusCode+16];
-
-          p = strstr(strContentLength, "\r\n");
-          if (p)
-          {
-            pos = p - strContentLength;
-            char actualContentLength[12];
-            strncpy(actualContentLength,strContentLength,pos);
-            unsigned int iActualContentLength = atoi(actualContentLength);
-
-
-            // find the end of the header, where the body content begins
-            p = strstr(strbuffer, "\r\n\r\n");
-
-            if (p)
-            {
-              // done!
-              *realStatusCode = iStatusCode;
-              *contentLength = iActualContentLength;
-
-              pos = p - strbuffer;
-              return pos+4; // +4 to skip CRLFCRLF
-            } else {
-             ///fprintf(stderr, "ERROR: could not find where body begins\n");
-            }
-          }
-          else
-          {
-           ///fprintf(stderr, "ERROR: No CRLF found?!?\n");
-          }
-
-        } else
-        {
-         ///fprintf(stderr, "ERROR: Server did not reply Content-Length Header field\n");
-        }
-      }
+bool
+HttpClientApplication::StartPipelinedResponse ()
+{
+  if (m_pipelinedRequests.empty() || !m_active)
+    return false;
 
-    } else
-    {
-     ///fprintf(stderr, "Invalid HTTP Response, %s\n", strbuffer);
-    }
+  m_fileToRequest = m_pipelinedRequests.front();
+  m_pipelinedRequests.pop_front();
+  NS_LOG_DEBUG("Client(" << node_id << "): Receiving pipelined response for " << m_fileToRequest);
 
-  } else
-  {
-   ///fprintf(stderr, "Not sure what this response header means\n");
-   ///fprintf(stderr, "Result=%s\n", strbuffer);
-  }
+  m_responseParser.Reset();
+  m_finished_download = false;
+  m_bytesRecv = 0;
+  // the server starts sending this response right after the previous one
+  _start_time = Simulator::Now ().GetMilliSeconds ();
+  PrepareContent();
+  return true;
+}
 
 
-  return 0;
+void
+HttpClientApplication::CancelDownload()
+{
+  // next time the client receives something, we cancel the socket
+  do_cancel_socket = true;
 }
 
 
@@ -643,6 +581,13 @@ HttpClientApplication::OnFileReceived(unsigned status, unsigned length)
 }
 
 
+void
+HttpClientApplication::OnHeaderReceived(unsigned status, unsigned length)
+{
+  m_headerReceivedTrace(this, this->m_fileToRequest, length);
+}
+
+
 void
 HttpClientApplication::ForceCloseSocket()
 {
@@ -669,85 +614,63 @@ HttpClientApplication::HandleRead (Ptr<Socket> s)
   }
 
   Ptr<Packet> packet;
-  Address from;
-
-  uint32_t bytes_recv_this_time = 0;
 
   while ((packet = socket->Recv ()) && (packet->GetSize() != 0)) // Vitalii: before mptcp it was while (true)
   {
-    // packet = socket->RecvFrom (from);
-
-    if (!(packet))
-    {
-      break;
-    }
-
-
-    packet->RemoveAllPacketTags ();
-    packet->RemoveAllByteTags ();
-    // PARSE PACKET
-    size_t packet_size = packet->CopyData(_tmpbuffer, packet->GetSize());
-    _tmpbuffer[packet_size] = '\0';
-
-    // NS_LOG_UNCOND ("\n\nsize: " << packet_size << " |" << _tmpbuffer << "|\n");
-
-    bytes_recv_this_time += packet_size;
-
-    if (m_is_first_packet)
+    // a packet can hold the end of one response and the start of the next pipelined one
+    uint32_t offset = 0;
+    while (offset < packet->GetSize())
     {
-      m_is_first_packet = false;
-      // parse header
-      int status_code = 0;
-      int where = ParseResponseHeader(_tmpbuffer, packet_size, &status_code, &(this->requested_content_length));
-      //fprintf(stderr, "content starts at position %d, with length %d (status code %d)\n", where, requested_content_length, status_code);
-      m_bytesRecv += packet_size - where;
+      bool hadHeader = m_responseParser.HasHeader();
 
-      m_headerReceivedTrace(this, this->m_fileToRequest, requested_content_length);
+      // only the header is copied out of the packet, the body is passed on to OnBodyReceived
+      offset += m_responseParser.Feed(packet, offset);
 
-      // write to file
-      if (!m_outFile.empty())
+      if (!hadHeader && m_responseParser.HasHeader())
       {
-        // open outfile to append
-        FILE* fp = fopen(m_outFile.c_str(), "a");
+        requested_content_length = m_responseParser.GetContentLength();
 
-        fwrite(&_tmpbuffer[where], sizeof(uint8_t), packet_size-where, fp);
+        if (m_keepContent)
+          m_content.reserve(requested_content_length);
 
-        fclose(fp);
+        OnHeaderReceived(m_responseParser.GetStatusCode(), requested_content_length);
       }
 
-
-    } else {
-      m_bytesRecv += packet_size;
-
-      // write to file
-      if (!m_outFile.empty())
+      if (m_responseParser.HasError())
       {
-        // open outfile to append
-        FILE* fp = fopen(m_outFile.c_str(), "a");
+        NS_LOG_WARN("Client(" << node_id << "): Invalid response for " << m_fileToRequest);
+        return;
+      }
 
-        fwrite(_tmpbuffer, sizeof(uint8_t), packet_size, fp);
+      // we have received the whole file!
+      if (m_responseParser.IsComplete())
+      {
+        NS_LOG_DEBUG("All bytes received, this means we are done...");
+        requested_content_length = m_bytesRecv;
+        OnFileReceived(m_responseParser.GetStatusCode(), requested_content_length);
 
-        fclose(fp);
+        if (!StartPipelinedResponse())
+          return;
       }
     }
-    
-    // we have received the whole file!
-    if (m_bytesRecv == requested_content_length)
-    {
-      NS_LOG_DEBUG("All bytes received, this means we are done...");
-      OnFileReceived(0, requested_content_length);
-      // break;
-      return;
-    }
-    else if (m_bytesRecv > requested_content_length)
-    {
-     ///fprintf(stderr, "Client(%d)::HandleRead(time=%f) Expected only %d bytes, but received already %d bytes\n",
-        // node_id, Simulator::Now().GetSeconds(), requested_content_length, m_bytesRecv);
-    }
-
   }
+}
+
 
-  //fprintf(stderr, "Client(%d)::HandleRead(time=%f) handled %d bytes this time\n", node_id, Simulator::Now().GetSeconds(), bytes_recv_this_time);
+void
+HttpClientApplication::OnBodyReceived (Ptr<const Packet> body)
+{
+  m_bytesRecv += body->GetSize();
+
+  if (m_outStream.is_open())
+    body->CopyData(&m_outStream, body->GetSize());
+
+  if (m_keepContent)
+  {
+    size_t offset = m_content.size();
+    m_content.resize(offset + body->GetSize());
+    body->CopyData((uint8_t*) &m_content[offset], body->GetSize());
+  }
 }
 
 } // Namespace ns3
@@ -32,6 +32,10 @@
 #include "ns3/tcp-socket.h"
 #include "ns3/mp-tcp-socket-base.h"
 
+#include "http-response-parser.h"
+
+#include <deque>
+#include <fstream>
 
 
 #define CRLF "\r\n"
@@ -96,6 +100,22 @@ public:
 
   void CancelDownload ();
 
+  /**
+   * \brief Whether PipelineRequest can send another request on the connection right now,
+   * i.e., KeepAlive is set and a response is being received on an established connection
+   */
+  bool CanPipelineRequest () const;
+
+  /**
+   * \brief Request fileToRequest on the same connection before the current response has been received
+   *
+   * Responses arrive in the order of the requests, OnFileReceived is called for each of them
+   * with m_fileToRequest set accordingly. The download time of a pipelined file is measured
+   * from the end of the previous response, when the server starts sending it.
+   * \returns false if no request could be pipelined (see CanPipelineRequest)
+   */
+  bool PipelineRequest (const std::string& fileToRequest);
+
   double GetLastDownloadBandwidth ();
 
   std::string GetRemoteAddress ();
@@ -107,7 +127,6 @@ protected:
   virtual void DoDispose (void);
 
   bool do_cancel_socket;
-  bool m_is_first_packet;
   bool m_has_parsed_response_header;
 
   bool m_finished_download;
@@ -140,14 +159,14 @@ protected: // callbacks/traces
 
   void TryEstablishConnection();
 
+  virtual void OnHeaderReceived(unsigned status, unsigned length);
+
   virtual void OnFileReceived(unsigned status, unsigned length);
 
 
   void ReportStats();
 
 
-  uint32_t ParseResponseHeader (const uint8_t* buffer, size_t len, int* statusCode, unsigned int* contentLength);
-
   void LogStateChange(const  ns3::TcpSocket::TcpStates_t old_state, const  ns3::TcpSocket::TcpStates_t new_state);
 
   void LogCwndChange(uint32_t oldCwnd, uint32_t newCwnd);
@@ -159,6 +178,9 @@ protected: // callbacks/traces
   std::string m_fileToRequest;
   std::string m_hostName; //!< The hostname of the destiatnion server
   std::string m_outFile;
+  std::ofstream m_outStream; //!< m_outFile, open while the application runs
+  bool m_keepContent;
+  std::string m_content; //!< body of the last download if KeepContent is set
 
   bool m_active;
 
@@ -166,7 +188,29 @@ protected: // callbacks/traces
 
 private:
 
-  uint8_t* _tmpbuffer;
+  HttpResponseParser m_responseParser;
+  std::deque<std::string> m_pipelinedRequests; //!< files requested after m_fileToRequest, in order
+
+  /**
+   * \brief (Re)create the outfile and clear m_content for the next download
+   */
+  void PrepareContent ();
+
+  /**
+   * \brief Continue with the response to the oldest pipelined request
+   * \returns false if there is none
+   */
+  bool StartPipelinedResponse ();
+
+  /**
+   * \brief Send a GET request for fileToRequest
+   */
+  void SendGetRequest (Ptr<MpTcpSocketBase> socket, const std::string& fileToRequest);
+
+  /**
+   * \brief Called by m_responseParser with every piece of the response body
+   */
+  void OnBodyReceived (Ptr<const Packet> body);
 
   /**
    * \brief Callback from Socket when ready to send a packet
@@ -0,0 +1,132 @@
+#include "http-content-cache.h"
+
+#include "ns3/log.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+NS_LOG_COMPONENT_DEFINE ("HttpContentCache");
+
+namespace ns3
+{
+
+
+HttpContentCache::HttpContentCache()
+  : m_filesSize(0),
+    m_maxSize(256 << 20)
+{
+}
+
+
+void
+HttpContentCache::SetMaxSize(uint64_t maxSize)
+{
+  NS_LOG_FUNCTION (this << maxSize);
+  m_maxSize = maxSize;
+  Evict();
+}
+
+
+void
+HttpContentCache::Add(const std::string& filename, const std::string& content)
+{
+  NS_LOG_FUNCTION (this << filename << content.size());
+  m_hosted[filename] = Create<Packet> ((const uint8_t*) content.data(), content.size());
+}
+
+
+Ptr<const Packet>
+HttpContentCache::Get(const std::string& filename)
+{
+  std::map<std::string, Ptr<const Packet> >::iterator hosted = m_hosted.find(filename);
+  if (hosted != m_hosted.end())
+  {
+    return hosted->second;
+  }
+
+  std::map<std::string, File>::iterator it = m_files.find(filename);
+  if (it != m_files.end())
+  {
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    return it->second.content;
+  }
+
+  NS_LOG_FUNCTION (this << filename);
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    NS_LOG_INFO ("Could not open '" << filename << "'");
+    return 0;
+  }
+
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) != 0)
+  {
+    close(fd);
+    return 0;
+  }
+
+  Ptr<Packet> content;
+  if (stat_buf.st_size == 0)
+  {
+    content = Create<Packet> ();
+  } else
+  {
+    void* data = mmap(NULL, stat_buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      NS_LOG_INFO ("Could not map '" << filename << "'");
+      close(fd);
+      return 0;
+    }
+    content = Create<Packet> ((const uint8_t*) data, stat_buf.st_size);
+    munmap(data, stat_buf.st_size);
+  }
+  close(fd);
+
+  if (content->GetSize() > m_maxSize)
+  {
+    NS_LOG_INFO ("Not caching '" << filename << "' with size " << content->GetSize());
+    return content;
+  }
+
+  NS_LOG_INFO ("Cached '" << filename << "' with size " << content->GetSize());
+  m_lru.push_front(filename);
+  File& file = m_files[filename];
+  file.content = content;
+  file.lru = m_lru.begin();
+  m_filesSize += content->GetSize();
+  Evict();
+  return content;
+}
+
+
+void
+HttpContentCache::Evict()
+{
+  // connections still sending a dropped file keep their reference to it
+  while (m_filesSize > m_maxSize)
+  {
+    std::map<std::string, File>::iterator it = m_files.find(m_lru.back());
+    NS_LOG_INFO ("Dropping '" << it->first << "' from the cache");
+    m_filesSize -= it->second.content->GetSize();
+    m_files.erase(it);
+    m_lru.pop_back();
+  }
+}
+
+
+void
+HttpContentCache::Clear()
+{
+  m_hosted.clear();
+  m_files.clear();
+  m_lru.clear();
+  m_filesSize = 0;
+}
+
+} // namespace ns3
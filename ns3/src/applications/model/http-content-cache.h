@@ -0,0 +1,69 @@
+#ifndef HTTP_CONTENT_CACHE
+#define HTTP_CONTENT_CACHE
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+
+namespace ns3
+{
+
+/**
+ * \brief Read-only content of the files hosted by a server, shared by all of its connections
+ *
+ * Each file is kept as one packet, connections slice their replies from it with
+ * Packet::CreateFragment, which shares the bytes instead of copying them.
+ * Files on disk are mapped and read on their first request and kept while the
+ * total size of cached files stays below the configured bound, the least recently
+ * requested ones are dropped first. Content added with Add() can not be reloaded
+ * and is never dropped.
+ */
+class HttpContentCache
+{
+public:
+  HttpContentCache();
+
+  /**
+   * \brief Bound the total size of the files loaded from disk, in bytes
+   *
+   * A file larger than the bound is still served, but not kept.
+   */
+  void SetMaxSize(uint64_t maxSize);
+
+  /**
+   * \brief Host content held in memory (e.g., a generated MPD) under filename
+   */
+  void Add(const std::string& filename, const std::string& content);
+
+  /**
+   * \brief Get the content of filename, loading it from disk if it is not cached yet
+   * \returns the content, or 0 if the file could not be read
+   */
+  Ptr<const Packet> Get(const std::string& filename);
+
+  void Clear();
+
+private:
+  void Evict();
+
+  struct File
+  {
+    Ptr<const Packet> content;
+    std::list<std::string>::iterator lru;
+  };
+
+  std::map<std::string, Ptr<const Packet> > m_hosted; ///< content added in memory
+  std::map<std::string, File> m_files; ///< content loaded from disk
+  std::list<std::string> m_lru; ///< files loaded from disk, most recently requested first
+  uint64_t m_filesSize;
+  uint64_t m_maxSize;
+};
+
+} // namespace ns3
+
+
+#endif /* HTTP_CONTENT_CACHE */
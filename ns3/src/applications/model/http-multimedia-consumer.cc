@@ -38,8 +38,6 @@ typedef MultimediaConsumer<HttpClientApplication> HTTPMultimediaConsumer;
 NS_OBJECT_ENSURE_REGISTERED(HTTPMultimediaConsumer);
 
 
-template <typename Parent> std::string MultimediaConsumer<Parent>::alphabet = std::string("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890");
-
 template<class Parent>
 TypeId
 MultimediaConsumer<Parent>::GetTypeId(void)
@@ -79,6 +77,18 @@ MultimediaConsumer<Parent>::GetTypeId(void)
                     MakeDoubleAccessor(&MultimediaConsumer<Parent>::startupDelay), MakeDoubleChecker<double>())
       .template AddAttribute("UserId", "The ID of this user (optional)", UintegerValue(0),
                     MakeUintegerAccessor(&MultimediaConsumer<Parent>::m_userId), MakeUintegerChecker<uint32_t>())
+      .template AddAttribute("EventDrivenPlayback", "Schedule playback, buffering and download retries only when the buffer changes; "
+                          "false polls the buffer every 100 ms while stalled and retries every second (legacy behaviour)", BooleanValue(true),
+                    MakeBooleanAccessor(&MultimediaConsumer<Parent>::m_eventDrivenPlayback), MakeBooleanChecker())
+      .template AddAttribute("PersistentConnection", "Download the MPD and all segments over one keep-alive connection "
+                          "instead of opening a connection per file", BooleanValue(true),
+                    MakeBooleanAccessor(&MultimediaConsumer<Parent>::m_persistentConnection), MakeBooleanChecker())
+      .template AddAttribute("PipelineRequests", "Request the next segments on the persistent connection as soon as the header of "
+                          "the current one arrives, as long as the buffer has room for all of them", BooleanValue(false),
+                    MakeBooleanAccessor(&MultimediaConsumer<Parent>::m_pipelineRequests), MakeBooleanChecker())
+      .template AddAttribute("PipelineDepth", "Maximum number of segments requested behind the one being received if PipelineRequests is set",
+                          UintegerValue(1),
+                    MakeUintegerAccessor(&MultimediaConsumer<Parent>::m_pipelineDepth), MakeUintegerChecker<uint32_t>(1))
       .AddTraceSource("PlayerTracer", "Trace Player consumes of multimedia data",
                       MakeTraceSourceAccessor(&MultimediaConsumer<Parent>::m_playerTracer))
                     ;
@@ -135,19 +145,6 @@ MultimediaConsumer<Parent>::StartApplication() // Called at time specified by St
   }
 
 
-  std::stringstream ss_tempDir;
-  ss_tempDir << "-ns3-node-" << super::node_id ;
-
-  for(int i = 0; i < 8; ++i)
-     ss_tempDir << MultimediaConsumer<Parent>::alphabet[rand()%MultimediaConsumer<Parent>::alphabet.size()];
-
-  m_tempDir = ns3::SystemPath::MakeTemporaryDirectoryName() + ss_tempDir.str();
-
-  NS_LOG_DEBUG("Client(" << super::node_id << "): Temporary Directory: " << m_tempDir);
-  ns3::SystemPath::MakeDirectories(m_tempDir);
-
-  m_tempMpdFile = m_tempDir + "/mpd.xml.gz";
-
   m_mpdParsed = false;
   m_initSegmentIsGlobal = false;
   m_hasInitSegment = false;
@@ -155,8 +152,11 @@ MultimediaConsumer<Parent>::StartApplication() // Called at time specified by St
   m_hasStartedPlaying = false;
   m_freezeStartTime = 0;
   totalConsumedSegments = 0;
+  m_waitingForSegment = false;
+  m_waitingForBuffering = false;
+  m_waitingForDownload = false;
+  m_pipelinedSegments.clear();
   requestedRepresentation = NULL;
-  requestedSegmentURL = NULL;
 
   m_currentDownloadType = MPD;
   m_startTime = Simulator::Now().GetMilliSeconds();
@@ -169,8 +169,9 @@ MultimediaConsumer<Parent>::StartApplication() // Called at time specified by St
           "Could not initialize adaptation logic...");
 
   super::SetAttribute("FileToRequest", StringValue(mpd_request_name));
-  super::SetAttribute("WriteOutfile", StringValue(m_tempMpdFile));
-  super::SetAttribute("KeepAlive", StringValue("true"));
+  super::SetAttribute("WriteOutfile", StringValue(""));
+  super::SetAttribute("KeepContent", BooleanValue(true));
+  super::SetAttribute("KeepAlive", BooleanValue(m_persistentConnection));
 
   // do base stuff
   super::StartApplication();
@@ -194,11 +195,16 @@ MultimediaConsumer<Parent>::StopApplication() // Called at time specified by Sto
   m_downloadEventTimer.Cancel();
   Simulator::Cancel(m_downloadEventTimer);
 
+  m_waitingForSegment = false;
+  m_waitingForBuffering = false;
+  m_waitingForDownload = false;
+  m_pipelinedSegments.clear();
+
   /*OK LOG ALL NOT RECEIVED FILES FROM MPD*/
   if(traceNotDownloadedSegments)
   {
     //check if mpd and player exists
-    if(mpd != NULL && mPlayer != NULL)
+    if(mpd && mPlayer != NULL)
     {
       //first consume everything from buffer
       while(consume() > 0.0);
@@ -215,18 +221,15 @@ MultimediaConsumer<Parent>::StopApplication() // Called at time specified by Sto
   }
 
   // clean up mpd/DASH specific stuff
-  if (mpd != NULL)
-  {
-    delete mpd;
-    mpd = NULL;
-  }
-
   if (mPlayer != NULL)
   {
     delete mPlayer;
     mPlayer = NULL;
   }
 
+  m_availableRepresentations.clear();
+  mpd = 0;
+
 
   // make sure to close the socket, in case it is still open
   super::SetAttribute("KeepAlive", StringValue("false"));
@@ -252,84 +255,24 @@ MultimediaConsumer<Parent>::setMpdUrl (std::string url)
   m_mpdUrl = ss.str ();
 }
 
-template<class Parent>
-bool
-MultimediaConsumer<Parent>::DecompressFile ( std::string source, std::string filename )
-{
-  NS_LOG_FUNCTION(source << filename);
-  std::ifstream infile( source.c_str(), std::ios_base::in | std::ios_base::binary ); //Creates the input stream
-  //Tests if the file is being opened correctly.
-  if ( !infile )
-  {
-   std::cerr<< "Can't open file: " << source << std::endl;
-   return false;
-  }
-
-  // read
-  std::string compressed_str((std::istreambuf_iterator<char>(infile)),
-                 std::istreambuf_iterator<char>());
-
-  try
-  {
-    std::string decompressed = zlib_decompress_string(compressed_str);
-
-    std::ofstream outfile( filename.c_str(), std::ios_base::out |  std::ios_base::binary ); //Creates the output stream
-    outfile << decompressed;
-    outfile.close();
-  }
-  catch(std::exception& e)
-  {
-    //std::cerr << e.what() << std::endl;
-    NS_LOG_DEBUG(e.what() << " Assuming file was not zipped!");
-    return false;
-  }
-
-
-  return true;
-}
-
-
 template<class Parent>
 void
 MultimediaConsumer<Parent>::OnMpdFile()
 {
  ///fprintf(stderr, "Client(%d): On MPD File...\n", super::node_id);
 
-  // check if file was gziped, if not, we use it as is
-  if (m_tempMpdFile.find(".gz") != std::string::npos)
-  {
-    // file was compressed, decompress it
-    NS_LOG_DEBUG("GZIP MPD File " << m_tempMpdFile << " received. Decompressing...");
-    std::string newFileName = m_tempMpdFile.substr(0, m_tempMpdFile.find(".gz"));
-
-    // TODO DECOMPRESS
-    if(DecompressFile(m_tempMpdFile, newFileName))
-      m_tempMpdFile = newFileName;
-  }
-
+  mpd = DashMpdRegistry::Get(m_mpdUrl, super::m_content);
+  super::m_content.clear();
 
-  // NS_LOG_UNCOND("MPD File " << m_tempMpdFile << " received. Parsing now...");
-
-  dash::IDASHManager *manager;
-  manager = CreateDashManager();
-  mpd = manager->Open((char*)m_tempMpdFile.c_str());
-
-  // We don't need the manager anymore...
-  manager->Delete();
-  manager = NULL;
-
-  if (mpd == NULL)
+  if (mpd == 0)
   {
-    NS_LOG_ERROR("Error parsing mpd " << m_tempMpdFile);
+    NS_LOG_ERROR("Error parsing mpd " << m_mpdUrl);
     return;
   }
 
-  // we are assuming there is only 1 period, get the first one
-  IPeriod *currentPeriod = mpd->GetPeriods().at(0);
-
   // get base URLs
   m_baseURL = "";
-  std::vector<dash::mpd::IBaseUrl*> baseUrls = mpd->GetBaseUrls ();
+  std::vector<dash::mpd::IBaseUrl*> baseUrls = mpd->GetMpd()->GetBaseUrls ();
 
   if (baseUrls.size() > 0)
   {
@@ -372,19 +315,15 @@ MultimediaConsumer<Parent>::OnMpdFile()
 
 
 
-  // Get the adaptation sets, though we are only takeing the first one
-  std::vector<IAdaptationSet *> allAdaptationSets = currentPeriod->GetAdaptationSets();
+  // we are assuming there is only 1 period and 1 adaptation set, use the first one
+  IAdaptationSet* adaptationSet = mpd->GetAdaptationSet();
 
-  // we are assuming that allAdaptationSets.size() == 1
-  if (allAdaptationSets.size() == 0)
+  if (adaptationSet == NULL)
   {
     NS_LOG_ERROR("Client(" << super::node_id << "): No adaptation sets found in MPD file... exiting.");
     return;
   }
 
-  // use first adaptation set
-  IAdaptationSet* adaptationSet = allAdaptationSets.at(0);
-
   // check if the adaptation set has an init segment
   // alternatively, the init segment is representation-specific
   NS_LOG_DEBUG("Checking for init segment in adaptation set...");
@@ -411,15 +350,13 @@ MultimediaConsumer<Parent>::OnMpdFile()
 
 
 
-  // get all representations
-  std::vector<IRepresentation*> reps = adaptationSet->GetRepresentation();
+  // get all representations, sorted by bandwidth
+  const std::vector<DashMpd::Representation>& reps = mpd->GetRepresentations();
 
   NS_LOG_DEBUG("Client(" << super::node_id << "): MPD file contains " << reps.size() << " Representations: ");
   NS_LOG_DEBUG("Client(" << super::node_id << "): Start Representation: " << m_startRepresentationId);
 
-    // calculate segment duration
-  // reps.at(0)->GetSegmentList()->GetDuration();
-  NS_LOG_DEBUG("Client(" << super::node_id << "): Period Duration:" << reps.at(0)->GetSegmentList()->GetDuration());
+  NS_LOG_DEBUG("Client(" << super::node_id << "): " << mpd->GetNSegments() << " Segments of " << mpd->GetSegmentDuration() << " s");
 
   bool startRepresentationSelected = false;
 
@@ -434,14 +371,13 @@ MultimediaConsumer<Parent>::OnMpdFile()
 
   m_availableRepresentations.clear();
 
-  std::vector<IRepresentation* >::iterator it;
+  std::vector<DashMpd::Representation>::const_iterator it;
 
-  //for (IRepresentation* rep : reps)
   for (it = reps.begin(); it != reps.end(); ++it)
   {
-    IRepresentation* rep = *it;
-    unsigned int width = rep->GetWidth();
-    unsigned int height = rep->GetHeight();
+    IRepresentation* rep = it->rep;
+    unsigned int width = it->width;
+    unsigned int height = it->height;
 
     // if not allowed to upscale, skip this representation
     if (!m_allowUpscale && width < this->m_screenWidth && height < this->m_screenHeight)
@@ -455,15 +391,15 @@ MultimediaConsumer<Parent>::OnMpdFile()
       continue;
     }
 
-    std::string repId = rep->GetId();
+    const std::string& repId = it->id;
 
     if (firstRepresentationId == "")
       firstRepresentationId = repId;
 
     // else: Use this representation and add it to available representations
-    std::vector<std::string> dependencies = rep->GetDependencyId ();
+    const std::vector<std::string>& dependencies = rep->GetDependencyId ();
 
-    unsigned int requiredDownloadSpeed = rep->GetBandwidth();
+    unsigned int requiredDownloadSpeed = it->bandwidth;
 
     if (dependencies.size() > 0) // we found out that this is layered content
       m_isLayeredContent = true;
@@ -483,7 +419,7 @@ MultimediaConsumer<Parent>::OnMpdFile()
           bestRepresentationBasedOnBandwidth = repId;
         }
       }
-      else if (rep->GetId() == m_startRepresentationId)
+      else if (repId == m_startRepresentationId)
       {
         NS_LOG_DEBUG("The last representation is the start representation!");
         startRepresentationSelected = true;
@@ -536,6 +472,7 @@ MultimediaConsumer<Parent>::OnMpdFile()
 
   m_mpdParsed = true;
   mPlayer->SetAvailableRepresentations(&m_availableRepresentations);
+  mPlayer->GetAdaptationLogic()->SetTotalSegments(mpd->GetNSegments());
 
 
   // trigger MPD parsed after x seconds
@@ -558,13 +495,6 @@ MultimediaConsumer<Parent>::OnMpdFile()
 
   // we received the MDP, so we can now start the timer for playing
   SchedulePlay(startupDelay);
-
-  /* also we can delete the folder (m_tempDir) the MPD is stored in */
-  std::string rmdir_cmd = "rm -rf " + m_tempDir;
-  if (system(rmdir_cmd.c_str()) != 0)
-  {
-   ///fprintf(stderr, "Error: could not delete directory '%s'.\n", m_tempDir.c_str());
-  }
 }
 
 
@@ -612,10 +542,25 @@ MultimediaConsumer<Parent>::OnMultimediaFile()
     if(mPlayer->EnoughSpaceInBuffer(requestedSegmentNr, requestedRepresentation, m_isLayeredContent))
     {
       if(mPlayer->AddToBuffer(requestedSegmentNr, requestedRepresentation, super::lastDownloadBitrate, m_isLayeredContent))
+      {
         NS_LOG_DEBUG("Segment Accepted for Buffering");
+        if (m_waitingForSegment)
+        {
+          // resume a stall right away
+          m_waitingForSegment = false;
+          SchedulePlay(0.0);
+        }
+      }
       else
         NS_LOG_DEBUG("Segment Rejected for Buffering");
     }
+    else if (m_eventDrivenPlayback)
+    {
+      // only playing out a segment frees space, so try again after the next one has been consumed,
+      // but do not download anything in the meantime
+      m_waitingForBuffering = true;
+      return;
+    }
     else
     {
       // try again in 1 second, and again and again... but do not donwload anything in the meantime
@@ -626,10 +571,31 @@ MultimediaConsumer<Parent>::OnMultimediaFile()
 
 
   m_currentDownloadType = Segment;
+
+  if (!m_pipelinedSegments.empty())
+  {
+    // the response to the oldest pipelined request follows on the connection
+    requestedSegmentNr = m_pipelinedSegments.front().first;
+    requestedRepresentation = m_pipelinedSegments.front().second;
+    m_pipelinedSegments.pop_front();
+    return;
+  }
+
   ScheduleDownloadOfSegment();
 }
 
 
+template<class Parent>
+void
+MultimediaConsumer<Parent>::OnHeaderReceived(unsigned status, unsigned length)
+{
+  super::OnHeaderReceived(status, length);
+
+  if (m_pipelineRequests && m_currentDownloadType == Segment && status == 200)
+    PipelineSegments();
+}
+
+
 template<class Parent>
 void
 MultimediaConsumer<Parent>::OnFileReceived(unsigned status, unsigned length)
@@ -671,6 +637,7 @@ MultimediaConsumer<Parent>::DownloadInitSegment()
   super::StopApplication();
   super::SetAttribute("FileToRequest", StringValue(m_baseURL + m_initSegment));
   super::SetAttribute("WriteOutfile", StringValue(""));
+  super::SetAttribute("KeepContent", BooleanValue(false));
   super::StartApplication();
 }
 
@@ -706,7 +673,8 @@ MultimediaConsumer<Parent>::DownloadSegment()
   requestedRepresentation = NULL;
   requestedSegmentNr = 0;
 
-  requestedSegmentURL = mPlayer->GetAdaptationLogic()->GetNextSegment(&requestedSegmentNr, &requestedRepresentation, &m_hasDownloadedAllSegments);
+  // only valid until the adaptation logic is asked for the next segment, e.g. by PipelineSegments
+  dash::mpd::ISegmentURL* requestedSegmentURL = mPlayer->GetAdaptationLogic()->GetNextSegment(&requestedSegmentNr, &requestedRepresentation, &m_hasDownloadedAllSegments);
  ///fprintf(stderr, "Multimediaconsumer::Downloadsegment()\n");
   if(m_hasDownloadedAllSegments) // DONE
   {
@@ -719,13 +687,18 @@ MultimediaConsumer<Parent>::DownloadSegment()
   if (requestedSegmentURL == NULL) //IDLE
   {
     NS_LOG_DEBUG("IDLE\n");
-    m_downloadEventTimer = Simulator::Schedule(Seconds(1.0), &MultimediaConsumer<Parent>::DownloadSegment, this);
+    // the adaptation logic decides on the buffer level, which only drops when a segment is played out
+    if (m_eventDrivenPlayback)
+      m_waitingForDownload = true;
+    else
+      m_downloadEventTimer = Simulator::Schedule(Seconds(1.0), &MultimediaConsumer<Parent>::DownloadSegment, this);
     return;
   }
 
   super::StopApplication();
   super::SetAttribute("FileToRequest", StringValue(m_baseURL + requestedSegmentURL->GetMediaURI()));
   super::SetAttribute("WriteOutfile", StringValue(""));
+  super::SetAttribute("KeepContent", BooleanValue(false));
   super::StartApplication();
 }
 
@@ -733,6 +706,35 @@ MultimediaConsumer<Parent>::DownloadSegment()
 
 
 
+template<class Parent>
+void
+MultimediaConsumer<Parent>::PipelineSegments()
+{
+  if (m_isLayeredContent)
+    return;
+
+  // the buffer only gets fuller until all requested segments have arrived, so with room for
+  // all of them now, none of them has to wait for space in OnMultimediaFile
+  while (m_pipelinedSegments.size() < m_pipelineDepth && super::CanPipelineRequest() &&
+         mPlayer->GetBufferLevel() + (m_pipelinedSegments.size() + 2) * mpd->GetSegmentDuration() <= m_maxBufferedSeconds)
+  {
+    unsigned int segmentNr = 0;
+    const dash::mpd::IRepresentation* representation = NULL;
+    bool hasDownloadedAllSegments = false;
+    dash::mpd::ISegmentURL* segmentURL = mPlayer->GetAdaptationLogic()->GetNextSegment(&segmentNr,
+                                                          &representation, &hasDownloadedAllSegments);
+    // done or idle, DownloadSegment asks again once the requested segments have been received
+    if (hasDownloadedAllSegments || segmentURL == NULL)
+      return;
+
+    NS_LOG_DEBUG("Client(" << super::node_id << "): Pipelining segment " << segmentNr << " of " << representation->GetId());
+    // CanPipelineRequest held, so the request is sent
+    super::PipelineRequest(m_baseURL + segmentURL->GetMediaURI());
+    m_pipelinedSegments.push_back(std::make_pair(segmentNr, representation));
+  }
+}
+
+
 template<class Parent>
 void
 MultimediaConsumer<Parent>::SchedulePlay(double wait_time)
@@ -752,6 +754,7 @@ MultimediaConsumer<Parent>::DoPlay()
   if(consumed_sec > 0) // we play
   {
     SchedulePlay(consumed_sec);
+    OnSegmentConsumed();
   }
   else if(consumed_sec == 0.0 && m_hasDownloadedAllSegments)
   {
@@ -760,8 +763,18 @@ MultimediaConsumer<Parent>::DoPlay()
   }
   else //we stall
   {
-     //restart timer
-     SchedulePlay(); // with default parm.
+    if (m_eventDrivenPlayback)
+    {
+      // OnMultimediaFile resumes playback as soon as the next segment has been buffered
+      m_waitingForSegment = true;
+      // an idle download would never be retried with an empty buffer
+      OnSegmentConsumed();
+    }
+    else
+    {
+      //restart timer
+      SchedulePlay(); // with default parm.
+    }
 
     //check if we should abort the download
     if(requestedRepresentation != NULL && !m_hasDownloadedAllSegments && requestedRepresentation->GetDependencyId().size() > 0) // means we are downloading something with dependencies
@@ -780,6 +793,23 @@ MultimediaConsumer<Parent>::DoPlay()
   }
 }
 
+template<class Parent>
+void
+MultimediaConsumer<Parent>::OnSegmentConsumed()
+{
+  // the buffer level dropped, retry whatever was waiting for space in the buffer
+  if (m_waitingForBuffering)
+  {
+    m_waitingForBuffering = false;
+    OnMultimediaFile();
+  }
+  else if (m_waitingForDownload)
+  {
+    m_waitingForDownload = false;
+    DownloadSegment();
+  }
+}
+
 template<class Parent>
 double
 MultimediaConsumer<Parent>::consume()
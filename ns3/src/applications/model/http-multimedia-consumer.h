@@ -47,6 +47,10 @@
 
 #include "multimedia-player.h"
 
+#include "dash-mpd-registry.h"
+
+#include <deque>
+
 
 #define MULTIMEDIA_CONSUMER_LOOP_TIMER 0.1
 #define MIN_BUFFER_LEVEL 4.0
@@ -94,10 +98,10 @@ public:
 
 protected:
   virtual void
-  OnFileReceived(unsigned status, unsigned length);
+  OnHeaderReceived(unsigned status, unsigned length);
 
-  bool
-  DecompressFile ( std::string source, std::string filename );
+  virtual void
+  OnFileReceived(unsigned status, unsigned length);
 
   std::string m_mpdUrl;     ///< \brief http URL of the MPD
   unsigned int m_screenWidth; ///< \brief The spatial width of the simulated screen
@@ -111,12 +115,7 @@ protected:
   std::string m_startRepresentationId;  ///< \brief The representation ID for initializing streaming
   std::string m_adaptationLogicStr;     ///< \brief The adaptation logic that should be used
 
-
-  std::string m_tempDir; ///< \brief a temporary directory for storing and parsing the downloaded mpd file
-  std::string m_tempMpdFile; ///< \brief path to the temporary MPD file
-
-
-  dash::mpd::IMPD *mpd; ///< \brief Pointer to the MPD
+  Ptr<DashMpd> mpd; ///< \brief the MPD, shared with all consumers of the same video (see DashMpdRegistry)
   dash::player::MultimediaPlayer *mPlayer;
 
   std::map<std::string, IRepresentation*> m_availableRepresentations; ///< \brief a map with available representations
@@ -134,8 +133,6 @@ protected:
   uint32_t m_userId;
   uint32_t m_videoId;
 
-  static std::string alphabet;
-
   bool m_mpdParsed;
   bool m_initSegmentIsGlobal;
   bool m_hasInitSegment;
@@ -144,14 +141,26 @@ protected:
   bool traceNotDownloadedSegments;
   unsigned int totalConsumedSegments;
 
-  dash::mpd::ISegmentURL* requestedSegmentURL;
+  bool m_eventDrivenPlayback; ///< \brief wake up only when the buffer changes instead of polling every MULTIMEDIA_CONSUMER_LOOP_TIMER
+  bool m_waitingForSegment;   ///< \brief playback is stalled until the next segment is added to the buffer
+  bool m_waitingForBuffering; ///< \brief the received segment is buffered once the next segment has been played out
+  bool m_waitingForDownload;  ///< \brief the adaptation logic is idle until the next segment has been played out
+
+  bool m_persistentConnection; ///< \brief download all files over one keep-alive connection
+  bool m_pipelineRequests;     ///< \brief request the next segments as soon as the current one starts arriving
+  uint32_t m_pipelineDepth;    ///< \brief maximum number of segments requested behind the one being received
+
   const dash::mpd::IRepresentation* requestedRepresentation;
   unsigned int requestedSegmentNr;
 
+  /// \brief segment numbers and representations of the pipelined requests, in the order of the responses
+  std::deque<std::pair<unsigned int, const dash::mpd::IRepresentation*> > m_pipelinedSegments;
+
 
 
   void SchedulePlay(double wait_time = MULTIMEDIA_CONSUMER_LOOP_TIMER);
   void DoPlay();
+  void OnSegmentConsumed();
   double consume();
 
   EventId m_consumerLoopTimer;
@@ -179,6 +188,9 @@ protected:
   virtual void
   DownloadSegment();
 
+  virtual void
+  PipelineSegments();
+
   //Vitalii: removed dependencyIDs to fit the videoID. Dunno how to make more than 8 params in a traced callback :)
   TracedCallback<Ptr<ns3::Application> /*App*/, unsigned int /* UserId */, unsigned int /* videoId */, unsigned int /*SegmentNr*/,
                 std::string /*RepresentationId*/, unsigned int /* experiendedBitrate */,
@@ -0,0 +1,329 @@
+#include "http-response-parser.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <strings.h>
+
+NS_LOG_COMPONENT_DEFINE ("HttpResponseParser");
+
+namespace ns3
+{
+
+// bytes copied per scan, large enough for a typical header, small enough not to copy much of the body
+static const uint32_t SCAN_BYTES = 256;
+static const uint32_t MAX_HEADER_SIZE = 16 * 1024;
+static const uint32_t MAX_LINE_SIZE = 1024;
+
+static const std::string CRLF_CRLF("\r\n\r\n");
+static const std::string CRLF_ONLY("\r\n");
+
+
+static std::string
+Trim(const std::string& value)
+{
+  size_t begin = value.find_first_not_of(" \t");
+  if (begin == std::string::npos)
+    return "";
+  size_t end = value.find_last_not_of(" \t");
+  return value.substr(begin, end - begin + 1);
+}
+
+static bool
+ContainsToken(const std::string& value, const char* token)
+{
+  std::string lower(value);
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  return lower.find(token) != std::string::npos;
+}
+
+
+HttpResponseParser::HttpResponseParser()
+{
+  Reset();
+}
+
+void
+HttpResponseParser::SetBodyCallback(Callback<void, Ptr<const Packet> > bodyCallback)
+{
+  m_bodyCallback = bodyCallback;
+}
+
+void
+HttpResponseParser::Reset()
+{
+  m_state = HEADER;
+  m_scanned.clear();
+  m_statusCode = 0;
+  m_contentLength = 0;
+  m_chunked = false;
+  m_keepAlive = true;
+  m_remaining = 0;
+  m_bodyBytes = 0;
+}
+
+
+uint32_t
+HttpResponseParser::Feed(Ptr<const Packet> packet, uint32_t offset)
+{
+  uint32_t start = offset;
+  uint32_t size = packet->GetSize();
+
+  while (offset < size)
+  {
+    bool found = false;
+
+    switch (m_state)
+    {
+      case HEADER:
+        offset += ScanFor(packet, offset, CRLF_CRLF, &found);
+        if (found)
+          ParseHeader();
+        else if (m_scanned.size() > MAX_HEADER_SIZE)
+        {
+          NS_LOG_WARN("Response header exceeds " << MAX_HEADER_SIZE << " bytes");
+          m_state = ERROR;
+        }
+        break;
+
+      case BODY:
+        offset += DeliverBody(packet, offset, m_remaining);
+        if (m_remaining == 0)
+          m_state = COMPLETE;
+        break;
+
+      case BODY_UNTIL_CLOSE:
+        offset += DeliverBody(packet, offset, size - offset);
+        break;
+
+      case CHUNK_SIZE:
+        offset += ScanFor(packet, offset, CRLF_ONLY, &found);
+        if (found)
+        {
+          // the size is hexadecimal and might be followed by chunk extensions
+          char* end;
+          m_remaining = strtoull(m_scanned.c_str(), &end, 16);
+          if (end == m_scanned.c_str())
+          {
+            NS_LOG_WARN("Invalid chunk size '" << m_scanned << "'");
+            m_state = ERROR;
+          }
+          else
+            m_state = (m_remaining == 0) ? TRAILER : CHUNK_DATA;
+          m_scanned.clear();
+        }
+        break;
+
+      case CHUNK_DATA:
+        offset += DeliverBody(packet, offset, m_remaining);
+        if (m_remaining == 0)
+          m_state = CHUNK_DATA_END;
+        break;
+
+      case CHUNK_DATA_END:
+      case TRAILER:
+        offset += ScanFor(packet, offset, CRLF_ONLY, &found);
+        if (found)
+        {
+          bool emptyLine = (m_scanned == CRLF_ONLY);
+          m_scanned.clear();
+
+          if (m_state == CHUNK_DATA_END)
+          {
+            if (emptyLine)
+              m_state = CHUNK_SIZE;
+            else
+            {
+              NS_LOG_WARN("Chunk data not followed by CRLF");
+              m_state = ERROR;
+            }
+          }
+          else if (emptyLine)
+            m_state = COMPLETE; // trailer fields are ignored
+        }
+        break;
+
+      case COMPLETE:
+      case ERROR:
+        return offset - start;
+    }
+
+    if (m_state != HEADER && m_scanned.size() > MAX_LINE_SIZE)
+    {
+      NS_LOG_WARN("Chunk framing line exceeds " << MAX_LINE_SIZE << " bytes");
+      m_state = ERROR;
+    }
+  }
+
+  return offset - start;
+}
+
+
+// Appends up to SCAN_BYTES bytes of packet to m_scanned, stopping right after terminator
+uint32_t
+HttpResponseParser::ScanFor(Ptr<const Packet> packet, uint32_t offset, const std::string& terminator, bool* found)
+{
+  uint32_t length = std::min(packet->GetSize() - offset, SCAN_BYTES);
+  uint8_t bytes[SCAN_BYTES];
+  packet->CreateFragment(offset, length)->CopyData(bytes, length);
+
+  // the terminator might have started in the bytes scanned before
+  size_t oldSize = m_scanned.size();
+  size_t from = oldSize >= terminator.size() - 1 ? oldSize - (terminator.size() - 1) : 0;
+  m_scanned.append((const char*) bytes, length);
+
+  size_t pos = m_scanned.find(terminator, from);
+  if (pos == std::string::npos)
+  {
+    *found = false;
+    return length;
+  }
+
+  *found = true;
+  m_scanned.resize(pos + terminator.size());
+  return m_scanned.size() - oldSize;
+}
+
+
+uint32_t
+HttpResponseParser::DeliverBody(Ptr<const Packet> packet, uint32_t offset, uint64_t remaining)
+{
+  uint32_t length = (uint32_t) std::min((uint64_t) (packet->GetSize() - offset), remaining);
+  if (length == 0)
+    return 0;
+
+  m_bodyBytes += length;
+  if (m_state != BODY_UNTIL_CLOSE)
+    m_remaining -= length;
+
+  if (!m_bodyCallback.IsNull())
+  {
+    if (offset == 0 && length == packet->GetSize())
+      m_bodyCallback(packet);
+    else
+      m_bodyCallback(packet->CreateFragment(offset, length));
+  }
+  return length;
+}
+
+
+void
+HttpResponseParser::ParseHeader()
+{
+  NS_LOG_FUNCTION (this << m_scanned.size());
+
+  // status line, e.g., HTTP/1.1 200 OK
+  size_t lineEnd = m_scanned.find(CRLF_ONLY);
+  std::string statusLine = m_scanned.substr(0, lineEnd);
+  if (statusLine.compare(0, 5, "HTTP/") != 0 || statusLine.size() < 12)
+  {
+    NS_LOG_WARN("Invalid HTTP response '" << statusLine << "'");
+    m_state = ERROR;
+    return;
+  }
+
+  m_keepAlive = (statusLine.compare(0, 8, "HTTP/1.0") != 0);
+  m_statusCode = atoi(statusLine.c_str() + 9);
+
+  bool hasContentLength = false;
+
+  size_t lineStart = lineEnd + 2;
+  while ((lineEnd = m_scanned.find(CRLF_ONLY, lineStart)) != std::string::npos && lineEnd > lineStart)
+  {
+    size_t colon = m_scanned.find(':', lineStart);
+    if (colon != std::string::npos && colon < lineEnd)
+    {
+      std::string name = m_scanned.substr(lineStart, colon - lineStart);
+      std::string value = Trim(m_scanned.substr(colon + 1, lineEnd - colon - 1));
+
+      if (strcasecmp(name.c_str(), "Content-Length") == 0)
+      {
+        m_contentLength = strtoull(value.c_str(), NULL, 10);
+        hasContentLength = true;
+      }
+      else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0)
+        m_chunked = ContainsToken(value, "chunked");
+      else if (strcasecmp(name.c_str(), "Connection") == 0)
+      {
+        if (ContainsToken(value, "close"))
+          m_keepAlive = false;
+        else if (ContainsToken(value, "keep-alive"))
+          m_keepAlive = true;
+      }
+    }
+    lineStart = lineEnd + 2;
+  }
+
+  NS_LOG_DEBUG("Status " << m_statusCode << ", Content-Length " << m_contentLength << ", chunked " << m_chunked);
+  m_scanned.clear();
+
+  if ((m_statusCode >= 100 && m_statusCode < 200) || m_statusCode == 204 || m_statusCode == 304)
+    m_state = COMPLETE; // never has a body
+  else if (m_chunked)
+  {
+    m_contentLength = 0;
+    m_state = CHUNK_SIZE;
+  }
+  else if (hasContentLength)
+  {
+    m_remaining = m_contentLength;
+    m_state = (m_remaining == 0) ? COMPLETE : BODY;
+  }
+  else
+  {
+    m_keepAlive = false;
+    m_state = BODY_UNTIL_CLOSE;
+  }
+}
+
+
+bool
+HttpResponseParser::HasHeader() const
+{
+  return m_state != HEADER && !(m_state == ERROR && m_statusCode == 0);
+}
+
+bool
+HttpResponseParser::IsComplete() const
+{
+  return m_state == COMPLETE;
+}
+
+bool
+HttpResponseParser::HasError() const
+{
+  return m_state == ERROR;
+}
+
+int
+HttpResponseParser::GetStatusCode() const
+{
+  return m_statusCode;
+}
+
+uint64_t
+HttpResponseParser::GetContentLength() const
+{
+  return m_contentLength;
+}
+
+bool
+HttpResponseParser::IsChunked() const
+{
+  return m_chunked;
+}
+
+bool
+HttpResponseParser::IsKeepAlive() const
+{
+  return m_keepAlive;
+}
+
+uint64_t
+HttpResponseParser::GetBodyBytes() const
+{
+  return m_bodyBytes;
+}
+
+} // namespace ns3
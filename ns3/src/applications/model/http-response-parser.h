@@ -0,0 +1,106 @@
+#ifndef HTTP_RESPONSE_PARSER
+#define HTTP_RESPONSE_PARSER
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/callback.h"
+
+#include <string>
+
+
+namespace ns3
+{
+
+/**
+ * \brief Incremental parser for the HTTP/1.x responses received on one connection
+ *
+ * The response is fed packet by packet as it arrives from the socket. Only the status
+ * line, the header fields and the chunk framing are copied and inspected, the body is
+ * handed to the body callback as fragments of the received packets.
+ *
+ * Bodies can be delimited by Content-Length or by chunked transfer encoding; without
+ * either, the body lasts until the connection is closed and the response never completes.
+ * Once a response is complete, Feed consumes nothing more, so bytes of a next response on
+ * a keep-alive connection are left to the caller, which calls Reset before feeding them.
+ */
+class HttpResponseParser
+{
+public:
+  HttpResponseParser();
+
+  /**
+   * \brief Called with every piece of the body, in order
+   */
+  void SetBodyCallback(Callback<void, Ptr<const Packet> > bodyCallback);
+
+  /**
+   * \brief Prepare for the next response on the connection
+   */
+  void Reset();
+
+  /**
+   * \brief Parse the bytes of packet starting at offset
+   * \returns the number of bytes consumed, less than the remaining bytes only if the
+   *          response was completed or found to be malformed
+   */
+  uint32_t Feed(Ptr<const Packet> packet, uint32_t offset = 0);
+
+  bool HasHeader() const;
+  bool IsComplete() const;
+  bool HasError() const;
+
+  int GetStatusCode() const;
+
+  /**
+   * \brief The value of Content-Length, 0 if the body is chunked or has no length
+   */
+  uint64_t GetContentLength() const;
+
+  bool IsChunked() const;
+
+  /**
+   * \brief Whether the server keeps the connection open after this response
+   */
+  bool IsKeepAlive() const;
+
+  /**
+   * \brief Number of body bytes received so far (without chunk framing)
+   */
+  uint64_t GetBodyBytes() const;
+
+private:
+  enum State
+  {
+    HEADER,
+    BODY,
+    BODY_UNTIL_CLOSE,
+    CHUNK_SIZE,
+    CHUNK_DATA,
+    CHUNK_DATA_END,
+    TRAILER,
+    COMPLETE,
+    ERROR
+  };
+
+  uint32_t ScanFor(Ptr<const Packet> packet, uint32_t offset, const std::string& terminator, bool* found);
+  uint32_t DeliverBody(Ptr<const Packet> packet, uint32_t offset, uint64_t remaining);
+  void ParseHeader();
+
+  Callback<void, Ptr<const Packet> > m_bodyCallback;
+
+  State m_state;
+  std::string m_scanned; //!< header or framing line being scanned
+
+  int m_statusCode;
+  uint64_t m_contentLength;
+  bool m_chunked;
+  bool m_keepAlive;
+
+  uint64_t m_remaining; //!< bytes left of the body or of the current chunk
+  uint64_t m_bodyBytes;
+};
+
+} // namespace ns3
+
+
+#endif /* HTTP_RESPONSE_PARSER */
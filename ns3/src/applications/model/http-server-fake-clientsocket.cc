@@ -22,12 +22,48 @@ namespace ns3
 {
 
 
+HttpVirtualPayloadSource::HttpVirtualPayloadSource(uint32_t size) : m_size(size)
+{
+}
+
+uint32_t
+HttpVirtualPayloadSource::GetSize() const
+{
+  return m_size;
+}
+
+int
+HttpVirtualPayloadSource::Transmit(Ptr<MpTcpSocketBase> socket, uint32_t offset, uint32_t size)
+{
+  // zero-filled virtual packets, the socket does not allocate the payload either
+  return socket->FillBuffer(std::min(size, m_size - offset));
+}
+
+
+HttpContentPayloadSource::HttpContentPayloadSource(Ptr<const Packet> content) : m_content(content)
+{
+}
+
+uint32_t
+HttpContentPayloadSource::GetSize() const
+{
+  return m_content->GetSize();
+}
+
+int
+HttpContentPayloadSource::Transmit(Ptr<MpTcpSocketBase> socket, uint32_t offset, uint32_t size)
+{
+  return socket->FillBuffer(m_content->CreateFragment(offset, std::min(size, m_content->GetSize() - offset)));
+}
+
+
 
 HttpServerFakeClientSocket::HttpServerFakeClientSocket(uint64_t socket_id,
     std::string contentDir,
     std::map<std::string /* filename */, long /* file size */>& fileSizes,
     std::vector<std::string /* filename */>& virtualFiles,
-    Callback<void, uint64_t> finished_callback) : m_fileSizes(fileSizes), m_virtualFiles(virtualFiles)
+    HttpContentCache& contentCache,
+    Callback<void, uint64_t> finished_callback) : m_fileSizes(fileSizes), m_virtualFiles(virtualFiles), m_contentCache(contentCache)
 {
   this->m_socket_id = socket_id;
   this->m_finished_callback = finished_callback;
@@ -40,8 +76,6 @@ HttpServerFakeClientSocket::HttpServerFakeClientSocket(uint64_t socket_id,
   m_content_dir = contentDir;
 
   m_keep_alive = false;
-
-  m_is_virtual_file = false;
 }
 
 
@@ -61,7 +95,6 @@ void
 HttpServerFakeClientSocket::HandleIncomingData(Ptr<Socket> s)
 {
   Ptr<Packet> packet;
-  Address from;
   Ptr<MpTcpSocketBase> socket = DynamicCast<MpTcpSocketBase>(s);
   // while ((packet = socket->RecvFrom (from)))
   while ((packet = socket->Recv ()) && (packet->GetSize() != 0))
@@ -77,31 +110,39 @@ HttpServerFakeClientSocket::HandleIncomingData(Ptr<Socket> s)
     size_t packet_size = packet->CopyData(buffer, packet->GetSize());
     buffer[packet_size] = '\0';
 
-    // check if packet in m_activePackets
-    if (bytes_recv == 0)
-    {
-      m_activeRecvString = std::string((char*)buffer);
-      bytes_recv += packet_size;
-    } else
-    {
-      m_activeRecvString += std::string((char*)buffer);
-      bytes_recv += packet_size;
-    }
-    // std::cout << "\nfinal: |" << m_activeRecvString << "|, and size " << bytes_recv << "\n\n";
-      // NS_FATAL_ERROR ("");
+    m_activeRecvString.append((char*)buffer, packet_size);
+    bytes_recv += packet_size;
 
     free(buffer);
 
-
-    if (string_ends_width(m_activeRecvString, std::string(CRLF)))
+    // split off every complete request, a pipelining client sends the next ones before the reply
+    size_t end;
+    while ((end = m_activeRecvString.find(CRLF CRLF)) != std::string::npos)
     {
-      m_currentBytesTx = 0;
-      m_totalBytesToTx = 0;
-
-      FinishedIncomingData(socket, from, m_activeRecvString);
-      m_activeRecvString = "";
+      m_pendingRequests.push_back(m_activeRecvString.substr(0, end + 4));
+      m_activeRecvString.erase(0, end + 4);
     }
   }
+
+  // requests are answered in order, the next one once the current reply has been handed to the socket
+  if (!m_pendingRequests.empty() && m_currentBytesTx >= m_totalBytesToTx)
+    ServeNextRequest(socket);
+}
+
+
+void
+HttpServerFakeClientSocket::ServeNextRequest(Ptr<Socket> socket)
+{
+  std::string request = m_pendingRequests.front();
+  m_pendingRequests.pop_front();
+
+  m_currentBytesTx = 0;
+  m_totalBytesToTx = 0;
+  m_bytesToTransmit.clear();
+  m_payload = 0;
+
+  NS_LOG_DEBUG ("Server("<<m_socket_id<<"): Serving request, " << m_pendingRequests.size() << " more pipelined");
+  FinishedIncomingData(socket, Address(), request);
 }
 
 
@@ -221,25 +262,22 @@ HttpServerFakeClientSocket::FinishedIncomingData(Ptr<Socket> socket, Address fro
 
   long filesize = GetFileSize(filename);
 
-  m_is_virtual_file = false;
-
   if (filesize == -1)
   {
     NS_LOG_INFO ("Server(" << m_socket_id << "): Error, '" << filename.c_str () << "' not found!");
-    // return 404
-    std::string replyString("HTTP/1.1 404 Not Found\r\n\r\n");
+    // return 404, with an empty body that a keep-alive client can tell apart from the next reply
+    std::string replyString("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
 
     AddBytesToTransmit((uint8_t*)replyString.c_str(), replyString.length());
   } else
   {
-    // Vitalii: somehow the app send buffer doesn't get cleared from previous
-    //          data/segments, so let's clear it here for sure
-    this->m_bytesToTransmit.clear();
     // Create a proper header
     std::stringstream replySS;
     replySS << "HTTP/1.1 200 OK" << CRLF; // OR HTTP/1.1 404 Not Found
     replySS << "Content-Type: text/xml; charset=utf-8" << CRLF; // e.g., when sending the MPD
     replySS << "Content-Length: " << filesize << CRLF;
+    if (m_keep_alive)
+      replySS << "Connection: keep-alive" << CRLF;
     replySS << CRLF;
 
     //fprintf(stderr, "Replying with header:\n%s\n", replySS.str().c_str());
@@ -248,57 +286,25 @@ HttpServerFakeClientSocket::FinishedIncomingData(Ptr<Socket> socket, Address fro
     uint8_t* buffer = (uint8_t*)replyString.c_str();
     AddBytesToTransmit(buffer,replyString.length());
 
-    // now append the virtual payload data
-    uint8_t tmp[4096];
-
+    // now append the payload data
     if (std::find(m_virtualFiles.begin(), m_virtualFiles.end(), filename) != m_virtualFiles.end())
     {
-      // handle virtual payload
-      // fill tmp with some random data
+      // handle virtual payload, it is generated while transmitting
       NS_LOG_DEBUG ("Server("<<m_socket_id<<"): Generating virtual payload of size "<<filesize<<" ...");
 
-
+      m_payload = Create<HttpVirtualPayloadSource> (filesize);
       this->m_totalBytesToTx += filesize;
-      this->m_is_virtual_file = true;
-
-      /*
-      for (int i = 0; i < 4096; i++)
-      {
-        tmp[i] = (uint8_t)rand();
-      }
-
-
-      int cnt = 0;
-
-      while (cnt < filesize)
-      {
-        if (cnt + 4096 < filesize)
-        {
-          AddBytesToTransmit(tmp, 4096);
-        } else {
-          AddBytesToTransmit(tmp, filesize - cnt);
-        }
-        cnt += 4096;
-      } */
     } else
     {
-      NS_LOG_INFO ("[" << Simulator::Now().GetSeconds() << "s] Server(" << m_socket_id << "): Opening file on disk with size " << filesize);
-      // handle actual payload
-      FILE* fp = fopen(filename.c_str(), "rb");
-
-      int size_returned = 4096;
+      // handle actual payload, either hosted in memory or read from disk on the first request
+      Ptr<const Packet> content = m_contentCache.Get(filename);
+      NS_LOG_INFO ("[" << Simulator::Now().GetSeconds() << "s] Server(" << m_socket_id << "): Sending cached file with size " << filesize);
 
-      while (size_returned == 4096)
+      if (content != 0)
       {
-        size_returned = fread(tmp, 1, 4096, fp);
-
-        if (size_returned > 0)
-        {
-          AddBytesToTransmit(tmp, size_returned);
-        }
+        m_payload = Create<HttpContentPayloadSource> (content);
+        this->m_totalBytesToTx += content->GetSize();
       }
-
-      fclose(fp);
     }
   }
 
@@ -317,6 +323,11 @@ HttpServerFakeClientSocket::HandleReadyToTransmit(Ptr<Socket> s, uint32_t txSize
     NS_LOG_DEBUG ("Server("<<m_socket_id<<")::HandleReadyToTransmit: Nothing to transmit (yet)...");
     return;
   }
+  if (m_currentBytesTx >= m_totalBytesToTx && !m_pendingRequests.empty())
+  {
+    ServeNextRequest(socket);
+    return;
+  }
   if (m_currentBytesTx >= m_totalBytesToTx && m_totalBytesToTx > 0)
   {
     // already sent everything, check if we need to "close" the socket and disband this object, or if we keep it alive
@@ -339,6 +350,7 @@ HttpServerFakeClientSocket::HandleReadyToTransmit(Ptr<Socket> s, uint32_t txSize
         // we already finished sending, so we can clear the buffer for the sake of saving memory
         this->m_bytesToTransmit.clear();
         std::vector<uint8_t>().swap( this->m_bytesToTransmit ); // explicitly clear the buffer
+        m_payload = 0;
         m_is_shutdown = true; // make sure to set that flag to true, so that we do not call this stuff again
       }
     } else {
@@ -350,6 +362,7 @@ HttpServerFakeClientSocket::HandleReadyToTransmit(Ptr<Socket> s, uint32_t txSize
       // we already finished sending, so we can clear the buffer for the sake of saving memory
       this->m_bytesToTransmit.clear();
       std::vector<uint8_t>().swap( this->m_bytesToTransmit ); // explicitly clear the buffer
+      m_payload = 0;
       m_is_shutdown = true;
     }
     return;
@@ -357,51 +370,32 @@ HttpServerFakeClientSocket::HandleReadyToTransmit(Ptr<Socket> s, uint32_t txSize
   //fprintf(stderr, "Server(%ld)::HandleReadyToTransmit(socket,txSize=%u)\n", m_socket_id, txSize);
 
 
-  // get txSize bytes from m_bytesToTransmit, starting at byte m_currentBytesTx
+  // get txSize bytes from m_bytesToTransmit and then m_payload, starting at byte m_currentBytesTx
 
   while (m_currentBytesTx < m_totalBytesToTx && socket->GetTxAvailable () > 0)
   {
     uint32_t remainingBytes = m_totalBytesToTx - m_currentBytesTx;
 
-    // if (remainingBytes > 2860)
-    //   remainingBytes = 2860;
     if (remainingBytes > 1400)
       remainingBytes = 1400;
 
-    if (remainingBytes < socket->GetTxAvailable ())
-    {
-      remainingBytes = std::min(remainingBytes, socket->GetTxAvailable ());
-      NS_LOG_WARN ("Server::HandleReadyToTransmit: Socket has less Tx space " <<
-                    "available than we need; this can potentially make issues" <<
-                    "for pushing data into socket tx buffer!");
-    }
+    int amountSent = 0;
+    uint32_t inMemoryBytes = m_bytesToTransmit.size();
 
-    Ptr<Packet> replyPacket;
-    uint8_t *buffer;
-    if (!m_is_virtual_file)
+    if (m_currentBytesTx < inMemoryBytes)
     {
-      buffer = (uint8_t*) &((this->m_bytesToTransmit)[m_currentBytesTx]);
-      replyPacket = Create<Packet> (buffer, remainingBytes);
-    } else
+      amountSent = socket->FillBuffer (&m_bytesToTransmit[m_currentBytesTx],
+                                       std::min(remainingBytes, inMemoryBytes - m_currentBytesTx));
+    }
+    // the rest of the chunk is taken from the payload source, so header and body share segments as before
+    if (m_payload != 0 && m_currentBytesTx + amountSent >= inMemoryBytes && (uint32_t) amountSent < remainingBytes)
     {
-      if (m_currentBytesTx == 0) // reply with header
-      {
-        buffer = (uint8_t*) &((this->m_bytesToTransmit)[m_currentBytesTx]);
-        replyPacket = Create<Packet> (buffer, this->m_bytesToTransmit.size());
-      } else {
-        // create a virtual reply packet
-        buffer = (uint8_t*)malloc(remainingBytes);
-
-        replyPacket = Create<Packet> (buffer, remainingBytes);
-        free (buffer);
-      }
+      int payloadSent = m_payload->Transmit (socket, m_currentBytesTx + amountSent - inMemoryBytes,
+                                             remainingBytes - amountSent);
+      if (payloadSent > 0)
+        amountSent += payloadSent;
     }
-
-    // std::cout << "\n\n size: " << remainingBytes << " |" << buffer << "|\n";
-    int amountSent = socket->FillBuffer (buffer, remainingBytes);
     socket->SendBufferedData ();
-    // free (buffer);
-    // int amountSent = socket->Send (replyPacket);
 
     if (amountSent <= 0)
     {
@@ -414,6 +408,10 @@ HttpServerFakeClientSocket::HandleReadyToTransmit(Ptr<Socket> s, uint32_t txSize
 
     //fprintf(stderr, "Server(%ld)::HandleReadyToTransmit - Transmitted %d bytes, %u remaining\n", m_socket_id, amountSent, m_totalBytesToTx - m_currentBytesTx);
   }
+
+  // the reply is in the send buffer, so the reply to a pipelined request can follow right behind it
+  if (m_currentBytesTx >= m_totalBytesToTx && !m_pendingRequests.empty())
+    ServeNextRequest(socket);
 }
 
 
@@ -6,8 +6,12 @@
 #include "ns3/application.h"
 #include "ns3/ptr.h"
 #include "ns3/string.h"
+#include "ns3/simple-ref-count.h"
 #include "ns3/tcp-socket.h"
 
+#include "http-content-cache.h"
+
+#include <deque>
 #include <map>
 #include <vector>
 #include <stdio.h>
@@ -17,6 +21,58 @@ namespace ns3
 {
 class Socket;
 class Address;
+class MpTcpSocketBase;
+
+
+/**
+ * \brief Body of a reply that is handed to the socket chunk by chunk, as tx space becomes
+ * available, instead of being copied into the transmit buffer of the connection up front
+ */
+class HttpPayloadSource : public SimpleRefCount<HttpPayloadSource>
+{
+public:
+  virtual ~HttpPayloadSource() {}
+
+  virtual uint32_t GetSize() const = 0;
+
+  /**
+   * \brief Append size bytes of the body, starting at offset, to the send buffer of socket
+   * \returns the number of bytes taken by the socket
+   */
+  virtual int Transmit(Ptr<MpTcpSocketBase> socket, uint32_t offset, uint32_t size) = 0;
+};
+
+
+/**
+ * \brief Payload of a virtual file: zero-filled packets, nothing is held in memory
+ */
+class HttpVirtualPayloadSource : public HttpPayloadSource
+{
+public:
+  HttpVirtualPayloadSource(uint32_t size);
+
+  virtual uint32_t GetSize() const;
+  virtual int Transmit(Ptr<MpTcpSocketBase> socket, uint32_t offset, uint32_t size);
+
+private:
+  uint32_t m_size;
+};
+
+
+/**
+ * \brief Payload of a hosted file, sliced from the content cache without copying
+ */
+class HttpContentPayloadSource : public HttpPayloadSource
+{
+public:
+  HttpContentPayloadSource(Ptr<const Packet> content);
+
+  virtual uint32_t GetSize() const;
+  virtual int Transmit(Ptr<MpTcpSocketBase> socket, uint32_t offset, uint32_t size);
+
+private:
+  Ptr<const Packet> m_content;
+};
 
 
 class HttpServerFakeClientSocket
@@ -24,7 +80,7 @@ class HttpServerFakeClientSocket
 public:
   HttpServerFakeClientSocket(uint64_t socket_id,
   std::string contentDir, std::map<std::string /* filename */, long /* file size */>& fileSizes,
-  std::vector<std::string /* filename */>& virtualFiles,
+  std::vector<std::string /* filename */>& virtualFiles, HttpContentCache& contentCache,
   Callback<void, uint64_t> finished_callback);
 
   virtual ~HttpServerFakeClientSocket();
@@ -49,6 +105,11 @@ protected:
   virtual void FinishedIncomingData(Ptr<Socket> socket, Address from, std::string data);
   void AddBytesToTransmit(const uint8_t* buffer, uint32_t size);
 
+  /**
+   * \brief Start replying to the oldest request in m_pendingRequests
+   */
+  void ServeNextRequest(Ptr<Socket> socket);
+
   std::string ParseHTTPHeader(std::string data);
 
   long GetFileSize(std::string filename);
@@ -67,17 +128,18 @@ protected:
 
   bool m_is_shutdown;
 
-  bool m_is_virtual_file;
-
   bool m_keep_alive;
 
-  std::vector<uint8_t> m_bytesToTransmit;
+  std::vector<uint8_t> m_bytesToTransmit; ///< header (and body, unless it comes from m_payload) of the reply
+  Ptr<HttpPayloadSource> m_payload;       ///< body of the reply following m_bytesToTransmit, may be 0
 
 
-  std::string m_activeRecvString;
+  std::string m_activeRecvString;         ///< received bytes of a request that is not complete yet
+  std::deque<std::string> m_pendingRequests; ///< complete requests not answered yet, in order of arrival
 
   std::map<std::string,long>& m_fileSizes;
   std::vector<std::string>& m_virtualFiles;
+  HttpContentCache& m_contentCache;
 };
 
 } // namespace ns3
@@ -14,17 +14,10 @@ class HttpServerFakeVirtualClientSocket : public HttpServerFakeClientSocket
 public:
   HttpServerFakeVirtualClientSocket(uint64_t socket_id,
   std::string contentDir, std::map<std::string /* filename */, long /* file size */>& fileSizes,
-  std::vector<std::string /* filename */>& fakeFiles, std::map<std::string,std::string>& /* virtual file host */ virtualHostedFiles,
+  std::vector<std::string /* filename */>& fakeFiles, HttpContentCache& contentCache,
   Callback<void, uint64_t> finished_callback);
 
   ~HttpServerFakeVirtualClientSocket();
-
-protected:
-  std::map<std::string,std::string>& m_virtualHostedFiles;
-
-  void FinishedIncomingData(Ptr<Socket> socket, Address from, std::string data);
-
-
 };
 
 } // namespace ns3
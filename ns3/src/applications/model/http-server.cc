@@ -87,6 +87,10 @@ HttpServerApplication::GetTypeId (void)
                    StringValue("localhost"),
                    MakeStringAccessor(&HttpServerApplication::m_hostName),
                    MakeStringChecker())
+    .AddAttribute("ContentCacheSize", "Maximum number of bytes of files read from disk kept in memory",
+                   UintegerValue(256 << 20),
+                   MakeUintegerAccessor(&HttpServerApplication::m_contentCacheSize),
+                   MakeUintegerChecker<uint64_t>())
     .AddTraceSource("ThroughputTracer", "Trace Throughput statistics of this server",
                       MakeTraceSourceAccessor(&HttpServerApplication::m_throughputTrace))
                     ;
@@ -169,6 +173,8 @@ HttpServerApplication::StartApplication (void)
 
   m_lastSocketID = 1;
 
+  m_contentCache.SetMaxSize(m_contentCacheSize);
+
   if (m_socket == 0)
   {
     TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -289,7 +295,7 @@ HttpServerApplication::ConnectionAccepted (Ptr<Socket> socket, const Address& ad
 
   uint64_t socket_id = RegisterSocket(socket);
 
-  m_activeClients[socket_id] = new HttpServerFakeClientSocket(socket_id, m_contentDir, m_fileSizes, m_virtualFiles,
+  m_activeClients[socket_id] = new HttpServerFakeClientSocket(socket_id, m_contentDir, m_fileSizes, m_virtualFiles, m_contentCache,
                   MakeCallback(&HttpServerApplication::FinishedCallback, this));
 
   NS_LOG_DEBUG (socket << " " << Simulator::Now () << " Successful socket id : " << socket_id << " Connection Accepted From " << address);
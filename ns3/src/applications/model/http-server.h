@@ -101,6 +101,7 @@ private:
 
   std::map<std::string, long> m_fileSizes;
   std::vector<std::string> m_virtualFiles;
+  HttpContentCache m_contentCache;
 
   uint64_t m_lastSocketID;
 
@@ -130,6 +131,7 @@ private:
   std::string m_metaDataFile;
   std::string m_metaDataContentDirectory;
   std::string m_hostName;
+  uint64_t m_contentCacheSize;
   Address m_listeningAddress;
 
   EventId m_reportStatsTimer;
@@ -36,6 +36,11 @@ NodeThroughputTracer::InstallAll(const std::string& file)
 {
   using namespace std;
 
+  if (BinaryTraceFile::IsBinaryFileName(file)) {
+    Install(NodeContainer::GetGlobal(), boost::shared_ptr<BinaryTraceFile>(new BinaryTraceFile(file)));
+    return;
+  }
+
   std::list< Ptr< NodeThroughputTracer > > tracers;
 
   boost::shared_ptr<std::ofstream> os(new std::ofstream());
@@ -64,6 +69,11 @@ NodeThroughputTracer::Install(const NodeContainer& nodes, const std::string& fil
 {
   using namespace std;
 
+  if (BinaryTraceFile::IsBinaryFileName(file)) {
+    Install(nodes, boost::shared_ptr<BinaryTraceFile>(new BinaryTraceFile(file)));
+    return;
+  }
+
   std::list< Ptr< NodeThroughputTracer > > tracers;
 
   boost::shared_ptr<std::ofstream> os(new std::ofstream());
@@ -92,6 +102,11 @@ NodeThroughputTracer::Install(Ptr<Node> node, const std::string& file)
 {
   using namespace std;
 
+  if (BinaryTraceFile::IsBinaryFileName(file)) {
+    Install(NodeContainer(node), boost::shared_ptr<BinaryTraceFile>(new BinaryTraceFile(file)));
+    return;
+  }
+
   std::list< Ptr< NodeThroughputTracer > > tracers;
 
   boost::shared_ptr<std::ofstream> os(new std::ofstream());
@@ -122,6 +137,27 @@ NodeThroughputTracer::Install(Ptr<Node> node, boost::shared_ptr<std::ofstream> o
   return trace;
 }
 
+void
+NodeThroughputTracer::Install(const NodeContainer& nodes, boost::shared_ptr<BinaryTraceFile> trace)
+{
+  if (!trace->IsOpen()) {
+    NS_LOG_ERROR("Binary trace file cannot be opened for writing. Tracing disabled");
+    return;
+  }
+
+  for (NodeContainer::Iterator node = nodes.Begin(); node != nodes.End(); node++) {
+    m_allTracers.push_back(Install(*node, trace));
+  }
+}
+
+Ptr<NodeThroughputTracer>
+NodeThroughputTracer::Install(Ptr<Node> node, boost::shared_ptr<BinaryTraceFile> trace)
+{
+  NS_LOG_DEBUG("Node: " << node->GetId());
+
+  return CreateObject<NodeThroughputTracer>(trace, node);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
@@ -145,9 +181,24 @@ NodeThroughputTracer::NodeThroughputTracer(boost::shared_ptr<std::ofstream> os,
   Connect();
 }
 
+NodeThroughputTracer::NodeThroughputTracer(boost::shared_ptr<BinaryTraceFile> trace, Ptr<Node> node)
+  : m_nodePtr(node)
+  , m_trace(trace)
+{
+  std::stringstream node_id_str;
+  node_id_str << m_nodePtr->GetId();
+
+  m_node = node_id_str.str();
+  m_nodeIndex = m_trace->Intern(m_node);
+
+  Connect();
+}
+
 NodeThroughputTracer::~NodeThroughputTracer()
 {
-  m_os->close();
+  // the binary trace file is flushed and closed once its last tracer is gone
+  if (m_os)
+    m_os->close();
 };
 
 void
@@ -160,19 +211,33 @@ NodeThroughputTracer::Connect()
 }
 
 void
-NodeThroughputTracer::PrintHeader(std::ofstream& os) const
+NodeThroughputTracer::PrintHeader(std::ostream& os)
 {
   os << "Time\tNode\tTxBytes\tRxBytes\tOpenSockets";
 }
 
 void
-NodeThroughputTracer::ThroughputStats(Ptr<ns3::Application> app, uint64_t txBytes, uint64_t rxBytes, uint32_t openSockets)
+NodeThroughputTracer::PrintRecord(std::ostream& os, const Record& record, const std::string& node)
 {
-  (*m_os) << Simulator::Now().ToDouble(Time::S) << "\t" << m_node << "\t"
-        << txBytes << "\t" << rxBytes << "\t" << openSockets << "\n";
-
+  os << record.time << "\t" << node << "\t"
+     << record.txBytes << "\t" << record.rxBytes << "\t" << record.openSockets << "\n";
+}
 
-  (*m_os).flush();
+void
+NodeThroughputTracer::ThroughputStats(Ptr<ns3::Application> app, uint64_t txBytes, uint64_t rxBytes, uint32_t openSockets)
+{
+  Record record;
+  record.time = Simulator::Now().ToDouble(Time::S);
+  record.txBytes = txBytes;
+  record.rxBytes = rxBytes;
+  record.openSockets = openSockets;
+
+  if (m_trace) {
+    record.node = m_nodeIndex;
+    m_trace->Write(RECORD_TYPE, &record, sizeof(record));
+  } else {
+    PrintRecord(*m_os, record, m_node);
+  }
 }
 
 
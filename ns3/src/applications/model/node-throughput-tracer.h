@@ -11,9 +11,12 @@
 #include "ns3/event-id.h"
 #include "ns3/core-module.h"
 #include "ns3/trace-source-accessor.h"
+#include "binary-trace-file.h"
 
 #include <boost/shared_ptr.hpp>
 
+#include <ostream>
+
 
 using namespace std;
 
@@ -29,13 +32,31 @@ class Packet;
  */
 class NodeThroughputTracer : public ns3::Object {
 public:
+  /**
+   * @brief Type of the records in binary trace files
+   */
+  static const uint8_t RECORD_TYPE = 2;
+
+  /**
+   * @brief Binary record of a throughput report, the node is the index of an interned string
+   */
+  struct Record
+  {
+    double time;
+    uint64_t txBytes;
+    uint64_t rxBytes;
+    uint32_t node;
+    uint32_t openSockets;
+  };
+
   static void
   Destroy();
 
   /**
    * @brief Helper method to install tracers on all simulation nodes
    *
-   * @param file File to which traces will be written.  If filename is -, then std::out is used
+   * @param file File to which traces will be written.  If filename is -, then std::out is used.
+   *             If filename ends with .bin, binary records are written (see BinaryTraceFile)
    *
    * @returns a tuple of reference to output stream and list of tracers. !!! Attention !!! This
    *tuple needs to be preserved
@@ -49,7 +70,8 @@ public:
    * @brief Helper method to install tracers on the selected simulation nodes
    *
    * @param nodes Nodes on which to install tracer
-   * @param file File to which traces will be written.  If filename is -, then std::out is used
+   * @param file File to which traces will be written.  If filename is -, then std::out is used.
+   *             If filename ends with .bin, binary records are written (see BinaryTraceFile)
    *
    * @returns a tuple of reference to output stream and list of tracers. !!! Attention !!! This
    *tuple needs to be preserved
@@ -63,7 +85,8 @@ public:
    * @brief Helper method to install tracers on a specific simulation node
    *
    * @param nodes Nodes on which to install tracer
-   * @param file File to which traces will be written.  If filename is -, then std::out is used
+   * @param file File to which traces will be written.  If filename is -, then std::out is used.
+   *             If filename ends with .bin, binary records are written (see BinaryTraceFile)
    * @param averagingPeriod How often data will be written into the trace file (default, every half
    *second)
    *
@@ -90,6 +113,15 @@ public:
   static Ptr<NodeThroughputTracer>
   Install(Ptr<Node> node, boost::shared_ptr<std::ofstream> os);
 
+  /**
+   * @brief Helper method to install a tracer writing binary records on a specific simulation node
+   *
+   * @param node  Node on which to install tracer
+   * @param trace Binary trace file, shared by the tracers of all nodes
+   */
+  static Ptr<NodeThroughputTracer>
+  Install(Ptr<Node> node, boost::shared_ptr<BinaryTraceFile> trace);
+
   /**
    * @brief Trace constructor that attaches to all applications on the node using node's pointer
    * @param os    reference to the output stream
@@ -104,6 +136,13 @@ public:
    */
   NodeThroughputTracer(boost::shared_ptr<std::ofstream> os, const std::string& node);
 
+  /**
+   * @brief Trace constructor that writes binary records of all applications on the node
+   * @param trace binary trace file
+   * @param node  pointer to the node
+   */
+  NodeThroughputTracer(boost::shared_ptr<BinaryTraceFile> trace, Ptr<Node> node);
+
   /**
    * @brief Destructor
    */
@@ -114,10 +153,21 @@ public:
    *
    * @param os reference to output stream
    */
-  void
-  PrintHeader(std::ofstream& os) const;
+  static void
+  PrintHeader(std::ostream& os);
+
+  /**
+   * @brief Print a record as a line of the text trace
+   *
+   * @param node name or id of the node
+   */
+  static void
+  PrintRecord(std::ostream& os, const Record& record, const std::string& node);
 
 private:
+  static void
+  Install(const NodeContainer& nodes, boost::shared_ptr<BinaryTraceFile> trace);
+
   void
   Connect();
 
@@ -129,6 +179,8 @@ private:
   Ptr<Node> m_nodePtr;
 
   boost::shared_ptr<std::ofstream> m_os;
+  boost::shared_ptr<BinaryTraceFile> m_trace;
+  uint32_t m_nodeIndex; //!< interned name of the node in m_trace
 
 };
 
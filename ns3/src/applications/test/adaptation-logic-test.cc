@@ -0,0 +1,210 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string>
+#include <vector>
+#include "ns3/test.h"
+#include "libdash.h"
+#include "adaptation-logic.h"
+
+using namespace ns3;
+
+/**
+ * Three representations share 1 Mbit/s. Neither the order of the MPD nor the order of
+ * the bandwidths matches the order of the ids, so that only a stable sort of the
+ * representations by id returns "2" for that rung.
+ */
+static const char g_mpd[] =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+  "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" type=\"static\" minBufferTime=\"PT2S\""
+  " mediaPresentationDuration=\"PT600S\" profiles=\"urn:mpeg:dash:profile:isoff-main:2011\">"
+  "<Period>"
+  "<AdaptationSet>"
+  "<Representation id=\"5\" bandwidth=\"1000000\">"
+  "<SegmentTemplate media=\"5_$Number$\" duration=\"2\" startNumber=\"0\"/></Representation>"
+  "<Representation id=\"1\" bandwidth=\"2000000\">"
+  "<SegmentTemplate media=\"1_$Number$\" duration=\"2\" startNumber=\"0\"/></Representation>"
+  "<Representation id=\"4\" bandwidth=\"1000000\">"
+  "<SegmentTemplate media=\"4_$Number$\" duration=\"2\" startNumber=\"0\"/></Representation>"
+  "<Representation id=\"3\" bandwidth=\"500000\">"
+  "<SegmentTemplate media=\"3_$Number$\" duration=\"2\" startNumber=\"0\"/></Representation>"
+  "<Representation id=\"2\" bandwidth=\"1000000\">"
+  "<SegmentTemplate media=\"2_$Number$\" duration=\"2\" startNumber=\"0\"/></Representation>"
+  "</AdaptationSet>"
+  "</Period>"
+  "</MPD>";
+
+
+class AdaptationLogicLadderTest : public TestCase
+{
+public:
+  AdaptationLogicLadderTest ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoTeardown (void);
+  virtual void DoRun (void);
+
+  // Id of rep, "none" for NULL
+  static std::string Id (const dash::mpd::IRepresentation* rep);
+  // As the adaptation logics used to select representations, by walking all of them
+  dash::mpd::IRepresentation* WalkHighestBelow (double bitrate);
+  dash::mpd::IRepresentation* WalkNextHigher (double bitrate);
+
+  dash::mpd::IMPD* m_mpd;
+  dash::player::RepresentationsMap m_representations;
+};
+
+AdaptationLogicLadderTest::AdaptationLogicLadderTest ()
+  : TestCase ("Representations selected by bandwidth at the rungs of the ladder"),
+    m_mpd (0)
+{
+}
+
+void
+AdaptationLogicLadderTest::DoSetup (void)
+{
+  dash::IDASHManager *manager = CreateDashManager ();
+  m_mpd = manager->OpenBuffer (g_mpd, sizeof (g_mpd) - 1, "http://localhost/test.mpd");
+  manager->Delete ();
+  if (m_mpd == 0)
+    {
+      return;
+    }
+
+  const std::vector<dash::mpd::IRepresentation*>& reps =
+    m_mpd->GetPeriods ().at (0)->GetAdaptationSets ().at (0)->GetRepresentation ();
+  for (std::vector<dash::mpd::IRepresentation*>::const_iterator it = reps.begin (); it != reps.end (); ++it)
+    {
+      m_representations[(*it)->GetId ()] = *it;
+    }
+}
+
+void
+AdaptationLogicLadderTest::DoTeardown (void)
+{
+  m_representations.clear ();
+  delete m_mpd;
+  m_mpd = 0;
+}
+
+std::string
+AdaptationLogicLadderTest::Id (const dash::mpd::IRepresentation* rep)
+{
+  return rep == 0 ? "none" : rep->GetId ();
+}
+
+dash::mpd::IRepresentation*
+AdaptationLogicLadderTest::WalkHighestBelow (double bitrate)
+{
+  dash::mpd::IRepresentation* found = 0;
+  for (dash::player::RepresentationsMap::iterator it = m_representations.begin (); it != m_representations.end (); ++it)
+    {
+      if (it->second->GetBandwidth () < bitrate && (found == 0 || it->second->GetBandwidth () > found->GetBandwidth ()))
+        {
+          found = it->second;
+        }
+    }
+  return found;
+}
+
+dash::mpd::IRepresentation*
+AdaptationLogicLadderTest::WalkNextHigher (double bitrate)
+{
+  dash::mpd::IRepresentation* found = 0;
+  for (dash::player::RepresentationsMap::iterator it = m_representations.begin (); it != m_representations.end (); ++it)
+    {
+      if (it->second->GetBandwidth () > bitrate && (found == 0 || it->second->GetBandwidth () < found->GetBandwidth ()))
+        {
+          found = it->second;
+        }
+    }
+  return found;
+}
+
+void
+AdaptationLogicLadderTest::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_NE (m_mpd, 0, "MPD not parsed");
+  dash::player::AdaptationLogic logic (0);
+
+  // Without representations there is nothing to select
+  dash::player::RepresentationsMap none;
+  logic.SetAvailableRepresentations (&none);
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetLowestRepresentation ()), "none", "lowest of no representations");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetHighestRepresentationBelow (1e6)), "none", "highest of no representations");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetNextHigherRepresentation (1e6)), "none", "next higher of no representations");
+
+  logic.SetAvailableRepresentations (&m_representations);
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetLowestRepresentation ()), "3", "wrong lowest representation");
+
+  // Below the lowest rung
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetHighestRepresentationBelow (0)), "none", "representation below 0");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetHighestRepresentationBelow (499999)), "none", "representation below the lowest");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetNextHigherRepresentation (0)), "3", "lowest not next higher than 0");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetNextHigherRepresentation (499999.5)), "3", "lowest not next higher");
+
+  // Exactly at a rung, which is neither below nor higher
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetHighestRepresentationBelow (500000)), "none", "lowest rung below its bitrate");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetNextHigherRepresentation (500000)), "2", "lowest rung higher than its bitrate");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetHighestRepresentationBelow (1000000)), "3", "middle rung below its bitrate");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetNextHigherRepresentation (1000000)), "1", "middle rung higher than its bitrate");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetHighestRepresentationBelow (2000000)), "2", "highest rung below its bitrate");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetNextHigherRepresentation (2000000)), "none", "highest rung higher than its bitrate");
+
+  // Above the highest rung
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetHighestRepresentationBelow (2000000.5)), "1", "highest not below");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetHighestRepresentationBelow (1e12)), "1", "highest not below 1 Tbit/s");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetNextHigherRepresentation (1e12)), "none", "representation above 1 Tbit/s");
+
+  // Of equal bandwidths, the first by id
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetHighestRepresentationBelow (1000001)), "2", "tie not resolved by id");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetHighestRepresentationBelow (1999999)), "2", "tie not resolved by id");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetNextHigherRepresentation (500001)), "2", "tie not resolved by id");
+  NS_TEST_EXPECT_MSG_EQ (Id (logic.GetNextHigherRepresentation (999999.5)), "2", "tie not resolved by id");
+
+  // And the same as walking all representations, around every rung
+  std::vector<double> bitrates;
+  bitrates.push_back (-1);
+  bitrates.push_back (1e12);
+  for (dash::player::RepresentationsMap::iterator it = m_representations.begin (); it != m_representations.end (); ++it)
+    {
+      double bandwidth = it->second->GetBandwidth ();
+      bitrates.push_back (bandwidth - 1);
+      bitrates.push_back (bandwidth - 0.5);
+      bitrates.push_back (bandwidth);
+      bitrates.push_back (bandwidth + 0.5);
+      bitrates.push_back (bandwidth + 1);
+    }
+  for (std::vector<double>::const_iterator bitrate = bitrates.begin (); bitrate != bitrates.end (); ++bitrate)
+    {
+      NS_TEST_EXPECT_MSG_EQ (Id (logic.GetHighestRepresentationBelow (*bitrate)), Id (WalkHighestBelow (*bitrate)),
+                             "highest below " << *bitrate << " differs from a walk");
+      NS_TEST_EXPECT_MSG_EQ (Id (logic.GetNextHigherRepresentation (*bitrate)), Id (WalkNextHigher (*bitrate)),
+                             "next higher than " << *bitrate << " differs from a walk");
+    }
+}
+
+
+static class AdaptationLogicTestSuite : public TestSuite
+{
+public:
+  AdaptationLogicTestSuite ()
+    : TestSuite ("adaptation-logic", UNIT)
+  {
+    AddTestCase (new AdaptationLogicLadderTest, TestCase::QUICK);
+  }
+} g_adaptationLogicTestSuite;
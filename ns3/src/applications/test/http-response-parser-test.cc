@@ -0,0 +1,332 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/packet.h"
+#include "ns3/http-response-parser.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/**
+ * Feeds a byte stream to HttpResponseParser the way HttpClientApplication does, as
+ * packets cut at given offsets, and checks each response completed against the expected one
+ */
+class HttpResponseParserTest : public TestCase
+{
+public:
+  HttpResponseParserTest (std::string name);
+
+protected:
+  struct Response
+  {
+    Response (int status, std::string body, bool keepAlive, uint32_t end)
+      : status (status), body (body), keepAlive (keepAlive), end (end)
+    {
+    }
+    int status;
+    std::string body;
+    bool keepAlive;
+    uint32_t end;     //!< offset in the stream right after the response
+  };
+
+  /**
+   * \brief Check stream parsed whole, cut at every single offset and cut into single bytes
+   * \param complete whether the last response is expected to complete
+   */
+  void Check (const std::string& stream, const std::vector<Response>& expected, bool complete = true);
+
+private:
+  void Parse (const std::string& stream, const std::vector<uint32_t>& cuts);
+  void Compare (const std::vector<Response>& expected, bool complete, const std::string& how);
+  void OnBody (Ptr<const Packet> body);
+
+  HttpResponseParser m_parser;
+  std::vector<Response> m_responses;
+  std::string m_body;
+};
+
+HttpResponseParserTest::HttpResponseParserTest (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+HttpResponseParserTest::OnBody (Ptr<const Packet> body)
+{
+  std::vector<uint8_t> bytes (body->GetSize ());
+  if (!bytes.empty ())
+    {
+      body->CopyData (&bytes[0], bytes.size ());
+    }
+  m_body.append (bytes.begin (), bytes.end ());
+}
+
+void
+HttpResponseParserTest::Parse (const std::string& stream, const std::vector<uint32_t>& cuts)
+{
+  m_parser = HttpResponseParser ();
+  m_parser.SetBodyCallback (MakeCallback (&HttpResponseParserTest::OnBody, this));
+  m_responses.clear ();
+  m_body.clear ();
+
+  uint32_t start = 0;
+  for (uint32_t c = 0; c <= cuts.size (); c++)
+    {
+      uint32_t end = (c < cuts.size ()) ? cuts[c] : stream.size ();
+      Ptr<Packet> packet = Create<Packet> ((const uint8_t*) stream.data () + start, end - start);
+      uint32_t offset = 0;
+      while (offset < packet->GetSize ())
+        {
+          offset += m_parser.Feed (packet, offset);
+          if (m_parser.HasError ())
+            {
+              return;
+            }
+          if (m_parser.IsComplete ())
+            {
+              NS_TEST_EXPECT_MSG_EQ (m_parser.GetBodyBytes (), m_body.size (), "body bytes counted");
+              m_responses.push_back (Response (m_parser.GetStatusCode (), m_body, m_parser.IsKeepAlive (), start + offset));
+              m_body.clear ();
+              m_parser.Reset ();
+            }
+        }
+      start = end;
+    }
+}
+
+void
+HttpResponseParserTest::Compare (const std::vector<Response>& expected, bool complete, const std::string& how)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_parser.HasError (), false, how << ": parse error");
+  uint32_t nComplete = complete ? expected.size () : expected.size () - 1;
+  NS_TEST_ASSERT_MSG_EQ (m_responses.size (), nComplete, how << ": number of responses completed");
+  for (uint32_t r = 0; r < nComplete; r++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_responses[r].status, expected[r].status, how << ": status of response " << r);
+      NS_TEST_EXPECT_MSG_EQ (m_responses[r].body, expected[r].body, how << ": body of response " << r);
+      NS_TEST_EXPECT_MSG_EQ (m_responses[r].keepAlive, expected[r].keepAlive, how << ": keep-alive of response " << r);
+      NS_TEST_EXPECT_MSG_EQ (m_responses[r].end, expected[r].end, how << ": end of response " << r);
+    }
+  if (!complete)
+    {
+      const Response& last = expected.back ();
+      NS_TEST_EXPECT_MSG_EQ (m_parser.HasHeader (), true, how << ": header of the last response");
+      NS_TEST_EXPECT_MSG_EQ (m_parser.GetStatusCode (), last.status, how << ": status of the last response");
+      NS_TEST_EXPECT_MSG_EQ (m_body, last.body, how << ": body of the last response");
+      NS_TEST_EXPECT_MSG_EQ (m_parser.GetBodyBytes (), last.body.size (), how << ": body bytes of the last response");
+      NS_TEST_EXPECT_MSG_EQ (m_parser.IsKeepAlive (), last.keepAlive, how << ": keep-alive of the last response");
+    }
+}
+
+void
+HttpResponseParserTest::Check (const std::string& stream, const std::vector<Response>& expected, bool complete)
+{
+  std::vector<uint32_t> cuts;
+  Parse (stream, cuts);
+  Compare (expected, complete, "whole");
+
+  for (uint32_t cut = 1; cut < stream.size (); cut++)
+    {
+      cuts.assign (1, cut);
+      Parse (stream, cuts);
+      std::ostringstream how;
+      how << "cut at " << cut;
+      Compare (expected, complete, how.str ());
+    }
+
+  cuts.clear ();
+  for (uint32_t cut = 1; cut < stream.size (); cut++)
+    {
+      cuts.push_back (cut);
+    }
+  Parse (stream, cuts);
+  Compare (expected, complete, "byte by byte");
+}
+
+
+class HttpResponseParserContentLengthTest : public HttpResponseParserTest
+{
+public:
+  HttpResponseParserContentLengthTest ();
+  virtual void DoRun (void);
+};
+
+HttpResponseParserContentLengthTest::HttpResponseParserContentLengthTest ()
+  : HttpResponseParserTest ("Bodies delimited by Content-Length, split at every byte")
+{
+}
+
+void
+HttpResponseParserContentLengthTest::DoRun (void)
+{
+  std::string body = "<MPD>segment list</MPD>\r\n\r\n";
+  std::string stream = "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/dash+xml\r\n"
+    "content-length:  27 \r\n"
+    "\r\n" + body;
+  std::vector<Response> expected (1, Response (200, body, true, stream.size ()));
+  Check (stream, expected);
+
+  // HTTP/1.0 closes the connection unless asked not to
+  stream = "HTTP/1.0 200 OK\r\nContent-Length: 4\r\n\r\nabcd";
+  expected.assign (1, Response (200, "abcd", false, stream.size ()));
+  Check (stream, expected);
+
+  stream = "HTTP/1.0 200 OK\r\nConnection: Keep-Alive\r\nContent-Length: 4\r\n\r\nabcd";
+  expected.assign (1, Response (200, "abcd", true, stream.size ()));
+  Check (stream, expected);
+
+  stream = "HTTP/1.1 404 Not Found\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+  expected.assign (1, Response (404, "", false, stream.size ()));
+  Check (stream, expected);
+
+  // Without a length the body lasts until the connection is closed
+  stream = "HTTP/1.1 200 OK\r\n\r\nuntil close";
+  expected.assign (1, Response (200, "until close", false, stream.size ()));
+  Check (stream, expected, false);
+}
+
+
+class HttpResponseParserChunkedTest : public HttpResponseParserTest
+{
+public:
+  HttpResponseParserChunkedTest ();
+  virtual void DoRun (void);
+};
+
+HttpResponseParserChunkedTest::HttpResponseParserChunkedTest ()
+  : HttpResponseParserTest ("Chunked bodies with extensions and trailers, split at every byte")
+{
+}
+
+void
+HttpResponseParserChunkedTest::DoRun (void)
+{
+  std::string stream = "HTTP/1.1 200 OK\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "5\r\nhello\r\n"
+    "1A;name=value;other=\"quoted\"\r\nabcdefghijklmnopqrstuvwxyz\r\n"
+    "3 ; ext\r\n\r\n\r\r\n"
+    "0;last\r\n"
+    "X-Checksum: 1234\r\n"
+    "X-Other: 5678\r\n"
+    "\r\n";
+  std::vector<Response> expected (1, Response (200, "helloabcdefghijklmnopqrstuvwxyz\r\n\r", true, stream.size ()));
+  Check (stream, expected);
+
+  // No trailer, upper case hexadecimal size
+  stream = "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip, Chunked\r\n\r\n"
+    "B\r\n0123456789A\r\n0\r\n\r\n";
+  expected.assign (1, Response (200, "0123456789A", true, stream.size ()));
+  Check (stream, expected);
+}
+
+
+class HttpResponseParserPipelineTest : public HttpResponseParserTest
+{
+public:
+  HttpResponseParserPipelineTest ();
+  virtual void DoRun (void);
+};
+
+HttpResponseParserPipelineTest::HttpResponseParserPipelineTest ()
+  : HttpResponseParserTest ("Pipelined responses in one packet")
+{
+}
+
+void
+HttpResponseParserPipelineTest::DoRun (void)
+{
+  std::string first = "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n0123456789";
+  std::string second = "HTTP/1.1 304 Not Modified\r\nContent-Length: 10\r\n\r\n";
+  std::string third = "HTTP/1.1 206 Partial Content\r\nTransfer-Encoding: chunked\r\n\r\n"
+    "4;x=y\r\nabcd\r\n0\r\nTrailer: value\r\n\r\n";
+  std::string fourth = "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 3\r\n\r\nxyz";
+
+  std::string stream = first + second + third + fourth;
+  std::vector<Response> expected;
+  expected.push_back (Response (200, "0123456789", true, first.size ()));
+  expected.push_back (Response (304, "", true, first.size () + second.size ()));
+  expected.push_back (Response (206, "abcd", true, first.size () + second.size () + third.size ()));
+  expected.push_back (Response (200, "xyz", false, stream.size ()));
+  Check (stream, expected);
+
+  // Feed stops right after a complete response
+  HttpResponseParser parser;
+  Ptr<Packet> packet = Create<Packet> ((const uint8_t*) stream.data (), stream.size ());
+  NS_TEST_EXPECT_MSG_EQ (parser.Feed (packet), first.size (), "bytes of the next response consumed");
+  NS_TEST_EXPECT_MSG_EQ (parser.IsComplete (), true, "first response not complete");
+  NS_TEST_EXPECT_MSG_EQ (parser.Feed (packet, first.size ()), 0, "bytes consumed before Reset");
+  parser.Reset ();
+  NS_TEST_EXPECT_MSG_EQ (parser.Feed (packet, first.size ()), second.size (), "second response");
+  NS_TEST_EXPECT_MSG_EQ (parser.GetBodyBytes (), 0, "body of a 304 response");
+}
+
+
+class HttpResponseParserErrorTest : public TestCase
+{
+public:
+  HttpResponseParserErrorTest ();
+  virtual void DoRun (void);
+
+private:
+  bool Fails (const std::string& stream);
+};
+
+HttpResponseParserErrorTest::HttpResponseParserErrorTest ()
+  : TestCase ("Malformed responses")
+{
+}
+
+bool
+HttpResponseParserErrorTest::Fails (const std::string& stream)
+{
+  HttpResponseParser parser;
+  parser.Feed (Create<Packet> ((const uint8_t*) stream.data (), stream.size ()));
+  return parser.HasError ();
+}
+
+void
+HttpResponseParserErrorTest::DoRun (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (Fails ("HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\na"), false, "valid response");
+  NS_TEST_EXPECT_MSG_EQ (Fails ("ICY 200 OK\r\nContent-Length: 1\r\n\r\na"), true, "not HTTP");
+  NS_TEST_EXPECT_MSG_EQ (Fails ("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nxyz\r\n"), true,
+                         "invalid chunk size");
+  NS_TEST_EXPECT_MSG_EQ (Fails ("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nabc\r\n"), true,
+                         "chunk longer than its size");
+  NS_TEST_EXPECT_MSG_EQ (Fails ("HTTP/1.1 200 OK\r\nX: " + std::string (20000, 'x')), true, "header too long");
+  NS_TEST_EXPECT_MSG_EQ (Fails ("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n1;" + std::string (2000, 'x')),
+                         true, "chunk extension too long");
+}
+
+
+static class HttpResponseParserTestSuite : public TestSuite
+{
+public:
+  HttpResponseParserTestSuite ()
+    : TestSuite ("http-response-parser", UNIT)
+  {
+    AddTestCase (new HttpResponseParserContentLengthTest, TestCase::QUICK);
+    AddTestCase (new HttpResponseParserChunkedTest, TestCase::QUICK);
+    AddTestCase (new HttpResponseParserPipelineTest, TestCase::QUICK);
+    AddTestCase (new HttpResponseParserErrorTest, TestCase::QUICK);
+  }
+} g_httpResponseParserTestSuite;
@@ -0,0 +1,347 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/random-variable-stream.h"
+#include "ns3/test.h"
+#include "libdash.h"
+#include "multimediabuffer.h"
+
+using namespace ns3;
+
+/**
+ * Segment ids sort so that a layer ("a") comes before its base ("b") in a segment's
+ * entries and becomes the one counted in the total. Segments of "c" last a third of a
+ * second, so that levels carry rounding errors. The second adaptation set holds a "b"
+ * with longer segments, replacing a buffered "b" changes its duration.
+ */
+static const char g_mpd[] =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+  "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" type=\"static\" minBufferTime=\"PT2S\""
+  " mediaPresentationDuration=\"PT600S\" profiles=\"urn:mpeg:dash:profile:isoff-main:2011\">"
+  "<Period>"
+  "<AdaptationSet>"
+  "<Representation id=\"a\" dependencyId=\"b\" bandwidth=\"2000000\">"
+  "<SegmentTemplate media=\"a_$Number$\" duration=\"4\" startNumber=\"0\"/></Representation>"
+  "<Representation id=\"b\" bandwidth=\"1000000\">"
+  "<SegmentTemplate media=\"b_$Number$\" duration=\"2\" startNumber=\"0\"/></Representation>"
+  "<Representation id=\"c\" bandwidth=\"500000\">"
+  "<SegmentTemplate media=\"c_$Number$\" duration=\"1\" timescale=\"3\" startNumber=\"0\"/></Representation>"
+  "<Representation id=\"d\" dependencyId=\"b c\" bandwidth=\"3000000\">"
+  "<SegmentTemplate media=\"d_$Number$\" duration=\"2\" startNumber=\"0\"/></Representation>"
+  "</AdaptationSet>"
+  "<AdaptationSet>"
+  "<Representation id=\"b\" bandwidth=\"1000000\">"
+  "<SegmentTemplate media=\"b_$Number$\" duration=\"3\" startNumber=\"0\"/></Representation>"
+  "</AdaptationSet>"
+  "</Period>"
+  "</MPD>";
+
+/**
+ * Buffer whose levels can be recomputed by walking all of its segments, as
+ * getBufferedSeconds used to do
+ */
+class MultimediaBufferTestBuffer : public dash::player::MultimediaBuffer
+{
+public:
+  MultimediaBufferTestBuffer (unsigned int maxBufferedSeconds)
+    : MultimediaBuffer (maxBufferedSeconds)
+  {
+  }
+
+  // Sum of the first entry of each segment
+  double WalkBufferedSeconds (void)
+  {
+    double seconds = 0.0;
+    for (MBuffer::iterator it = buff.begin (); it != buff.end (); ++it)
+      {
+        seconds += it->second.begin ()->second.segmentDuration;
+      }
+    return seconds;
+  }
+
+  double WalkBufferedSeconds (const std::string& repId)
+  {
+    double seconds = 0.0;
+    for (MBuffer::iterator it = buff.begin (); it != buff.end (); ++it)
+      {
+        BufferRepresentationEntryMap::iterator k = it->second.find (repId);
+        if (k != it->second.end ())
+          {
+            seconds += k->second.segmentDuration;
+          }
+      }
+    return seconds;
+  }
+
+  bool IsBufferEmpty (void) const
+  {
+    return buff.empty ();
+  }
+};
+
+
+class MultimediaBufferTest : public TestCase
+{
+public:
+  MultimediaBufferTest (std::string name);
+
+protected:
+  virtual void DoSetup (void);
+  virtual void DoTeardown (void);
+
+  const dash::mpd::IRepresentation* Find (unsigned int set, const std::string& id);
+
+  // Compare the running levels against a walk of the buffer
+  void CheckLevels (MultimediaBufferTestBuffer& buffer, const std::string& when);
+  // Consume everything, then check that no residue is left
+  void Drain (MultimediaBufferTestBuffer& buffer);
+
+  dash::mpd::IMPD* m_mpd;
+  std::vector<std::string> m_ids;
+};
+
+MultimediaBufferTest::MultimediaBufferTest (std::string name)
+  : TestCase (name),
+    m_mpd (0)
+{
+  m_ids.push_back ("a");
+  m_ids.push_back ("b");
+  m_ids.push_back ("c");
+  m_ids.push_back ("d");
+  m_ids.push_back ("x"); // never buffered
+}
+
+void
+MultimediaBufferTest::DoSetup (void)
+{
+  dash::IDASHManager *manager = CreateDashManager ();
+  m_mpd = manager->OpenBuffer (g_mpd, sizeof (g_mpd) - 1, "http://localhost/test.mpd");
+  manager->Delete ();
+}
+
+void
+MultimediaBufferTest::DoTeardown (void)
+{
+  delete m_mpd;
+  m_mpd = 0;
+}
+
+const dash::mpd::IRepresentation*
+MultimediaBufferTest::Find (unsigned int set, const std::string& id)
+{
+  const std::vector<dash::mpd::IRepresentation*>& reps =
+    m_mpd->GetPeriods ().at (0)->GetAdaptationSets ().at (set)->GetRepresentation ();
+  for (std::vector<dash::mpd::IRepresentation*>::const_iterator it = reps.begin (); it != reps.end (); ++it)
+    {
+      if ((*it)->GetId () == id)
+        {
+          return *it;
+        }
+    }
+  return 0;
+}
+
+void
+MultimediaBufferTest::CheckLevels (MultimediaBufferTestBuffer& buffer, const std::string& when)
+{
+  NS_TEST_EXPECT_MSG_EQ_TOL (buffer.getBufferedSeconds (), buffer.WalkBufferedSeconds (), 1e-9,
+                             "total level differs from the buffer " << when);
+  for (std::vector<std::string>::const_iterator id = m_ids.begin (); id != m_ids.end (); ++id)
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL (buffer.getBufferedSeconds (*id), buffer.WalkBufferedSeconds (*id), 1e-9,
+                                 "level of " << *id << " differs from the buffer " << when);
+    }
+  NS_TEST_EXPECT_MSG_EQ (buffer.isEmpty (), buffer.IsBufferEmpty (), "isEmpty wrong " << when);
+}
+
+void
+MultimediaBufferTest::Drain (MultimediaBufferTestBuffer& buffer)
+{
+  while (!buffer.IsBufferEmpty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (buffer.isEmpty (), false, "segments left in an empty buffer");
+      buffer.consumeFromBuffer ();
+      CheckLevels (buffer, "while draining");
+    }
+
+  // Exactly, whatever rounding errors were accumulated
+  NS_TEST_EXPECT_MSG_EQ (buffer.getBufferedSeconds (), 0.0, "total level left in the drained buffer");
+  for (std::vector<std::string>::const_iterator id = m_ids.begin (); id != m_ids.end (); ++id)
+    {
+      NS_TEST_EXPECT_MSG_EQ (buffer.getBufferedSeconds (*id), 0.0, "level of " << *id << " left in the drained buffer");
+    }
+  NS_TEST_EXPECT_MSG_EQ (buffer.isEmpty (), true, "drained buffer not empty");
+  NS_TEST_EXPECT_MSG_EQ (buffer.consumeFromBuffer ().repId, "InvalidSegment", "segment consumed from the drained buffer");
+}
+
+
+class MultimediaBufferLayerTest : public MultimediaBufferTest
+{
+public:
+  MultimediaBufferLayerTest ();
+  virtual void DoRun (void);
+};
+
+MultimediaBufferLayerTest::MultimediaBufferLayerTest ()
+  : MultimediaBufferTest ("Levels follow replaced and layered segments")
+{
+}
+
+void
+MultimediaBufferLayerTest::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_NE (m_mpd, 0, "MPD not parsed");
+  const dash::mpd::IRepresentation* a = Find (0, "a");
+  const dash::mpd::IRepresentation* b = Find (0, "b");
+  const dash::mpd::IRepresentation* c = Find (0, "c");
+  const dash::mpd::IRepresentation* d = Find (0, "d");
+  const dash::mpd::IRepresentation* longB = Find (1, "b");
+
+  MultimediaBufferTestBuffer buffer (30);
+  CheckLevels (buffer, "before any segment");
+
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (0, b, 1e6), true, "segment 0 of b not added");
+  CheckLevels (buffer, "after segment 0 of b");
+  NS_TEST_EXPECT_MSG_EQ_TOL (buffer.getBufferedSeconds (), 2.0, 1e-9, "total level wrong");
+
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (1, c, 1e6), true, "segment 1 of c not added");
+  CheckLevels (buffer, "after segment 1 of c");
+
+  // The layer sorts first, the total now counts it for segment 0
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (0, a, 1e6), true, "layer a not added to segment 0");
+  CheckLevels (buffer, "after layer a on segment 0");
+  NS_TEST_EXPECT_MSG_EQ_TOL (buffer.getBufferedSeconds (), 4.0 + 1.0 / 3, 1e-9, "layer not counted in the total");
+
+  // A layer needs all the segments it depends on
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (1, d, 1e6), false, "layer d added without b");
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (1, a, 1e6), false, "layer a added without b");
+  CheckLevels (buffer, "after refused layers");
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (1, b, 1e6), true, "segment 1 of b not added");
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (1, d, 1e6), true, "layer d not added to segment 1");
+  CheckLevels (buffer, "after layer d on segment 1");
+
+  // Replacing in place counts the new duration only
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (0, longB, 1e6), true, "segment 0 of b not replaced");
+  CheckLevels (buffer, "after replacing segment 0 of b");
+  NS_TEST_EXPECT_MSG_EQ_TOL (buffer.getBufferedSeconds ("b"), 5.0, 1e-9, "replaced segment counted twice");
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (1, longB, 1e6), true, "segment 1 of b not replaced");
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (1, c, 1e6), true, "segment 1 of c not replaced");
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (0, a, 1e6), true, "layer a not replaced");
+  CheckLevels (buffer, "after replacing segment 1");
+
+  // The first entry of a segment can be replaced by a layer added later
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (1, a, 1e6), true, "layer a not added to segment 1");
+  CheckLevels (buffer, "after layer a on segment 1");
+  NS_TEST_EXPECT_MSG_EQ_TOL (buffer.getBufferedSeconds (), 8.0, 1e-9, "total level wrong");
+
+  // The entry with the most dependencies is played
+  NS_TEST_EXPECT_MSG_EQ (buffer.consumeFromBuffer ().repId, "a", "segment 0 played at the wrong layer");
+  CheckLevels (buffer, "after consuming segment 0");
+  NS_TEST_EXPECT_MSG_EQ (buffer.consumeFromBuffer ().repId, "d", "segment 1 played at the wrong layer");
+  CheckLevels (buffer, "after consuming segment 1");
+  Drain (buffer);
+
+  // A drained buffer counts from zero again
+  NS_TEST_EXPECT_MSG_EQ (buffer.addToBuffer (2, c, 1e6), true, "segment 2 of c not added");
+  CheckLevels (buffer, "after refilling");
+  NS_TEST_EXPECT_MSG_EQ_TOL (buffer.getBufferedSeconds (), 1.0 / 3, 1e-9, "total level wrong after refilling");
+  Drain (buffer);
+}
+
+
+class MultimediaBufferRandomTest : public MultimediaBufferTest
+{
+public:
+  MultimediaBufferRandomTest ();
+  virtual void DoRun (void);
+};
+
+MultimediaBufferRandomTest::MultimediaBufferRandomTest ()
+  : MultimediaBufferTest ("Levels match the buffer over random operations down to empty")
+{
+}
+
+void
+MultimediaBufferRandomTest::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_NE (m_mpd, 0, "MPD not parsed");
+  std::vector<const dash::mpd::IRepresentation*> bases;
+  bases.push_back (Find (0, "b"));
+  bases.push_back (Find (0, "c"));
+  bases.push_back (Find (1, "b"));
+  std::vector<const dash::mpd::IRepresentation*> layers;
+  layers.push_back (Find (0, "a"));
+  layers.push_back (Find (0, "d"));
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  MultimediaBufferTestBuffer buffer (20);
+  unsigned int next = 0;  // next segment to download, segments before it are buffered or played
+  for (uint32_t round = 0; round < 10; round++)
+    {
+      for (uint32_t i = 0; i < 200; i++)
+        {
+          unsigned int played = buffer.nextSegmentNrToBeConsumed ();
+          switch (random->GetInteger (0, 3))
+            {
+            case 0:
+              if (buffer.addToBuffer (next, bases.at (random->GetInteger (0, bases.size () - 1)), 1e6))
+                {
+                  next++;
+                }
+              break;
+            case 1:
+              if (next > played)
+                {
+                  buffer.addToBuffer (random->GetInteger (played, next - 1),
+                                      layers.at (random->GetInteger (0, layers.size () - 1)), 1e6);
+                }
+              break;
+            case 2:
+              if (next > played)
+                {
+                  buffer.addToBuffer (random->GetInteger (played, next - 1),
+                                      bases.at (random->GetInteger (0, bases.size () - 1)), 1e6);
+                }
+              break;
+            default:
+              buffer.consumeFromBuffer ();
+              break;
+            }
+          std::ostringstream when;
+          when << "in round " << round << " at operation " << i;
+          CheckLevels (buffer, when.str ());
+        }
+      Drain (buffer);
+      NS_TEST_ASSERT_MSG_EQ (buffer.nextSegmentNrToBeConsumed (), next, "segments left behind");
+    }
+}
+
+
+static class MultimediaBufferTestSuite : public TestSuite
+{
+public:
+  MultimediaBufferTestSuite ()
+    : TestSuite ("multimedia-buffer", UNIT)
+  {
+    AddTestCase (new MultimediaBufferLayerTest, TestCase::QUICK);
+    AddTestCase (new MultimediaBufferRandomTest, TestCase::QUICK);
+  }
+} g_multimediaBufferTestSuite;
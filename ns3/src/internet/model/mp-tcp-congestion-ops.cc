@@ -0,0 +1,423 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * The algorithms were moved here from mp-tcp-socket-base.cc, written by
+ * Morteza Kheirkhah <m.kheirkhah@sussex.ac.uk>
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <cstdlib>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/mp-tcp-congestion-ops.h"
+
+NS_LOG_COMPONENT_DEFINE("MpTcpCongestionOps");
+
+namespace ns3
+{
+
+NS_OBJECT_ENSURE_REGISTERED(MpTcpCongestionOps);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpUncoupledReno);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpLia);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpOlia);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpBalia);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpFullyCoupled);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpCoupledScalable);
+
+TypeId
+MpTcpCongestionOps::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpCongestionOps")
+      .SetParent<Object>();
+  return tid;
+}
+
+MpTcpCongestionOps::MpTcpCongestionOps() :
+    m_totalCwnd(0), m_sumOverRtt(0)
+{
+  NS_LOG_FUNCTION(this);
+}
+
+MpTcpCongestionOps::~MpTcpCongestionOps()
+{
+  NS_LOG_FUNCTION(this);
+  // Subflows may outlive this object (e.g. the socket switched algorithm), so detach from their traces
+  for (uint32_t i = 0; i < m_subflows.size(); i++)
+    {
+      std::ostringstream oss;
+      oss << i;
+      m_subflows[i].sFlow->TraceDisconnect("cWindow", oss.str(), MakeCallback(&MpTcpCongestionOps::CwndChanged, this));
+    }
+}
+
+void
+MpTcpCongestionOps::AddSubflow(Ptr<MpTcpSubFlow> sFlow)
+{
+  NS_LOG_FUNCTION(this << sFlow);
+  SubflowState state;
+  state.sFlow = sFlow;
+  state.window = 0;
+  state.rtt = 0;
+  state.overRtt = 0;
+  state.overRtt2 = 0;
+  m_subflows.push_back(state);
+  m_overRtt.insert(0);
+  m_overRtt2.insert(0);
+
+  std::ostringstream oss;
+  oss << m_subflows.size() - 1;
+  sFlow->TraceConnect("cWindow", oss.str(), MakeCallback(&MpTcpCongestionOps::CwndChanged, this));
+  Refresh(m_subflows.size() - 1);
+}
+
+void
+MpTcpCongestionOps::UpdateSubflow(uint8_t sFlowIdx)
+{
+  if (sFlowIdx < m_subflows.size())
+    Refresh(sFlowIdx);
+}
+
+uint32_t
+MpTcpCongestionOps::GetNSubflows() const
+{
+  return m_subflows.size();
+}
+
+uint32_t
+MpTcpCongestionOps::GetTotalCwnd() const
+{
+  return (uint32_t) m_totalCwnd;
+}
+
+void
+MpTcpCongestionOps::CwndChanged(std::string context, uint32_t oldCwnd, uint32_t newCwnd)
+{
+  Refresh(atoi(context.c_str()));
+}
+
+void
+MpTcpCongestionOps::Refresh(uint8_t sFlowIdx)
+{
+  SubflowState &s = m_subflows[sFlowIdx];
+  m_totalCwnd -= s.window;
+  m_sumOverRtt -= s.overRtt;
+  m_overRtt.erase(m_overRtt.find(s.overRtt));
+  m_overRtt2.erase(m_overRtt2.find(s.overRtt2));
+
+  Ptr<MpTcpSubFlow> sFlow = s.sFlow;
+  s.window = sFlow->m_inFastRec ? sFlow->ssthresh : sFlow->cwnd.Get();
+  s.rtt = std::max(sFlow->rtt->GetCurrentEstimate().GetSeconds(), 1e-6);
+  s.overRtt = s.window / s.rtt;
+  s.overRtt2 = s.overRtt / s.rtt;
+
+  m_totalCwnd += s.window;
+  m_sumOverRtt += s.overRtt;
+  m_overRtt.insert(s.overRtt);
+  m_overRtt2.insert(s.overRtt2);
+}
+
+void
+MpTcpCongestionOps::IncreaseCwnd(uint8_t sFlowIdx, double adder)
+{
+  Ptr<MpTcpSubFlow> sFlow = m_subflows[sFlowIdx].sFlow;
+  if (adder >= 0)
+    sFlow->cwnd += static_cast<uint32_t>(std::max(1.0, adder));
+  else
+    sFlow->cwnd -= static_cast<uint32_t>(std::min(-adder, (double) sFlow->cwnd.Get() - sFlow->MSS));
+}
+
+uint32_t
+MpTcpCongestionOps::GetSsThresh(uint8_t sFlowIdx, uint32_t bytesInFlight)
+{
+  return std::max(2 * m_subflows[sFlowIdx].sFlow->MSS, bytesInFlight / 2);
+}
+
+void
+MpTcpCongestionOps::PktsAcked(uint8_t sFlowIdx, uint32_t ackedBytes)
+{
+}
+
+void
+MpTcpCongestionOps::CongestionEvent(uint8_t sFlowIdx)
+{
+}
+
+/*
+ * Uncoupled Reno
+ */
+TypeId
+MpTcpUncoupledReno::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpUncoupledReno")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpUncoupledReno>();
+  return tid;
+}
+
+std::string
+MpTcpUncoupledReno::GetName() const
+{
+  return "Uncoupled-TCP";
+}
+
+void
+MpTcpUncoupledReno::CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes)
+{
+  Ptr<MpTcpSubFlow> sFlow = m_subflows[sFlowIdx].sFlow;
+  double acked = std::min(ackedBytes, sFlow->MSS);
+  IncreaseCwnd(sFlowIdx, acked * sFlow->MSS / sFlow->cwnd.Get());
+  NS_LOG_LOGIC("Subflow " << (int) sFlowIdx << " Congestion Control (Uncoupled_TCPs) cwnd " << sFlow->cwnd);
+}
+
+/*
+ * LIA
+ */
+TypeId
+MpTcpLia::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpLia")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpLia>();
+  return tid;
+}
+
+std::string
+MpTcpLia::GetName() const
+{
+  return "Linked-Increase";
+}
+
+double
+MpTcpLia::GetAlpha() const
+{
+  if (m_sumOverRtt <= 0)
+    return 1;
+  return m_totalCwnd * (*m_overRtt2.rbegin()) / (m_sumOverRtt * m_sumOverRtt);
+}
+
+void
+MpTcpLia::CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes)
+{
+  Ptr<MpTcpSubFlow> sFlow = m_subflows[sFlowIdx].sFlow;
+  double acked = std::min(ackedBytes, sFlow->MSS);
+  double alpha = GetAlpha();
+  double adder = std::min(alpha * acked * sFlow->MSS / m_totalCwnd, acked * sFlow->MSS / sFlow->cwnd.Get());
+  IncreaseCwnd(sFlowIdx, adder);
+  NS_LOG_LOGIC("Subflow " << (int) sFlowIdx << " Congestion Control (LIA): alpha " << alpha << " increment is " << adder << " cwnd " << sFlow->cwnd);
+}
+
+/*
+ * OLIA
+ */
+TypeId
+MpTcpOlia::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpOlia")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpOlia>();
+  return tid;
+}
+
+MpTcpOlia::MpTcpOlia() :
+    m_nextAlphaUpdate(Seconds(0))
+{
+  NS_LOG_FUNCTION(this);
+}
+
+std::string
+MpTcpOlia::GetName() const
+{
+  return "OLIA";
+}
+
+void
+MpTcpOlia::UpdateAlpha()
+{
+  uint32_t n = m_subflows.size();
+  m_lastLossBytes.resize(n, 0);
+  m_sinceLossBytes.resize(n, 0);
+  m_alpha.assign(n, 0);
+
+  // M: subflows with the largest window; B: best paths, largest l_r^2 / rtt_r
+  double maxWindow = 0, maxQuality = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double l = std::max(m_lastLossBytes[i], m_sinceLossBytes[i]);
+      maxWindow = std::max(maxWindow, m_subflows[i].window);
+      maxQuality = std::max(maxQuality, l * l / m_subflows[i].rtt);
+    }
+  uint32_t nMax = 0, nBestNotMax = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double l = std::max(m_lastLossBytes[i], m_sinceLossBytes[i]);
+      if (m_subflows[i].window == maxWindow)
+        nMax++;
+      else if (l * l / m_subflows[i].rtt == maxQuality)
+        nBestNotMax++;
+    }
+  if (nBestNotMax == 0)
+    return;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double l = std::max(m_lastLossBytes[i], m_sinceLossBytes[i]);
+      if (m_subflows[i].window == maxWindow)
+        m_alpha[i] = -1.0 / (n * nMax);
+      else if (l * l / m_subflows[i].rtt == maxQuality)
+        m_alpha[i] = 1.0 / (n * nBestNotMax);
+    }
+}
+
+void
+MpTcpOlia::PktsAcked(uint8_t sFlowIdx, uint32_t ackedBytes)
+{
+  if (m_sinceLossBytes.size() < m_subflows.size())
+    m_sinceLossBytes.resize(m_subflows.size(), 0);
+  m_sinceLossBytes[sFlowIdx] += ackedBytes;
+}
+
+void
+MpTcpOlia::CongestionEvent(uint8_t sFlowIdx)
+{
+  m_lastLossBytes.resize(m_subflows.size(), 0);
+  m_sinceLossBytes.resize(m_subflows.size(), 0);
+  m_lastLossBytes[sFlowIdx] = m_sinceLossBytes[sFlowIdx];
+  m_sinceLossBytes[sFlowIdx] = 0;
+  m_nextAlphaUpdate = Seconds(0); // Best paths may have changed
+}
+
+void
+MpTcpOlia::CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes)
+{
+  if (Simulator::Now() >= m_nextAlphaUpdate || m_alpha.size() < m_subflows.size())
+    {
+      UpdateAlpha();
+      m_nextAlphaUpdate = Simulator::Now() + Seconds(m_subflows[sFlowIdx].rtt);
+    }
+  const SubflowState &s = m_subflows[sFlowIdx];
+  double acked = std::min(ackedBytes, s.sFlow->MSS);
+  double adder = acked * s.sFlow->MSS * (s.overRtt2 / (m_sumOverRtt * m_sumOverRtt) + m_alpha[sFlowIdx] / s.window);
+  IncreaseCwnd(sFlowIdx, adder);
+  NS_LOG_LOGIC("Subflow " << (int) sFlowIdx << " Congestion Control (OLIA): alpha " << m_alpha[sFlowIdx] << " increment is " << adder << " cwnd " << s.sFlow->cwnd);
+}
+
+/*
+ * BALIA
+ */
+TypeId
+MpTcpBalia::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpBalia")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpBalia>();
+  return tid;
+}
+
+std::string
+MpTcpBalia::GetName() const
+{
+  return "BALIA";
+}
+
+void
+MpTcpBalia::CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes)
+{
+  const SubflowState &s = m_subflows[sFlowIdx];
+  double acked = std::min(ackedBytes, s.sFlow->MSS);
+  double alpha = *m_overRtt.rbegin() / s.overRtt;
+  double adder = acked * s.sFlow->MSS * s.overRtt2 / (m_sumOverRtt * m_sumOverRtt) * ((1 + alpha) / 2) * ((4 + alpha) / 5);
+  IncreaseCwnd(sFlowIdx, adder);
+  NS_LOG_LOGIC("Subflow " << (int) sFlowIdx << " Congestion Control (BALIA): alpha " << alpha << " increment is " << adder << " cwnd " << s.sFlow->cwnd);
+}
+
+uint32_t
+MpTcpBalia::GetSsThresh(uint8_t sFlowIdx, uint32_t bytesInFlight)
+{
+  const SubflowState &s = m_subflows[sFlowIdx];
+  double alpha = s.overRtt > 0 ? *m_overRtt.rbegin() / s.overRtt : 1;
+  double cwnd = s.sFlow->cwnd.Get();
+  double d = cwnd - cwnd / 2 * std::min(alpha, 1.5);
+  return std::max(2 * s.sFlow->MSS, (uint32_t) std::max(d, 0.0));
+}
+
+/*
+ * Fully coupled
+ */
+TypeId
+MpTcpFullyCoupled::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpFullyCoupled")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpFullyCoupled>();
+  return tid;
+}
+
+std::string
+MpTcpFullyCoupled::GetName() const
+{
+  return "Fully-Coupled";
+}
+
+void
+MpTcpFullyCoupled::CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes)
+{
+  Ptr<MpTcpSubFlow> sFlow = m_subflows[sFlowIdx].sFlow;
+  double acked = std::min(ackedBytes, sFlow->MSS);
+  IncreaseCwnd(sFlowIdx, acked * sFlow->MSS / m_totalCwnd);
+  NS_LOG_LOGIC("Subflow " << (int) sFlowIdx << " Congestion Control (Fully_Coupled) cwnd " << sFlow->cwnd);
+}
+
+uint32_t
+MpTcpFullyCoupled::GetSsThresh(uint8_t sFlowIdx, uint32_t bytesInFlight)
+{
+  Ptr<MpTcpSubFlow> sFlow = m_subflows[sFlowIdx].sFlow;
+  int d = (int) sFlow->cwnd.Get() - (int) (m_totalCwnd / 2);
+  return std::max(2 * sFlow->MSS, (uint32_t) std::max(d, 0));
+}
+
+/*
+ * Coupled scalable TCP
+ */
+TypeId
+MpTcpCoupledScalable::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpCoupledScalable")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpCoupledScalable>();
+  return tid;
+}
+
+std::string
+MpTcpCoupledScalable::GetName() const
+{
+  return "CST";
+}
+
+void
+MpTcpCoupledScalable::CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes)
+{
+  Ptr<MpTcpSubFlow> sFlow = m_subflows[sFlowIdx].sFlow;
+  sFlow->cwnd += static_cast<uint32_t>(std::min(ackedBytes, sFlow->MSS) * 0.01);
+}
+
+uint32_t
+MpTcpCoupledScalable::GetSsThresh(uint8_t sFlowIdx, uint32_t bytesInFlight)
+{
+  Ptr<MpTcpSubFlow> sFlow = m_subflows[sFlowIdx].sFlow;
+  int d = (int) sFlow->cwnd.Get() - (int) ((uint32_t) m_totalCwnd >> 3);
+  return std::max(2 * sFlow->MSS, (uint32_t) std::max(d, 0));
+}
+
+} //namespace ns3
@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * The algorithms were moved here from mp-tcp-socket-base.cc, written by
+ * Morteza Kheirkhah <m.kheirkhah@sussex.ac.uk>
+ */
+
+#ifndef MP_TCP_CONGESTION_OPS_H
+#define MP_TCP_CONGESTION_OPS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <set>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/mp-tcp-subflow.h"
+
+using namespace std;
+
+namespace ns3
+{
+
+/**
+ * Coupled congestion control of an MPTCP connection. Slow start and the
+ * fast recovery / timeout machinery stay in MpTcpSocketBase; an algorithm
+ * only decides the congestion avoidance increase and the slow start
+ * threshold after a fast retransmit.
+ *
+ * The connection-wide values the coupled algorithms need (total window,
+ * sum of cwnd/rtt, largest cwnd/rtt and cwnd/rtt^2) are kept up to date
+ * from the subflows' cWindow trace and from UpdateSubflow(), which the
+ * socket calls when ssthresh, fast recovery state or the RTT estimate of a
+ * subflow changes. An ACK therefore never walks the subflow list.
+ */
+class MpTcpCongestionOps : public Object
+{
+public:
+  static TypeId GetTypeId(void);
+  MpTcpCongestionOps();
+  virtual ~MpTcpCongestionOps();
+
+  virtual std::string GetName() const = 0;
+  virtual void CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes) = 0;  // Grow cwnd of a subflow above ssthresh
+  virtual uint32_t GetSsThresh(uint8_t sFlowIdx, uint32_t bytesInFlight);      // New ssthresh upon fast retransmit (Reno by default)
+  virtual void PktsAcked(uint8_t sFlowIdx, uint32_t ackedBytes);               // Called for every new ACK, in slow start too
+  virtual void CongestionEvent(uint8_t sFlowIdx);                              // Called once the subflow has reacted to a loss
+
+  void AddSubflow(Ptr<MpTcpSubFlow> sFlow);  // Subflows are registered in the socket's order and never removed
+  void UpdateSubflow(uint8_t sFlowIdx);      // Re-read the effective window and RTT of a subflow
+  uint32_t GetNSubflows() const;
+  uint32_t GetTotalCwnd() const;
+
+protected:
+  struct SubflowState
+  {
+    Ptr<MpTcpSubFlow> sFlow;
+    double window;        // ssthresh while in fast recovery, cwnd otherwise (bytes)
+    double rtt;           // Smoothed RTT (seconds)
+    double overRtt;       // window / rtt
+    double overRtt2;      // window / rtt^2
+  };
+
+  void CwndChanged(std::string context, uint32_t oldCwnd, uint32_t newCwnd);
+  void Refresh(uint8_t sFlowIdx);
+  void IncreaseCwnd(uint8_t sFlowIdx, double adder); // Apply a (possibly negative) byte increase, keeps cwnd >= 1 MSS
+
+  vector<SubflowState> m_subflows;
+  double m_totalCwnd;              // Sum of windows (bytes)
+  double m_sumOverRtt;             // Sum of window / rtt
+  multiset<double> m_overRtt;      // window / rtt of every subflow, for its maximum
+  multiset<double> m_overRtt2;     // window / rtt^2 of every subflow, for its maximum
+};
+
+/**
+ * Each subflow runs standard TCP Reno congestion avoidance on its own.
+ */
+class MpTcpUncoupledReno : public MpTcpCongestionOps
+{
+public:
+  static TypeId GetTypeId(void);
+  virtual std::string GetName() const;
+  virtual void CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes);
+};
+
+/**
+ * Linked Increases Algorithm (RFC 6356): the increase of a subflow is
+ * min(alpha * acked * MSS / total_cwnd, acked * MSS / cwnd) with
+ * alpha = total_cwnd * max(cwnd/rtt^2) / (sum(cwnd/rtt))^2.
+ */
+class MpTcpLia : public MpTcpCongestionOps
+{
+public:
+  static TypeId GetTypeId(void);
+  virtual std::string GetName() const;
+  virtual void CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes);
+  double GetAlpha() const;
+};
+
+/**
+ * Opportunistic Linked Increases Algorithm (Khalili et al., IEEE/ACM ToN 2013).
+ * alpha_r shifts window from the subflows with the largest window to the best
+ * paths, those with the largest l_r^2 / rtt_r where l_r is the data delivered
+ * between losses. The alpha values are re-evaluated upon a loss and at most
+ * once per RTT of the connection.
+ */
+class MpTcpOlia : public MpTcpCongestionOps
+{
+public:
+  static TypeId GetTypeId(void);
+  MpTcpOlia();
+  virtual std::string GetName() const;
+  virtual void CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes);
+  virtual void PktsAcked(uint8_t sFlowIdx, uint32_t ackedBytes);
+  virtual void CongestionEvent(uint8_t sFlowIdx);
+private:
+  void UpdateAlpha();
+  vector<double> m_lastLossBytes;  // l1: bytes delivered between the last two losses
+  vector<double> m_sinceLossBytes; // l2: bytes delivered since the last loss
+  vector<double> m_alpha;
+  Time m_nextAlphaUpdate;
+};
+
+/**
+ * Balanced Linked Adaptation (Peng et al., IEEE/ACM ToN 2016). With
+ * x_r = cwnd_r / rtt_r and alpha_r = max(x) / x_r, the increase is
+ * (x_r / (rtt_r * sum(x)^2)) * ((1 + alpha_r) / 2) * ((4 + alpha_r) / 5) per
+ * packet and a loss reduces cwnd_r by cwnd_r / 2 * min(alpha_r, 1.5).
+ */
+class MpTcpBalia : public MpTcpCongestionOps
+{
+public:
+  static TypeId GetTypeId(void);
+  virtual std::string GetName() const;
+  virtual void CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes);
+  virtual uint32_t GetSsThresh(uint8_t sFlowIdx, uint32_t bytesInFlight);
+};
+
+/**
+ * The subflows behave as a single TCP flow: the increase is acked * MSS /
+ * total_cwnd and a loss takes half of the total window off the subflow.
+ */
+class MpTcpFullyCoupled : public MpTcpCongestionOps
+{
+public:
+  static TypeId GetTypeId(void);
+  virtual std::string GetName() const;
+  virtual void CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes);
+  virtual uint32_t GetSsThresh(uint8_t sFlowIdx, uint32_t bytesInFlight);
+};
+
+/**
+ * Coupled Scalable TCP: constant increase of 1% of the acked bytes, a loss
+ * takes one eighth of the total window off the subflow.
+ */
+class MpTcpCoupledScalable : public MpTcpCongestionOps
+{
+public:
+  static TypeId GetTypeId(void);
+  virtual std::string GetName() const;
+  virtual void CongestionAvoidance(uint8_t sFlowIdx, uint32_t ackedBytes);
+  virtual uint32_t GetSsThresh(uint8_t sFlowIdx, uint32_t bytesInFlight);
+};
+
+} //namespace ns3
+#endif /* MP_TCP_CONGESTION_OPS_H */
@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <new>
+#include <vector>
+#include "ns3/mp-tcp-pool.h"
+
+using namespace std;
+
+namespace ns3
+{
+
+static const size_t POOL_GRANULE = 8;      // Size classes are multiples of 8 bytes
+static const size_t POOL_MAX_SIZE = 128;   // Larger blocks are not pooled
+
+static uint64_t g_poolRequests = 0;
+static uint64_t g_poolHeapAllocations = 0;
+static uint64_t g_poolInUse = 0;
+
+static vector<void*>*
+FreeLists()
+{
+  static vector<void*>* lists = new vector<void*>[POOL_MAX_SIZE / POOL_GRANULE + 1];
+  return lists;
+}
+
+void*
+MpTcpPool::Allocate(size_t size)
+{
+  g_poolRequests++;
+  g_poolInUse++;
+  if (size <= POOL_MAX_SIZE)
+    {
+      size_t sizeClass = (size + POOL_GRANULE - 1) / POOL_GRANULE;
+      vector<void*>& list = FreeLists()[sizeClass];
+      if (!list.empty())
+        {
+          void* ptr = list.back();
+          list.pop_back();
+          return ptr;
+        }
+      g_poolHeapAllocations++;
+      return ::operator new(sizeClass * POOL_GRANULE);
+    }
+  g_poolHeapAllocations++;
+  return ::operator new(size);
+}
+
+void
+MpTcpPool::Release(void* ptr, size_t size)
+{
+  if (ptr == 0)
+    return;
+  g_poolInUse--;
+  if (size <= POOL_MAX_SIZE)
+    FreeLists()[(size + POOL_GRANULE - 1) / POOL_GRANULE].push_back(ptr);
+  else
+    ::operator delete(ptr);
+}
+
+uint64_t
+MpTcpPool::GetRequests()
+{
+  return g_poolRequests;
+}
+
+uint64_t
+MpTcpPool::GetHeapAllocations()
+{
+  return g_poolHeapAllocations;
+}
+
+uint64_t
+MpTcpPool::GetInUse()
+{
+  return g_poolInUse;
+}
+
+void
+MpTcpPool::ResetCounters()
+{
+  g_poolRequests = 0;
+  g_poolHeapAllocations = 0;
+}
+
+} //namespace ns3
@@ -0,0 +1,49 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MP_TCP_POOL_H
+#define MP_TCP_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace ns3
+{
+
+/**
+ * Free lists for the small fixed-size objects MPTCP creates and destroys for
+ * every segment (DSN mappings) or connection (address info).
+ * Classes route their operator new/delete here; released blocks are kept per
+ * size class and handed out again instead of going back to malloc.
+ *
+ * The pool is process-wide, so the blocks one socket releases are reused by
+ * the others. Its lists are never destroyed, blocks may still be released
+ * during static teardown.
+ */
+class MpTcpPool
+{
+public:
+  static void* Allocate(size_t size);
+  static void Release(void* ptr, size_t size);
+
+  static uint64_t GetRequests();          // Number of Allocate() calls
+  static uint64_t GetHeapAllocations();   // Allocate() calls that could not be served from a free list
+  static uint64_t GetInUse();             // Blocks allocated and not released yet, ResetCounters() leaves it
+  static void ResetCounters();
+};
+
+} //namespace ns3
+#endif /* MP_TCP_POOL_H */
@@ -0,0 +1,342 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/mp-tcp-socket-base.h"
+#include "ns3/mp-tcp-scheduler.h"
+
+NS_LOG_COMPONENT_DEFINE("MpTcpScheduler");
+
+namespace ns3
+{
+
+NS_OBJECT_ENSURE_REGISTERED(MpTcpScheduler);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpSchedulerRoundRobin);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpSchedulerMinRtt);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpSchedulerBlest);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpSchedulerEcf);
+
+TypeId
+MpTcpScheduler::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpScheduler")
+      .SetParent<Object>();
+  return tid;
+}
+
+MpTcpScheduler::MpTcpScheduler()
+{
+  NS_LOG_FUNCTION(this);
+}
+
+MpTcpScheduler::~MpTcpScheduler()
+{
+  NS_LOG_FUNCTION(this);
+}
+
+uint32_t
+MpTcpScheduler::GetNSubflows(Ptr<MpTcpSocketBase> sock)
+{
+  return sock->subflows.size();
+}
+
+bool
+MpTcpScheduler::IsEstablished(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx)
+{
+  Ptr<MpTcpSubFlow> sFlow = sock->subflows[sFlowIdx];
+  // A retired subflow still gets to resend what it has outstanding after a timeout
+  return sFlow->state == TcpSocket::ESTABLISHED && (!sFlow->retired || sFlow->maxSeqNb > sFlow->TxSeqNumber - 1);
+}
+
+uint32_t
+MpTcpScheduler::GetWindow(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx)
+{
+  return std::min(sock->AvailableWindow(sFlowIdx), sock->sendingBuffer.PendingData());
+}
+
+uint32_t
+MpTcpScheduler::GetCwnd(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx)
+{
+  return sock->subflows[sFlowIdx]->cwnd;
+}
+
+uint32_t
+MpTcpScheduler::GetMss(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx)
+{
+  return sock->subflows[sFlowIdx]->MSS;
+}
+
+uint32_t
+MpTcpScheduler::GetBytesInFlight(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx)
+{
+  return sock->BytesInFlight(sFlowIdx);
+}
+
+Time
+MpTcpScheduler::GetRtt(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx)
+{
+  return sock->subflows[sFlowIdx]->rtt->GetCurrentEstimate();
+}
+
+Time
+MpTcpScheduler::GetRttVariation(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx)
+{
+  return sock->subflows[sFlowIdx]->rtt->GetVariation();
+}
+
+uint32_t
+MpTcpScheduler::GetPendingData(Ptr<MpTcpSocketBase> sock)
+{
+  return sock->sendingBuffer.PendingData();
+}
+
+uint32_t
+MpTcpScheduler::GetPeerWindow(Ptr<MpTcpSocketBase> sock)
+{
+  return sock->remoteRecvWnd;
+}
+
+uint32_t
+MpTcpScheduler::GetSendWindow(Ptr<MpTcpSocketBase> sock)
+{
+  // The peer's window is shared by all subflows at connection level (see ConnectionWindow)
+  return GetPeerWindow(sock);
+}
+
+int
+MpTcpScheduler::GetFastestSubflow(Ptr<MpTcpSocketBase> sock)
+{
+  int fastest = -1;
+  for (uint32_t i = 0; i < GetNSubflows(sock); i++)
+    {
+      if (!IsEstablished(sock, i))
+        continue;
+      if (fastest < 0 || GetRtt(sock, i) < GetRtt(sock, fastest))
+        fastest = i;
+    }
+  return fastest;
+}
+
+int
+MpTcpScheduler::GetFastestAvailableSubflow(Ptr<MpTcpSocketBase> sock)
+{
+  int fastest = -1;
+  for (uint32_t i = 0; i < GetNSubflows(sock); i++)
+    {
+      if (!IsEstablished(sock, i) || GetWindow(sock, i) == 0)
+        continue;
+      if (fastest < 0 || GetRtt(sock, i) < GetRtt(sock, fastest))
+        fastest = i;
+    }
+  return fastest;
+}
+
+int
+MpTcpScheduler::GetUnmeasuredSubflow(Ptr<MpTcpSocketBase> sock)
+{
+  // A joining subflow keeps its initial RTT estimate until its first data is acked; it would never look fast
+  // enough to the RTT-based schedulers, so a segment is sent on it first to get a real sample.
+  for (uint32_t i = 0; i < GetNSubflows(sock); i++)
+    {
+      if (IsEstablished(sock, i) && sock->subflows[i]->lastMeasuredRtt.IsZero() && GetWindow(sock, i) > 0)
+        return i;
+    }
+  return -1;
+}
+
+/*
+ * Round robin
+ */
+TypeId
+MpTcpSchedulerRoundRobin::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpSchedulerRoundRobin")
+      .SetParent<MpTcpScheduler>()
+      .AddConstructor<MpTcpSchedulerRoundRobin>();
+  return tid;
+}
+
+MpTcpSchedulerRoundRobin::MpTcpSchedulerRoundRobin() :
+    m_next(0)
+{
+  NS_LOG_FUNCTION(this);
+}
+
+int
+MpTcpSchedulerRoundRobin::GetSubflowToUse(Ptr<MpTcpSocketBase> sock)
+{
+  NS_LOG_FUNCTION(this);
+  uint32_t n = GetNSubflows(sock);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t idx = (m_next + i) % n;
+      if (IsEstablished(sock, idx) && GetWindow(sock, idx) > 0)
+        {
+          m_next = (idx + 1) % n;
+          return idx;
+        }
+    }
+  return -1;
+}
+
+/*
+ * Minimum RTT
+ */
+TypeId
+MpTcpSchedulerMinRtt::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpSchedulerMinRtt")
+      .SetParent<MpTcpScheduler>()
+      .AddConstructor<MpTcpSchedulerMinRtt>();
+  return tid;
+}
+
+MpTcpSchedulerMinRtt::MpTcpSchedulerMinRtt()
+{
+  NS_LOG_FUNCTION(this);
+}
+
+int
+MpTcpSchedulerMinRtt::GetSubflowToUse(Ptr<MpTcpSocketBase> sock)
+{
+  NS_LOG_FUNCTION(this);
+  int probe = GetUnmeasuredSubflow(sock);
+  if (probe >= 0)
+    return probe;
+  return GetFastestAvailableSubflow(sock);
+}
+
+/*
+ * BLEST
+ */
+TypeId
+MpTcpSchedulerBlest::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpSchedulerBlest")
+      .SetParent<MpTcpScheduler>()
+      .AddConstructor<MpTcpSchedulerBlest>()
+      .AddAttribute("Lambda",
+          "Scaling factor of the data the fastest subflow is expected to send during one RTT of a slower subflow",
+          DoubleValue(1.0),
+          MakeDoubleAccessor(&MpTcpSchedulerBlest::m_lambda),
+          MakeDoubleChecker<double>(0.0));
+  return tid;
+}
+
+MpTcpSchedulerBlest::MpTcpSchedulerBlest() :
+    m_lambda(1.0)
+{
+  NS_LOG_FUNCTION(this);
+}
+
+int
+MpTcpSchedulerBlest::GetSubflowToUse(Ptr<MpTcpSocketBase> sock)
+{
+  NS_LOG_FUNCTION(this);
+  int probe = GetUnmeasuredSubflow(sock);
+  if (probe >= 0)
+    return probe;
+  int xf = GetFastestSubflow(sock);
+  if (xf < 0)
+    return -1;
+  if (GetWindow(sock, xf) > 0)
+    return xf;
+
+  int xs = GetFastestAvailableSubflow(sock);
+  if (xs < 0)
+    return -1;
+
+  // Bytes xf could send while one segment is in flight on xs: X = MSS_f * (cwnd_f + (rtt_s/rtt_f - 1)/2) * rtt_s/rtt_f
+  double rttF = std::max(GetRtt(sock, xf).GetSeconds(), 1e-6);
+  double ratio = GetRtt(sock, xs).GetSeconds() / rttF;
+  double mssF = GetMss(sock, xf);
+  double cwndF = (double) std::min(GetCwnd(sock, xf), GetPeerWindow(sock)) / mssF;
+  double x = mssF * (cwndF + (ratio - 1) / 2) * ratio;
+
+  double spare = (double) GetSendWindow(sock) - (GetBytesInFlight(sock, xs) + GetMss(sock, xs));
+  if (x * m_lambda > spare)
+    {
+      NS_LOG_LOGIC("BLEST -> hold data for subflow " << xf << ", X=" << x << " spare=" << spare);
+      return -1;
+    }
+  return xs;
+}
+
+/*
+ * ECF
+ */
+TypeId
+MpTcpSchedulerEcf::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpSchedulerEcf")
+      .SetParent<MpTcpScheduler>()
+      .AddConstructor<MpTcpSchedulerEcf>()
+      .AddAttribute("Beta",
+          "Hysteresis factor used once the scheduler waits for the fastest subflow",
+          DoubleValue(0.25),
+          MakeDoubleAccessor(&MpTcpSchedulerEcf::m_beta),
+          MakeDoubleChecker<double>(0.0));
+  return tid;
+}
+
+MpTcpSchedulerEcf::MpTcpSchedulerEcf() :
+    m_beta(0.25), m_waiting(false)
+{
+  NS_LOG_FUNCTION(this);
+}
+
+int
+MpTcpSchedulerEcf::GetSubflowToUse(Ptr<MpTcpSocketBase> sock)
+{
+  NS_LOG_FUNCTION(this);
+  int probe = GetUnmeasuredSubflow(sock);
+  if (probe >= 0)
+    return probe;
+  int xf = GetFastestSubflow(sock);
+  if (xf < 0)
+    return -1;
+  if (GetWindow(sock, xf) > 0)
+    return xf;
+
+  int xs = GetFastestAvailableSubflow(sock);
+  if (xs < 0)
+    return -1;
+
+  double rttF = GetRtt(sock, xf).GetSeconds();
+  double rttS = GetRtt(sock, xs).GetSeconds();
+  double delta = std::max(GetRttVariation(sock, xf), GetRttVariation(sock, xs)).GetSeconds();
+  double k = (double) GetPendingData(sock) / GetMss(sock, xf);             // Segments left to send
+  double cwndF = std::max((double) GetCwnd(sock, xf) / GetMss(sock, xf), 1.0);
+  double cwndS = std::max((double) GetCwnd(sock, xs) / GetMss(sock, xs), 1.0);
+  double n = 1 + k / cwndF;                                                // Rounds needed on xf alone
+
+  if (n * rttF < (1 + (m_waiting ? m_beta : 0)) * (rttS + delta))
+    {
+      if ((k / cwndS) * rttS >= 2 * rttF + delta)
+        {
+          NS_LOG_LOGIC("ECF -> wait for subflow " << xf << " instead of using " << xs);
+          m_waiting = true;
+          return -1;
+        }
+    }
+  else
+    m_waiting = false;
+  return xs;
+}
+
+} //namespace ns3
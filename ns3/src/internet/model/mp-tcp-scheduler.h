@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MP_TCP_SCHEDULER_H
+#define MP_TCP_SCHEDULER_H
+
+#include <stdint.h>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+
+namespace ns3
+{
+
+class MpTcpSocketBase;
+
+/**
+ * Packet scheduler of an MPTCP connection: decides which subflow the next
+ * segment of the sending buffer goes to. SendPendingData() asks it once per
+ * segment; returning -1 keeps the data in the sending buffer until the next
+ * ACK gives the scheduler another chance.
+ */
+class MpTcpScheduler : public Object
+{
+public:
+  static TypeId GetTypeId(void);
+  MpTcpScheduler();
+  virtual ~MpTcpScheduler();
+
+  virtual int GetSubflowToUse(Ptr<MpTcpSocketBase> sock) = 0; // Index of subflow to send on, -1 to hold
+
+protected:
+  // Per-subflow state of the socket, read through friendship
+  uint32_t GetNSubflows(Ptr<MpTcpSocketBase> sock);
+  bool IsEstablished(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx);     // Established and not retired by the path manager
+  uint32_t GetWindow(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx);     // Bytes this subflow may send now
+  uint32_t GetCwnd(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx);
+  uint32_t GetMss(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx);
+  uint32_t GetBytesInFlight(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx);
+  Time GetRtt(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx);
+  Time GetRttVariation(Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx);
+  uint32_t GetPendingData(Ptr<MpTcpSocketBase> sock);                  // Unsent bytes in the sending buffer
+  uint32_t GetPeerWindow(Ptr<MpTcpSocketBase> sock);                   // Receive window advertised by the peer
+  uint32_t GetSendWindow(Ptr<MpTcpSocketBase> sock);                   // Bytes the connection may have outstanding
+
+  int GetFastestSubflow(Ptr<MpTcpSocketBase> sock);                    // Lowest RTT among established subflows
+  int GetFastestAvailableSubflow(Ptr<MpTcpSocketBase> sock);           // Lowest RTT among subflows with window
+  int GetUnmeasuredSubflow(Ptr<MpTcpSocketBase> sock);                 // Subflow with window but no RTT sample yet
+};
+
+/**
+ * Default scheduler: rotates over the established subflows, skipping those
+ * with no window left.
+ */
+class MpTcpSchedulerRoundRobin : public MpTcpScheduler
+{
+public:
+  static TypeId GetTypeId(void);
+  MpTcpSchedulerRoundRobin();
+  virtual int GetSubflowToUse(Ptr<MpTcpSocketBase> sock);
+private:
+  uint32_t m_next; // Subflow to try first on the next call
+};
+
+/**
+ * Sends on the subflow with the lowest smoothed RTT that has window left.
+ */
+class MpTcpSchedulerMinRtt : public MpTcpScheduler
+{
+public:
+  static TypeId GetTypeId(void);
+  MpTcpSchedulerMinRtt();
+  virtual int GetSubflowToUse(Ptr<MpTcpSocketBase> sock);
+};
+
+/**
+ * BLocking ESTimation scheduler (Ferlin et al., IFIP Networking 2016).
+ * When the fastest subflow is out of window, the data it could still send
+ * during one RTT of the slower subflow is estimated; the slower subflow is
+ * only used if that much send window would still be left, so that it does
+ * not cause head-of-line blocking at the receiver.
+ */
+class MpTcpSchedulerBlest : public MpTcpScheduler
+{
+public:
+  static TypeId GetTypeId(void);
+  MpTcpSchedulerBlest();
+  virtual int GetSubflowToUse(Ptr<MpTcpSocketBase> sock);
+private:
+  double m_lambda; // Scaling factor applied to the estimate
+};
+
+/**
+ * Earliest Completion First scheduler (Lim et al., CoNEXT 2017).
+ * When the fastest subflow is out of window, waits for it if the pending
+ * data would complete earlier that way than by also using a slower subflow.
+ */
+class MpTcpSchedulerEcf : public MpTcpScheduler
+{
+public:
+  static TypeId GetTypeId(void);
+  MpTcpSchedulerEcf();
+  virtual int GetSubflowToUse(Ptr<MpTcpSocketBase> sock);
+private:
+  double m_beta;   // Hysteresis applied while waiting for the fastest subflow
+  bool m_waiting;  // Whether the last decision was to wait
+};
+
+} //namespace ns3
+#endif /* MP_TCP_SCHEDULER_H */
@@ -29,6 +29,8 @@
 #include "ns3/abort.h"
 #include "ns3/log.h"
 #include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/nstime.h"
 #include "ns3/mp-tcp-socket-base.h"
 #include "ns3/tcp-l4-protocol.h"
 #include "ns3/ipv4-l3-protocol.h"
@@ -39,7 +41,6 @@
 #include "ns3/drop-tail-queue.h"
 #include "ns3/object-vector.h"
 
-//#define PLOT
 #define RAND_GAP
 
 NS_LOG_COMPONENT_DEFINE("MpTcpSocketBase");
@@ -66,13 +67,18 @@ MpTcpSocketBase::GetTypeId(void)
                           COUPLED_EPSILON,  "COUPLED_EPSILON",
                           COUPLED_SCALABLE_TCP, "COUPLED_SCALABLE_TCP",
                           COUPLED_FULLY, "COUPLED_FULLY",
-                          UNCOUPLED, "UNCOUPLED"))
+                          UNCOUPLED, "UNCOUPLED",
+                          OLIA,      "OLIA",
+                          BALIA,     "BALIA"))
 
       .AddAttribute("SchedulingAlgorithm",
                     "Algorithm for data distribution between sub-flows",
           EnumValue(Round_Robin),
           MakeEnumAccessor(&MpTcpSocketBase::SetDataDistribAlgo),
-          MakeEnumChecker(Round_Robin, "Round_Robin"))
+          MakeEnumChecker(Round_Robin, "Round_Robin",
+                          Min_RTT,     "Min_RTT",
+                          BLEST,       "BLEST",
+                          ECF,         "ECF"))
 
       .AddAttribute("PathManagement",
                      "Mechanism for establishing new sub-flows",
@@ -80,7 +86,32 @@ MpTcpSocketBase::GetTypeId(void)
           MakeEnumAccessor(&MpTcpSocketBase::SetPathManager),
           MakeEnumChecker(Default,"Default",
                           FullMesh, "FullMesh",
-                          NdiffPorts, "NdiffPorts"))
+                          NdiffPorts, "NdiffPorts",
+                          Adaptive, "Adaptive"))
+
+      .AddAttribute("PathManagerInterval",
+                    "Adaptive path manager: how often the contribution of each subflow is evaluated",
+          TimeValue(Seconds(1)),
+          MakeTimeAccessor(&MpTcpSocketBase::m_pmInterval),
+          MakeTimeChecker())
+
+      .AddAttribute("RetireIntervals",
+                    "Adaptive path manager: consecutive intervals a subflow carries almost nothing before it is retired",
+          UintegerValue(5),
+          MakeUintegerAccessor(&MpTcpSocketBase::m_pmRetireIntervals),
+          MakeUintegerChecker<uint32_t>(1))
+
+      .AddAttribute("RetireShare",
+                    "Adaptive path manager: share of the data acked in an interval below which a subflow carried almost nothing",
+          DoubleValue(0.05),
+          MakeDoubleAccessor(&MpTcpSocketBase::m_pmRetireShare),
+          MakeDoubleChecker<double>(0, 1))
+
+      .AddAttribute("ReprobeTime",
+                    "Adaptive path manager: a retired subflow is scheduled again after this long to measure it anew, zero never",
+          TimeValue(Seconds(30)),
+          MakeTimeAccessor(&MpTcpSocketBase::m_pmReprobeTime),
+          MakeTimeChecker())
 
       .AddAttribute("MaxSubflows",
                     "Maximum number of sub-flows per each mptcp connection",
@@ -105,7 +136,33 @@ MpTcpSocketBase::GetTypeId(void)
           MakeBooleanAccessor (&MpTcpSocketBase::m_shortFlowTCP),
           MakeBooleanChecker())
 
-      .AddAttribute ("AlphaPerAck", " Update alpha per ACK ",
+      .AddAttribute ("Sack", " Negotiate selective acknowledgements on subflows and repair several losses per RTT with them."
+                     " Pure ACKs always carry the data-level ACK for connection-level flow control, which leaves room for three blocks ",
+          BooleanValue (true),
+          MakeBooleanAccessor (&MpTcpSocketBase::m_sack),
+          MakeBooleanChecker())
+
+      .AddAttribute ("OpportunisticRetransmission", " Reinject the segment holding back a full receive window on a faster subflow ",
+          BooleanValue (false),
+          MakeBooleanAccessor (&MpTcpSocketBase::m_opportunisticReTx),
+          MakeBooleanChecker())
+
+      .AddAttribute ("Penalization", " Halve the cwnd of the subflow holding back a full receive window, at most once per its RTT ",
+          BooleanValue (false),
+          MakeBooleanAccessor (&MpTcpSocketBase::m_penalization),
+          MakeBooleanChecker())
+
+      .AddAttribute ("RcvBufAutoTuning", " Grow the connection-level receive buffer to twice the data delivered per RTT ",
+          BooleanValue (true),
+          MakeBooleanAccessor (&MpTcpSocketBase::m_rcvBufAutoTuning),
+          MakeBooleanChecker())
+
+      .AddAttribute ("RcvBufMax", " Largest receive buffer auto-tuning may grow a connection to, sizes the window scale too ",
+          UintegerValue (6291456),
+          MakeUintegerAccessor (&MpTcpSocketBase::m_rcvBufMax),
+          MakeUintegerChecker<uint32_t>())
+
+      .AddAttribute ("AlphaPerAck", " Obsolete: coupled congestion control state is now kept up to date on every window or RTT change ",
           BooleanValue (false),
           MakeBooleanAccessor (&MpTcpSocketBase::m_alphaPerAck),
           MakeBooleanChecker())
@@ -118,7 +175,33 @@ MpTcpSocketBase::GetTypeId(void)
       .AddAttribute ("LargePlotting", " Activate short flow plotting ",
           BooleanValue (false),
           MakeBooleanAccessor (&MpTcpSocketBase::m_largePlotting),
-          MakeBooleanChecker());
+          MakeBooleanChecker())
+
+      .AddAttribute ("StatsFilePrefix", " Stream the evaluation statistics of each connection to a binary file with this prefix ",
+          StringValue (""),
+          MakeStringAccessor (&MpTcpSocketBase::m_statsFilePrefix),
+          MakeStringChecker())
+
+      .AddAttribute ("StatsSamples", " Number of plotting points kept per subflow and statistic ",
+          UintegerValue (1024),
+          MakeUintegerAccessor (&MpTcpSocketBase::m_statsSamples),
+          MakeUintegerChecker<uint32_t>())
+
+      .AddTraceSource("ReorderQueue",
+                      "Number of out-of-order segments held at connection level",
+          MakeTraceSourceAccessor(&MpTcpSocketBase::m_reorderQueueDepth))
+
+      .AddTraceSource("RcvBuf",
+                      "Connection-level receive buffer size",
+          MakeTraceSourceAccessor(&MpTcpSocketBase::m_rcvBuf))
+
+      .AddTraceSource("Reinjection",
+                      "Segment reinjected on another subflow: data sequence number, subflow holding it, subflow used",
+          MakeTraceSourceAccessor(&MpTcpSocketBase::m_reinjectionTrace))
+
+      .AddTraceSource("PathManager",
+                      "Adaptive path manager decision: subflow, true if it was retired, false if it is scheduled again",
+          MakeTraceSourceAccessor(&MpTcpSocketBase::m_pathManagerTrace));
 
   return tid;
 }
@@ -139,7 +222,6 @@ MpTcpSocketBase::MpTcpSocketBase():
   addrAdvertised = false;
   mpTokenRegister = false;
   lastUsedsFlowIdx = 0;
-  totalCwnd = 0;
   localToken = 0;
   remoteToken = 0;
   client = false;
@@ -148,6 +230,19 @@ MpTcpSocketBase::MpTcpSocketBase():
   segmentSize = 0;
   nextTxSequence = 1;
   nextRxSequence = 1;
+  highestDataAck = 1;
+  m_persistProbes = 0;
+  m_reorderQueueDepth = 0;
+  m_rcvBuf = 131072;
+  m_rcvBufMax = 6291456;
+  m_rcvBufAutoTuning = true;
+  m_rcvBufReserved = 0;
+  m_rcvSpaceSeq = 0;
+  m_rcvSpaceTime = Seconds(0);
+  m_pmInterval = Seconds(1);
+  m_pmRetireIntervals = 5;
+  m_pmRetireShare = 0.05;
+  m_pmReprobeTime = Seconds(30);
   //gnu.SetOutFile("allPlots.pdf");
   mod = 60;
   // --------------
@@ -157,15 +252,12 @@ MpTcpSocketBase::MpTcpSocketBase():
   TimeOuts = 0;
   FastReTxs = 0;
   FastRecoveries = 0;
+  Reinjections = 0;
   flowCompletionTime = true;
   //TxBytes = 0;
   flowType = "NULL";
   outputFileName = "NULL";
 
-  alpha = 1; // alpha is 1 by default
-  _e = 1;    // epsilon 1 by default
-  a = A_SCALE;
-
 
   Callback<void, Ptr<Socket> > vPS = MakeNullCallback<void, Ptr<Socket> >();
   Callback<void, Ptr<Socket>, const Address &> vPSA = MakeNullCallback<void, Ptr<Socket>, const Address &>();
@@ -193,8 +285,14 @@ MpTcpSocketBase::~MpTcpSocketBase(void)
       m_tcp->DeAllocate(m_endPoint);
       NS_ASSERT(m_endPoint == 0);
     }
+  ReleaseRcvBuf();
   m_tcp = 0;
   CancelAllSubflowTimers();
+  // The socket owns its address information
+  for (uint32_t i = 0; i < localAddrs.size(); i++)
+    delete localAddrs[i];
+  for (uint32_t i = 0; i < remoteAddrs.size(); i++)
+    delete remoteAddrs[i];
   NS_LOG_INFO(Simulator::Now().GetSeconds() << " ["<< this << "] ~MpTcpSocketBase -> m_node: " << m_node << " m_tcp: " << m_tcp << " m_endPoint: " << m_endPoint);
 }
 
@@ -249,14 +347,15 @@ MpTcpSocketBase::EstimateRtt(uint8_t sFlowIdx, const TcpHeader& mptcpHeader)
   NS_LOG_FUNCTION(this << (int)sFlowIdx);
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
   sFlow->lastMeasuredRtt = sFlow->rtt->AckSeq(mptcpHeader.GetAckNumber());
-  //sFlow->measuredRTT.insert(sFlow->measuredRTT.end(), sFlow->rtt->GetCurrentEstimate().GetSeconds());
+  GetCongestionOps()->UpdateSubflow(sFlowIdx);
 
   // Plotting
-#ifdef PLOT
-  sFlow->_RTT.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->lastMeasuredRtt.GetMilliSeconds()));
-  sFlow->_AvgRTT.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->rtt->GetCurrentEstimate().GetMilliSeconds()));
-  sFlow->_RTO.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->rtt->RetransmitTimeout().GetMilliSeconds()));
-#endif
+  if (m_stats)
+    {
+      m_stats->Record(sFlowIdx, MpTcpStats::RTT, sFlow->lastMeasuredRtt.GetMilliSeconds());
+      m_stats->Record(sFlowIdx, MpTcpStats::SRTT, sFlow->rtt->GetCurrentEstimate().GetMilliSeconds());
+      m_stats->Record(sFlowIdx, MpTcpStats::RTO, sFlow->rtt->RetransmitTimeout().GetMilliSeconds());
+    }
 }
 
 /* Read options from incoming packets */
@@ -265,18 +364,16 @@ MpTcpSocketBase::ReadOptions(Ptr<Packet> pkt, const TcpHeader& mptcpHeader)
 { // Any packet without SYN and MP_CAPABLE is not being processed!
   NS_LOG_FUNCTION(this << mptcpHeader);
   NS_ASSERT(remoteToken == 0 && mpEnabled == false);
-  vector<TcpOptions*> mp_options = mptcpHeader.GetOptions();
+  const TcpOptionList& mp_options = mptcpHeader.GetOptions();
   uint8_t flags = mptcpHeader.GetFlags();
-  TcpOptions *opt;
   bool hasSyn = flags & TcpHeader::SYN;
-  for (uint32_t j = 0; j < mp_options.size(); j++)
+  for (TcpOptionList::const_iterator opt = mp_options.Begin(); opt != mp_options.End(); ++opt)
     {
-      opt = mp_options[j];
       if ((opt->optName == OPT_MPC) && hasSyn && (mpRecvState == MP_NONE))
         { // SYN+ACK would be send later on by ProcessSynRcvd(...)
           mpRecvState = MP_MPC;
           mpEnabled = true;
-          remoteToken = ((OptMultipathCapable *) opt)->senderToken;
+          remoteToken = opt->mpc.senderToken;
           if (remoteToken == 0)
             NS_ASSERT(remoteToken != 0); // Correct condition
           return true;
@@ -295,26 +392,23 @@ MpTcpSocketBase::ReadOptions(uint8_t sFlowIdx, Ptr<Packet> pkt, const TcpHeader&
 {
   NS_LOG_FUNCTION(this << (int)sFlowIdx << mptcpHeader);
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  vector<TcpOptions*> options = mptcpHeader.GetOptions();
+  const TcpOptionList& options = mptcpHeader.GetOptions();
   uint8_t flags = mptcpHeader.GetFlags();
-  TcpOptions *opt;
   bool hasSyn = flags & TcpHeader::SYN;
   bool TxAddr = false;
-  for (uint32_t j = 0; j < options.size(); j++)
+  for (TcpOptionList::const_iterator opt = options.Begin(); opt != options.End(); ++opt)
     {
-      opt = options[j];
       if ((opt->optName == OPT_MPC) && hasSyn && (mpRecvState == MP_NONE))
         { // SYN+ACK would be send later on by ProcessSynRcvd(...)
           mpRecvState = MP_MPC;
           mpEnabled = true;
-          remoteToken = ((OptMultipathCapable *) opt)->senderToken;
+          remoteToken = opt->mpc.senderToken;
           NS_ASSERT(remoteToken != 0);
           NS_ASSERT(client);
         }
       else if ((opt->optName == OPT_JOIN) && hasSyn)
         {
-          OptJoinConnection * optJoin = (OptJoinConnection *) opt;
-          if ((mpSendState == MP_ADDR) && (localToken == optJoin->receiverToken))
+          if ((mpSendState == MP_ADDR) && (localToken == opt->join.receiverToken))
             { // SYN+ACK would be send later on by ProcessSynRcvd(...)
               // Join option is sent over the path (couple of addresses) not already in use
               NS_LOG_UNCOND("Server receive new subflow!");
@@ -325,15 +419,25 @@ MpTcpSocketBase::ReadOptions(uint8_t sFlowIdx, Ptr<Packet> pkt, const TcpHeader&
           // Receiver store sender's addresses information and send back its addresses.
           // If there are several addresses to advertise then multiple OPT_ADDR would be attached to the TCP Options.
           MpTcpAddressInfo * addrInfo = new MpTcpAddressInfo();
-          addrInfo->addrID = ((OptAddAddress *) opt)->addrID;
-          addrInfo->ipv4Addr = ((OptAddAddress *) opt)->addr;
+          addrInfo->addrID = opt->addAddr.addrID;
+          addrInfo->ipv4Addr = opt->addAddr.GetAddress();
           remoteAddrs.insert(remoteAddrs.end(), addrInfo);
+          remoteAddrByIp.insert(make_pair(addrInfo->ipv4Addr, addrInfo));
           TxAddr = true;
         }
       else if (opt->optName == OPT_DSN)
         { // not implemented yet
           NS_LOG_LOGIC(this << " ReadOption-> OPT_DSN -> we'll deal with it later on");
         }
+      else if ((opt->optName == OPT_SACK_PERMITTED) && hasSyn)
+        { // SYN+ACK would carry SACK-Permitted back, see SendEmptyPacket(...)
+          sFlow->sackPermitted = m_sack;
+        }
+      else if ((opt->optName == OPT_WSCALE) && hasSyn)
+        { // SYN+ACK would carry our own shift back, see AddSynOptions(...)
+          sFlow->wscalePermitted = true;
+          sFlow->sndWScale = opt->wscale.shift;
+        }
       else if (hasSyn)
         { // incoming packet has syn but without proper mptcp option
           // TODO Should send RST here as remoteToken is not received...
@@ -346,14 +450,14 @@ MpTcpSocketBase::ReadOptions(uint8_t sFlowIdx, Ptr<Packet> pkt, const TcpHeader&
       if (mpSendState != MP_ADDR)
         {
           NS_LOG_DEBUG(Simulator::Now().GetSeconds()<< "---------------------- AdvertiseAvailableAddresses By Server ---------------------");
-          NS_ASSERT(pathManager == FullMesh);
+          NS_ASSERT(pathManager == FullMesh || pathManager == Adaptive);
           AdvertiseAvailableAddresses(); // this is what the receiver has to do
           return false;
         }
       // If addresses already sent then initiate subflows...
       else if (mpSendState == MP_ADDR)
         {
-          NS_ASSERT(pathManager == FullMesh);
+          NS_ASSERT(pathManager == FullMesh || pathManager == Adaptive);
           InitiateSubflows();  // this is what the initiator has to do
           return false;
         }
@@ -445,6 +549,22 @@ MpTcpSocketBase::CompleteFork(Ptr<Packet> p, const TcpHeader& mptcpHeader, const
   NS_LOG_FUNCTION(this);
   // In closed object following conditions should be true!
   server = true;
+  m_scheduler = 0; // Fork() shares the listener's scheduler, congestion control and statistics, this connection needs its own
+  m_congestionOps = 0;
+  m_stats = 0;
+  // Fork() copied the listener's address pointers, this connection deletes its own copies
+  localAddrByIp.clear();
+  for (uint32_t i = 0; i < localAddrs.size(); i++)
+    {
+      localAddrs[i] = new MpTcpAddressInfo(*localAddrs[i]);
+      localAddrByIp.insert(make_pair(localAddrs[i]->ipv4Addr, localAddrs[i]));
+    }
+  remoteAddrByIp.clear();
+  for (uint32_t i = 0; i < remoteAddrs.size(); i++)
+    {
+      remoteAddrs[i] = new MpTcpAddressInfo(*remoteAddrs[i]);
+      remoteAddrByIp.insert(make_pair(remoteAddrs[i]->ipv4Addr, remoteAddrs[i]));
+    }
 
   // Get port and address from peer (connecting host)
   if (InetSocketAddress::IsMatchingType(toAddress))
@@ -475,7 +595,18 @@ MpTcpSocketBase::CompleteFork(Ptr<Packet> p, const TcpHeader& mptcpHeader, const
   sFlow->cnCount = sFlow->cnRetries;
   sFlow->m_endPoint = m_endPoint; // This is master subsock, its endpoint is the same as connection endpoint.
   NS_LOG_INFO ("("<< (int)sFlow->routeId<<") LISTEN -> SYN_RCVD");
-  subflows.insert(subflows.end(), sFlow);
+  AddSubflow(sFlow);
+  const TcpOptionList& options = mptcpHeader.GetOptions();
+  for (TcpOptionList::const_iterator opt = options.Begin(); opt != options.End(); ++opt)
+    {
+      if (opt->optName == OPT_SACK_PERMITTED)
+        sFlow->sackPermitted = m_sack;
+      else if (opt->optName == OPT_WSCALE)
+        {
+          sFlow->wscalePermitted = true;
+          sFlow->sndWScale = opt->wscale.shift;
+        }
+    }
   sFlow->RxSeqNumber = (mptcpHeader.GetSequenceNumber()).GetValue() + 1; //Set the subflow sequence number and send SYN+ACK
   NS_LOG_DEBUG("CompleteFork -> RxSeqNb: " << sFlow->RxSeqNumber << " highestAck: " << sFlow->highestAck);
   SendEmptyPacket(sFlow->routeId, TcpHeader::SYN | TcpHeader::ACK);
@@ -552,8 +683,10 @@ MpTcpSocketBase::ProcessSynSent(uint8_t sFlowIdx, Ptr<Packet> packet, const TcpH
         }NS_LOG_INFO("(" << sFlow->routeId << ") "<< TcpStateName[sFlow->state] << " -> ESTABLISHED");
       sFlow->state = ESTABLISHED;
       sFlow->retxEvent.Cancel();
-      if ((m_largePlotting && (flowType.compare("Large") == 0)) || (m_shortPlotting && (flowType.compare("Short") == 0)))
-        sFlow->StartTracing("cWindow");
+      if (sFlow->handshakeRtt.IsZero())
+        sFlow->handshakeRtt = Simulator::Now() - sFlow->synSentTime;
+      StartStats(sFlowIdx);
+      StartPathManager();
       sFlow->rtt->Init(mptcpHeader.GetAckNumber());
       sFlow->initialSequnceNumber = (mptcpHeader.GetAckNumber().GetValue());
       NS_LOG_INFO("(" <<sFlow->routeId << ") InitialSeqNb of data packet should be --->>> " << sFlow->initialSequnceNumber << " Cwnd: " << sFlow->cwnd);
@@ -578,6 +711,7 @@ MpTcpSocketBase::ProcessSynSent(uint8_t sFlowIdx, Ptr<Packet> packet, const TcpH
             // No address advertisement
             break;
           case FullMesh:
+          case Adaptive:
             // Address need to be advertised
             AdvertiseAvailableAddresses();
             break;
@@ -631,6 +765,10 @@ MpTcpSocketBase::ProcessSynRcvd(uint8_t sFlowIdx, Ptr<Packet> packet, const TcpH
       m_state = ESTABLISHED;      // NEED TO CONSIDER IT AGAIN....
       sFlow->connected = true;    // This means subflow is established
       sFlow->retxEvent.Cancel();  // This would cancel ReTxTimer where it being setup when SYN is sent.
+      if (sFlow->handshakeRtt.IsZero())
+        sFlow->handshakeRtt = Simulator::Now() - sFlow->synSentTime;
+      StartStats(sFlowIdx);
+      StartPathManager();
       // Danger? Does this assertion is correct? what if lack ack of 3WHS plus first d-packet get drop??!
       // NS_ASSERT_MSG(sFlow->RxSeqNumber == mptcpHeader.GetSequenceNumber().GetValue(), "Ops");
       // Following two lines are equal to this single statement "sFlow->MaxSeqNb = ++sFlow->TxSeqNumber";
@@ -780,6 +918,8 @@ void
 MpTcpSocketBase::CancelAllSubflowTimers(void)
 {
   NS_LOG_FUNCTION_NOARGS();
+  m_pmEvent.Cancel();
+  m_persistEvent.Cancel();
   for (uint32_t i = 0; i < subflows.size(); i++)
     {
       Ptr<MpTcpSubFlow> sFlow = subflows[i];
@@ -841,15 +981,13 @@ MpTcpSocketBase::ReceivedData(uint8_t sFlowIdx, Ptr<Packet> p, const TcpHeader&
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
   uint32_t expectedSeq = sFlow->RxSeqNumber;
   //uint32_t Seq = mptcpHeader.GetSequenceNumber().GetValue();
-  vector<TcpOptions*> options = mptcpHeader.GetOptions();
-  TcpOptions* opt;
+  const TcpOptionList& options = mptcpHeader.GetOptions();
   bool stored = true;
-  for (uint32_t i = 0; i < options.size(); i++)
+  for (TcpOptionList::const_iterator opt = options.Begin(); opt != options.End(); ++opt)
     {
-      opt = options[i];
       if (opt->optName == OPT_DSN)
         {
-          OptDataSeqMapping* optDSN = (OptDataSeqMapping*) opt;
+          const OptDataSeqMapping* optDSN = &opt->dsn;
           //NS_ASSERT(optDSN->subflowSeqNumber == Seq);
           if (optDSN->subflowSeqNumber == sFlow->RxSeqNumber)
             { /* Received packet is in-sequence at sub-flow level. Now check connection level? */
@@ -867,6 +1005,7 @@ MpTcpSocketBase::ReceivedData(uint8_t sFlowIdx, Ptr<Packet> p, const TcpHeader&
                   sFlow->highestAck = std::max(sFlow->highestAck, (mptcpHeader.GetAckNumber()).GetValue() - 1);
                   nextRxSequence += amountRead;
                   ReadUnOrderedData(p);
+                  AdjustRcvBuf();
                   //SendAccumulativeAck(sFlowIdx);
                   if (expectedSeq < sFlow->RxSeqNumber)
                     {
@@ -885,25 +1024,29 @@ MpTcpSocketBase::ReceivedData(uint8_t sFlowIdx, Ptr<Packet> p, const TcpHeader&
                 { /** Received packet is out of sequence at connection level 
                     but in-order at sub-flow level **/
 
-                  stored = StoreUnOrderedData(
-                      new DSNMapping(sFlowIdx, optDSN->dataSeqNumber, optDSN->dataLevelLength, optDSN->subflowSeqNumber,
-                          mptcpHeader.GetAckNumber().GetValue(), p));
-                  // For allowing sub-flow to progress, RxSeqNb should be advanced even though packet is not in-order of connection level.
-                  if (stored)
-                    {
-                      NS_ASSERT(optDSN->subflowSeqNumber == sFlow->RxSeqNumber);
-                      sFlow->RxSeqNumber += optDSN->dataLevelLength;
-                      sFlow->highestAck = std::max(sFlow->highestAck, (mptcpHeader.GetAckNumber()).GetValue() - 1);
-
+                  DSNMapping *ptrDSN = new DSNMapping(sFlowIdx, optDSN->dataSeqNumber, optDSN->dataLevelLength,
+                      optDSN->subflowSeqNumber, mptcpHeader.GetAckNumber().GetValue(), p);
+                  stored = StoreUnOrderedData(ptrDSN);
+                  if (!stored)
+                    { // Same data has already arrived via another subflow, this subflow's segment is consumed anyway.
+                      delete ptrDSN;
                     }
+                  // For allowing sub-flow to progress, RxSeqNb should be advanced even though packet is not in-order of connection level.
+                  NS_ASSERT(optDSN->subflowSeqNumber == sFlow->RxSeqNumber);
+                  sFlow->RxSeqNumber += optDSN->dataLevelLength;
+                  sFlow->highestAck = std::max(sFlow->highestAck, (mptcpHeader.GetAckNumber()).GetValue() - 1);
+                  AdvanceSubflowRxSequence(sFlowIdx);
                   // We need to send ACK here to indicate that a packet leaves a network and signaling to sender that which sequence number is expected to receive at sub-flow level.
                   SendEmptyPacket(sFlowIdx, TcpHeader::ACK);
                 }
               else
                 { /** Received packet is duplicated in connection level! */
                   NS_ASSERT(optDSN->dataSeqNumber < nextRxSequence);
-                  NS_FATAL_ERROR("This functionality is not yet implemented!");
                   NS_LOG_WARN(this << "Duplicated segment received at connection level so it should be rejected!");
+                  // Data is dropped but the segment is in-order at sub-flow level, so the subflow moves on.
+                  sFlow->RxSeqNumber += optDSN->dataLevelLength;
+                  sFlow->highestAck = std::max(sFlow->highestAck, (mptcpHeader.GetAckNumber()).GetValue() - 1);
+                  AdvanceSubflowRxSequence(sFlowIdx);
                   SendEmptyPacket(sFlowIdx, TcpHeader::ACK);
                 }
             }
@@ -911,10 +1054,22 @@ MpTcpSocketBase::ReceivedData(uint8_t sFlowIdx, Ptr<Packet> p, const TcpHeader&
             { /* Received packet is out of order at sub-flow level */
               // This condition might occurs when a packet get drop...Does this condition mean that packet should be 
               // out of order at connection level? YES
-              NS_ASSERT(optDSN->dataSeqNumber > nextRxSequence);
-              StoreUnOrderedData(
-                  new DSNMapping(sFlowIdx, optDSN->dataSeqNumber, optDSN->dataLevelLength, optDSN->subflowSeqNumber,
-                      mptcpHeader.GetAckNumber().GetValue(), p));
+              DSNMapping *ptrDSN = new DSNMapping(sFlowIdx, optDSN->dataSeqNumber, optDSN->dataLevelLength,
+                  optDSN->subflowSeqNumber, mptcpHeader.GetAckNumber().GetValue(), p);
+              bool held = optDSN->dataSeqNumber >= nextRxSequence && StoreUnOrderedData(ptrDSN);
+              if (!held)
+                { // Duplicated or overlapping data, the subflow hole is filled once this segment is retransmitted.
+                  delete ptrDSN;
+                }
+              // SACK the segment only if its data is either held in unOrdered or already delivered
+              if (sFlow->sackPermitted && (held || optDSN->dataSeqNumber + optDSN->dataLevelLength <= nextRxSequence))
+                RecordSackBlock(sFlowIdx, optDSN->subflowSeqNumber, optDSN->dataLevelLength);
+              if (held && optDSN->dataSeqNumber == nextRxSequence)
+                { // In sequence at connection level, e.g. a reinjected segment, so it does not wait for this subflow's hole
+                  ReadUnOrderedData(p);
+                  AdjustRcvBuf();
+                  NotifyDataRecv();
+                }
               SendEmptyPacket(sFlowIdx, TcpHeader::ACK); // We need to send ACK regardless of whether segment has 
                                                          //already stored in unOrdered or not!
             }
@@ -956,10 +1111,26 @@ MpTcpSocketBase::ReceivedAck(uint8_t sFlowIdx, Ptr<Packet> packet, const TcpHead
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
   uint32_t ack = (mptcpHeader.GetAckNumber()).GetValue();
 
-#ifdef PLOT
-  uint32_t tmp = ((ack - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->ACK.push_back(make_pair(Simulator::Now().GetSeconds(), tmp));
-#endif
+  if (m_stats)
+    m_stats->Record(sFlowIdx, MpTcpStats::ACK, ((ack - sFlow->initialSequnceNumber) / sFlow->MSS) % mod);
+
+  if (sFlow->sackPermitted && (mptcpHeader.GetFlags() & TcpHeader::ACK))
+    ProcessSack(sFlowIdx, mptcpHeader);
+
+  // The data-level ACK moves the peer's receive window, which may open it without acking new subflow data
+  bool windowOpened = false;
+  if (mptcpHeader.GetFlags() & TcpHeader::ACK)
+    {
+      const TcpOptionList& options = mptcpHeader.GetOptions();
+      for (TcpOptionList::const_iterator opt = options.Begin(); opt != options.End(); ++opt)
+        {
+          if (opt->optName == OPT_DATA_ACK && opt->dataAck.dataAck > highestDataAck)
+            {
+              highestDataAck = std::min(opt->dataAck.dataAck, nextTxSequence);
+              windowOpened = true;
+            }
+        }
+    }
 
   // Stop execution if TCPheader is not ACK at all.
   if (0 == (mptcpHeader.GetFlags() & TcpHeader::ACK))
@@ -970,39 +1141,26 @@ MpTcpSocketBase::ReceivedAck(uint8_t sFlowIdx, Ptr<Packet> packet, const TcpHead
   else if (ack <= sFlow->highestAck + 1)
     {
       NS_LOG_LOGIC ("This acknowlegment" << mptcpHeader.GetAckNumber () << "do not ack the latest data in subflow level");
-      list<DSNMapping *>::iterator current = sFlow->mapDSN.begin();
-      list<DSNMapping *>::iterator next = sFlow->mapDSN.begin();
-      while (current != sFlow->mapDSN.end())
-        {
-          ++next;
-          DSNMapping *ptrDSN = *current;
-          // All segments before ackSeqNum should be removed from the mapDSN list.
-          if (ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength <= ack)
-            { // Optional task ...
-              //next = sFlow->mapDSN.erase(current);
-              //delete ptrDSN;
-            }
-          // There is a sent segment with subflowSN equal to ack but the ack is smaller than already receveid acked!
-          else if ((ptrDSN->subflowSeqNumber == ack) && (ack < sFlow->highestAck + 1))
-            { // Case 1: Old ACK, ignored.
-              NS_LOG_WARN ("Ignored ack of " << mptcpHeader.GetAckNumber());
-              NS_ASSERT(3!=3);
-              break;
+      // Segments before ackSeqNum would be removed from the mapDSN on a new ACK.
+      DSNMapping *ptrDSN = sFlow->mapDSN.FindBySeq(ack);
+      // There is a sent segment with subflowSN equal to ack but the ack is smaller than already receveid acked!
+      if (ptrDSN != 0 && (ack < sFlow->highestAck + 1))
+        { // Case 1: Old ACK, ignored.
+          NS_LOG_WARN ("Ignored ack of " << mptcpHeader.GetAckNumber());
+          NS_ASSERT(3!=3);
+        }
+      // There is a sent segment with requested SequenceNumber and ack is for first unacked byte!!
+      else if (ptrDSN != 0 && (ack == sFlow->highestAck + 1))
+        { // Case 2: Potentially a duplicated ACK, so ack should be smaller than nextExpectedSN to send.
+          if (ack < sFlow->TxSeqNumber)
+            {
+              //NS_LOG_ERROR(Simulator::Now().GetSeconds()<< " [" << m_node->GetId()<< "] Duplicated ack received for SeqgNb: " << ack << " DUPACKs: " << sFlow->m_dupAckCount + 1);
+              DupAck(sFlowIdx, ptrDSN);
             }
-          // There is a sent segment with requested SequenceNumber and ack is for first unacked byte!!
-          else if ((ptrDSN->subflowSeqNumber == ack) && (ack == sFlow->highestAck + 1))
-            { // Case 2: Potentially a duplicated ACK, so ack should be smaller than nextExpectedSN to send.
-              if (ack < sFlow->TxSeqNumber)
-                {
-                  //NS_LOG_ERROR(Simulator::Now().GetSeconds()<< " [" << m_node->GetId()<< "] Duplicated ack received for SeqgNb: " << ack << " DUPACKs: " << sFlow->m_dupAckCount + 1);
-                  DupAck(sFlowIdx, ptrDSN);
-                  break;
-                }
-              // otherwise, the ACK is precisely equal to the nextTxSequence
+          else
+            { // otherwise, the ACK is precisely equal to the nextTxSequence
               NS_ASSERT(ack <= sFlow->TxSeqNumber);
-              break;
             }
-          current = next;
         }
     }
   else if (ack > sFlow->highestAck + 1)
@@ -1010,7 +1168,22 @@ MpTcpSocketBase::ReceivedAck(uint8_t sFlowIdx, Ptr<Packet> packet, const TcpHead
       NS_LOG_WARN ("New ack of " << mptcpHeader.GetAckNumber ());
       NewAckNewReno(sFlowIdx, mptcpHeader, 0);
       sFlow->m_dupAckCount = 0;
-    }
+      windowOpened = false; // NewAckNewReno has sent what the window allows
+    }
+  if (m_persistEvent.IsRunning() && ConnectionWindow() >= std::min(sendingBuffer.PendingData(), segmentSize))
+    { // Answer to a window probe or a window update, the peer's window is open again
+      m_persistEvent.Cancel();
+      m_persistProbes = 0;
+      windowOpened = true;
+    }
+  if (windowOpened && !sendingBuffer.Empty())
+    SendPendingData(sFlowIdx);
+  // An empty segment just below the subflow's receive sequence is a window probe of the peer, it gets an ACK
+  // with the current window like any unacceptable segment (RFC 793). Pure ACKs after a timeout of the peer
+  // restart at the first unacked byte and are not answered, that would count as duplicate ACKs there.
+  if (packet->GetSize() == 0 && (mptcpHeader.GetFlags() & TcpHeader::ACK)
+      && mptcpHeader.GetSequenceNumber().GetValue() + 1 == sFlow->RxSeqNumber)
+    SendEmptyPacket(sFlowIdx, TcpHeader::ACK);
   // If there is any data piggy-backed, store it into m_rxBuffer
   if (packet->GetSize() > 0)
     {
@@ -1056,21 +1229,14 @@ MpTcpSocketBase::SendDataPacket(uint8_t sFlowIdx, uint32_t size, bool withAck)
    */
   if (sFlow->maxSeqNb > sFlow->TxSeqNumber -1)
     {
-      uint32_t IterNumber = 0;
-      for (list<DSNMapping *>::iterator it = sFlow->mapDSN.begin(); (it != sFlow->mapDSN.end() && guard == false); ++it)
-        { // Look for match a segment from subflow's buffer where it is matched with TxSeqNumber
-          IterNumber++;
-          DSNMapping * ptr = *it;
-          if (ptr->subflowSeqNumber == sFlow->TxSeqNumber)
-            {
-              // NS_FATAL_ERROR ("VITALII: timeout");
-              ptrDSN = ptr;
-              p = Create<Packet>(ptrDSN->dataLevelLength);
-              packetSize = ptrDSN->dataLevelLength;
-              guard = true;
-              NS_LOG_LOGIC(Simulator::Now().GetSeconds() <<" A segment matched from subflow buffer. Its size is "<< packetSize << " IterNumInMapDSN: " << IterNumber <<" maxSeqNb: " << sFlow->maxSeqNb << " TxSeqNb: " << sFlow->TxSeqNumber << " FastRecovery: " << sFlow->m_inFastRec << " SegNb: " << ptrDSN->subflowSeqNumber); //
-              break;
-            }
+      // Look for match a segment from subflow's buffer where it is matched with TxSeqNumber
+      ptrDSN = sFlow->mapDSN.FindBySeq(sFlow->TxSeqNumber);
+      if (ptrDSN != 0)
+        {
+          p = ptrDSN->payload->Copy();
+          packetSize = ptrDSN->dataLevelLength;
+          guard = true;
+          NS_LOG_LOGIC(Simulator::Now().GetSeconds() <<" A segment matched from subflow buffer. Its size is "<< packetSize << " maxSeqNb: " << sFlow->maxSeqNb << " TxSeqNb: " << sFlow->TxSeqNumber << " FastRecovery: " << sFlow->m_inFastRec << " SegNb: " << ptrDSN->subflowSeqNumber); //
         }
       if (p == 0)
         {
@@ -1139,7 +1305,7 @@ MpTcpSocketBase::SendDataPacket(uint8_t sFlowIdx, uint32_t size, bool withAck)
   header.SetAckNumber(SequenceNumber32(sFlow->RxSeqNumber));
   header.SetSourcePort(sFlow->sPort);
   header.SetDestinationPort(sFlow->dPort);
-  header.SetWindowSize(AdvertisedWindowSize());
+  header.SetWindowSize(AdvertisedWindowSize(sFlowIdx));
   if (!guard)
     { // If packet is made from sendingBuffer, then we got to add the packet and its info to subflow's mapDSN.
       sFlow->AddDSNMapping(sFlowIdx, nextTxSequence, packetSize, sFlow->TxSeqNumber, sFlow->RxSeqNumber, p->Copy());
@@ -1199,10 +1365,8 @@ MpTcpSocketBase::SendDataPacket(uint8_t sFlowIdx, uint32_t size, bool withAck)
   if (!guard)
     sFlow->PktCount++;
 
-#ifdef PLOT
-  uint32_t tmp = (((sFlow->TxSeqNumber + packetSize) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->DATA.push_back(make_pair(Simulator::Now().GetSeconds(), tmp));
-#endif
+  if (m_stats)
+    m_stats->Record(sFlowIdx, MpTcpStats::DATA, (((sFlow->TxSeqNumber + packetSize) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod);
 
   NS_LOG_LOGIC(Simulator::Now().GetSeconds() << " ["<< m_node->GetId()<< "] SendDataPacket->  " << header <<" dSize: " << packetSize<< " sFlow: " << sFlow->routeId);
 
@@ -1328,14 +1492,14 @@ MpTcpSocketBase::DoRetransmit(uint8_t sFlowIdx)
 
   // we retransmit only one lost pkt
   //Ptr<Packet> pkt = Create<Packet>(ptrDSN->packet, ptrDSN->dataLevelLength);
-  Ptr<Packet> pkt = Create<Packet>(ptrDSN->dataLevelLength);
+  Ptr<Packet> pkt = ptrDSN->payload->Copy();
   TcpHeader header;
   header.SetSourcePort(sFlow->sPort);
   header.SetDestinationPort(sFlow->dPort);
   header.SetFlags(TcpHeader::NONE);  // Change to NONE Flag
   header.SetSequenceNumber(SequenceNumber32(ptrDSN->subflowSeqNumber));
   header.SetAckNumber(SequenceNumber32(sFlow->RxSeqNumber));  // for the acknowledgment, we ACK the sFlow last received data
-  header.SetWindowSize(AdvertisedWindowSize());
+  header.SetWindowSize(AdvertisedWindowSize(sFlowIdx));
 
   header.AddOptDSN(OPT_DSN, ptrDSN->dataSeqNumber, ptrDSN->dataLevelLength, ptrDSN->subflowSeqNumber);
 
@@ -1355,14 +1519,12 @@ MpTcpSocketBase::DoRetransmit(uint8_t sFlowIdx)
   SetReTxTimeout(sFlowIdx);
 
 
-#ifdef PLOT
-  uint32_t tmp = (((ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->RETRANSMIT.push_back(make_pair(Simulator::Now().GetSeconds(), tmp));
-  if (!sFlow->m_inFastRec)
+  if (m_stats)
     {
-      timeOutTrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->cwnd));
+      m_stats->Record(sFlowIdx, MpTcpStats::RETRANSMIT, (((ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod);
+      if (!sFlow->m_inFastRec)
+        m_stats->Record(sFlowIdx, MpTcpStats::TIMEOUT, sFlow->cwnd);
     }
-#endif
 
   //TxBytes += ptrDSN->dataLevelLength + 62;
 
@@ -1387,7 +1549,7 @@ MpTcpSocketBase::DoRetransmit(uint8_t sFlowIdx, DSNMapping* ptrDSN)
 
   // we retransmit only one lost pkt
   //Ptr<Packet> pkt = Create<Packet>(ptrDSN->packet, ptrDSN->dataLevelLength);
-  Ptr<Packet> pkt = Create<Packet>(ptrDSN->dataLevelLength);
+  Ptr<Packet> pkt = ptrDSN->payload->Copy();
   if (pkt == 0)
     NS_ASSERT(3!=3);
 
@@ -1397,7 +1559,7 @@ MpTcpSocketBase::DoRetransmit(uint8_t sFlowIdx, DSNMapping* ptrDSN)
   header.SetFlags(TcpHeader::NONE);  // Change to NONE Flag
   header.SetSequenceNumber(SequenceNumber32(ptrDSN->subflowSeqNumber));
   header.SetAckNumber(SequenceNumber32(sFlow->RxSeqNumber));
-  header.SetWindowSize(AdvertisedWindowSize());
+  header.SetWindowSize(AdvertisedWindowSize(sFlowIdx));
   // Make sure info here comes from ptrDSN...
   header.AddOptDSN(OPT_DSN, ptrDSN->dataSeqNumber, ptrDSN->dataLevelLength, ptrDSN->subflowSeqNumber);
 
@@ -1414,10 +1576,9 @@ MpTcpSocketBase::DoRetransmit(uint8_t sFlowIdx, DSNMapping* ptrDSN)
 
   // Send Segment to lower layer
   m_tcp->SendPacket(pkt, header, sFlow->sAddr, sFlow->dAddr, FindOutputNetDevice(sFlow->sAddr));
-#ifdef PLOT
-  uint32_t tmp = (((ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->RETRANSMIT.push_back(make_pair(Simulator::Now().GetSeconds(), tmp));
-#endif
+  ptrDSN->retransmitted = true;
+  if (m_stats)
+    m_stats->Record(sFlowIdx, MpTcpStats::RETRANSMIT, (((ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod);
 
   //TxBytes += ptrDSN->dataLevelLength + 62;
 
@@ -1432,29 +1593,340 @@ MpTcpSocketBase::DoRetransmit(uint8_t sFlowIdx, DSNMapping* ptrDSN)
 
   NS_LOG_INFO("("<<(int) sFlowIdx << ") DoRetransmit -> " << header);
 }
+/*
+ * The receive window is full and its first segment, at highestDataAck, is still
+ * in flight on some subflow. Reinject it once on the fastest other subflow that
+ * has room (opportunistic retransmission), and halve the holding subflow's cwnd
+ * so that it gets less data to hold back (penalization).
+ */
+void
+MpTcpSocketBase::OpportunisticRetransmit()
+{
+  if (!m_opportunisticReTx && !m_penalization)
+    return;
+
+  DSNMapping* head = 0;
+  uint8_t slowIdx = 0;
+  for (uint8_t i = 0; i < subflows.size() && head == 0; i++)
+    {
+      head = subflows[i]->mapDSN.FindByDataSeq(highestDataAck);
+      slowIdx = i;
+    }
+  if (head == 0)
+    return;
+
+  Ptr<MpTcpSubFlow> slow = subflows[slowIdx];
+  Time slowRtt = slow->rtt->GetCurrentEstimate();
+  int fastIdx = -1;
+  Time fastRtt = slowRtt;
+  for (uint8_t i = 0; i < subflows.size(); i++)
+    {
+      Ptr<MpTcpSubFlow> sFlow = subflows[i];
+      if (i == slowIdx || sFlow->state != ESTABLISHED || sFlow->retired || sFlow->maxSeqNb != sFlow->TxSeqNumber - 1)
+        continue;
+      if (sFlow->rtt->GetCurrentEstimate() < fastRtt)
+        {
+          fastIdx = i;
+          fastRtt = sFlow->rtt->GetCurrentEstimate();
+        }
+    }
+  if (fastIdx < 0)
+    return; // No faster subflow, the head is not held back by a slow path
+
+  Ptr<MpTcpSubFlow> fast = subflows[fastIdx];
+  if (m_opportunisticReTx && !head->reinjected && fast->cwnd.Get() >= BytesInFlight(fastIdx) + fast->MSS)
+    {
+      ReinjectSegment(fastIdx, head);
+      head->reinjected = true;
+      Reinjections++;
+      m_reinjectionTrace(head->dataSeqNumber, slowIdx, fastIdx);
+    }
+
+  if (m_penalization && !slow->m_inFastRec && slow->maxSeqNb == slow->TxSeqNumber - 1
+      && Simulator::Now() - slow->lastPenalized >= slowRtt)
+    {
+      slow->cwnd = std::max(slow->cwnd.Get() / 2, slow->MSS);
+      slow->ssthresh = std::max(slow->cwnd.Get(), 2 * slow->MSS);
+      slow->lastPenalized = Simulator::Now();
+      GetCongestionOps()->UpdateSubflow(slowIdx);
+      NS_LOG_LOGIC("Penalize subflow " << (int) slowIdx << " cwnd -> " << slow->cwnd);
+    }
+}
+
+/*
+ * Like SendDataPacket, but the payload and data sequence number come from a
+ * segment sent on another subflow, the connection-level sequence does not move.
+ */
+void
+MpTcpSocketBase::ReinjectSegment(uint8_t sFlowIdx, DSNMapping* ptrDSN)
+{
+  NS_LOG_FUNCTION(this << (int) sFlowIdx << ptrDSN->dataSeqNumber);
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  NS_ASSERT(sFlow->maxSeqNb == sFlow->TxSeqNumber - 1);
+
+  Ptr<Packet> p = ptrDSN->payload->Copy();
+  uint16_t packetSize = ptrDSN->dataLevelLength;
+
+  TcpHeader header;
+  header.SetFlags(0);
+  header.SetSequenceNumber(SequenceNumber32(sFlow->TxSeqNumber));
+  header.SetAckNumber(SequenceNumber32(sFlow->RxSeqNumber));
+  header.SetSourcePort(sFlow->sPort);
+  header.SetDestinationPort(sFlow->dPort);
+  header.SetWindowSize(AdvertisedWindowSize(sFlowIdx));
+  sFlow->AddDSNMapping(sFlowIdx, ptrDSN->dataSeqNumber, packetSize, sFlow->TxSeqNumber, sFlow->RxSeqNumber, p->Copy(),
+      true);
+  header.AddOptDSN(OPT_DSN, ptrDSN->dataSeqNumber, packetSize, sFlow->TxSeqNumber);
+
+  uint8_t hlen = 5;
+  uint8_t olen = 20;
+  uint8_t plen = 0;
+  plen = (4 - (olen % 4)) % 4;
+  olen = (olen + plen) / 4;
+  hlen += olen;
+  header.SetLength(hlen);
+  header.SetOptionsLength(olen);
+  header.SetPaddingLength(plen);
+
+  SetReTxTimeout(sFlowIdx);
+  m_tcp->SendPacket(p, header, sFlow->sAddr, sFlow->dAddr, FindOutputNetDevice(sFlow->sAddr));
+  sFlow->PktCount++;
+  if (m_stats)
+    m_stats->Record(sFlowIdx, MpTcpStats::DATA, (((sFlow->TxSeqNumber + packetSize) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod);
+
+  sFlow->rtt->SentSeq(SequenceNumber32(sFlow->TxSeqNumber), packetSize);
+  sFlow->TxSeqNumber += packetSize;
+  sFlow->maxSeqNb = std::max(sFlow->maxSeqNb, sFlow->TxSeqNumber - 1);
+}
+
 void
 MpTcpSocketBase::DiscardUpTo(uint8_t sFlowIdx, uint32_t ack)
 {
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  list<DSNMapping *>::iterator current = sFlow->mapDSN.begin();
-  list<DSNMapping *>::iterator next = sFlow->mapDSN.begin();
-  while (current != sFlow->mapDSN.end())
-    {
-      ++next;
-      DSNMapping *ptrDSN = *current;
-      // All segments before ackSeqNum should be removed from the mapDSN list. Maybe equal part never run due to if condition above.
-      if (ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength <= ack)
+  // All segments before ackSeqNum should be removed from the mapDSN list.
+  sFlow->mapDSN.DiscardUpTo(ack);
+}
+
+void
+MpTcpSocketBase::StartPathManager()
+{
+  if (pathManager == Adaptive && !m_pmEvent.IsRunning())
+    m_pmEvent = Simulator::Schedule(m_pmInterval, &MpTcpSocketBase::EvaluateSubflows, this);
+}
+
+/*
+ * Adaptive path manager, run every PathManagerInterval. A subflow whose share of the data
+ * acked in an interval is below RetireShare is useless in that interval; after
+ * RetireIntervals of them in a row it is retired: the schedulers skip it, so it costs neither
+ * per-packet work nor reordering, but it stays open and its data in flight is still acked or
+ * retransmitted. Subflows are only judged while the connection moves data, as DASH sessions
+ * idle between segments, unless they lost segments without getting anything acked. The
+ * lowest-RTT subflow that carried data and the last active one are never retired, one whose
+ * local interface went down is retired at once. A retired subflow is scheduled again when a
+ * local interface goes up or down, when all active subflows stalled on losses, or after
+ * ReprobeTime so that paths whose conditions changed are measured anew. The evaluations run
+ * until the connection is CLOSED.
+ */
+void
+MpTcpSocketBase::EvaluateSubflows()
+{
+  NS_LOG_FUNCTION(this);
+  if (m_state == CLOSED)
+    return; // Terminal: a closed connection is not reopened, so the evaluations stop for good
+  m_pmEvent = Simulator::Schedule(m_pmInterval, &MpTcpSocketBase::EvaluateSubflows, this);
+  if (m_state != ESTABLISHED)
+    return; // Not established yet, looked at again in the next interval
+
+  uint64_t total = 0;
+  uint32_t active = 0;
+  int fastest = -1;
+  bool ifChanged = false;
+  bool stalled = true;
+  for (uint32_t i = 0; i < subflows.size(); i++)
+    {
+      Ptr<MpTcpSubFlow> sFlow = subflows[i];
+      if (sFlow->state != ESTABLISHED)
+        continue;
+      bool up = IsLocalInterfaceUp(sFlow->sAddr);
+      sFlow->pmAcked = sFlow->pmMeasured ? sFlow->highestAck - sFlow->pmAckedMark : 0;
+      if (sFlow->pmMeasured && up != sFlow->pmIfUp)
+        ifChanged = true;
+      sFlow->pmMeasured = true;
+      sFlow->pmAckedMark = sFlow->highestAck;
+      sFlow->pmIfUp = up;
+      total += sFlow->pmAcked;
+      if (sFlow->retired)
+        continue;
+      active++;
+      if (sFlow->pmAcked > 0 || sFlow->pmLosses == 0)
+        stalled = false;
+      if (sFlow->pmAcked > 0
+          && (fastest < 0 || sFlow->rtt->GetCurrentEstimate() < subflows[fastest]->rtt->GetCurrentEstimate()))
+        fastest = i;
+    }
+
+  bool busy = total >= 10 * (uint64_t) segmentSize;
+  for (uint32_t i = 0; i < subflows.size(); i++)
+    {
+      Ptr<MpTcpSubFlow> sFlow = subflows[i];
+      if (sFlow->state != ESTABLISHED)
+        continue;
+      if (sFlow->retired)
+        {
+          bool reprobe = !m_pmReprobeTime.IsZero() && Simulator::Now() - sFlow->retiredAt >= m_pmReprobeTime;
+          if (sFlow->pmIfUp && (ifChanged || (stalled && active > 0) || reprobe))
+            SetSubflowRetired(i, false);
+        }
+      else if (!sFlow->pmIfUp)
+        {
+          if (active > 1)
+            {
+              SetSubflowRetired(i, true);
+              active--;
+            }
+        }
+      else if (busy || (sFlow->pmAcked == 0 && sFlow->pmLosses > 0))
+        {
+          if (sFlow->pmAcked < m_pmRetireShare * total || sFlow->pmAcked == 0)
+            sFlow->pmUseless++;
+          else
+            sFlow->pmUseless = 0;
+          NS_LOG_LOGIC(this << " EvaluateSubflows -> (" << i << ") acked " << sFlow->pmAcked << " of " << total
+              << " losses " << sFlow->pmLosses << " rtt " << sFlow->rtt->GetCurrentEstimate() << " useless " << sFlow->pmUseless);
+          if (sFlow->pmUseless >= m_pmRetireIntervals && (int) i != fastest && active > 1)
+            {
+              SetSubflowRetired(i, true);
+              active--;
+            }
+        }
+      sFlow->pmLosses = 0;
+    }
+}
+
+void
+MpTcpSocketBase::SetSubflowRetired(uint8_t sFlowIdx, bool retired)
+{
+  NS_LOG_FUNCTION(this << (int) sFlowIdx << retired);
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  sFlow->retired = retired;
+  sFlow->retiredAt = Simulator::Now();
+  sFlow->pmUseless = 0;
+  m_pathManagerTrace(sFlowIdx, retired);
+  if (!retired && !sendingBuffer.Empty())
+    SendPendingData(sFlowIdx);
+}
+
+bool
+MpTcpSocketBase::IsLocalInterfaceUp(Ipv4Address addr)
+{
+  Ptr<Ipv4L3Protocol> ipv4 = m_node->GetObject<Ipv4L3Protocol>();
+  int32_t interface = ipv4->GetInterfaceForAddress(addr);
+  return interface >= 0 && ipv4->IsUp(interface);
+}
+
+/*
+ * Marks the segments covered by the SACK blocks of an incoming ACK, blocks
+ * that are stale or beyond anything sent on the subflow are ignored.
+ */
+void
+MpTcpSocketBase::ProcessSack(uint8_t sFlowIdx, const TcpHeader& mptcpHeader)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  const TcpOptionList& options = mptcpHeader.GetOptions();
+  for (TcpOptionList::const_iterator opt = options.Begin(); opt != options.End(); ++opt)
+    {
+      if (opt->optName != OPT_SACK)
+        continue;
+      for (uint8_t b = 0; b < opt->sack.count; b++)
+        {
+          uint32_t left = opt->sack.left[b];
+          uint32_t right = opt->sack.right[b];
+          if (right <= left || left <= sFlow->highestAck + 1 || right > sFlow->maxSeqNb + 1)
+            continue;
+          sFlow->mapDSN.MarkSacked(left, right);
+          sFlow->highSacked = std::max(sFlow->highSacked, right);
+        }
+    }
+}
+
+void
+MpTcpSocketBase::RecordSackBlock(uint8_t sFlowIdx, uint32_t seq, uint32_t len)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  map<uint32_t, uint32_t>& blocks = sFlow->rcvSackBlocks;
+  uint32_t start = seq;
+  uint32_t end = seq + len;
+  // Merge with the ranges the segment touches
+  map<uint32_t, uint32_t>::iterator it = blocks.upper_bound(start);
+  if (it != blocks.begin())
+    {
+      map<uint32_t, uint32_t>::iterator prev = it;
+      --prev;
+      if (prev->second >= start)
         {
-//          if (sFlowIdx == 0)
-//            NS_LOG_UNCOND("DiscardUp-> SeqNb: " << ptrDSN->subflowSeqNumber << " DSNMappingSize: " << sFlow->mapDSN.size() - 1 << " Subflow(" << (int)sFlow->routeId << ")");
-          //delete ptrDSN->packet;
-          //ptrDSN->packet = 0;
-          next = sFlow->mapDSN.erase(current);
-          // delete[] ptrDSN->payload;
-          delete ptrDSN;
+          start = prev->first;
+          end = std::max(end, prev->second);
+          blocks.erase(prev);
         }
-      current = next;
     }
+  while (it != blocks.end() && it->first <= end)
+    {
+      end = std::max(end, it->second);
+      blocks.erase(it++);
+    }
+  blocks[start] = end;
+  sFlow->lastSackBlock = start;
+}
+
+/*
+ * A SYN offers SACK and window scaling, a SYN+ACK only echoes what the peer's SYN offered.
+ */
+uint8_t
+MpTcpSocketBase::AddSynOptions(uint8_t sFlowIdx, TcpHeader& header)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  bool offer = (sFlow->state == SYN_SENT);
+  uint8_t len = 0;
+  if (m_sack && (offer || sFlow->sackPermitted))
+    {
+      header.AddOptSACKPermitted(OPT_SACK_PERMITTED);
+      len += 2;
+    }
+  if (offer || sFlow->wscalePermitted)
+    {
+      sFlow->rcvWScale = RcvWindowShift();
+      header.AddOptWScale(OPT_WSCALE, sFlow->rcvWScale);
+      len += 3;
+    }
+  return len;
+}
+
+/*
+ * As in RFC 2018 the first block is the one holding the latest segment, the
+ * lowest blocks follow, since they are the holes the sender repairs first.
+ */
+uint8_t
+MpTcpSocketBase::AddOptSack(uint8_t sFlowIdx, TcpHeader& header, uint8_t maxBlocks)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  OptSack sack;
+  sack.count = 0;
+  map<uint32_t, uint32_t>::iterator latest = sFlow->rcvSackBlocks.find(sFlow->lastSackBlock);
+  if (latest != sFlow->rcvSackBlocks.end())
+    {
+      sack.left[sack.count] = latest->first;
+      sack.right[sack.count++] = latest->second;
+    }
+  for (map<uint32_t, uint32_t>::iterator it = sFlow->rcvSackBlocks.begin();
+      it != sFlow->rcvSackBlocks.end() && sack.count < maxBlocks; ++it)
+    {
+      if (it == latest)
+        continue;
+      sack.left[sack.count] = it->first;
+      sack.right[sack.count++] = it->second;
+    }
+  header.AddOptSACK(OPT_SACK, sack);
+  return 2 + 8 * sack.count;
 }
 
 // .....................................................................................................
@@ -1580,7 +2052,7 @@ MpTcpSocketBase::Connect(Ipv4Address servAddr, uint16_t servPort)
 
   // This is master subsocket (master subflow) then its endpoint is the same as connection endpoint.
   sFlow->m_endPoint = m_endPoint;
-  subflows.insert(subflows.end(), sFlow);
+  AddSubflow(sFlow);
 //  m_tcp->m_sockets.push_back(this); //TMP REMOVE
 
   sFlow->rtt->Reset(); // Dangerous ?!?!?! Not really?
@@ -1728,6 +2200,13 @@ MpTcpSocketBase::FillBuffer(uint8_t* data, uint32_t size)
   return sendingBuffer.AddRealData(data, size);
 }
 
+int
+MpTcpSocketBase::FillBuffer(Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION(this << packet->GetSize());
+  return sendingBuffer.AddPacket(packet);
+}
+
 /**
  * Sending data via subflows with available window size. It sends data only to ESTABLISHED subflows.
  * It sends data by calling SendDataPacket() function.
@@ -1781,31 +2260,13 @@ MpTcpSocketBase::SendPendingData(uint8_t sFlowIdx)
   // Send data as much as possible (it depends on subflows AvailableWindow and data in sending buffer)
   while (!sendingBuffer.Empty())
     {
-      uint32_t window = 0;
-      // Search for a subflow with available windows
-      for (uint32_t i = 0; i < subflows.size(); i++)
-        {
-          // std::cout << "\n\n Checking subflows: |" << subflows[lastUsedsFlowIdx]->state << "|\n\n";
-          if (subflows[lastUsedsFlowIdx]->state != ESTABLISHED)
-            {
-              lastUsedsFlowIdx = getSubflowToUse(); // Vitalii: For some reason server gets stuck having lastUsedsFlowIdx
-                                                    //          referring to second subflow (which is only getting
-                                                    //          established), so let's rotate the lastUsedsFlowIdx just in case
-              continue;
-            }
-          window = std::min(AvailableWindow(lastUsedsFlowIdx), sendingBuffer.PendingData()); // Get available window size
-          if (window == 0)
-            {  // No more available window in the current subflow, try with another one
-              NS_LOG_LOGIC("SendPendingData -> No window available on (" << (int)lastUsedsFlowIdx << ") Try next one!");
-              lastUsedsFlowIdx = getSubflowToUse();
-            }
-          else
-            {
-              NS_LOG_LOGIC ("SendPendingData -> Find subflow with spare window PendingData (" << sendingBuffer.PendingData() << ") Available window ("<<AvailableWindow (lastUsedsFlowIdx)<<")");
-              break;
-            }
-        }
-
+      // Ask the scheduler for a subflow with available window
+      int idx = getSubflowToUse();
+      if (idx < 0)
+        break;
+      lastUsedsFlowIdx = idx;
+      uint32_t window = std::min(AvailableWindow(lastUsedsFlowIdx), sendingBuffer.PendingData());
+      NS_LOG_LOGIC ("SendPendingData -> Scheduler picked subflow (" << idx << ") PendingData (" << sendingBuffer.PendingData() << ") Available window ("<< window <<")");
       if (window == 0)
         break;
 
@@ -1830,28 +2291,43 @@ MpTcpSocketBase::SendPendingData(uint8_t sFlowIdx)
           else
             nOctetsSent += amountSent;  // Count total bytes sent in this loop
         } // end of if statement
-      lastUsedsFlowIdx = getSubflowToUse();
     } // end of main while loop
+  // Data is left but the peer's window is full, a slow subflow may be holding back its head
+  if (!sendingBuffer.Empty() && ConnectionWindow() < std::min(sendingBuffer.PendingData(), segmentSize))
+    {
+      OpportunisticRetransmit();
+      SetPersistTimer();
+    }
   //NS_LOG_UNCOND ("["<< m_node->GetId() << "] SendPendingData -> amount data sent = " << nOctetsSent << "... Notify application.");
   if (nOctetsSent > 0)
     NotifyDataSent(GetTxAvailable());
   return (nOctetsSent > 0);
 }
 
-uint8_t
+int
 MpTcpSocketBase::getSubflowToUse()
 {
   NS_LOG_FUNCTION(this);
-  uint8_t nextSubFlow = 0;
-  switch (distribAlgo)
+  if (m_scheduler == 0)
     {
-  case Round_Robin:
-    nextSubFlow = (lastUsedsFlowIdx + 1) % subflows.size();
-    break;
-  default:
-    break;
+      switch (distribAlgo)
+        {
+      case Min_RTT:
+        m_scheduler = CreateObject<MpTcpSchedulerMinRtt>();
+        break;
+      case BLEST:
+        m_scheduler = CreateObject<MpTcpSchedulerBlest>();
+        break;
+      case ECF:
+        m_scheduler = CreateObject<MpTcpSchedulerEcf>();
+        break;
+      case Round_Robin:
+      default:
+        m_scheduler = CreateObject<MpTcpSchedulerRoundRobin>();
+        break;
+        }
     }
-  return nextSubFlow;
+  return m_scheduler->GetSubflowToUse(this);
 }
 
 /**
@@ -1893,60 +2369,19 @@ void
 MpTcpSocketBase::ReduceCWND(uint8_t sFlowIdx, DSNMapping* ptrDSN)
 {
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  uint32_t mss = sFlow->MSS;
-  int d = 0;
-  calculateTotalCWND();
-
-  switch (AlgoCC)
-    {
-  case Uncoupled_TCPs:
-  case Linked_Increases:
-  case RTT_Compensator:
-  case COUPLED_INC:
-  case COUPLED_EPSILON:
-  case UNCOUPLED:
-    sFlow->ssthresh = std::max(2 * mss, BytesInFlight(sFlowIdx) / 2);
-    sFlow->cwnd = sFlow->ssthresh + 3 * mss;
-    break;
-
-  case COUPLED_SCALABLE_TCP:
-      d = (int) sFlow->cwnd.Get() - (compute_total_window() >> 3);
-      if (d < 0)
-        d = 0;
-      sFlow->ssthresh = max(2 * mss, (uint32_t) d);
-      sFlow->cwnd = sFlow->ssthresh + 3 * mss;
-      break;
-
-  case COUPLED_FULLY:
-    d = (int) sFlow->cwnd.Get() - compute_total_window() / B_MP;
-    if (d < 0)
-      d = 0;
-    sFlow->ssthresh = max(2 * mss, (uint32_t) d);
-    sFlow->cwnd = sFlow->ssthresh + 3 * mss;
-    break;
-
-  case Fully_Coupled:
-    d = sFlow->cwnd.Get() - totalCwnd / 2;
-    if (d < 0)
-      d = 0;
-    sFlow->ssthresh = std::max(2 * mss, (uint32_t) d);
-    sFlow->cwnd = sFlow->ssthresh + 3 * mss;
-    break;
-
-  default:
-    NS_ASSERT(3!=3);
-    break;
-    }
+  Ptr<MpTcpCongestionOps> cc = GetCongestionOps();
+  sFlow->ssthresh = cc->GetSsThresh(sFlowIdx, BytesInFlight(sFlowIdx));
+  sFlow->cwnd = sFlow->ssthresh + 3 * sFlow->MSS;
   // update
   sFlow->m_recover = SequenceNumber32(sFlow->maxSeqNb + 1);
   sFlow->m_inFastRec = true;
+  cc->UpdateSubflow(sFlowIdx);
+  cc->CongestionEvent(sFlowIdx);
 
   // Retrasnmit a specific packet (lost segment)
   DoRetransmit(sFlowIdx, ptrDSN);
-#ifdef PLOT
-  reTxTrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->cwnd));
-  sFlow->ssthreshtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->ssthresh));
-#endif
+  if (m_stats)
+    m_stats->Record(sFlowIdx, MpTcpStats::FAST_RETX, sFlow->cwnd);
 }
 
 /** Retransmit timeout */
@@ -1963,18 +2398,21 @@ MpTcpSocketBase::Retransmit(uint8_t sFlowIdx)
   sFlow->ssthresh = std::max(2 * sFlow->MSS, BytesInFlight(sFlowIdx) / 2);
   sFlow->cwnd = sFlow->MSS; //  sFlow->cwnd = 1.0;
   sFlow->TxSeqNumber = sFlow->highestAck + 1; // m_nextTxSequence = m_txBuffer.HeadSequence(); // Restart from highest Ack
+  if (sFlow->sackPermitted)
+    { // RFC 2018: SACK information is not trusted after a timeout, everything unacked is sent again
+      sFlow->mapDSN.ClearSacked();
+      sFlow->highSacked = 0;
+    }
   // TODO TEMP
   //if (!(sendingBuffer->Empty() && sFlow->mapDSN.size() > 0))
   sFlow->rtt->IncreaseMultiplier();  // Double the next RTO
 
-  if (AlgoCC >= COUPLED_EPSILON)
-      window_changed();
+  GetCongestionOps()->UpdateSubflow(sFlowIdx);
+  GetCongestionOps()->CongestionEvent(sFlowIdx);
 
   DoRetransmit(sFlowIdx);  // Retransmit the packet
-#ifdef PLOT
-  sFlow->_TimeOut.push_back(make_pair(Simulator::Now().GetSeconds(), TimeScale));
-#endif
   TimeOuts++;
+  sFlow->pmLosses++;
   // rfc 3782 - Recovering from timeOut
   //sFlow->m_recover = SequenceNumber32(sFlow->maxSeqNb + 1);
 }
@@ -1994,37 +2432,17 @@ DSNMapping*
 MpTcpSocketBase::getAckedSegment(uint8_t sFlowIdx, uint32_t ack)
 {
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  DSNMapping* ptrDSN = 0;
-  for (list<DSNMapping *>::iterator it = sFlow->mapDSN.begin(); it != sFlow->mapDSN.end(); ++it)
-    {
-      DSNMapping* dsn = *it;
-      if (dsn->subflowSeqNumber + dsn->dataLevelLength == ack)
-        {
-          ptrDSN = dsn;
-          break;
-        }
-    }
-  return ptrDSN;
+  return sFlow->mapDSN.FindByEnd(ack);
 }
 
 DSNMapping*
 MpTcpSocketBase::getSegmentOfACK(uint8_t sFlowIdx, uint32_t ack)
 {
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  DSNMapping* ptrDSN = 0;
-  for (list<DSNMapping *>::iterator it = sFlow->mapDSN.begin(); it != sFlow->mapDSN.end(); ++it)
-    {
-      DSNMapping* dsn = *it;
-      if (dsn->subflowSeqNumber == ack)
-        {
-          ptrDSN = dsn;
-          break;
-        }
-    }
-  return ptrDSN;
+  return sFlow->mapDSN.FindBySeq(ack);
 }
 void
-MpTcpSocketBase::NewAckNewReno(uint8_t sFlowIdx, const TcpHeader& mptcpHeader, TcpOptions* opt)
+MpTcpSocketBase::NewAckNewReno(uint8_t sFlowIdx, const TcpHeader& mptcpHeader, const TcpOptions* opt)
 {
   NS_LOG_FUNCTION (this << (int)sFlowIdx);
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
@@ -2039,16 +2457,18 @@ MpTcpSocketBase::NewAckNewReno(uint8_t sFlowIdx, const TcpHeader& mptcpHeader, T
       sFlow->cwnd -= ack.GetValue() - (sFlow->highestAck + 1); // data bytes where acked
       // RFC3782 sec.5, partialAck condition for inflating.
       sFlow->cwnd += sFlow->MSS; // increase cwnd
-#ifdef PLOT
       NS_LOG_LOGIC ("Partial ACK in fast recovery: cwnd set to " << sFlow->cwnd.Get());
-      PartialAck.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->cwnd.Get()));
-      sFlow->ssthreshtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->ssthresh));
-      sFlow->_FR_PA.push_back(make_pair(Simulator::Now().GetSeconds(), TimeScale));
-#endif
+      if (m_stats)
+        m_stats->Record(sFlowIdx, MpTcpStats::PARTIAL_ACK, sFlow->cwnd.Get());
       DiscardUpTo(sFlowIdx, ack.GetValue());
       DSNMapping* ptrDSN = getSegmentOfACK(sFlowIdx, ack.GetValue());
       NS_ASSERT(ptrDSN != 0);
-      DoRetransmit(sFlowIdx, ptrDSN);
+      if (sFlow->sackPermitted && ptrDSN->retransmitted)
+        { // Its retransmission is still on the way, repair the next hole instead
+          ptrDSN = sFlow->mapDSN.NextLost(sFlow->highSacked);
+        }
+      if (ptrDSN != 0)
+        DoRetransmit(sFlowIdx, ptrDSN);
 
       NewACK(sFlowIdx, mptcpHeader, opt); // update m_nextTxSequence and send new data if allowed by window
       //DoRetransmit(sFlowIdx); // Assume the next seq is lost. Retransmit lost packet
@@ -2062,12 +2482,10 @@ MpTcpSocketBase::NewAckNewReno(uint8_t sFlowIdx, const TcpHeader& mptcpHeader, T
 
       // Exit from Fast recovery
       sFlow->m_inFastRec = false;
+      GetCongestionOps()->UpdateSubflow(sFlowIdx);
       FullAcks++;
-#ifdef PLOT
-      FullAck.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->cwnd.Get()));
-      sFlow->ssthreshtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->ssthresh));
-      sFlow->_FR_FA.push_back(make_pair(Simulator::Now().GetSeconds(), TimeScale));
-#endif
+      if (m_stats)
+        m_stats->Record(sFlowIdx, MpTcpStats::FULL_ACK, sFlow->cwnd.Get());
     }
 
   if (!(sFlow->mapDSN.size() == 0 && sendingBuffer.Empty() && sFlow->state == FIN_WAIT_1))
@@ -2079,7 +2497,7 @@ MpTcpSocketBase::NewAckNewReno(uint8_t sFlowIdx, const TcpHeader& mptcpHeader, T
 }
 
 void
-MpTcpSocketBase::NewACK(uint8_t sFlowIdx, const TcpHeader& mptcpHeader, TcpOptions* opt)
+MpTcpSocketBase::NewACK(uint8_t sFlowIdx, const TcpHeader& mptcpHeader, const TcpOptions* opt)
 {
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
   uint32_t ack = (mptcpHeader.GetAckNumber()).GetValue();
@@ -2096,7 +2514,8 @@ MpTcpSocketBase::NewACK(uint8_t sFlowIdx, const TcpHeader& mptcpHeader, TcpOptio
 
   if (GetTxAvailable() > 0)
     { // Notify app about free space available in TxBuffer
-      NotifyDataSent(GetTxAvailable()); // NotifySend(GetTxAvailable());
+      NotifyDataSent(GetTxAvailable());
+      NotifySend(GetTxAvailable());
     }
   if (ack > sFlow->TxSeqNumber)
     {
@@ -2156,7 +2575,7 @@ MpTcpSocketBase::SendEmptyPacket(uint8_t sFlowIdx, uint8_t flags)
   header.SetFlags(flags);
   header.SetSequenceNumber(s);
   header.SetAckNumber(SequenceNumber32(sFlow->RxSeqNumber));
-  header.SetWindowSize(AdvertisedWindowSize());
+  header.SetWindowSize(AdvertisedWindowSize(sFlowIdx, flags & TcpHeader::SYN));
 
   bool hasSyn = flags & TcpHeader::SYN;
   bool hasFin = flags & TcpHeader::FIN;
@@ -2217,6 +2636,20 @@ MpTcpSocketBase::SendEmptyPacket(uint8_t sFlowIdx, uint8_t flags)
       olen += 6;
     }
 
+  if (hasSyn)
+    {
+      olen += AddSynOptions(sFlowIdx, header);
+      sFlow->synSentTime = Simulator::Now();
+    }
+  else if (isAck)
+    { // Data-level ACK (9 bytes). The peer's window starts there, so every pure ACK carries it, whatever
+      // OpportunisticRetransmission and Penalization are set to. It leaves room for three SACK blocks.
+      header.AddOptDataACK(OPT_DATA_ACK, nextRxSequence);
+      olen += 9;
+      if (sFlow->sackPermitted && !sFlow->rcvSackBlocks.empty())
+        olen += AddOptSack(sFlowIdx, header, OptSack::MAX_BLOCKS - 1);
+    }
+
   uint8_t plen = (4 - (olen % 4)) % 4;
   olen = (olen + plen) / 4;
   hlen = 5 + olen;
@@ -2265,13 +2698,15 @@ MpTcpSocketBase::SetRcvBufSize(uint32_t size)
   //m_rxBuffer.SetMaxBufferSize(size);
   //recvingBuffer = new DataBuffer(size);
   // Size of recving buffer does not allocate any memory instantly but allows node to store to this bound.
+  // Flow control is done against m_rcvBuf instead, see AdvertisedWindowSize().
   recvingBuffer.SetBufferSize(50000000);
+  m_rcvBuf = size;
 }
 uint32_t
 MpTcpSocketBase::GetRcvBufSize(void) const
 {
   //return m_rxBuffer.MaxBufferSize();
-  return 0;
+  return m_rcvBuf;
 }
 
 
@@ -2288,12 +2723,14 @@ MpTcpSocketBase::Recv()
   NS_LOG_FUNCTION (this);
   // Vitalii: better to check if 1400 bytes is a good amount to transmit each time
   // std::cout << "Need to check what's the max size to retreive at mp-tcp-socket-base!\n";
+  uint32_t freeBefore = RcvBufFree();
   uint32_t toRead = std::min(recvingBuffer.PendingData(), uint32_t(1400));
-  uint8_t *rcvd = recvingBuffer.RetrieveRealData(toRead);
-  Ptr<Packet> outPacket = Create<Packet> (rcvd, toRead);
-  delete[] rcvd; //needs to be done as *rcvd was allocated with 'new' 
-  // std::cout << "\n\n has data after: " << recvingBuffer.PendingData() << "\n";
-
+  Ptr<Packet> outPacket = recvingBuffer.RetrievePacket(toRead);
+  if (outPacket == 0)
+    {
+      outPacket = Create<Packet>();
+    }
+  SendWindowUpdate(freeBefore);
   return outPacket;
 }
 
@@ -2303,8 +2740,11 @@ MpTcpSocketBase::Recv(uint32_t size)
 {
   NS_LOG_FUNCTION (this);
   //Null packet means no data to read, and an empty packet indicates EOF
+  uint32_t freeBefore = RcvBufFree();
   uint32_t toRead = std::min(recvingBuffer.PendingData(), size);
-  return recvingBuffer.Retrieve(toRead);
+  uint32_t amount = recvingBuffer.Retrieve(toRead);
+  SendWindowUpdate(freeBefore);
+  return amount;
 }
 
 
@@ -2375,7 +2815,8 @@ MpTcpSocketBase::DoForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t port, Pt
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
 
   //uint32_t dataLen;   // packet's payload length
-  remoteRecvWnd = (uint32_t) mptcpHeader.GetWindowSize(); //update the flow control window
+  // Update the flow control window, it is scaled on everything but SYNs once the subflow negotiated it
+  remoteRecvWnd = (uint32_t) mptcpHeader.GetWindowSize() << ((mptcpHeader.GetFlags() & TcpHeader::SYN) ? 0 : sFlow->sndWScale);
 
   if (mptcpHeader.GetFlags() & TcpHeader::ACK)
     { // This function update subflow's lastMeasureRtt variable.
@@ -2411,7 +2852,7 @@ MpTcpSocketBase::DoForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t port, Pt
         h.SetAckNumber(SequenceNumber32(sFlow->RxSeqNumber));
         h.SetSourcePort(sFlow->sPort);
         h.SetDestinationPort(sFlow->dPort);
-        h.SetWindowSize(AdvertisedWindowSize());
+        h.SetWindowSize(AdvertisedWindowSize(sFlowIdx, true));
         m_tcp->SendPacket(Create<Packet>(), h, header.GetDestination(), header.GetSource(),
             FindOutputNetDevice(header.GetDestination()));
       }
@@ -2485,7 +2926,7 @@ MpTcpSocketBase::InitiateSubflows()
         if (sFlow->m_endPoint == 0)
           return -1;
         sFlow->m_endPoint->SetRxCallback(MakeCallback(&MpTcpSocketBase::ForwardUp, Ptr<MpTcpSocketBase>(this)));
-        subflows.insert(subflows.end(), sFlow);
+        AddSubflow(sFlow);
 
         // Create packet and add MP_JOIN option to it.
         Ptr<Packet> pkt = Create<Packet>();
@@ -2495,9 +2936,9 @@ MpTcpSocketBase::InitiateSubflows()
         header.SetAckNumber(SequenceNumber32(sFlow->RxSeqNumber));
         header.SetSourcePort(sFlow->sPort);
         header.SetDestinationPort(sFlow->dPort);
-        header.SetWindowSize(AdvertisedWindowSize());
+        header.SetWindowSize(AdvertisedWindowSize(sFlow->routeId, true));
         header.AddOptJOIN(OPT_JOIN, remoteToken, addrID);
-        uint8_t olen = 6;
+        uint8_t olen = 6 + AddSynOptions(sFlow->routeId, header);
         uint8_t plen = (4 - (olen % 4)) % 4;
         olen = (olen + plen) / 4;
         uint8_t hlen = 5 + olen;
@@ -2508,6 +2949,7 @@ MpTcpSocketBase::InitiateSubflows()
 
         // Send packet lower down the networking stack
         m_tcp->SendPacket(pkt, header, local, remote, FindOutputNetDevice(local));
+        sFlow->synSentTime = Simulator::Now();
         NS_LOG_INFO("InitiateSubflows -> (" << local << " -> " << remote << ") | "<< header);
       }
   return true;
@@ -2541,7 +2983,7 @@ MpTcpSocketBase::InitiateSingleSubflows(uint16_t randomPort)
   if (sFlow->m_endPoint == 0)
     return -1;
   sFlow->m_endPoint->SetRxCallback(MakeCallback(&MpTcpSocketBase::ForwardUp, Ptr<MpTcpSocketBase>(this)));
-  subflows.insert(subflows.end(), sFlow);
+  AddSubflow(sFlow);
 
   // Create packet and add MP_JOIN option to it.
   Ptr<Packet> pkt = Create<Packet>();
@@ -2551,9 +2993,9 @@ MpTcpSocketBase::InitiateSingleSubflows(uint16_t randomPort)
   header.SetAckNumber(SequenceNumber32(sFlow->RxSeqNumber));
   header.SetSourcePort(sFlow->sPort);
   header.SetDestinationPort(sFlow->dPort);
-  header.SetWindowSize(AdvertisedWindowSize());
+  header.SetWindowSize(AdvertisedWindowSize(sFlow->routeId, true));
   header.AddOptJOIN(OPT_JOIN, remoteToken, /*addrID*/0);
-  uint8_t olen = 6;
+  uint8_t olen = 6 + AddSynOptions(sFlow->routeId, header);
   uint8_t plen = (4 - (olen % 4)) % 4;
   olen = (olen + plen) / 4;
   uint8_t hlen = 5 + olen;
@@ -2564,6 +3006,7 @@ MpTcpSocketBase::InitiateSingleSubflows(uint16_t randomPort)
   NS_LOG_UNCOND(this << " => "<< Simulator::Now().GetSeconds() <<" [" << m_node->GetId() <<"] (" <<sFlow->routeId << ") InitiateSingleSubflow -> 4-Tuple: " << sFlow->sAddr<< ":"<< sFlow->sPort << " , "<< sFlow->dAddr << ":" << sFlow->dPort);
   // Send packet lower down the networking stack
   m_tcp->SendPacket(pkt, header, sFlow->sAddr, sFlow->dAddr, FindOutputNetDevice(sFlow->sAddr));
+  sFlow->synSentTime = Simulator::Now();
 //    }
   return true;
 }
@@ -2633,63 +3076,25 @@ MpTcpSocketBase::InitiateMultipleSubflows()
 }
 #endif
 
-void
-MpTcpSocketBase::calculateTotalCWND()
-{
-  totalCwnd = 0;
-  for (uint32_t i = 0; i < subflows.size(); i++)
-    {
-      if (subflows[i]->m_inFastRec)
-        totalCwnd += subflows[i]->ssthresh;
-      else
-        totalCwnd += subflows[i]->cwnd.Get();          // Should be this all the time
-    }
-}
-
-uint32_t
-MpTcpSocketBase::compute_total_window()
-{
-  if (AlgoCC < COUPLED_SCALABLE_TCP)
-    exit(10);
-
-  totalCwnd = 0;
-  for (uint32_t i = 0; i < subflows.size(); i++)
-    {
-      if (subflows[i]->m_inFastRec)
-        totalCwnd += subflows[i]->ssthresh;
-      else
-        totalCwnd += subflows[i]->cwnd.Get();
-    }
-  return totalCwnd;
-}
-
 void
 MpTcpSocketBase::ReadUnOrderedData(Ptr<Packet> packet)
 {
   NS_LOG_FUNCTION (this);
   //NS_LOG_WARN("ReadUnOrderedData()-> Size: " << unOrdered.size());
-  list<DSNMapping *>::iterator current = unOrdered.begin();
-  list<DSNMapping *>::iterator next = unOrdered.begin();
-
-  // I changed this method, now whenever a segment is readed it get dropped from that list
-  while (next != unOrdered.end())
+  // Drain every stored segment that became in-order at connection level in one pass, it get dropped from the map once readed.
+  while (!unOrdered.empty() && unOrdered.begin()->first <= nextRxSequence)
     {
-      ++next;
-      DSNMapping *ptrDSN = *current;
+      DSNMapping *ptrDSN = unOrdered.begin()->second;
       uint32_t sFlowIdx = ptrDSN->subflowIndex;
       Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-      if ((ptrDSN->dataSeqNumber <= nextRxSequence) /*&& (ptrDSN->subflowSeqNumber == sFlow->RxSeqNumber)*/)
+      uint32_t amount = ptrDSN->dataLevelLength;
+      if (ptrDSN->dataSeqNumber < nextRxSequence)
+        { /* Same data was delivered by a copy on another subflow, e.g. a reinjected segment */
+          NS_ASSERT(ptrDSN->dataSeqNumber + ptrDSN->dataLevelLength <= nextRxSequence);
+        }
+      else
         { /* Stored segment is in-order at connection level */
-          NS_ASSERT(ptrDSN->dataSeqNumber == nextRxSequence);
-
-          //uint32_t amount = recvingBuffer->Add(ptrDSN->packet, ptrDSN->dataLevelLength);
-          // uint8_t* _buf = (uint8_t*) malloc ((size_t) ptrDSN->dataLevelLength+1); // Vitalii: I shouldn't use my packet here!
-          // uint8_t *_buf = new uint8_t[ptrDSN->dataLevelLength+1];
-          // uint32_t _siz = packet->CopyData(_buf, ptrDSN->dataLevelLength);
-          // _buf = ptrDSN->payload;
-          // uint32_t amount = recvingBuffer.Add(ptrDSN->dataLevelLength); //dude, WTF? Why handicap the implementation?
-          uint32_t amount = recvingBuffer.AddRealData(ptrDSN->payload, ptrDSN->dataLevelLength); // Vitalii: We need to add real data, not a default alphabet!
-          // free(_buf);
+          amount = recvingBuffer.AddPacket(ptrDSN->payload); // Vitalii: We need to add real data, not a default alphabet!
           if (amount == 0)
             { // Receive buffer is full.
               NS_FATAL_ERROR("In our model receive buffer never get full");
@@ -2697,38 +3102,86 @@ MpTcpSocketBase::ReadUnOrderedData(Ptr<Packet> packet)
             }
           NS_ASSERT(amount == ptrDSN->dataLevelLength);
           nextRxSequence += amount;
+        }
 
-          if (ptrDSN->subflowSeqNumber == sFlow->RxSeqNumber)
-            { /** Stored segment is also in-order at sub-flow level */
-              sFlow->RxSeqNumber += amount;
-              sFlow->highestAck = std::max(sFlow->highestAck, ptrDSN->acknowledgement - 1);
-              //SendEmptyPacket(sFlowIdx, TcpHeader::ACK);
-              sFlow->AccumulativeAck = true; //TODO TEMP
-            }
-          else
-            NS_ASSERT(ptrDSN->subflowSeqNumber < sFlow->RxSeqNumber);
-
-          NotifyDataRecv();
-          unOrdered.erase(current);
-          delete ptrDSN;
+      if (ptrDSN->subflowSeqNumber == sFlow->RxSeqNumber)
+        { /** Stored segment is also in-order at sub-flow level */
+          sFlow->RxSeqNumber += amount;
+          sFlow->highestAck = std::max(sFlow->highestAck, ptrDSN->acknowledgement - 1);
+          //SendEmptyPacket(sFlowIdx, TcpHeader::ACK);
+          sFlow->AccumulativeAck = true; //TODO TEMP
+        }
+      unOrdered.erase(unOrdered.begin());
+      if (ptrDSN->subflowSeqNumber > sFlow->RxSeqNumber)
+        { /** Still behind a hole of its sub-flow, kept so that the sub-flow jumps over it once the hole is filled */
+          ptrDSN->payload = 0;
+          continue;
         }
-      else if (ptrDSN->subflowSeqNumber == sFlow->RxSeqNumber)
-        { /* Stored segment is in-order only at sub-flow level! */
-          NS_ASSERT((ptrDSN->dataSeqNumber > nextRxSequence));
+      unOrderedBySubflow.erase(make_pair((uint8_t) sFlowIdx, ptrDSN->subflowSeqNumber));
+      delete ptrDSN;
+    }
+  m_reorderQueueDepth = unOrdered.size();
+
+  /* Stored segments that are in-order only at sub-flow level! */
+  for (uint32_t i = 0; i < subflows.size(); i++)
+    {
+      AdvanceSubflowRxSequence(i);
+    }
+  // Caller notifies the application once for all data read here
+}
+
+/*
+ * Segments arriving out of order at sub-flow level are kept in unOrdered until
+ * the connection level catches up. Once the hole in front of them is filled,
+ * subflow's RxSeqNumber jumps over them so they are not requested again.
+ * With SACK, it also jumps over the SACKed ranges, which cover segments held in
+ * unOrdered as well as those whose data had already arrived via another subflow.
+ * Segments already read at connection level stay indexed here, without payload,
+ * until their sub-flow has passed them.
+ */
+void
+MpTcpSocketBase::AdvanceSubflowRxSequence(uint8_t sFlowIdx)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  map<uint32_t, uint32_t>& blocks = sFlow->rcvSackBlocks;
+  while (true)
+    {
+      map<pair<uint8_t, uint32_t>, DSNMapping *>::iterator it = unOrderedBySubflow.find(make_pair(sFlowIdx, sFlow->RxSeqNumber));
+      if (it != unOrderedBySubflow.end())
+        {
+          DSNMapping *ptrDSN = it->second;
           //NS_LOG_UNCOND("ReadUnOrderedData()-> sub-flow is in-order but connection is out of order " << (int)sFlow->routeId);
           sFlow->RxSeqNumber += ptrDSN->dataLevelLength;
           sFlow->highestAck = std::max(sFlow->highestAck, ptrDSN->acknowledgement - 1);
           // TODO Should let sender know about this update ?!?!
           // ACK should be sent per packet basis! If we send any ACK here it would break this rule? Could we solve this via DATA-ACK?
           sFlow->AccumulativeAck = true;  // TODO TEMP
-          //SendEmptyPacket(sFlowIdx, TcpHeader::ACK);
+          unOrderedBySubflow.erase(it);
+          if (ptrDSN->dataSeqNumber < nextRxSequence)
+            { // Already read from unOrdered, so this was its last reference
+              delete ptrDSN;
+            }
         }
-      current = next;
+      else if (!blocks.empty() && blocks.begin()->first <= sFlow->RxSeqNumber)
+        { // Cumulatively acked from now on, so it is no longer reported
+          sFlow->RxSeqNumber = std::max(sFlow->RxSeqNumber, blocks.begin()->second);
+          blocks.erase(blocks.begin());
+        }
+      else
+        break;
+    }
+  // Segments jumped over by a SACK block are not looked up any more
+  map<pair<uint8_t, uint32_t>, DSNMapping *>::iterator it = unOrderedBySubflow.lower_bound(make_pair(sFlowIdx, (uint32_t) 0));
+  while (it != unOrderedBySubflow.end() && it->first.first == sFlowIdx && it->first.second < sFlow->RxSeqNumber)
+    {
+      if (it->second->dataSeqNumber < nextRxSequence)
+        delete it->second;
+      unOrderedBySubflow.erase(it++);
     }
 }
 
 uint8_t
-MpTcpSocketBase::ProcessOption(TcpOptions * opt)
+MpTcpSocketBase::ProcessOption(const TcpOptions * opt)
 {
   uint8_t originalSFlow = 255;
   if (opt != 0)
@@ -2750,10 +3203,8 @@ MpTcpSocketBase::DupAck(uint8_t sFlowIdx, DSNMapping* ptrDSN)
   uint32_t segmentSize = sFlow->MSS;
   //calculateTotalCWND();
 
-#ifdef PLOT
-  uint32_t tmp = (((ptrDSN->subflowSeqNumber) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->DUPACK.push_back(make_pair(Simulator::Now().GetSeconds(), tmp));
-#endif
+  if (m_stats)
+    m_stats->Record(sFlowIdx, MpTcpStats::DUPACK, ((ptrDSN->subflowSeqNumber - sFlow->initialSequnceNumber) / sFlow->MSS) % mod);
 
   // Congestion control algorithms
   if (sFlow->m_dupAckCount == 3 && !sFlow->m_inFastRec)
@@ -2762,21 +3213,20 @@ MpTcpSocketBase::DupAck(uint8_t sFlowIdx, DSNMapping* ptrDSN)
 
       // Cut the window to the half
       ReduceCWND(sFlowIdx, ptrDSN);
-
-#ifdef PLOT
-      sFlow->_FReTx.push_back(make_pair(Simulator::Now().GetSeconds(), TimeScale));
-#endif
       FastReTxs++;
+      sFlow->pmLosses++;
+    }
+  else if (sFlow->m_inFastRec && sFlow->sackPermitted && sFlow->mapDSN.NextLost(sFlow->highSacked) != 0)
+    { // SACK recovery (RFC6675): the segment that left the network makes room for the next hole rather than new data
+      DoRetransmit(sFlowIdx, sFlow->mapDSN.NextLost(sFlow->highSacked));
+      FastRecoveries++;
     }
   else if (sFlow->m_inFastRec)
     { // Fast Recovery
 // Increase cwnd for every additional DupACK (RFC2582, sec.3 bullet #3)
       sFlow->cwnd += segmentSize;
-
-#ifdef PLOT
-      DupAcks.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->cwnd));
-      sFlow->ssthreshtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->ssthresh));
-#endif
+      if (m_stats)
+        m_stats->Record(sFlowIdx, MpTcpStats::DUPACK_INFLATE, sFlow->cwnd);
       NS_LOG_WARN ("DupAck-> FastRecovery. Increase cwnd by one MSS, from " << sFlow->cwnd.Get() <<" -> " << sFlow->cwnd << " AvailableWindow: " << AvailableWindow(sFlowIdx));
       FastRecoveries++;
       // Send more data into pipe if possible to get ACK clock going
@@ -2803,7 +3253,9 @@ MpTcpSocketBase::DupAck(uint8_t sFlowIdx, DSNMapping* ptrDSN)
   UNCOUPLED,              // 5
   COUPLED_EPSILON,        // 6
   COUPLED_INC,            // 7
-  COUPLED_FULLY           // 8
+  COUPLED_FULLY,          // 8
+  OLIA,                   // 9
+  BALIA                   // 10
  */
 std::string
 MpTcpSocketBase::PrintCC(uint32_t cc)
@@ -2837,6 +3289,12 @@ MpTcpSocketBase::PrintCC(uint32_t cc)
   case 8:
     return "CF";             //8
     break;
+  case 9:
+    return "OLIA";           //9
+    break;
+  case 10:
+    return "BALIA";          //10
+    break;
   default:
     exit(200);
     return "Unknown";
@@ -2866,6 +3324,8 @@ MpTcpSocketBase::GeneratePlotDetail(void)
 void
 MpTcpSocketBase::GenerateCwndTracer()
 {
+  if (!m_stats)
+    return;
   Gnuplot cwndTracerGraph;
   cwndTracerGraph.AppendExtra("set terminal postscript eps enhanced color solid font 'Times-Bold,15'\n"
                               "set output \"cwnd.eps\"\n"
@@ -2885,13 +3345,14 @@ MpTcpSocketBase::GenerateCwndTracer()
       std::stringstream title;
       title << "SF " << idx;
       dataSet.SetTitle(title.str());
-      vector<pair<double, uint32_t> >::iterator it = sFlow->cwndTracer.begin();
-      while (it != sFlow->cwndTracer.end())
+      const vector<pair<double, double> >& samples = m_stats->Get(idx, MpTcpStats::CWND).samples;
+      vector<pair<double, double> >::const_iterator it = samples.begin();
+      while (it != samples.end())
         {
           dataSet.Add(it->first, it->second / sFlow->MSS);
           it++;
         }
-      if (sFlow->cwndTracer.size() > 0)
+      if (samples.size() > 0)
         cwndTracerGraph.AddDataset(dataSet);
     }
 
@@ -2915,13 +3376,14 @@ MpTcpSocketBase::GenerateCwndTracer()
       std::stringstream title;
       title << "SST " << idx;
       dataSet.SetTitle(title.str());
-      vector<pair<double, uint32_t> >::iterator it = sFlow->sstTracer.begin();
-      while (it != sFlow->sstTracer.end())
+      const vector<pair<double, double> >& samples = m_stats->Get(idx, MpTcpStats::SSTHRESH).samples;
+      vector<pair<double, double> >::const_iterator it = samples.begin();
+      while (it != samples.end())
         {
           dataSet.Add(it->first, it->second);
           it++;
         }
-      if (sFlow->sstTracer.size() > 0)
+      if (samples.size() > 0)
         sstGraph.AddDataset(dataSet);
     }
   gnu.AddPlot(cwndTracerGraph);
@@ -2931,6 +3393,8 @@ MpTcpSocketBase::GenerateCwndTracer()
 void
 MpTcpSocketBase::GenerateRTT()
 {
+  if (!m_stats)
+    return;
   // RTT
   Gnuplot rttGraph;
   rttGraph.AppendExtra(
@@ -2955,14 +3419,15 @@ MpTcpSocketBase::GenerateRTT()
 
       dataSet.SetTitle(title.str());
 
-      vector<pair<double, double> >::iterator it = sFlow->rttTracer.begin();
+      const vector<pair<double, double> >& samples = m_stats->Get(idx, MpTcpStats::SRTT).samples;
+      vector<pair<double, double> >::const_iterator it = samples.begin();
 
-      while (it != sFlow->rttTracer.end())
+      while (it != samples.end())
         {
           dataSet.Add(it->first, it->second);
           it++;
         }
-      if (sFlow->rttTracer.size() > 0)
+      if (samples.size() > 0)
         rttGraph.AddDataset(dataSet);
     }
 
@@ -2989,14 +3454,15 @@ MpTcpSocketBase::GenerateRTT()
 
       dataSet.SetTitle(title.str());
 
-      vector<pair<double, double> >::iterator it = sFlow->rtoTracer.begin();
+      const vector<pair<double, double> >& samples = m_stats->Get(idx, MpTcpStats::RTO).samples;
+      vector<pair<double, double> >::const_iterator it = samples.begin();
 
-      while (it != sFlow->rtoTracer.end())
+      while (it != samples.end())
         {
           dataSet.Add(it->first, it->second);
           it++;
         }
-      if (sFlow->rtoTracer.size() > 0)
+      if (samples.size() > 0)
         rtoGraph.AddDataset(dataSet);
     }
 
@@ -3014,9 +3480,10 @@ MpTcpSocketBase::GenerateRTT()
 
       dataSet.SetTitle(title.str());
 
-      vector<pair<double, double> >::iterator it = TxQueue.begin();
+      const vector<pair<double, double> >& samples = m_stats->Get(idx, MpTcpStats::TX_QUEUE).samples;
+      vector<pair<double, double> >::const_iterator it = samples.begin();
 
-      while (it != TxQueue.end())
+      while (it != samples.end())
         {
           dataSet.Add(it->first, it->second);
           it++;
@@ -3070,35 +3537,34 @@ bool
 MpTcpSocketBase::StoreUnOrderedData(DSNMapping *toStore)
 {
   NS_LOG_FUNCTION (this);
-  for (list<DSNMapping *>::iterator it = unOrdered.begin(); it != unOrdered.end(); ++it)
+  uint64_t start = toStore->dataSeqNumber;
+  uint64_t end = start + toStore->dataLevelLength;
+  // Duplicate or overlap with the segment after it
+  map<uint64_t, DSNMapping *>::iterator next = unOrdered.lower_bound(start);
+  if (next != unOrdered.end() && next->first < end)
     {
-      DSNMapping *stored = *it;
-      if (toStore->dataSeqNumber == stored->dataSeqNumber)
+      NS_LOG_WARN("StoreUnOrderedData -> DSN " << start << " overlaps stored DSN " << next->first);
+      return false;
+    }
+  // Overlap with the segment before it
+  if (next != unOrdered.begin())
+    {
+      map<uint64_t, DSNMapping *>::iterator prev = next;
+      --prev;
+      if (prev->first + prev->second->dataLevelLength > start)
         {
+          NS_LOG_WARN("StoreUnOrderedData -> DSN " << start << " overlaps stored DSN " << prev->first);
           return false;
         }
-      else if (toStore->dataSeqNumber < stored->dataSeqNumber)
-        {
-    /*
-          std::cout << "\n Subflows to store:" << int(toStore->subflowIndex) << "; Subflow stored: " 
-                    << int(stored->subflowIndex) << ";\n";
-          std::cout << "DSN to store: " << toStore->dataSeqNumber << "; DSN stored: " 
-                    << stored->dataSeqNumber << ";\n";
-          std::cout << "SSN to store: " << toStore->subflowSeqNumber << "; SSN stored: "
-                    << stored->subflowSeqNumber << ";\n";
-    */
-          // This assertion is to make sure un-ordered segments are stored in-order of subflow & connection level.
-          // Vitalii: for some reason I sometimes get this assert violated, though it seems that it should not 
-          // happen; however, if I just comment it out, everything still goes well.
-
-          // if (toStore->subflowIndex == stored->subflowIndex)
-          //   NS_ASSERT(toStore->subflowSeqNumber < stored->subflowSeqNumber);
+    }
+  unOrdered.insert(next, make_pair(start, toStore));
 
-          unOrdered.insert(it, toStore);
-          return true;
-        }
+  Ptr<MpTcpSubFlow> sFlow = subflows[toStore->subflowIndex];
+  if (toStore->subflowSeqNumber > sFlow->RxSeqNumber)
+    { // Out of order at sub-flow level as well
+      unOrderedBySubflow[make_pair(toStore->subflowIndex, toStore->subflowSeqNumber)] = toStore;
     }
-  unOrdered.insert(unOrdered.end(), toStore);
+  m_reorderQueueDepth = unOrdered.size();
   return true;
 }
 
@@ -3221,10 +3687,10 @@ MpTcpSocketBase::FindPacketFromUnOrdered(uint8_t sFlowIdx)
 {
   NS_LOG_FUNCTION((int)sFlowIdx);
   bool reValue = false;
-  list<DSNMapping *>::iterator current = unOrdered.begin();
+  map<uint64_t, DSNMapping *>::iterator current = unOrdered.begin();
   while (current != unOrdered.end())
     {
-      DSNMapping* ptrDSN = *current;
+      DSNMapping* ptrDSN = current->second;
       if (ptrDSN->subflowIndex == sFlowIdx)
         {
           reValue = true;
@@ -3511,9 +3977,10 @@ MpTcpSocketBase::AdvertiseAvailableAddresses()
           header.AddOptADDR(OPT_ADDR, addrInfo->addrID, addrInfo->ipv4Addr);
           olen += 6;
           localAddrs.insert(localAddrs.end(), addrInfo);
+          localAddrByIp.insert(make_pair(addrInfo->ipv4Addr, addrInfo));
         }
       uint8_t plen = (4 - (olen % 4)) % 4;
-      header.SetWindowSize(AdvertisedWindowSize());
+      header.SetWindowSize(AdvertisedWindowSize(0));
       olen = (olen + plen) / 4;
       hlen = 5 + olen;
       header.SetLength(hlen);
@@ -3612,35 +4079,13 @@ bool
 MpTcpSocketBase::IsLocalAddress(Ipv4Address addr)
 {
   NS_LOG_FUNCTION(this << addr);
-  bool found = false;
-  MpTcpAddressInfo * pAddrInfo;
-  for (uint32_t i = 0; i < localAddrs.size(); i++)
-    {
-      pAddrInfo = localAddrs[i];
-      if (pAddrInfo->ipv4Addr == addr)
-        {
-          found = true;
-          break;
-        }
-    }
-  return found;
+  return localAddrByIp.find(addr) != localAddrByIp.end();
 }
 
 bool
 MpTcpSocketBase::IsRemoteAddress(Ipv4Address addr)
 {
-  bool found = false;
-  MpTcpAddressInfo * mpAddrInfo;
-  for (uint32_t i = 0; i < remoteAddrs.size(); i++)
-    {
-      mpAddrInfo = remoteAddrs[i];
-      if (mpAddrInfo->ipv4Addr == addr)
-        {
-          found = true;
-          break;
-        }
-    }
-  return found;
+  return remoteAddrByIp.find(addr) != remoteAddrByIp.end();
 }
 
 uint32_t
@@ -3651,10 +4096,177 @@ MpTcpSocketBase::BytesInFlight(uint8_t sFlowIdx)
   return sFlow->maxSeqNb - sFlow->highestAck;        //m_highTxMark - m_highestRxAck;
 }
 
+/**
+ * The window is what is left of the connection-level receive buffer once the data not yet
+ * read by the application is taken off. Windows on a SYN are never scaled (RFC 7323).
+ */
 uint16_t
-MpTcpSocketBase::AdvertisedWindowSize()
+MpTcpSocketBase::AdvertisedWindowSize(uint8_t sFlowIdx, bool syn)
 {
-  return (uint16_t) 65535;
+  uint32_t window = RcvBufFree();
+  if (!syn && sFlowIdx < subflows.size() && subflows[sFlowIdx]->wscalePermitted)
+    window >>= subflows[sFlowIdx]->rcvWScale;
+  return (uint16_t) std::min<uint32_t>(window, 65535);
+}
+
+uint32_t
+MpTcpSocketBase::RcvBufFree()
+{
+  uint32_t pending = recvingBuffer.PendingData();
+  return (pending >= m_rcvBuf.Get()) ? 0 : (m_rcvBuf.Get() - pending);
+}
+
+/**
+ * Tell a sender that saw the window close that it reopened, once the application has read
+ * enough for a full segment. Should this ACK be lost, the sender's window probe finds out.
+ */
+void
+MpTcpSocketBase::SendWindowUpdate(uint32_t freeBefore)
+{
+  if (freeBefore >= segmentSize || RcvBufFree() < segmentSize)
+    return;
+  for (uint32_t i = 0; i < subflows.size(); i++)
+    {
+      if (subflows[i]->state == ESTABLISHED)
+        {
+          SendEmptyPacket(i, TcpHeader::ACK);
+          return;
+        }
+    }
+}
+
+/*
+ * Once all data is acked, no ACK will tell the sender that the peer's window reopened unless
+ * the peer's window update gets through. The persist timer probes the window then, as for
+ * TCP (RFC 1122 4.2.2.17), backing off from PersistTimeout up to 60 s.
+ */
+void
+MpTcpSocketBase::SetPersistTimer()
+{
+  if (m_persistEvent.IsRunning())
+    return;
+  for (uint32_t i = 0; i < subflows.size(); i++)
+    {
+      if (subflows[i]->state == ESTABLISHED && BytesInFlight(i) > 0)
+        return; // Its ACKs carry the window
+    }
+  Time timeout = Seconds(std::min(60.0, m_persistTimeout.GetSeconds() * (1 << std::min<uint32_t>(m_persistProbes, 6))));
+  NS_LOG_LOGIC(this << " SetPersistTimer -> window " << ConnectionWindow() << " probe in " << timeout);
+  m_persistEvent = Simulator::Schedule(timeout, &MpTcpSocketBase::PersistTimeout, this);
+}
+
+/*
+ * The probe is an empty ACK one byte below the subflow's unacked data, on the fastest subflow that
+ * is scheduled, and the peer answers it with its current window. As it carries no data, the
+ * connection-level sequence space needs no byte set aside for it.
+ */
+void
+MpTcpSocketBase::PersistTimeout()
+{
+  NS_LOG_FUNCTION(this);
+  if (sendingBuffer.Empty() || ConnectionWindow() >= std::min(sendingBuffer.PendingData(), segmentSize))
+    {
+      m_persistProbes = 0;
+      if (!sendingBuffer.Empty())
+        SendPendingData();
+      return;
+    }
+
+  int fastIdx = -1;
+  for (uint32_t i = 0; i < subflows.size(); i++)
+    {
+      Ptr<MpTcpSubFlow> sFlow = subflows[i];
+      if (sFlow->state != ESTABLISHED || sFlow->retired || sFlow->m_endPoint == 0)
+        continue;
+      if (fastIdx < 0 || sFlow->rtt->GetCurrentEstimate() < subflows[fastIdx]->rtt->GetCurrentEstimate())
+        fastIdx = i;
+    }
+  if (fastIdx < 0)
+    return; // Nothing established is left to probe on
+
+  Ptr<MpTcpSubFlow> sFlow = subflows[fastIdx];
+  TcpHeader header;
+  header.SetSourcePort(sFlow->sPort);
+  header.SetDestinationPort(sFlow->dPort);
+  header.SetFlags(TcpHeader::ACK);
+  header.SetSequenceNumber(SequenceNumber32(sFlow->highestAck));
+  header.SetAckNumber(SequenceNumber32(sFlow->RxSeqNumber));
+  header.SetWindowSize(AdvertisedWindowSize(fastIdx));
+  header.AddOptDataACK(OPT_DATA_ACK, nextRxSequence);
+  uint8_t olen = 9;
+  uint8_t plen = (4 - (olen % 4)) % 4;
+  olen = (olen + plen) / 4;
+  header.SetLength(5 + olen);
+  header.SetOptionsLength(olen);
+  header.SetPaddingLength(plen);
+  NS_LOG_LOGIC(this << " PersistTimeout -> probe " << m_persistProbes << " on subflow " << fastIdx);
+  m_tcp->SendPacket(Create<Packet>(), header, sFlow->sAddr, sFlow->dAddr, FindOutputNetDevice(sFlow->sAddr));
+
+  m_persistProbes++;
+  SetPersistTimer();
+}
+
+uint8_t
+MpTcpSocketBase::RcvWindowShift()
+{
+  uint32_t bound = std::max(m_rcvBufMax, m_rcvBuf.Get());
+  uint8_t shift = 0;
+  while (shift < 14 && ((uint64_t) 65535 << shift) < bound)
+    shift++;
+  return shift;
+}
+
+/**
+ * Dynamic right-sizing as in Linux: once per RTT the receive buffer is grown to twice the
+ * data delivered in that RTT, so the window never limits a sender that is still opening its
+ * cwnd. The buffer only grows, bounded by m_rcvBufMax and by what is left of the node's
+ * TcpL4Protocol::MpTcpRcvBufLimit. The RTT is the handshake's, a pure receiver has no other.
+ */
+void
+MpTcpSocketBase::AdjustRcvBuf()
+{
+  if (!m_rcvBufAutoTuning || m_tcp == 0)
+    return;
+  Time now = Simulator::Now();
+  if (m_rcvSpaceSeq == 0)
+    {
+      m_rcvSpaceSeq = nextRxSequence;
+      m_rcvSpaceTime = now;
+      return;
+    }
+  Time rtt = Seconds(0);
+  for (uint32_t i = 0; i < subflows.size(); i++)
+    {
+      if (subflows[i]->state == ESTABLISHED)
+        rtt = std::max(rtt, subflows[i]->handshakeRtt);
+    }
+  if (rtt.IsZero() || now - m_rcvSpaceTime < rtt)
+    return;
+
+  uint64_t copied = nextRxSequence - m_rcvSpaceSeq;
+  m_rcvSpaceSeq = nextRxSequence;
+  m_rcvSpaceTime = now;
+  uint64_t wanted = std::min<uint64_t>(2 * copied, m_rcvBufMax);
+  if (wanted <= m_rcvBuf.Get())
+    return;
+  uint32_t room = (m_tcp->m_mpRcvBufUsed >= m_tcp->m_mpRcvBufLimit) ? 0 : (m_tcp->m_mpRcvBufLimit - m_tcp->m_mpRcvBufUsed);
+  uint32_t grow = std::min<uint64_t>(wanted - m_rcvBuf.Get(), room);
+  if (grow == 0)
+    return;
+  NS_LOG_LOGIC(this << " AdjustRcvBuf -> " << m_rcvBuf.Get() << " + " << grow << " copied: " << copied << " rtt: " << rtt);
+  m_rcvBuf += grow;
+  m_rcvBufReserved += grow;
+  m_tcp->m_mpRcvBufUsed += grow;
+}
+
+void
+MpTcpSocketBase::ReleaseRcvBuf()
+{
+  if (m_tcp == 0 || m_rcvBufReserved == 0)
+    return;
+  m_tcp->m_mpRcvBufUsed -= std::min(m_rcvBufReserved, m_tcp->m_mpRcvBufUsed);
+  m_rcvBuf -= m_rcvBufReserved;
+  m_rcvBufReserved = 0;
 }
 
 uint32_t
@@ -3666,6 +4278,10 @@ MpTcpSocketBase::AvailableWindow(uint8_t sFlowIdx)
   uint32_t window = std::min(remoteRecvWnd, sFlow->cwnd.Get());
   uint32_t unAcked = (sFlow->TxSeqNumber - (sFlow->highestAck + 1));
   uint32_t freeCWND = (window < unAcked) ? 0 : (window - unAcked);
+  if (sFlow->maxSeqNb == sFlow->TxSeqNumber - 1)
+    { // New data also has to fit into the peer's window at connection level
+      freeCWND = std::min(freeCWND, ConnectionWindow());
+    }
   // NS_LOG_UNCOND ("\n\n window: " << window << "; unacked: " << unAcked << "; free: " << freeCWND << ";\n\n");
   if (freeCWND < sFlow->MSS && sendingBuffer.PendingData() >= sFlow->MSS)
     {
@@ -3679,6 +4295,17 @@ MpTcpSocketBase::AvailableWindow(uint8_t sFlowIdx)
     }
 }
 
+/*
+ * The peer advertises one window for the whole connection, starting at the
+ * highest data-level ACK, so data outstanding on all subflows counts against it.
+ */
+uint32_t
+MpTcpSocketBase::ConnectionWindow()
+{
+  uint64_t outstanding = nextTxSequence - highestDataAck;
+  return (outstanding >= remoteRecvWnd) ? 0 : (uint32_t) (remoteRecvWnd - outstanding);
+}
+
 uint32_t
 MpTcpSocketBase::GetTxAvailable()
 {
@@ -3718,16 +4345,10 @@ MpTcpSocketBase::LookupSubflow(Ipv4Address src, uint32_t srcPort, Ipv4Address ds
   Ptr<MpTcpSubFlow> sFlow = 0;
   uint8_t sFlowIdx = maxSubflows;
 
-  // Walk through the existing subflow container and try to find one with 4-tuple match!
-  for (uint32_t i = 0; i < subflows.size(); i++)
-    {
-      sFlow = subflows[i];
-      if (sFlow->sAddr == src && sFlow->dAddr == dst && sFlow->sPort == srcPort && sFlow->dPort == dstPort)
-        {
-          sFlowIdx = i;
-          return sFlowIdx;
-        }
-    }
+  // Find an existing subflow with 4-tuple match!
+  unordered_map<MpTcpTuple, uint8_t, MpTcpTupleHash>::iterator it = subflowByTuple.find(MpTcpTuple(src, srcPort, dst, dstPort));
+  if (it != subflowByTuple.end())
+    return it->second;
 
   // For now this should be happen only at server side
   NS_ASSERT(server);
@@ -3754,87 +4375,30 @@ MpTcpSocketBase::LookupSubflow(Ipv4Address src, uint32_t srcPort, Ipv4Address ds
   if (sFlow->m_endPoint == 0)
     return -1;
   sFlow->m_endPoint->SetRxCallback(MakeCallback(&MpTcpSocketBase::ForwardUp, Ptr<MpTcpSocketBase>(this)));
-  subflows.insert(subflows.end(), sFlow);
+  AddSubflow(sFlow);
   NS_LOG_UNCOND(this << " LookupSubflow -> Subflow(" << (int) sFlowIdx <<") has created its (src,dst) = (" << sFlow->sAddr << ":" << sFlow->sPort << " , "<< sFlow->dAddr << ":" << sFlow->dPort<< ")" );
 
   return sFlowIdx;
 }
 
-uint32_t
-MpTcpSocketBase::compute_a_scaled()
-{
-  if (AlgoCC < COUPLED_EPSILON)
-      exit(1);
-
-  uint32_t sum_denominator = 0;
-  uint64_t t = 0;
-  uint64_t cwndSum = 0;
-
-  for (uint32_t i = 0; i < subflows.size(); i++)
-    {
-      Ptr<MpTcpSubFlow> sFlow = subflows[i];
-      Time time = sFlow->rtt->GetCurrentEstimate();
-      uint32_t rtt = time.GetMicroSeconds() / 10;
-      if (rtt == 0)
-        rtt = 1;
-
-      uint32_t cwnd = sFlow->m_inFastRec ? sFlow->ssthresh : sFlow->cwnd.Get();
-      uint32_t mss = sFlow->MSS;
-
-      t = max(t, (uint64_t) cwnd * mss * mss / rtt / rtt);
-      sum_denominator += cwnd * mss / rtt;
-      cwndSum += cwnd;
-    }
-  return (uint32_t) (A_SCALE * (uint64_t) cwndSum * t / sum_denominator / sum_denominator);
-}
-
-double
-MpTcpSocketBase::compute_alfa()
+uint8_t
+MpTcpSocketBase::LookupByAddrs(Ipv4Address src, Ipv4Address dst)
 {
-  if (AlgoCC < COUPLED_EPSILON)
-      exit(300);
-
-  if (subflows.size() == 1)
-    {
-      return 1;
-    }
-  else
-    {
-      double maxt = 0, sum_denominator = 0;
-      for (uint32_t i = 0; i < subflows.size(); i++)
-        {
-          Ptr<MpTcpSubFlow> sFlow = subflows[i];
-          uint32_t cwnd = sFlow->m_inFastRec ? sFlow->ssthresh : sFlow->cwnd.Get();
-          Time time = sFlow->rtt->GetCurrentEstimate();
-          uint32_t rtt = time.GetMilliSeconds();
-
-          if (rtt == 0)
-            rtt = 1;
-
-          double t = pow(cwnd, _e / 2) / rtt;
-          if (t > maxt)
-            maxt = t;
-          sum_denominator += ((double) cwnd / rtt);
-        }
-      return (double) compute_total_window() * pow(maxt, 1 / (1 - _e / 2)) / pow(sum_denominator, 1 / (1 - _e / 2));
-    }
+  NS_LOG_FUNCTION(this << src << dst);
+  unordered_map<uint64_t, uint8_t>::iterator it = subflowByAddrs.find(((uint64_t) src.Get() << 32) | dst.Get());
+  if (it == subflowByAddrs.end())
+    return maxSubflows;
+  return it->second;
 }
 
 void
-MpTcpSocketBase::window_changed()
+MpTcpSocketBase::AddSubflow(Ptr<MpTcpSubFlow> sFlow)
 {
-  switch (AlgoCC)
-    {
-  case COUPLED_EPSILON:
-    if (_e > 0 && _e < 2)
-      alpha = compute_alfa();
-    return;
-  case COUPLED_INC:
-    a = compute_a_scaled();
-    return;
-  default:
-    break;
-    }
+  NS_LOG_FUNCTION(this << sFlow->sAddr << sFlow->sPort << sFlow->dAddr << sFlow->dPort);
+  uint8_t sFlowIdx = subflows.size();
+  subflows.insert(subflows.end(), sFlow);
+  subflowByTuple.insert(make_pair(MpTcpTuple(sFlow->sAddr, sFlow->sPort, sFlow->dAddr, sFlow->dPort), sFlowIdx));
+  subflowByAddrs.insert(make_pair(((uint64_t) sFlow->sAddr.Get() << 32) | sFlow->dAddr.Get(), sFlowIdx));
 }
 
 void
@@ -3842,190 +4406,90 @@ MpTcpSocketBase::OpenCWND(uint8_t sFlowIdx, uint32_t ackedBytes)
 {
   NS_LOG_FUNCTION(this << (int) sFlowIdx << ackedBytes);
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  Ptr<MpTcpCongestionOps> cc = GetCongestionOps();
 
-  double adder = 0;
-  uint32_t cwnd = sFlow->cwnd.Get();
-  uint32_t ssthresh = sFlow->ssthresh;
-  uint32_t mss = sFlow->MSS;
-
-  // params used only for COUPLED_INC and COUPLED_EPS only
-  int tcp_inc, tt;
-  int tmp, total_cwnd, tmp2;
-  double tmp_float;
-
-  if (AlgoCC >= COUPLED_SCALABLE_TCP)
-    {
-      if (ackedBytes > mss)
-        ackedBytes = mss;
-      if (ackedBytes < 0)
-        {
-          exit(200);
-          return;
-        }
-      tcp_inc = (ackedBytes * mss) / cwnd;
-      tt = (ackedBytes * mss) % cwnd;
-      if (m_alphaPerAck)
-        {
-          a = compute_a_scaled(); // Per ACK for COUPLED_INC
-          alpha = compute_alfa(); // Per ACK for COUPLED_EPSILON
-        }
-    }
-
-  calculateTotalCWND();
-  if (cwnd < ssthresh)
+  cc->PktsAcked(sFlowIdx, ackedBytes);
+  if (sFlow->cwnd.Get() < sFlow->ssthresh)
     {
       sFlow->cwnd += sFlow->MSS;
-#ifdef PLOT
-      sFlow->ssthreshtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->ssthresh));
-      sFlow->CWNDtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->cwnd));
-      totalCWNDtrack.push_back(make_pair(Simulator::Now().GetSeconds(), totalCwnd));
-      sFlow->_ss.push_back(make_pair(Simulator::Now().GetSeconds(), TimeScale));
-#endif
+      if (m_stats)
+        m_stats->Record(sFlowIdx, MpTcpStats::SLOW_START, sFlow->cwnd);
       NS_LOG_WARN ("Congestion Control (Slow Start) increment by one segmentSize");
     }
   else
+    {
+      cc->CongestionAvoidance(sFlowIdx, ackedBytes);
+      if (m_stats)
+        m_stats->Record(sFlowIdx, MpTcpStats::CONG_AVOID, sFlow->cwnd);
+    }
+  if (m_stats)
+    m_stats->Record(sFlowIdx, MpTcpStats::TOTAL_CWND, cc->GetTotalCwnd());
+}
+
+/**
+ * Congestion control object of this connection, created from AlgoCC on first use. Subflows created since the
+ * last call are registered with it here, so subflow creation paths don't need to know about it.
+ */
+Ptr<MpTcpCongestionOps>
+MpTcpSocketBase::GetCongestionOps()
+{
+  if (m_congestionOps == 0)
     {
       switch (AlgoCC)
         {
-      case RTT_Compensator:
-        calculateAlpha(); // Calculate alpha per drop or RTT...RFC 6356 (Section 4.1)
-        adder = std::min(alpha * sFlow->MSS * sFlow->MSS / totalCwnd, static_cast<double>(sFlow->MSS * sFlow->MSS) / cwnd);
-        adder = std::max(1.0, adder);
-        sFlow->cwnd += static_cast<double>(adder);
-#ifdef PLOT
-        sFlow->ssthreshtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->ssthresh));
-        sFlow->CWNDtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->cwnd));
-        totalCWNDtrack.push_back(make_pair(Simulator::Now().GetSeconds(), totalCwnd));
-#endif
-        NS_LOG_ERROR ("Congestion Control (RTT_Compensator): alpha "<<alpha<<" ackedBytes (" << ackedBytes << ") totalCwnd ("<< totalCwnd / sFlow->MSS<<" packets) -> increment is "<<adder << " cwnd: " << sFlow->cwnd);
-        break;
       case Linked_Increases:
-        calculateAlpha();
-        adder = alpha * sFlow->MSS * sFlow->MSS / totalCwnd;
-        adder = std::max(1.0, adder);
-        sFlow->cwnd += static_cast<double>(adder);
-#ifdef PLOT
-        sFlow->ssthreshtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->ssthresh));
-        sFlow->CWNDtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->cwnd));
-        totalCWNDtrack.push_back(make_pair(Simulator::Now().GetSeconds(), totalCwnd));
-#endif
-        NS_LOG_ERROR ("Subflow "<<(int)sFlowIdx<<" Congestion Control (Linked_Increases): alpha "<<alpha<<" increment is "<<adder<<" ssthresh "<< ssthresh << " cwnd "<<cwnd );
+      case RTT_Compensator:
+      case COUPLED_INC:
+      case COUPLED_EPSILON:
+        m_congestionOps = CreateObject<MpTcpLia>();
         break;
-      case Uncoupled_TCPs:
-        adder = static_cast<double>(sFlow->MSS * sFlow->MSS) / cwnd;
-        adder = std::max(1.0, adder);
-        sFlow->cwnd += static_cast<double>(adder);
-#ifdef PLOT
-        sFlow->ssthreshtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->ssthresh));
-        sFlow->CWNDtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->cwnd));
-        totalCWNDtrack.push_back(make_pair(Simulator::Now().GetSeconds(), totalCwnd));
-#endif
-        NS_LOG_WARN ("Subflow "<<(int)sFlowIdx<<" Congestion Control (Uncoupled_TCPs) increment is "<<adder<<" ssthresh "<< ssthresh << " cwnd "<<cwnd);
+      case OLIA:
+        m_congestionOps = CreateObject<MpTcpOlia>();
         break;
-      case UNCOUPLED:
-        sFlow->cwnd += tcp_inc;
+      case BALIA:
+        m_congestionOps = CreateObject<MpTcpBalia>();
         break;
       case Fully_Coupled:
-        adder = static_cast<double>(sFlow->MSS * sFlow->MSS) / totalCwnd;
-        adder = std::max(1.0, adder);
-        sFlow->cwnd += static_cast<double>(adder);
-#ifdef PLOT
-        sFlow->ssthreshtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->ssthresh));
-        sFlow->CWNDtrack.push_back(make_pair(Simulator::Now().GetSeconds(), sFlow->cwnd));
-        totalCWNDtrack.push_back(make_pair(Simulator::Now().GetSeconds(), totalCwnd));
-#endif
-        NS_LOG_ERROR ("Subflow "<<(int)sFlowIdx<<" Congestion Control (Fully_Coupled) increment is "<<adder<<" ssthresh "<< ssthresh << " cwnd "<<cwnd);
-        break;
-
-      case COUPLED_INC:
-        total_cwnd = compute_total_window();
-        tmp2 = (ackedBytes * mss * a) / total_cwnd;
-
-        tmp = tmp2 / A_SCALE;
-
-        if (tmp < 0)
-          {
-            printf("Negative increase!");
-            tmp = 0;
-          }
-
-        if (rand() % A_SCALE < tmp2 % A_SCALE)
-          tmp++;
-
-        if (tmp > tcp_inc)    //capping
-          tmp = tcp_inc;
-
-        if ((cwnd + tmp) / mss != cwnd / mss)
-          a = compute_a_scaled();
-
-        sFlow->cwnd = cwnd + tmp;
-        break;
-
-      case COUPLED_EPSILON: // RTT_Compensator
-        total_cwnd = compute_total_window();
-        tmp_float = ((double) ackedBytes * mss * alpha * pow(alpha * cwnd, 1 - _e)) / pow(total_cwnd, 2 - _e);
-        tmp = (int) floor(tmp_float);
-
-        if (drand() < tmp_float - tmp)
-          tmp++;
-
-        if (tmp > tcp_inc)    //capping
-          tmp = tcp_inc;
-
-        if ((cwnd + tmp) / mss != cwnd / mss)
-          {
-            if (_e > 0 && _e < 2)
-              alpha = compute_alfa();
-          }
-
-        sFlow->cwnd = cwnd + tmp;
+      case COUPLED_FULLY:
+        m_congestionOps = CreateObject<MpTcpFullyCoupled>();
         break;
-        //
       case COUPLED_SCALABLE_TCP:
-        sFlow->cwnd = cwnd + ackedBytes * 0.01;
+        m_congestionOps = CreateObject<MpTcpCoupledScalable>();
         break;
-
-      case COUPLED_FULLY:
-          total_cwnd = compute_total_window();
-          tt = (int) (ackedBytes * mss * A_MP);
-          tmp = tt / total_cwnd;
-          if (tmp > tcp_inc)
-            tmp = tcp_inc;
-          sFlow->cwnd = cwnd + tmp;
-          break;
+      case Uncoupled_TCPs:
+      case UNCOUPLED:
       default:
+        m_congestionOps = CreateObject<MpTcpUncoupledReno>();
         break;
         }
-#ifdef PLOT
-      sFlow->_ca.push_back(make_pair(Simulator::Now().GetSeconds(), TimeScale));
-#endif
     }
+  while (m_congestionOps->GetNSubflows() < subflows.size())
+    m_congestionOps->AddSubflow(subflows[m_congestionOps->GetNSubflows()]);
+  return m_congestionOps;
 }
 
+/**
+ * Statistics are opt-in: nothing is recorded unless plotting is enabled for this flow type or a
+ * StatsFilePrefix is given, in which case the connection's first established subflow creates them.
+ */
 void
-MpTcpSocketBase::calculateAlpha()
+MpTcpSocketBase::StartStats(uint8_t sFlowIdx)
 {
-  // this method is called whenever a congestion happen in order to regulate the agressivety of subflows
-  // alpha = cwnd_total * MAX(cwnd_i / rtt_i^2) / {SUM(cwnd_i / rtt_i))^2}   //RFC 6356 formula (2)
-
-  NS_LOG_FUNCTION_NOARGS ();
-  alpha = 0;
-  double maxi = 0;
-  double sumi = 0;
-
-  for (uint32_t i = 0; i < subflows.size(); i++)
+  bool plotting = (m_largePlotting && (flowType.compare("Large") == 0)) || (m_shortPlotting && (flowType.compare("Short") == 0));
+  if (!plotting && m_statsFilePrefix.empty())
+    return;
+  if (m_stats == 0)
     {
-      Ptr<MpTcpSubFlow> sFlow = subflows[i];
-
-      Time time = sFlow->rtt->GetCurrentEstimate();
-      double rtt = time.GetSeconds();
-      double tmpi = sFlow->cwnd.Get() / (rtt * rtt);
-      if (maxi < tmpi)
-        maxi = tmpi;
-
-      sumi += sFlow->cwnd.Get() / rtt;
+      string fileName;
+      if (!m_statsFilePrefix.empty())
+        {
+          stringstream oss;
+          oss << m_statsFilePrefix << "-" << m_node->GetId() << "-" << subflows[sFlowIdx]->sPort << "-" << subflows[sFlowIdx]->dPort;
+          fileName = oss.str();
+        }
+      m_stats = Create<MpTcpStats>(m_statsSamples, fileName);
     }
-  alpha = (totalCwnd * maxi) / (sumi * sumi);
+  subflows[sFlowIdx]->StartTracing("cWindow", m_stats);
 }
 
 void
@@ -4035,11 +4499,7 @@ MpTcpSocketBase::DestroySubflowMapDSN()
   for (uint32_t i = 0; i < subflows.size(); i++)
     {
       Ptr<MpTcpSubFlow> sFlow = subflows[i];
-      for (std::list<DSNMapping *>::iterator i = sFlow->mapDSN.begin(); i != sFlow->mapDSN.end(); i++)
-        {
-          i = sFlow->mapDSN.erase(i);
-        }
-      sFlow->mapDSN.clear();
+      sFlow->mapDSN.Clear();
     }
 }
 
@@ -4047,11 +4507,19 @@ void
 MpTcpSocketBase::DestroyUnOrdered()
 {
   NS_LOG_FUNCTION_NOARGS();
-  for (std::list<DSNMapping*>::iterator i = unOrdered.begin(); i != unOrdered.end(); i++)
+  for (map<uint64_t, DSNMapping*>::iterator i = unOrdered.begin(); i != unOrdered.end(); i++)
+    {
+      delete i->second;
+    }
+  // Segments already read but still behind a hole of their sub-flow are only referenced here
+  for (map<pair<uint8_t, uint32_t>, DSNMapping*>::iterator i = unOrderedBySubflow.begin(); i != unOrderedBySubflow.end(); i++)
     {
-      i = unOrdered.erase(i);
+      if (i->second->dataSeqNumber < nextRxSequence)
+        delete i->second;
     }
   unOrdered.clear();
+  unOrderedBySubflow.clear();
+  m_reorderQueueDepth = 0;
 }
 
 /** Kill this socket. This is a callback function configured to m_endpoint in
@@ -4069,6 +4537,7 @@ MpTcpSocketBase::Destroy(void)
         {
           m_tcp->m_sockets.erase(it);
         }
+      ReleaseRcvBuf();
     }
   CancelAllSubflowTimers();
   NS_LOG_INFO("Leave Destroy(" << this << ") m_sockets:  " << m_tcp->m_sockets.size()<< ")");
@@ -4110,12 +4579,21 @@ void
 MpTcpSocketBase::SetCongestionCtrlAlgo(CongestionCtrl_t ccalgo)
 {
   AlgoCC = ccalgo;
+  m_congestionOps = 0;
 }
 
 void
 MpTcpSocketBase::SetDataDistribAlgo(DataDistribAlgo_t ddalgo)
 {
   distribAlgo = ddalgo;
+  m_scheduler = 0;
+}
+
+void
+MpTcpSocketBase::SetScheduler(Ptr<MpTcpScheduler> scheduler)
+{
+  NS_LOG_FUNCTION(this << scheduler);
+  m_scheduler = scheduler;
 }
 
 void
@@ -4171,7 +4649,13 @@ MpTcpSocketBase::getQueuePkt(Ipv4Address addr)
   PointerValue ptr;
   net0->GetAttribute("TxQueue", ptr);
   Ptr<Queue> txQueue = ptr.Get<Queue>();
-  TxQueue.push_back(make_pair(Simulator::Now().GetSeconds(), txQueue->GetNPackets()));
+  if (!m_stats)
+    return;
+  for (uint32_t i = 0; i < subflows.size(); i++)
+    {
+      if (subflows[i]->sAddr == addr)
+        m_stats->Record(i, MpTcpStats::TX_QUEUE, txQueue->GetNPackets());
+    }
 }
 // PLOT_CI_5_8_MPTCP_0_1
 void
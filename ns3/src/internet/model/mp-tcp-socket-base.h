@@ -21,15 +21,17 @@
 #ifndef MP_TCP_SOCKET_BASE_H
 #define MP_TCP_SOCKET_BASE_H
 
+#include <unordered_map>
 #include "ns3/mp-tcp-typedefs.h"
 #include "ns3/tcp-socket-base.h"
 #include "ns3/gnuplot.h"
 #include "mp-tcp-subflow.h"
+#include "ns3/mp-tcp-scheduler.h"
+#include "ns3/mp-tcp-congestion-ops.h"
+#include "ns3/mp-tcp-stats.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/traced-callback.h"
 
-#define A_MP 1
-#define B_MP 2
-#define A_SCALE 512
 
 using namespace std;
 namespace ns3
@@ -62,6 +64,7 @@ public: // public methods
   //int FillBuffer(uint8_t* buf, uint32_t size);// Fill sending buffer with data - TcpTxBuffer API need to be used in future!
   int FillBuffer(uint32_t size);
   int FillBuffer(uint8_t* data, uint32_t size);
+  int FillBuffer(Ptr<Packet> packet);   // Queue the packet itself, its bytes are not copied
   //uint32_t Recv(uint8_t* buf, uint32_t size); // Receive data from receiveing buffer - TcpRxBuffe API need to be used in future!
   Ptr<Packet> Recv();
   uint32_t Recv(uint32_t size); // Receive data from receiveing buffer - TcpRxBuffe API need to be used in future!
@@ -79,7 +82,8 @@ public: // public methods
 
   // Setter for congestion Control and data distribution algorithm
   void SetCongestionCtrlAlgo(CongestionCtrl_t ccalgo);  // This would be used by attribute system for setting congestion control
-  void SetDataDistribAlgo(DataDistribAlgo_t ddalgo);    // Round Robin is only algorithms used.
+  void SetDataDistribAlgo(DataDistribAlgo_t ddalgo);    // Select one of the built-in packet schedulers
+  void SetScheduler(Ptr<MpTcpScheduler> scheduler);     // Install a custom packet scheduler
   void SetPathManager (PathManager_t);
 
 
@@ -99,6 +103,7 @@ public: // public variables
   uint32_t TimeOuts;
   uint32_t FastReTxs;
   uint32_t FastRecoveries;
+  uint32_t Reinjections;
   bool flowCompletionTime;
   //uint64_t TxBytes;
   uint32_t flowId;
@@ -112,21 +117,15 @@ public: // public variables
   bool m_shortFlowTCP;
   //
   GnuplotCollection gnu;
-  std::list<uint32_t> sampleList;
-
-  vector<pair<double, double> > totalCWNDtrack;
-  vector<pair<double, double> > reTxTrack;
-  vector<pair<double, double> > timeOutTrack;
-  vector<pair<double, double> > PartialAck;
-  vector<pair<double, double> > FullAck;
-  vector<pair<double, double> > DupAcks;
-  vector<pair<double, double> > PacketDrop;
-  vector<pair<double, double> > TxQueue;
+  string m_statsFilePrefix;   // Stream every statistics record to <prefix>-<node>-<localPort>-<remotePort> if not empty
+  uint32_t m_statsSamples;    // Plotting points kept per subflow and series
+  Ptr<MpTcpStats> m_stats;    // Only created if plotting is active or m_statsFilePrefix is set
 
 
 protected: // protected methods
 
   friend class Tcp;
+  friend class MpTcpScheduler;
 
   // Implementing some inherited methods from ns3::TcpSocket. No need to comment them!
   virtual void SetSndBufSize (uint32_t size);
@@ -179,12 +178,20 @@ protected: // protected methods
   void ProcessWait    (uint8_t sFlowIdx, Ptr<Packet>, const TcpHeader&);
   void ProcessClosing (uint8_t sFlowIdx, Ptr<Packet>, const TcpHeader&);
   void ProcessLastAck (uint8_t sFlowIdx, Ptr<Packet>, const TcpHeader&);
-  uint8_t ProcessOption(TcpOptions *opt);
+  uint8_t ProcessOption(const TcpOptions *opt);
 
   // Window Management
   virtual uint32_t BytesInFlight(uint8_t sFlowIdx);  // Return total bytes in flight of a subflow
-  uint16_t AdvertisedWindowSize();
+  uint16_t AdvertisedWindowSize(uint8_t sFlowIdx, bool syn = false); // Free receive buffer, scaled unless on a SYN
   uint32_t AvailableWindow(uint8_t sFlowIdx);
+  uint32_t ConnectionWindow();       // Room left in the peer's receive window at connection level
+  uint32_t RcvBufFree();             // Receive buffer left once the data not yet read is taken off
+  void SendWindowUpdate(uint32_t freeBefore); // ACK a window the application reopened by reading
+  void SetPersistTimer();            // Probe the peer's window if it is closed and nothing is in flight to reopen it
+  virtual void PersistTimeout();     // Send a window probe on the fastest subflow and back off
+  uint8_t RcvWindowShift();          // Window scale to offer, enough for the receive buffer to reach m_rcvBufMax
+  void AdjustRcvBuf();               // Grow the receive buffer to twice the data delivered per RTT
+  void ReleaseRcvBuf();              // Return auto-tuned buffer space to the node's budget
 
   // Manage data Tx/Rx
   virtual Ptr<TcpSocketBase> Fork(void);
@@ -196,8 +203,8 @@ protected: // protected methods
   virtual bool ReadOptions (Ptr<Packet> pkt, const TcpHeader&); // Read option from incoming packets (Listening Socket only)
   virtual void DupAck(const TcpHeader& t, uint32_t count);  // Not in operation, it's pure virtual function from TcpSocketBase
   virtual void DupAck(uint8_t sFlowIdx, DSNMapping * ptrDSN);       // Congestion control algorithms -> loss recovery
-  virtual void NewACK(uint8_t sFlowIdx, const TcpHeader&, TcpOptions* opt);
-  void NewAckNewReno(uint8_t sFlowIdx, const TcpHeader&, TcpOptions* opt);
+  virtual void NewACK(uint8_t sFlowIdx, const TcpHeader&, const TcpOptions* opt);
+  void NewAckNewReno(uint8_t sFlowIdx, const TcpHeader&, const TcpOptions* opt);
   virtual void DoRetransmit (uint8_t sFlowIdx);
   virtual void DoRetransmit (uint8_t sFlowIdx, DSNMapping* ptrDSN);
   void SetReTxTimeout(uint8_t sFlowIdx);
@@ -205,27 +212,39 @@ protected: // protected methods
   virtual void Retransmit(uint8_t sFlowIdx);
   void LastAckTimeout(uint8_t sFlowIdx);
   void DiscardUpTo(uint8_t sFlowIdx, uint32_t ack);
+  void ProcessSack(uint8_t sFlowIdx, const TcpHeader&);   // Update the subflow's scoreboard from SACK blocks
+  void RecordSackBlock(uint8_t sFlowIdx, uint32_t seq, uint32_t len); // Remember an out-of-order segment to SACK
+  uint8_t AddOptSack(uint8_t sFlowIdx, TcpHeader& header, uint8_t maxBlocks); // Returns the option's length in bytes
+  uint8_t AddSynOptions(uint8_t sFlowIdx, TcpHeader& header); // SACK-Permitted and Window Scale, returns their length
+  void OpportunisticRetransmit();    // Unblock a full receive window by reinjecting its head segment
+  void ReinjectSegment(uint8_t sFlowIdx, DSNMapping* ptrDSN); // Send a copy of another subflow's segment
+
+  // Adaptive path management
+  void StartPathManager();           // Schedule the first evaluation once a subflow is established
+  void EvaluateSubflows();           // Retire subflows that carry nothing, schedule retired ones again
+  void SetSubflowRetired(uint8_t sFlowIdx, bool retired);
+  bool IsLocalInterfaceUp(Ipv4Address addr);
 
   // Re-ordering buffer
   bool StoreUnOrderedData(DSNMapping *ptr);
   void ReadUnOrderedData(Ptr<Packet> packet);
+  void AdvanceSubflowRxSequence(uint8_t sFlowIdx); // Skip subflow SeqNbs already held in unOrdered
   bool FindPacketFromUnOrdered(uint8_t sFlowIdx);
 
   // Congestion control
   virtual void OpenCWND(uint8_t sFlowIdx, uint32_t ackedBytes);
   void ReduceCWND(uint8_t sFlowIdx, DSNMapping* ptrDSN);
-  virtual void calculateAlpha();
-  virtual void calculateTotalCWND();
-  uint32_t compute_total_window();
-  uint32_t compute_a_scaled();
-  double compute_alfa();
-  void window_changed();
+  Ptr<MpTcpCongestionOps> GetCongestionOps();
+
+  // Evaluation & plotting
+  void StartStats(uint8_t sFlowIdx);  // Called once a subflow is established
 
   // Helper functions -> main operations
   uint8_t LookupByAddrs(Ipv4Address src, Ipv4Address dst); // Called by Forwardup() to find the right subflow for incoing packet
   virtual int LookupSubflow(Ipv4Address src, uint32_t sPort, Ipv4Address dst , uint32_t dPort); // LookupBy4-Tuple
+  void AddSubflow(Ptr<MpTcpSubFlow> sFlow);                // Append a subflow whose 4-tuple is set and index it
 
-  virtual uint8_t getSubflowToUse();  // Called by SendPendingData() to get a subflow based on round robin algorithm
+  virtual int getSubflowToUse();  // Called by SendPendingData() to ask the scheduler for a subflow, -1 if none should be used now
   bool IsThereRoute(Ipv4Address src, Ipv4Address dst);     // Called by InitiateSubflow & LookupByAddrs and Connect to check whether there is route between a pair of addresses.
   bool IsLocalAddress(Ipv4Address addr);
   bool IsRemoteAddress(Ipv4Address addr);
@@ -289,18 +308,35 @@ protected: // protected variables
   vector<Ptr<MpTcpSubFlow> > subflows;
   vector<MpTcpAddressInfo *> localAddrs;
   vector<MpTcpAddressInfo *> remoteAddrs;
-  list<DSNMapping *> unOrdered;  // buffer that hold the out of sequence received packet
+  unordered_map<MpTcpTuple, uint8_t, MpTcpTupleHash> subflowByTuple;        // Subflows are never removed, so indexes stay valid
+  unordered_map<uint64_t, uint8_t> subflowByAddrs;                          // First subflow of each (src, dst) address pair
+  unordered_map<Ipv4Address, MpTcpAddressInfo *, Ipv4AddressHash> localAddrByIp;
+  unordered_map<Ipv4Address, MpTcpAddressInfo *, Ipv4AddressHash> remoteAddrByIp;
+  map<uint64_t, DSNMapping *> unOrdered;  // buffer that hold the out of sequence received packet, keyed by dataSeqNumber
+  map<pair<uint8_t, uint32_t>, DSNMapping *> unOrderedBySubflow; // segments of unOrdered beyond their subflow's RxSeqNumber
+  TracedValue<uint32_t> m_reorderQueueDepth; // number of segments in unOrdered
 
   // Congestion control
-  double alpha;
-  uint32_t a;
-  double _e;
-
-  uint32_t totalCwnd;
   CongestionCtrl_t AlgoCC;       // Algorithm for Congestion Control
+  Ptr<MpTcpCongestionOps> m_congestionOps; // Created from AlgoCC on first use
   DataDistribAlgo_t distribAlgo; // Algorithm for Data Distribution
+  Ptr<MpTcpScheduler> m_scheduler; // Packet scheduler, created from distribAlgo on first use
   PathManager_t pathManager;        // Mechanism for subflow establishement
 
+  // Loss recovery
+  bool m_sack;                   // Offer and accept SACK on subflows
+  bool m_opportunisticReTx;      // Reinject the segment holding back a full receive window on a faster subflow
+  bool m_penalization;           // Halve the cwnd of the subflow holding back a full receive window
+  TracedCallback<uint64_t, uint8_t, uint8_t> m_reinjectionTrace; // Data seq, subflow holding it, subflow reinjected on
+
+  // Adaptive path management
+  Time m_pmInterval;             // How often subflows are evaluated
+  uint32_t m_pmRetireIntervals;  // Consecutive useless intervals before a subflow is retired
+  double m_pmRetireShare;        // Share of the acked data below which a subflow is useless in an interval
+  Time m_pmReprobeTime;          // Retired subflows are scheduled again after this long, zero never
+  EventId m_pmEvent;             // Next evaluation
+  TracedCallback<uint8_t, bool> m_pathManagerTrace; // Subflow, true if retired, false if scheduled again
+
   // Window management variables
   uint32_t m_ssThresh;           // Slow start threshold
   uint32_t m_initialCWnd;        // Initial congestion window value
@@ -308,6 +344,16 @@ protected: // protected variables
   uint32_t segmentSize;          // Segment size
   uint64_t nextTxSequence;       // Next expected sequence number to send in connection level
   uint64_t nextRxSequence;       // Next expected sequence number to receive in connection level
+  uint64_t highestDataAck;       // Highest data-level ACK received, the peer's window starts there
+  uint32_t m_persistProbes;      // Window probes sent since the peer's window closed, each doubles PersistTimeout
+
+  // Receive buffer auto-tuning
+  TracedValue<uint32_t> m_rcvBuf; // Connection-level receive buffer, the advertised window is what is free of it
+  uint32_t m_rcvBufMax;          // Auto-tuning never grows m_rcvBuf beyond this
+  bool m_rcvBufAutoTuning;       // Size m_rcvBuf from the data delivered per RTT
+  uint32_t m_rcvBufReserved;     // Bytes auto-tuning added to m_rcvBuf, charged to TcpL4Protocol::m_mpRcvBufUsed
+  uint64_t m_rcvSpaceSeq;        // nextRxSequence at the start of the current measurement
+  Time m_rcvSpaceTime;           // Start of the current measurement, zero before the first data
 
   // Buffer management
   DataBuffer sendingBuffer;
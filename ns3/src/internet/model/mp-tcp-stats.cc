@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/mp-tcp-stats.h"
+
+NS_LOG_COMPONENT_DEFINE("MpTcpStats");
+
+namespace ns3
+{
+
+MpTcpStats::Series::Series() :
+    count(0), min(0), max(0), mean(0), m2(0), stride(1)
+{
+}
+
+void
+MpTcpStats::Series::Add(double time, double value, uint32_t capacity)
+{
+  if (count == 0 || value < min)
+    min = value;
+  if (count == 0 || value > max)
+    max = value;
+  double delta = value - mean;
+  mean += delta / (count + 1);
+  m2 += delta * (value - mean);
+
+  if (capacity > 0 && count % stride == 0)
+    {
+      samples.push_back(make_pair(time, value));
+      if (samples.size() >= capacity)
+        { // Keep the points at even positions, i.e. those at a multiple of the doubled stride
+          for (uint32_t i = 0; 2 * i < samples.size(); i++)
+            samples[i] = samples[2 * i];
+          samples.resize((samples.size() + 1) / 2);
+          stride *= 2;
+        }
+    }
+  count++;
+}
+
+double
+MpTcpStats::Series::GetVariance() const
+{
+  return count > 1 ? m2 / (count - 1) : 0;
+}
+
+MpTcpStats::MpTcpStats(uint32_t samples, string fileName) :
+    m_samples(samples)
+{
+  NS_LOG_FUNCTION(this << samples << fileName);
+  if (!fileName.empty())
+    {
+      m_file.open(fileName.c_str(), ios::out | ios::binary | ios::trunc);
+      if (!m_file.is_open())
+        NS_LOG_WARN("MpTcpStats -> Unable to open " << fileName);
+      else
+        m_file.write("MPTSTAT1", 8);
+    }
+}
+
+MpTcpStats::~MpTcpStats()
+{
+  NS_LOG_FUNCTION(this);
+  if (m_file.is_open())
+    m_file.close();
+}
+
+void
+MpTcpStats::Record(uint8_t sFlowIdx, Series_t series, double value)
+{
+  double now = Simulator::Now().GetSeconds();
+  if (sFlowIdx >= m_series.size())
+    m_series.resize(sFlowIdx + 1, vector<Series>(SERIES_COUNT));
+  m_series[sFlowIdx][series].Add(now, value, m_samples);
+
+  if (m_file.is_open())
+    {
+      uint8_t ids[2] = { sFlowIdx, (uint8_t) series };
+      m_file.write(reinterpret_cast<const char*>(&now), sizeof(now));
+      m_file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+      m_file.write(reinterpret_cast<const char*>(ids), sizeof(ids));
+    }
+}
+
+const MpTcpStats::Series&
+MpTcpStats::Get(uint8_t sFlowIdx, Series_t series) const
+{
+  if (sFlowIdx >= m_series.size())
+    return m_empty;
+  return m_series[sFlowIdx][series];
+}
+
+uint32_t
+MpTcpStats::GetNSubflows() const
+{
+  return m_series.size();
+}
+
+string
+MpTcpStats::GetSeriesName(Series_t series)
+{
+  switch (series)
+    {
+  case CWND:           return "cwnd";
+  case SSTHRESH:       return "ssthresh";
+  case RTT:            return "rtt";
+  case SRTT:           return "srtt";
+  case RTO:            return "rto";
+  case DATA:           return "data";
+  case ACK:            return "ack";
+  case RETRANSMIT:     return "retransmit";
+  case DUPACK:         return "dupack";
+  case SLOW_START:     return "slow-start";
+  case CONG_AVOID:     return "congestion-avoidance";
+  case FAST_RETX:      return "fast-retransmit";
+  case PARTIAL_ACK:    return "partial-ack";
+  case FULL_ACK:       return "full-ack";
+  case DUPACK_INFLATE: return "dupack-inflate";
+  case TIMEOUT:        return "timeout";
+  case TOTAL_CWND:     return "total-cwnd";
+  case TX_QUEUE:       return "tx-queue";
+  default:             return "unknown";
+    }
+}
+
+} //namespace ns3
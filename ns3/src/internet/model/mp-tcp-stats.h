@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MP_TCP_STATS_H
+#define MP_TCP_STATS_H
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include "ns3/simple-ref-count.h"
+
+using namespace std;
+
+namespace ns3
+{
+
+/**
+ * Evaluation and plotting statistics of an MPTCP connection, with memory
+ * that does not grow with the simulated time.
+ *
+ * Each (subflow, series) pair keeps a running summary (count, min, max,
+ * mean, variance) and at most 'samples' (time, value) points for plotting:
+ * when the points are full every other one is dropped and only every
+ * second following record is kept, so the points stay evenly spread over
+ * the whole run.
+ *
+ * If a file name is given every record is also appended to it, unthinned,
+ * in binary form: an 8 byte "MPTSTAT1" magic followed by 18 byte records
+ * of { double time (s); double value; uint8_t subflow; uint8_t series },
+ * in host byte order.
+ */
+class MpTcpStats : public SimpleRefCount<MpTcpStats>
+{
+public:
+  typedef enum
+  {
+    CWND,           // Congestion window (bytes), on every change
+    SSTHRESH,       // Slow start threshold (bytes)
+    RTT,            // RTT sample (ms)
+    SRTT,           // Smoothed RTT (ms)
+    RTO,            // Retransmission timeout (ms)
+    DATA,           // Segment number of a sent data packet
+    ACK,            // Segment number of a received ACK
+    RETRANSMIT,     // Segment number of a retransmitted packet
+    DUPACK,         // Segment number of a duplicated ACK
+    SLOW_START,     // cwnd after a slow start increase
+    CONG_AVOID,     // cwnd after a congestion avoidance increase
+    FAST_RETX,      // cwnd upon fast retransmit
+    PARTIAL_ACK,    // cwnd upon a partial ACK in fast recovery
+    FULL_ACK,       // cwnd upon a full ACK ending fast recovery
+    DUPACK_INFLATE, // cwnd inflated by a duplicated ACK in fast recovery
+    TIMEOUT,        // cwnd before a retransmission timeout
+    TOTAL_CWND,     // Sum of the subflows' windows (bytes)
+    TX_QUEUE,       // Packets in the output device queue
+    SERIES_COUNT
+  } Series_t;
+
+  class Series
+  {
+  public:
+    Series();
+    void Add(double time, double value, uint32_t capacity);
+    double GetVariance() const;
+    uint64_t count;
+    double min;
+    double max;
+    double mean;
+    double m2;                                // Sum of squared deviations from the mean (Welford)
+    uint32_t stride;                          // One record in 'stride' is kept in 'samples'
+    vector<pair<double, double> > samples;    // Evenly thinned (time, value) points
+  };
+
+  MpTcpStats(uint32_t samples, string fileName);
+  ~MpTcpStats();
+
+  void Record(uint8_t sFlowIdx, Series_t series, double value);   // Record 'value' at the current simulation time
+  const Series& Get(uint8_t sFlowIdx, Series_t series) const;     // Empty series if nothing was recorded
+  uint32_t GetNSubflows() const;
+  static string GetSeriesName(Series_t series);
+
+private:
+  uint32_t m_samples;
+  vector<vector<Series> > m_series;  // [subflow][series]
+  ofstream m_file;
+  Series m_empty;
+};
+
+} //namespace ns3
+#endif /* MP_TCP_STATS_H */
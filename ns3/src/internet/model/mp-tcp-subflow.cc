@@ -50,7 +50,6 @@ MpTcpSubFlow::MpTcpSubFlow() :
     dAddr(Ipv4Address::GetZero()),
     dPort(0),
     oif(0),
-    mapDSN(0),
     lastMeasuredRtt(Seconds(0.0))
 {
   connected = false;
@@ -79,6 +78,23 @@ MpTcpSubFlow::MpTcpSubFlow() :
   m_gotFin = false;
   AccumulativeAck = false;
   m_limitedTxCount = 0;
+  sackPermitted = false;
+  highSacked = 0;
+  lastSackBlock = 0;
+  lastPenalized = Seconds(0);
+  wscalePermitted = false;
+  sndWScale = 0;
+  rcvWScale = 0;
+  synSentTime = Seconds(0);
+  handshakeRtt = Seconds(0);
+  retired = false;
+  retiredAt = Seconds(0);
+  pmMeasured = false;
+  pmAckedMark = 0;
+  pmAcked = 0;
+  pmLosses = 0;
+  pmUseless = 0;
+  pmIfUp = true;
 }
 
 MpTcpSubFlow::~MpTcpSubFlow()
@@ -92,12 +108,7 @@ MpTcpSubFlow::~MpTcpSubFlow()
   cwnd = 0;
   maxSeqNb = 0;
   highestAck = 0;
-  for (list<DSNMapping *>::iterator it = mapDSN.begin(); it != mapDSN.end(); ++it)
-    {
-      DSNMapping * ptrDSN = *it;
-      delete ptrDSN;
-    }
-  mapDSN.clear();
+  mapDSN.Clear();
 }
 
 bool
@@ -107,9 +118,10 @@ MpTcpSubFlow::Finished(void)
 }
 
 void
-MpTcpSubFlow::StartTracing(string traced)
+MpTcpSubFlow::StartTracing(string traced, Ptr<MpTcpStats> s)
 {
   //NS_LOG_UNCOND("("<< routeId << ") MpTcpSubFlow -> starting tracing of: "<< traced);
+  stats = s;
   TraceConnectWithoutContext(traced, MakeCallback(&MpTcpSubFlow::CwndTracer, this)); //"CongestionWindow"
 }
 
@@ -117,18 +129,18 @@ void
 MpTcpSubFlow::CwndTracer(uint32_t oldval, uint32_t newval)
 {
   //NS_LOG_UNCOND("Subflow "<< routeId <<": Moving cwnd from " << oldval << " to " << newval);
-  cwndTracer.push_back(make_pair(Simulator::Now().GetSeconds(), newval));
-  sstTracer.push_back(make_pair(Simulator::Now().GetSeconds(), ssthresh));
-  rttTracer.push_back(make_pair(Simulator::Now().GetSeconds(), rtt->GetCurrentEstimate().GetMilliSeconds()));
-  rtoTracer.push_back(make_pair(Simulator::Now().GetSeconds(), rtt->RetransmitTimeout().GetMilliSeconds()));
+  stats->Record(routeId, MpTcpStats::CWND, newval);
+  stats->Record(routeId, MpTcpStats::SSTHRESH, ssthresh);
 }
 
 void
 MpTcpSubFlow::AddDSNMapping(uint8_t sFlowIdx, uint64_t dSeqNum, uint16_t dLvlLen, uint32_t sflowSeqNum, uint32_t ack,
-    Ptr<Packet> pkt)
+    Ptr<Packet> pkt, bool reinjection)
 {
   NS_LOG_FUNCTION_NOARGS();
-  mapDSN.push_back(new DSNMapping(sFlowIdx, dSeqNum, dLvlLen, sflowSeqNum, ack, pkt));
+  DSNMapping* ptrDSN = new DSNMapping(sFlowIdx, dSeqNum, dLvlLen, sflowSeqNum, ack, pkt);
+  ptrDSN->reinjection = reinjection;
+  mapDSN.Insert(ptrDSN);
 }
 
 void
@@ -145,16 +157,6 @@ DSNMapping *
 MpTcpSubFlow::GetunAckPkt()
 {
   NS_LOG_FUNCTION(this);
-  DSNMapping * ptrDSN = 0;
-  for (list<DSNMapping *>::iterator it = mapDSN.begin(); it != mapDSN.end(); ++it)
-    {
-      DSNMapping * ptr = *it;
-      if (ptr->subflowSeqNumber == highestAck + 1)
-        {
-          ptrDSN = ptr;
-          break;
-        }
-    }
-  return ptrDSN;
+  return mapDSN.FindBySeq(highestAck + 1);
 }
 }
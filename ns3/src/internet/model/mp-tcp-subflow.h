@@ -38,6 +38,8 @@
 #include "ns3/tcp-socket.h"
 #include "ns3/ipv4-end-point.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/mp-tcp-typedefs.h"
+#include "ns3/mp-tcp-stats.h"
 
 using namespace std;
 
@@ -52,8 +54,9 @@ public:
   MpTcpSubFlow();
   ~MpTcpSubFlow();
 
-  void AddDSNMapping(uint8_t sFlowIdx, uint64_t dSeqNum, uint16_t dLvlLen, uint32_t sflowSeqNum, uint32_t ack, Ptr<Packet> pkt);
-  void StartTracing(string traced);
+  void AddDSNMapping(uint8_t sFlowIdx, uint64_t dSeqNum, uint16_t dLvlLen, uint32_t sflowSeqNum, uint32_t ack, Ptr<Packet> pkt,
+      bool reinjection = false);
+  void StartTracing(string traced, Ptr<MpTcpStats> stats);
   void CwndTracer(uint32_t oldval, uint32_t newval);
   void SetFinSequence(const SequenceNumber32& s);
   bool Finished();
@@ -86,8 +89,7 @@ public:
   bool m_limitedTx;           // perform limited transmit
   uint32_t m_dupAckCount;     // DupACK counter
   Ipv4EndPoint* m_endPoint;   // L4 stack object
-  list<DSNMapping *> mapDSN;  // List of all sent packets
-  multiset<double> measuredRTT;
+  DSNMappingTable mapDSN;     // All sent but unacked packets, indexed by subflow SeqNb
   Ptr<RttMeanDeviation> rtt;  // RTT calculator
   Time lastMeasuredRtt;       // Last measured RTT, used for plotting
   uint32_t TxSeqNumber;       // Subflow's next expected sequence number to send
@@ -98,29 +100,26 @@ public:
   bool AccumulativeAck;
   uint32_t m_limitedTxCount;
   uint32_t initialSequnceNumber; // Plotting
+  bool sackPermitted;         // SACK is negotiated on this subflow
+  uint32_t highSacked;        // Sender: end of the highest SACK block received
+  map<uint32_t, uint32_t> rcvSackBlocks; // Receiver: [start, end) ranges received above RxSeqNumber
+  uint32_t lastSackBlock;     // Receiver: start of the range that got the latest segment, reported first
+  Time lastPenalized;         // Last time cwnd was halved for holding back the connection-level window
+  bool wscalePermitted;       // Window scaling is negotiated on this subflow
+  uint8_t sndWScale;          // Shift of the windows the peer advertises on this subflow
+  uint8_t rcvWScale;          // Shift of the windows we advertise on this subflow, fixed by our SYN or SYN+ACK
+  Time synSentTime;           // When the last SYN or SYN+ACK was sent
+  Time handshakeRtt;          // RTT of the handshake, the only sample a pure receiver gets
+  bool retired;               // Adaptive path manager took the subflow out of scheduling, it stays open
+  Time retiredAt;             // When the subflow was retired
+  bool pmMeasured;            // Path manager: pmAckedMark and pmIfUp are set
+  uint32_t pmAckedMark;       // Path manager: highestAck at the start of the current interval
+  uint32_t pmAcked;           // Path manager: bytes acked in the last interval
+  uint32_t pmLosses;          // Path manager: fast retransmits and timeouts in the current interval
+  uint32_t pmUseless;         // Path manager: consecutive intervals the subflow carried almost nothing
+  bool pmIfUp;                // Path manager: local interface was up at the last evaluation
 
-  //plotting
-  vector<pair<double, uint32_t> > cwndTracer;
-  vector<pair<double, uint32_t> > sstTracer;
-  vector<pair<double, double> > rtoTracer;
-  vector<pair<double, double> > rttTracer;
-
-  vector<pair<double, double> > ssthreshtrack;
-  vector<pair<double, double> > CWNDtrack;
-  vector<pair<double, uint32_t> > DATA;
-  vector<pair<double, uint32_t> > ACK;
-  vector<pair<double, uint32_t> > DROP;
-  vector<pair<double, uint32_t> > RETRANSMIT;
-  vector<pair<double, uint32_t> > DUPACK;
-  vector<pair<double, double> > _ss;
-  vector<pair<double, double> > _ca;
-  vector<pair<double, double> > _FR_FA;
-  vector<pair<double, double> > _FR_PA;
-  vector<pair<double, double> > _FReTx;
-  vector<pair<double, double> > _TimeOut;
-  vector<pair<double, double> > _RTT;
-  vector<pair<double, double> > _AvgRTT;
-  vector<pair<double, double> > _RTO;
+  Ptr<MpTcpStats> stats;      // Connection statistics, only set while tracing
 };
 
 }
@@ -1,5 +1,8 @@
 #include <iostream>
+#include <algorithm>
+#include <functional>
 #include "ns3/mp-tcp-typedefs.h"
+#include "ns3/mp-tcp-pool.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 
@@ -16,6 +19,10 @@ DSNMapping::DSNMapping()
   dataLevelLength = 0;
   subflowSeqNumber = 0;
   dupAckCount = 0;
+  sacked = false;
+  retransmitted = false;
+  reinjected = false;
+  reinjection = false;
   payload = 0;
 }
 
@@ -27,10 +34,12 @@ DSNMapping::DSNMapping(uint8_t sFlowIdx, uint64_t dSeqNum, uint16_t dLvlLen, uin
   subflowSeqNumber = sflowSeqNum;
   acknowledgement = ack;
   dupAckCount = 0;
-  payload = new uint8_t[dLvlLen];
-  pkt->CopyData(payload, dLvlLen);
-
-
+  sacked = false;
+  retransmitted = false;
+  reinjected = false;
+  reinjection = false;
+  // Keep a fragment of the segment; it shares the packet buffer (copy-on-write)
+  payload = pkt->CreateFragment(0, dLvlLen);
 }
 /*
  DSNMapping::DSNMapping (const DSNMapping &res)
@@ -51,11 +60,7 @@ DSNMapping::~DSNMapping()
   dataLevelLength = 0;
   subflowSeqNumber = 0;
   dupAckCount = 0;
-//  if (packet != 0)
-  // delete[] packet;
-  //packet = 0;
-  //if (payload != 0) // maybe it causes double free
-    delete[] payload;
+  payload = 0;
 }
 
 bool
@@ -64,208 +69,365 @@ DSNMapping::operator <(const DSNMapping& rhs) const
   return this->dataSeqNumber < rhs.dataSeqNumber;
 }
 
-DataBuffer::DataBuffer()
+void*
+DSNMapping::operator new(size_t size)
 {
-  bufMaxSize = 0;
+  return MpTcpPool::Allocate(size);
 }
 
-DataBuffer::DataBuffer(uint32_t size)
+void
+DSNMapping::operator delete(void* ptr, size_t size)
 {
-  bufMaxSize = size;
+  MpTcpPool::Release(ptr, size);
 }
 
-DataBuffer::~DataBuffer()
+static bool
+DSNMappingSeqLess(const DSNMapping* lhs, uint32_t seq)
 {
-  bufMaxSize = 0;
+  return lhs->subflowSeqNumber < seq;
 }
-uint32_t
-DataBuffer::Add(uint32_t size)
+
+static bool
+DSNMappingEndLess(const DSNMapping* lhs, uint32_t end)
+{
+  return lhs->subflowSeqNumber + lhs->dataLevelLength < end;
+}
+
+static bool
+DSNMappingDataSeqLess(const DSNMapping* lhs, uint64_t dsn)
 {
-  // read data from buf and insert it into the DataBuffer instance
-  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-  uint32_t toWrite = std::min(size, (bufMaxSize - (uint32_t) buffer.size()));
-  if (buffer.empty() == true)
+  return lhs->dataSeqNumber < dsn;
+}
+
+DSNMappingTable::DSNMappingTable()
+{
+}
+
+DSNMappingTable::~DSNMappingTable()
+{
+  Clear();
+}
+
+void
+DSNMappingTable::Insert(DSNMapping* ptrDSN)
+{
+  NS_LOG_FUNCTION (this << ptrDSN->subflowSeqNumber);
+  if (!ptrDSN->reinjection)
     {
-      NS_LOG_INFO("DataBuffer::Add -> buffer is empty !");
+      if (m_originals.empty() || m_originals.back()->dataSeqNumber < ptrDSN->dataSeqNumber)
+        m_originals.push_back(ptrDSN);
+      else
+        m_originals.insert(std::lower_bound(m_originals.begin(), m_originals.end(), ptrDSN->dataSeqNumber,
+            DSNMappingDataSeqLess), ptrDSN);
     }
-  else
-    {
-      NS_LOG_INFO("DataBuffer::Add -> buffer was not empty !");
+  if (m_mappings.empty() || m_mappings.back()->subflowSeqNumber < ptrDSN->subflowSeqNumber)
+    { // Common case, segments are sent in sequence
+      m_mappings.push_back(ptrDSN);
+      return;
     }
+  iterator it = std::lower_bound(m_mappings.begin(), m_mappings.end(), ptrDSN->subflowSeqNumber, DSNMappingSeqLess);
+  m_mappings.insert(it, ptrDSN);
+}
 
-  uint32_t qty = 0;
+DSNMapping*
+DSNMappingTable::FindBySeq(uint32_t seq)
+{
+  iterator it = std::lower_bound(m_mappings.begin(), m_mappings.end(), seq, DSNMappingSeqLess);
+  if (it != m_mappings.end() && (*it)->subflowSeqNumber == seq)
+    {
+      return *it;
+    }
+  return 0;
+}
 
-  while (qty < toWrite)
+DSNMapping*
+DSNMappingTable::FindByEnd(uint32_t end)
+{
+  iterator it = std::lower_bound(m_mappings.begin(), m_mappings.end(), end, DSNMappingEndLess);
+  if (it != m_mappings.end() && (*it)->subflowSeqNumber + (*it)->dataLevelLength == end)
     {
-      //buffer.push(buf[qty]);
-      buffer.push((uint8_t)qty);
-      qty++;
-    }NS_LOG_INFO("DataBuffer::Add -> amount of data = "<< qty);NS_LOG_INFO("DataBuffer::Add -> freeSpace Size = "<< (bufMaxSize - (uint32_t) buffer.size()) );
+      return *it;
+    }
+  return 0;
+}
 
-  return qty;
+DSNMapping*
+DSNMappingTable::FindByDataSeq(uint64_t dsn)
+{
+  iterator it = std::lower_bound(m_originals.begin(), m_originals.end(), dsn, DSNMappingDataSeqLess);
+  if (it != m_originals.end() && (*it)->dataSeqNumber == dsn)
+    {
+      return *it;
+    }
+  return 0;
 }
 
 uint32_t
-DataBuffer::AddRealData(uint8_t* data, uint32_t size)
+DSNMappingTable::DiscardUpTo(uint32_t ack)
 {
-  // read data from buf and insert it into the DataBuffer instance
-  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-  // uint32_t toWrite = std::min(size, (bufMaxSize - (uint32_t) buffer.size()));
-  if (buffer.empty() == true)
+  NS_LOG_FUNCTION (this << ack);
+  uint32_t count = 0;
+  while (!m_mappings.empty() && m_mappings.front()->subflowSeqNumber + m_mappings.front()->dataLevelLength <= ack)
     {
-      NS_LOG_INFO("DataBuffer::Add -> buffer is empty !");
+      if (!m_mappings.front()->reinjection)
+        {
+          iterator it = std::lower_bound(m_originals.begin(), m_originals.end(), m_mappings.front()->dataSeqNumber,
+              DSNMappingDataSeqLess);
+          if (it != m_originals.end() && *it == m_mappings.front())
+            m_originals.erase(it);
+        }
+      delete m_mappings.front();
+      m_mappings.pop_front();
+      count++;
     }
-  else
+  return count;
+}
+
+void
+DSNMappingTable::MarkSacked(uint32_t left, uint32_t right)
+{
+  iterator it = std::lower_bound(m_mappings.begin(), m_mappings.end(), left, DSNMappingSeqLess);
+  while (it != m_mappings.end() && (*it)->subflowSeqNumber + (*it)->dataLevelLength <= right)
     {
-      NS_LOG_INFO("DataBuffer::Add -> buffer was not empty !");
+      (*it)->sacked = true;
+      ++it;
     }
+}
 
-  for (uint32_t i = 0; i < size; i++)
-  {
-    buffer.push(data[i]);
-  }
-
-  // NS_LOG_INFO("DataBuffer::Add -> amount of data = "<< qty);NS_LOG_INFO("DataBuffer::Add -> freeSpace Size = "<< (bufMaxSize - (uint32_t) buffer.size()) );
-  // std::cout << "\n\n buf: ";
-  // while (!buffer.empty())
-  // {
-  //   std::cout << buffer.front();
-  //   buffer.pop();
-  // }
-  // std::cout << std::endl;
-  return size;
+/*
+ * A segment is taken as lost once the peer has SACKed data sent after it,
+ * segments retransmitted in this recovery are left to the retransmission timer.
+ */
+DSNMapping*
+DSNMappingTable::NextLost(uint32_t highSacked)
+{
+  for (iterator it = m_mappings.begin(); it != m_mappings.end(); ++it)
+    {
+      DSNMapping* ptrDSN = *it;
+      if (ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength >= highSacked)
+        {
+          break;
+        }
+      if (!ptrDSN->sacked && !ptrDSN->retransmitted)
+        {
+          return ptrDSN;
+        }
+    }
+  return 0;
 }
 
+void
+DSNMappingTable::ClearSacked()
+{
+  for (iterator it = m_mappings.begin(); it != m_mappings.end(); ++it)
+    {
+      (*it)->sacked = false;
+      (*it)->retransmitted = false;
+    }
+}
+
+void
+DSNMappingTable::Clear()
+{
+  for (iterator it = m_mappings.begin(); it != m_mappings.end(); ++it)
+    {
+      delete *it;
+    }
+  m_mappings.clear();
+  m_originals.clear();
+}
 
-#ifdef OLD
 uint32_t
-DataBuffer::Add(uint8_t* buf, uint32_t size)
-{
-  // read data from buf and insert it into the DataBuffer instance
-  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-  uint32_t toWrite = std::min(size, (bufMaxSize - (uint32_t) buffer.size()));
-    if (buffer.empty() == true)
-      {
-        NS_LOG_INFO("DataBuffer::Add -> buffer is empty !");
-      }
-    else
-      {
-        NS_LOG_INFO("DataBuffer::Add -> buffer was not empty !");
-      }
-
-  uint32_t qty = 0;
-
-  while (qty < toWrite)
+DSNMappingTable::size() const
+{
+  return (uint32_t) m_mappings.size();
+}
+
+bool
+DSNMappingTable::empty() const
+{
+  return m_mappings.empty();
+}
+
+DSNMappingTable::iterator
+DSNMappingTable::begin()
+{
+  return m_mappings.begin();
+}
+
+DSNMappingTable::iterator
+DSNMappingTable::end()
+{
+  return m_mappings.end();
+}
+
+DataBuffer::DataBuffer()
+{
+  bufSize = 0;
+  bufMaxSize = 0;
+}
+
+DataBuffer::DataBuffer(uint32_t size)
+{
+  bufSize = 0;
+  bufMaxSize = size;
+}
+
+DataBuffer::~DataBuffer()
+{
+  buffer.clear();
+  bufSize = 0;
+  bufMaxSize = 0;
+}
+
+uint32_t
+DataBuffer::Add(uint32_t size)
+{
+  // Insert 'size' bytes of dummy data, the packet has a zero-filled virtual payload
+  NS_LOG_FUNCTION (this << (int) size << (int) FreeSpaceSize() );
+  uint32_t toWrite = std::min(size, FreeSpaceSize());
+  if (toWrite == 0)
     {
-      //buffer.push(buf[qty]);
-      buffer.push((uint8_t)qty);
-      qty++;
-    }NS_LOG_INFO("DataBuffer::Add -> amount of data = "<< qty);NS_LOG_INFO("DataBuffer::Add -> freeSpace Size = "<< (bufMaxSize - (uint32_t) buffer.size()) );
-  return qty;
+      NS_LOG_INFO("DataBuffer::Add -> buffer is full !");
+      return 0;
+    }
+  buffer.push_back(Create<Packet>(toWrite));
+  bufSize += toWrite;
+  NS_LOG_INFO("DataBuffer::Add -> amount of data = "<< toWrite);NS_LOG_INFO("DataBuffer::Add -> freeSpace Size = "<< FreeSpaceSize() );
+  return toWrite;
 }
-#endif
 
+uint32_t
+DataBuffer::AddRealData(uint8_t* data, uint32_t size)
+{
+  // Real data is copied once into a packet buffer; it is not capped by bufMaxSize
+  NS_LOG_FUNCTION (this << (int) size << (int) FreeSpaceSize() );
+  if (size == 0)
+    {
+      return 0;
+    }
+  buffer.push_back(Create<Packet>(data, size));
+  bufSize += size;
+  NS_LOG_INFO("DataBuffer::AddRealData -> freeSpace Size = "<< FreeSpaceSize() );
+  return size;
+}
+
+uint32_t
+DataBuffer::AddPacket(Ptr<Packet> pkt)
+{
+  // Append a whole segment without copying its bytes; it is not capped by bufMaxSize
+  NS_LOG_FUNCTION (this << pkt->GetSize() << (int) FreeSpaceSize() );
+  uint32_t size = pkt->GetSize();
+  if (size == 0)
+    {
+      return 0;
+    }
+  buffer.push_back(pkt->Copy()); // Own packet object, as the head gets trimmed in place
+  bufSize += size;
+  return size;
+}
 
 uint32_t
 DataBuffer::Retrieve(uint32_t size)
 {
-  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-  uint32_t quantity = std::min(size, (uint32_t) buffer.size());
+  NS_LOG_FUNCTION (this << (int) size << (int) FreeSpaceSize() );
+  uint32_t quantity = std::min(size, bufSize);
   if (quantity == 0)
     {
       NS_LOG_INFO("DataBuffer::Retrieve -> No data to read from buffer reception !");
       return 0;
     }
 
-  for (uint32_t i = 0; i < quantity; i++)
+  uint32_t left = quantity;
+  while (left > 0)
     {
-      //buf[i] = buffer.front();
-      buffer.pop();
+      Ptr<Packet> front = buffer.front();
+      uint32_t frontSize = front->GetSize();
+      if (frontSize <= left)
+        {
+          buffer.pop_front();
+          left -= frontSize;
+        }
+      else
+        {
+          front->RemoveAtStart(left);
+          left = 0;
+        }
     }
+  bufSize -= quantity;
 
-  NS_LOG_INFO("DataBuffer::Retrieve -> freeSpaceSize == "<< bufMaxSize - (uint32_t) buffer.size() );
+  NS_LOG_INFO("DataBuffer::Retrieve -> freeSpaceSize == "<< FreeSpaceSize() );
   return quantity;
 }
 
 uint8_t*
 DataBuffer::RetrieveRealData(uint32_t size)
 {
-  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-  uint32_t quantity = std::min(size, (uint32_t) buffer.size());
-  if (quantity == 0)
+  NS_LOG_FUNCTION (this << (int) size << (int) FreeSpaceSize() );
+  Ptr<Packet> pkt = RetrievePacket(size);
+  if (pkt == 0)
     {
       NS_LOG_WARN("DataBuffer::Retrieve -> No data to read from buffer reception !");
       return 0;
     }
 
-  uint8_t *payload = new uint8_t[quantity]; // should I delete this afterwards?
-  // uint8_t *payload[quantity];
-  // std::cout << "\nretrieving buffer of size:" << quantity << "|";
-  for (uint32_t i = 0; i < quantity; i++)
-    {
-      payload[i] = buffer.front();
-      // std::cout << buffer.front();
-      buffer.pop();
-    }
-
-
-  NS_LOG_INFO("DataBuffer::Retrieve -> freeSpaceSize == "<< bufMaxSize - (uint32_t) buffer.size() );
+  uint8_t *payload = new uint8_t[pkt->GetSize()]; // caller has to delete[] it
+  pkt->CopyData(payload, pkt->GetSize());
   return payload;
 }
 
-
-//uint32_t
-//DataBuffer::Retrieve(uint8_t* buf, uint32_t size)
-//{
-//  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-//  uint32_t quantity = std::min(size, (uint32_t) buffer.size());
-//  if (quantity == 0)
-//    {
-//      NS_LOG_INFO("DataBuffer::Retrieve -> No data to read from buffer reception !");
-//      return 0;
-//    }
-//
-//  for (uint32_t i = 0; i < quantity; i++)
-//    {
-//      buf[i] = buffer.front();
-//      buffer.pop();
-//    }
-//
-//  NS_LOG_INFO("DataBuffer::Retrieve -> freeSpaceSize == "<< bufMaxSize - (uint32_t) buffer.size() );
-//  return quantity;
-//}
-
 Ptr<Packet>
-DataBuffer::CreatePacket(uint32_t size)
+DataBuffer::RetrievePacket(uint32_t size)
 {
-  NS_LOG_FUNCTION (this << (int) size << (int) ( bufMaxSize - (uint32_t) buffer.size()) );
-  uint32_t quantity = std::min(size, (uint32_t) buffer.size());
+  NS_LOG_FUNCTION (this << (int) size << (int) FreeSpaceSize() );
+  uint32_t quantity = std::min(size, bufSize);
   if (quantity == 0)
     {
-      NS_LOG_INFO("DataBuffer::CreatePacket -> No data ready for sending !");
       return 0;
     }
-  // Copy from front of Buffer to a new uint8_t array pointer
-  uint8_t *ptrBuffer = new uint8_t[quantity];
-  // std::cout << "\n\nsending: |";
-  for (uint32_t i = 0; i < quantity; i++)
+
+  Ptr<Packet> outPkt = 0;
+  while (outPkt == 0 || outPkt->GetSize() < quantity)
     {
-      ptrBuffer[i] = buffer.front();
-      // std::cout << buffer.front();
-      buffer.pop();
+      Ptr<Packet> front = buffer.front();
+      uint32_t need = quantity - (outPkt == 0 ? 0 : outPkt->GetSize());
+      Ptr<Packet> part;
+      if (front->GetSize() <= need)
+        { // Whole segment is consumed, hand it over as is
+          part = front;
+          buffer.pop_front();
+        }
+      else
+        { // Slice the head of the segment off
+          part = front->CreateFragment(0, need);
+          front->RemoveAtStart(need);
+        }
+      if (outPkt == 0)
+        {
+          outPkt = part;
+        }
+      else
+        {
+          outPkt->AddAtEnd(part);
+        }
     }
-  // Create packet from a data pointer and its size
-  //Ptr<Packet> pkt = new Packet(ptrBuffer, quantity);
-  Ptr<Packet> pkt = Create<Packet>(ptrBuffer, quantity);
-  // Ptr<Packet> pkt = Create<Packet>(quantity);
-  delete[] ptrBuffer;
-  //ptrBuffer = 0; // MKS
-
-  // uint8_t *bf = new uint8_t[quantity]; // leaks memory and probably not needed
-  // pkt->CopyData(bf, quantity);
+  bufSize -= quantity;
 
+  NS_LOG_INFO("DataBuffer::RetrievePacket -> freeSpaceSize == "<< FreeSpaceSize() );
+  return outPkt;
+}
 
-  NS_LOG_INFO("DataBuffer::CreatePacket -> freeSpaceSize == "<< bufMaxSize - (uint32_t) buffer.size() );
+Ptr<Packet>
+DataBuffer::CreatePacket(uint32_t size)
+{
+  NS_LOG_FUNCTION (this << (int) size << (int) FreeSpaceSize() );
+  Ptr<Packet> pkt = RetrievePacket(size);
+  if (pkt == 0)
+    {
+      NS_LOG_INFO("DataBuffer::CreatePacket -> No data ready for sending !");
+      return 0;
+    }
+  NS_LOG_INFO("DataBuffer::CreatePacket -> freeSpaceSize == "<< FreeSpaceSize() );
   return pkt;
 }
 
@@ -275,59 +437,52 @@ Initially it is only called upon receiving an incoming packet by mptcp stack */
 uint32_t
 DataBuffer::ReadPacket(Ptr<Packet> pkt, uint32_t dataLen)
 {
-  NS_LOG_FUNCTION (this << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-
-  uint32_t toWrite = std::min(dataLen, (bufMaxSize - (uint32_t) buffer.size()));
-
-  uint8_t *ptrBuffer = new uint8_t[toWrite];
-  pkt->CopyData(ptrBuffer, toWrite);
+  NS_LOG_FUNCTION (this << (int) FreeSpaceSize() );
 
-  for (uint32_t j = 0; j < toWrite; j++)
-    // buffer.push(0); // this disregards the packet contents and only pushes spaces to the recv buffer >:(
-    buffer.push(ptrBuffer[j]);
-
-  delete[] ptrBuffer;
-  //ptrBuffer = 0; // MKS
+  uint32_t toWrite = std::min(dataLen, FreeSpaceSize());
+  if (toWrite == 0)
+    {
+      return 0;
+    }
+  buffer.push_back(pkt->CreateFragment(0, toWrite));
+  bufSize += toWrite;
 
   NS_LOG_INFO("DataBuffer::ReadPacket -> data   readed == "<< toWrite );
-  NS_LOG_INFO("DataBuffer::ReadPacket -> freeSpaceSize == "<< bufMaxSize - (uint32_t) buffer.size() );
+  NS_LOG_INFO("DataBuffer::ReadPacket -> freeSpaceSize == "<< FreeSpaceSize() );
   return toWrite;
 }
 
 uint32_t
 DataBuffer::PendingData()
 {
-  return ((uint32_t) buffer.size());
+  return bufSize;
 }
 
 bool
 DataBuffer::ClearBuffer()
 {
-  while (!buffer.empty())
-    {
-      buffer.pop();
-    }
-  NS_ASSERT(buffer.empty());
+  buffer.clear();
+  bufSize = 0;
   return true;
 }
 
 uint32_t
 DataBuffer::FreeSpaceSize()
 {
-  return (bufMaxSize - (uint32_t) buffer.size());
+  // Real data may be added beyond bufMaxSize (AddRealData), so never wrap around
+  return (bufSize >= bufMaxSize) ? 0 : (bufMaxSize - bufSize);
 }
 
 bool
 DataBuffer::Empty()
 {
-  // std::cout << "\n\n empty: |" << buffer.size() << "|\n";
-  return buffer.empty(); // ( freeSpaceSize == bufMaxSize );
+  return (bufSize == 0);
 }
 
 bool
 DataBuffer::Full()
 {
-  return (bufMaxSize == (uint32_t) buffer.size()); //( freeSpaceSize == 0 );
+  return (bufSize >= bufMaxSize);
 }
 
 void
@@ -347,4 +502,35 @@ MpTcpAddressInfo::~MpTcpAddressInfo()
   ipv4Addr = Ipv4Address::GetZero();
 }
 
+void*
+MpTcpAddressInfo::operator new(size_t size)
+{
+  return MpTcpPool::Allocate(size);
+}
+
+void
+MpTcpAddressInfo::operator delete(void* ptr, size_t size)
+{
+  MpTcpPool::Release(ptr, size);
+}
+
+MpTcpTuple::MpTcpTuple(Ipv4Address s, uint16_t sp, Ipv4Address d, uint16_t dp) :
+    sAddr(s), sPort(sp), dAddr(d), dPort(dp)
+{
+}
+
+bool
+MpTcpTuple::operator ==(const MpTcpTuple& rhs) const
+{
+  return sAddr == rhs.sAddr && dAddr == rhs.dAddr && sPort == rhs.sPort && dPort == rhs.dPort;
+}
+
+size_t
+MpTcpTupleHash::operator()(const MpTcpTuple& t) const
+{
+  uint64_t addrs = ((uint64_t) t.sAddr.Get() << 32) | t.dAddr.Get();
+  uint64_t ports = ((uint64_t) t.sPort << 16) | t.dPort;
+  return std::hash<uint64_t>()(addrs ^ (ports * 0x9e3779b97f4a7c15ULL)); // Spread the ports over the address bits
+}
+
 } // namespace ns3
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <vector>
 #include <queue>
+#include <deque>
 #include <list>
 #include <set>
 #include <map>
@@ -42,19 +43,25 @@ typedef enum
   UNCOUPLED,              // 5
   COUPLED_EPSILON,        // 6
   COUPLED_INC,            // 7
-  COUPLED_FULLY           // 8
+  COUPLED_FULLY,          // 8
+  OLIA,                   // 9
+  BALIA                   // 10
 } CongestionCtrl_t;
 
 typedef enum
 {
-  Round_Robin
+  Round_Robin,    // 0
+  Min_RTT,        // 1
+  BLEST,          // 2
+  ECF             // 3
 } DataDistribAlgo_t;
 
 typedef enum
 {
   Default,
   FullMesh,
-  NdiffPorts
+  NdiffPorts,
+  Adaptive        // FullMesh, then subflows are taken out of and back into scheduling at runtime
 } PathManager_t;
 
 
@@ -66,14 +73,52 @@ public:
   //DSNMapping (const DSNMapping &res);
   virtual ~DSNMapping();
   bool operator <(const DSNMapping& rhs) const;
+  static void* operator new(size_t size);   // Served from MpTcpPool
+  static void operator delete(void* ptr, size_t size);
   uint64_t dataSeqNumber;
   uint16_t dataLevelLength;
   uint32_t subflowSeqNumber;
   uint32_t acknowledgement;
   uint32_t dupAckCount;
   uint8_t subflowIndex;
+  bool sacked;          // Peer reported this segment in a SACK block
+  bool retransmitted;   // Already retransmitted during the current loss recovery
+  bool reinjected;      // A copy was sent on another subflow to unblock the receive window
+  bool reinjection;     // This is such a copy, the original is held by another subflow
   //uint8_t *packet;
-  uint8_t *payload;
+  Ptr<Packet> payload;  // Fragment sharing the segment's buffer, no byte copy
+};
+
+/**
+ * Sent-but-unacked mappings of a subflow, ordered by subflow sequence number.
+ * Mappings are appended in transmission order and cover contiguous ranges, so
+ * both a segment's start and its end can be found by binary search and acked
+ * segments are always a prefix that is dropped from the front. Segments taken
+ * from the sending buffer also carry increasing data sequence numbers, they are
+ * indexed by it apart from the reinjected copies, which go back in data sequence.
+ */
+class DSNMappingTable
+{
+public:
+  typedef deque<DSNMapping*>::iterator iterator;
+  DSNMappingTable();
+  ~DSNMappingTable();
+  void Insert(DSNMapping* ptrDSN);
+  DSNMapping* FindBySeq(uint32_t seq);      // Segment starting at 'seq'
+  DSNMapping* FindByEnd(uint32_t end);      // Segment whose last byte is 'end - 1'
+  DSNMapping* FindByDataSeq(uint64_t dsn);  // Original (not reinjected) segment carrying 'dsn'
+  uint32_t DiscardUpTo(uint32_t ack);       // Delete all segments fully covered by 'ack'
+  void MarkSacked(uint32_t left, uint32_t right); // Mark segments lying within SACK block [left, right)
+  DSNMapping* NextLost(uint32_t highSacked); // First segment below 'highSacked' neither SACKed nor retransmitted
+  void ClearSacked();                       // Forget SACK and retransmission marks
+  void Clear();
+  uint32_t size() const;
+  bool empty() const;
+  iterator begin();
+  iterator end();
+private:
+  deque<DSNMapping*> m_mappings;
+  deque<DSNMapping*> m_originals; // Mappings that are not reinjections, by data sequence number
 };
 
 class MpTcpAddressInfo
@@ -81,25 +126,55 @@ class MpTcpAddressInfo
 public:
   MpTcpAddressInfo();
   ~MpTcpAddressInfo();
+  static void* operator new(size_t size);   // Served from MpTcpPool
+  static void operator delete(void* ptr, size_t size);
   uint8_t addrID;
   Ipv4Address ipv4Addr;
   Ipv4Mask mask;
 };
 
+/**
+ * Subflow 4-tuple, as seen from the local end, used to demultiplex incoming segments.
+ */
+class MpTcpTuple
+{
+public:
+  MpTcpTuple(Ipv4Address sAddr, uint16_t sPort, Ipv4Address dAddr, uint16_t dPort);
+  bool operator ==(const MpTcpTuple& rhs) const;
+  Ipv4Address sAddr;
+  uint16_t sPort;
+  Ipv4Address dAddr;
+  uint16_t dPort;
+};
+
+class MpTcpTupleHash
+{
+public:
+  size_t operator()(const MpTcpTuple& t) const;
+};
+
+/**
+ * Connection-level data buffer. Data is kept as a queue of packet fragments
+ * (like TcpTxBuffer/TcpRxBuffer) so that enqueueing or dequeueing a segment
+ * never touches its bytes one by one; packets are built by fragment slicing.
+ */
 class DataBuffer
 {
 public:
   DataBuffer();
   DataBuffer(uint32_t size);
   ~DataBuffer();
-  queue<uint8_t> buffer;
+  deque<Ptr<Packet> > buffer; // Stored segments, front is the oldest data
+  uint32_t bufSize;           // Total number of bytes held in 'buffer'
   uint32_t bufMaxSize;
   //uint32_t Add(uint8_t* buf, uint32_t size);
   uint32_t Add(uint32_t size);
   uint32_t AddRealData(uint8_t* data, uint32_t size);
+  uint32_t AddPacket(Ptr<Packet> pkt);
   //uint32_t Retrieve(uint8_t* buf, uint32_t size);
   uint32_t Retrieve(uint32_t size);
   uint8_t* RetrieveRealData(uint32_t size);
+  Ptr<Packet> RetrievePacket(uint32_t size);
   Ptr<Packet> CreatePacket(uint32_t size);
   uint32_t ReadPacket(Ptr<Packet> pkt, uint32_t dataLen);
   bool Empty();
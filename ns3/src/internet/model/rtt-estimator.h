@@ -227,6 +227,12 @@ public:
    */
   void Gain (double g);
 
+  /**
+   * \brief Get the current mean deviation of the RTT samples.
+   * \return The current RTT variation.
+   */
+  Time GetVariation (void) const;
+
 private:
   double       m_gain;       //!< Filter gain
   Time         m_variance;   //!< Current variance
@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 #include <iostream>
+#include <algorithm>
 #include "tcp-header.h"
 #include "ns3/buffer.h"
 #include "ns3/address-utils.h"
@@ -35,7 +36,7 @@ NS_OBJECT_ENSURE_REGISTERED(TcpHeader);
 
 TcpHeader::TcpHeader() :
     m_sourcePort(0), m_destinationPort(0), m_sequenceNumber(0), m_ackNumber(0), m_length(5), m_flags(0), m_windowSize(0xffff), m_urgentPointer(
-        0), m_calcChecksum(false), m_goodChecksum(true), m_option(0), oLen(0), pLen(0), original(true)
+        0), m_calcChecksum(false), m_goodChecksum(true), oLen(0), pLen(0)
 {
 }
 
@@ -305,27 +306,20 @@ TcpHeader::Print(std::ostream &os) const
     }
   os << " Seq=" << GetSequenceNumber() << " Ack=" << GetAckNumber() << " Win=" << GetWindowSize();
 
-  for (uint32_t j = 0; j < m_option.size(); j++)
+  for (TcpOptionList::const_iterator opt = m_option.Begin(); opt != m_option.End(); ++opt)
     {
       os << " {";
-      TcpOptions *opt = m_option[j];
-      OptMultipathCapable *optMPC;
-      //OptJoinConnection *optJOIN;
-      //OptAddAddress *optADDR;
-      //OptDataSeqMapping *optDSN;
       //os << opt->optName;
       if (opt->optName == OPT_MPC)
         {
           os << "OPT_MPC(";
-          optMPC = (OptMultipathCapable *) opt;
-          os << optMPC->senderToken << ")";
+          os << opt->mpc.senderToken << ")";
         }
       else if (opt->optName == OPT_JOIN)
         {
           os << "OPT_JOIN";
-//          optJOIN = (OptJoinConnection *) opt;
-//          os << optJOIN->receiverToken;
-//          os << optJOIN->addrID;
+//          os << opt->join.receiverToken;
+//          os << opt->join.addrID;
         }
       else if (opt->optName == OPT_ADDR)
         {
@@ -334,10 +328,28 @@ TcpHeader::Print(std::ostream &os) const
       else if (opt->optName == OPT_DSN)
         {
           os << "OPT_DSN";
-          //optDSN = (OptDataSeqMapping *) opt;
-          //os << optDSN->dataSeqNumber;
-          //os << optDSN->dataLevelLength;
-          //os << optDSN->subflowSeqNumber;
+          //os << opt->dsn.dataSeqNumber;
+          //os << opt->dsn.dataLevelLength;
+          //os << opt->dsn.subflowSeqNumber;
+        }
+      else if (opt->optName == OPT_DATA_ACK)
+        {
+          os << "OPT_DATA_ACK(" << opt->dataAck.dataAck << ")";
+        }
+      else if (opt->optName == OPT_WSCALE)
+        {
+          os << "OPT_WSCALE(" << (int) opt->wscale.shift << ")";
+        }
+      else if (opt->optName == OPT_SACK_PERMITTED)
+        {
+          os << "OPT_SACK_PERMITTED";
+        }
+      else if (opt->optName == OPT_SACK)
+        {
+          os << "OPT_SACK(";
+          for (uint8_t b = 0; b < opt->sack.count; b++)
+            os << (b > 0 ? " " : "") << opt->sack.left[b] << "-" << opt->sack.right[b];
+          os << ")";
         }
       os << "}";
     }
@@ -397,41 +409,57 @@ TcpHeader::Serialize(Buffer::Iterator start) const
     }
 
   // write options in head
-  for (uint32_t j = 0; j < m_option.size(); j++)
+  for (TcpOptionList::const_iterator opt = m_option.Begin(); opt != m_option.End(); ++opt)
     {
-      TcpOptions *opt = m_option[j];
-      OptMultipathCapable *optMPC;
-      OptJoinConnection *optJOIN;
-      OptAddAddress *optADDR;
-      OptDataSeqMapping *optDSN;
       i.WriteU8(TcpOptionToUint(opt->optName));
 
       if (opt->optName == OPT_MPC)
         {
-          optMPC = (OptMultipathCapable *) opt;
-          i.WriteHtonU32(optMPC->senderToken);
+          i.WriteHtonU32(opt->mpc.senderToken);
         }
       else if (opt->optName == OPT_JOIN)
         {
-          optJOIN = (OptJoinConnection *) opt;
-          i.WriteHtonU32(optJOIN->receiverToken);
-          i.WriteU8(optJOIN->addrID);
+          i.WriteHtonU32(opt->join.receiverToken);
+          i.WriteU8(opt->join.addrID);
         }
       else if (opt->optName == OPT_ADDR)
         {
-          optADDR = (OptAddAddress *) opt;
-          i.WriteU8(optADDR->addrID);
-          i.WriteHtonU32(optADDR->addr.Get());
+          i.WriteU8(opt->addAddr.addrID);
+          i.WriteHtonU32(opt->addAddr.addr);
         }
       else if (opt->optName == OPT_DSN)
         {
-          optDSN = (OptDataSeqMapping *) opt;
-          i.WriteU64(optDSN->dataSeqNumber);
-          i.WriteHtonU16(optDSN->dataLevelLength);
-          i.WriteHtonU32(optDSN->subflowSeqNumber);
+          i.WriteU64(opt->dsn.dataSeqNumber);
+          i.WriteHtonU16(opt->dsn.dataLevelLength);
+          i.WriteHtonU32(opt->dsn.subflowSeqNumber);
+        }
+      else if (opt->optName == OPT_DATA_ACK)
+        {
+          i.WriteU64(opt->dataAck.dataAck);
+        }
+      else if (opt->optName == OPT_WSCALE)
+        { // RFC 7323 form, with its length
+          i.WriteU8(3);
+          i.WriteU8(opt->wscale.shift);
+        }
+      else if (opt->optName == OPT_SACK_PERMITTED)
+        {
+          i.WriteU8(2);
+        }
+      else if (opt->optName == OPT_SACK)
+        { // Unlike the MPTCP options above, SACK options carry their length as in RFC 2018
+          i.WriteU8(2 + 8 * opt->sack.count);
+          for (uint8_t b = 0; b < opt->sack.count; b++)
+            {
+              i.WriteHtonU32(opt->sack.left[b]);
+              i.WriteHtonU32(opt->sack.right[b]);
+            }
         }
     }
-  for (int j = 0; j < (int) pLen; j++)
+  // Pad up to the header length rather than by pLen: senders reserve more option space than
+  // their options take (e.g. 20 bytes for the 15 byte DSN option), and bytes left unwritten
+  // would be parsed as options by the receiver.
+  while (i.GetDistanceFrom(start) < GetSerializedSize())
     i.WriteU8(255);
   NS_LOG_INFO("TcpHeader::Serialize options length  olen = " << (int) oLen);
   NS_LOG_INFO("TcpHeader::Serialize padding length  plen = " << (int) pLen);
@@ -495,34 +523,81 @@ TcpHeader::Deserialize(Buffer::Iterator start)
     }
 
   // handle options field
+  m_option.Clear();
   while (!i.IsEnd() && hlen > 0)
     {
-      TcpOptions *opt;
-      TcpOption_t kind = (TcpOption_t) i.ReadU8(); //TcpOption_t kind = UintToTcpOption(i.ReadU8());
-      if (kind == OPT_MPC)
+      TcpOptions opt;
+      opt.optName = (TcpOption_t) i.ReadU8(); //TcpOption_t kind = UintToTcpOption(i.ReadU8());
+      if (opt.optName == OPT_MPC)
         {
-          opt = new OptMultipathCapable(kind, i.ReadNtohU32());
+          opt.mpc.senderToken = i.ReadNtohU32();
           plen = (plen + 5) % 4;
           hlen -= 5;
         }
-      else if (kind == OPT_JOIN)
+      else if (opt.optName == OPT_JOIN)
         {
-          opt = new OptJoinConnection(kind, i.ReadNtohU32(), i.ReadU8());
+          opt.join.receiverToken = i.ReadNtohU32();
+          opt.join.addrID = i.ReadU8();
           plen = (plen + 6) % 4;
           hlen -= 6;
         }
-      else if (kind == OPT_ADDR)
+      else if (opt.optName == OPT_ADDR)
         {
-          opt = new OptAddAddress(kind, i.ReadU8(), Ipv4Address(i.ReadNtohU32()));
+          opt.addAddr.addrID = i.ReadU8();
+          opt.addAddr.addr = i.ReadNtohU32();
           plen = (plen + 6) % 4;
           hlen -= 6;
         }
-      else if (kind == OPT_DSN)
+      else if (opt.optName == OPT_DSN)
         {
-          opt = new OptDataSeqMapping(kind, i.ReadU64(), i.ReadNtohU16(), i.ReadNtohU32());
+          opt.dsn.dataSeqNumber = i.ReadU64();
+          opt.dsn.dataLevelLength = i.ReadNtohU16();
+          opt.dsn.subflowSeqNumber = i.ReadNtohU32();
           plen = (plen + 15) % 4;
           hlen -= 15;
         }
+      else if (opt.optName == OPT_DATA_ACK)
+        {
+          opt.dataAck.dataAck = i.ReadU64();
+          plen = (plen + 9) % 4;
+          hlen -= 9;
+        }
+      else if (opt.optName == OPT_WSCALE)
+        {
+          i.ReadU8();
+          opt.wscale.shift = std::min<uint8_t>(i.ReadU8(), 14);
+          plen = (plen + 3) % 4;
+          hlen -= 3;
+        }
+      else if (opt.optName == OPT_SACK_PERMITTED)
+        {
+          i.ReadU8();
+          plen = (plen + 2) % 4;
+          hlen -= 2;
+        }
+      else if (opt.optName == OPT_SACK)
+        {
+          uint8_t length = i.ReadU8();
+          if (length < 2 || length > hlen)
+            { // malformed, the rest of the option space can not be parsed
+              hlen = 0;
+              break;
+            }
+          opt.sack.count = std::min<uint8_t>((length - 2) / 8, OptSack::MAX_BLOCKS);
+          for (uint8_t b = 0; b < opt.sack.count; b++)
+            {
+              opt.sack.left[b] = i.ReadNtohU32();
+              opt.sack.right[b] = i.ReadNtohU32();
+            }
+          // skip blocks beyond MAX_BLOCKS and a trailing partial block
+          i.Next(length - 2 - 8 * opt.sack.count);
+          plen = (plen + length) % 4;
+          hlen -= length;
+          if (opt.sack.count == 0)
+            {
+              continue;
+            }
+        }
       else
         {
           // the rest are pending octets, so leave
@@ -530,8 +605,11 @@ TcpHeader::Deserialize(Buffer::Iterator start)
           break;
         }
 
-      m_option.insert(m_option.end(), opt);
-
+      if (!m_option.Add(opt))
+        {
+          NS_LOG_WARN("More than " << (int) TcpOptionList::MAX_OPTIONS << " options, the rest are ignored");
+          break;
+        }
     }
   //i.Next(plen);
   NS_LOG_INFO("TcpHeader::Deserialize leaving this method plen" << plen);
@@ -546,14 +624,14 @@ TcpHeader::SetOptionsLength(uint8_t length)
   oLen = length;
 }
 
-vector<TcpOptions*>
+const TcpOptionList&
 TcpHeader::GetOptions(void) const
 {
   return m_option;
 }
 
 void
-TcpHeader::SetOptions(vector<TcpOptions*> opt)
+TcpHeader::SetOptions(const TcpOptionList& opt)
 {
   m_option = opt;
 }
@@ -562,12 +640,9 @@ uint8_t
 TcpHeader::GetOptionsLength() const
 {
   uint8_t length = 0;
-  TcpOptions *opt;
 
-  for (uint32_t j = 0; j < m_option.size(); j++)
+  for (TcpOptionList::const_iterator opt = m_option.Begin(); opt != m_option.End(); ++opt)
     {
-      opt = m_option[j];
-
       if (opt->optName == OPT_MPC)
         {
           length += 5;
@@ -584,6 +659,22 @@ TcpHeader::GetOptionsLength() const
         {
           length += 15;
         }
+      else if (opt->optName == OPT_DATA_ACK)
+        {
+          length += 9;
+        }
+      else if (opt->optName == OPT_WSCALE)
+        {
+          length += 3;
+        }
+      else if (opt->optName == OPT_SACK_PERMITTED)
+        {
+          length += 2;
+        }
+      else if (opt->optName == OPT_SACK)
+        {
+          length += 2 + 8 * opt->sack.count;
+        }
     }
   //return oLen;
   return length;
@@ -615,6 +706,14 @@ TcpHeader::TcpOptionToUint(TcpOption_t opt) const
     i = 32;
   else if (opt == OPT_DSN)
     i = 34;
+  else if (opt == OPT_DATA_ACK)
+    i = 35;
+  else if (opt == OPT_WSCALE)
+    i = 3;
+  else if (opt == OPT_SACK_PERMITTED)
+    i = 4;
+  else if (opt == OPT_SACK)
+    i = 5;
   else if (opt == OPT_NONE)
     i = 0;
   return i;
@@ -632,28 +731,20 @@ TcpHeader::UintToTcpOption(uint8_t kind) const
     i = OPT_ADDR;
   else if (kind == 34)
     i = OPT_DSN;
+  else if (kind == 35)
+    i = OPT_DATA_ACK;
+  else if (kind == 3)
+    i = OPT_WSCALE;
+  else if (kind == 4)
+    i = OPT_SACK_PERMITTED;
+  else if (kind == 5)
+    i = OPT_SACK;
   else if (kind == 0)
     i = OPT_NONE;
   return i;
 }
 
 
-TcpHeader::TcpHeader(const TcpHeader &res)
-{
-  //NS_LOG_FUNCTION_NOARGS();
-  SetSourcePort(res.GetSourcePort());
-  SetDestinationPort(res.GetDestinationPort());
-  SetFlags(res.GetFlags());
-  SetSequenceNumber(res.GetSequenceNumber());
-  SetAckNumber(res.GetAckNumber());
-  SetWindowSize(res.GetWindowSize());
-  //SetOptions         ( res.GetOptions () );
-  SetLength(res.GetLength());
-  SetOptionsLength(res.GetOptionsLength());
-  SetPaddingLength(res.GetPaddingLength());
-  SetOptions(res.GetOptions());
-  original = false;
-}
 /*
  TcpHeader
  TcpHeader::Copy()
@@ -675,32 +766,6 @@ TcpHeader::TcpHeader(const TcpHeader &res)
  */
 TcpHeader::~TcpHeader()
 {
-  if (original == false)
-    return;
-  //NS_LOG_FUNCTION_NOARGS();
-  for (uint32_t i = 0; i < m_option.size(); i++)
-    {
-      if (m_option[i] != 0)
-        switch (m_option[i]->optName)
-          {
-        case OPT_MPC:
-          delete (OptMultipathCapable*) m_option[i];
-          break;
-        case OPT_JOIN:
-          delete (OptJoinConnection*) m_option[i];
-          break;
-        case OPT_ADDR:
-          delete (OptAddAddress*) m_option[i];
-          break;
-        case OPT_DSN:
-          delete (OptDataSeqMapping*) m_option[i];
-          break;
-        default:
-          break;
-          }
-    }
-  m_option.clear();
-  oLen = 0;
 }
 
 bool
@@ -709,11 +774,10 @@ TcpHeader::AddOptMPC(TcpOption_t optName, uint32_t TxToken)
 //  NS_LOG_FUNCTION(this);
   if (optName == OPT_MPC)
     {
-      OptMultipathCapable* opt = new OptMultipathCapable(optName, TxToken);
-
-      m_option.insert(m_option.end(), opt);
-
-      return true;
+      TcpOptions opt;
+      opt.optName = optName;
+      opt.mpc.senderToken = TxToken;
+      return m_option.Add(opt);
     }
   return false;
 }
@@ -724,10 +788,11 @@ TcpHeader::AddOptJOIN(TcpOption_t optName, uint32_t RxToken, uint8_t addrID)
 //  NS_LOG_FUNCTION(this);
   if (optName == OPT_JOIN)
     {
-      OptJoinConnection* opt = new OptJoinConnection(optName, RxToken, addrID);
-
-      m_option.insert(m_option.end(), opt);
-      return true;
+      TcpOptions opt;
+      opt.optName = optName;
+      opt.join.receiverToken = RxToken;
+      opt.join.addrID = addrID;
+      return m_option.Add(opt);
     }
   return false;
 }
@@ -738,10 +803,11 @@ TcpHeader::AddOptADDR(TcpOption_t optName, uint8_t addrID, Ipv4Address addr)
 //  NS_LOG_FUNCTION(this);
   if (optName == OPT_ADDR)
     {
-      OptAddAddress* opt = new OptAddAddress(optName, addrID, addr);
-
-      m_option.insert(m_option.end(), opt);
-      return true;
+      TcpOptions opt;
+      opt.optName = optName;
+      opt.addAddr.addrID = addrID;
+      opt.addAddr.addr = addr.Get();
+      return m_option.Add(opt);
     }
   return false;
 }
@@ -752,9 +818,63 @@ TcpHeader::AddOptDSN(TcpOption_t optName, uint64_t dSeqNum, uint16_t dLevelLengt
 //  NS_LOG_FUNCTION(this);
   if (optName == OPT_DSN)
     {
-      OptDataSeqMapping* opt = new OptDataSeqMapping(optName, dSeqNum, dLevelLength, sfSeqNum);
-      m_option.insert(m_option.end(), opt);
-      return true;
+      TcpOptions opt;
+      opt.optName = optName;
+      opt.dsn.dataSeqNumber = dSeqNum;
+      opt.dsn.dataLevelLength = dLevelLength;
+      opt.dsn.subflowSeqNumber = sfSeqNum;
+      return m_option.Add(opt);
+    }
+  return false;
+}
+
+bool
+TcpHeader::AddOptDataACK(TcpOption_t optName, uint64_t dataAck)
+{
+  if (optName == OPT_DATA_ACK)
+    {
+      TcpOptions opt;
+      opt.optName = optName;
+      opt.dataAck.dataAck = dataAck;
+      return m_option.Add(opt);
+    }
+  return false;
+}
+
+bool
+TcpHeader::AddOptWScale(TcpOption_t optName, uint8_t shift)
+{
+  if (optName == OPT_WSCALE)
+    {
+      TcpOptions opt;
+      opt.optName = optName;
+      opt.wscale.shift = shift;
+      return m_option.Add(opt);
+    }
+  return false;
+}
+
+bool
+TcpHeader::AddOptSACKPermitted(TcpOption_t optName)
+{
+  if (optName == OPT_SACK_PERMITTED)
+    {
+      TcpOptions opt;
+      opt.optName = optName;
+      return m_option.Add(opt);
+    }
+  return false;
+}
+
+bool
+TcpHeader::AddOptSACK(TcpOption_t optName, const OptSack& sack)
+{
+  if (optName == OPT_SACK && sack.count > 0 && sack.count <= OptSack::MAX_BLOCKS)
+    {
+      TcpOptions opt;
+      opt.optName = optName;
+      opt.sack = sack;
+      return m_option.Add(opt);
     }
   return false;
 }
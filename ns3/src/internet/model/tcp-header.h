@@ -47,7 +47,6 @@ class TcpHeader : public Header
 {
 public:
   TcpHeader();
-  TcpHeader(const TcpHeader &res);
   //TcpHeader Copy();
 
   virtual
@@ -58,14 +57,18 @@ public:
   bool AddOptJOIN(TcpOption_t optName, uint32_t RxToken, uint8_t addrID);   // Join Connection Option
   bool AddOptADDR(TcpOption_t optName, uint8_t addrID, Ipv4Address addr);// Add address Option
   bool AddOptDSN(TcpOption_t optName, uint64_t dSeqNum, uint16_t dLevelLength, uint32_t sfSeqNum); // Data Sequence Mapping Option
+  bool AddOptDataACK(TcpOption_t optName, uint64_t dataAck); // Data-level ACK Option
+  bool AddOptWScale(TcpOption_t optName, uint8_t shift);     // Window Scale Option
+  bool AddOptSACKPermitted(TcpOption_t optName);          // SACK-Permitted Option, only on SYN segments
+  bool AddOptSACK(TcpOption_t optName, const OptSack& sack); // SACK Option
   void SetOptionsLength(uint8_t length);
   void SetPaddingLength(uint8_t length);
   uint8_t GetOptionsLength() const;
   uint8_t GetPaddingLength() const;
   uint8_t TcpOptionToUint(TcpOption_t opt) const;
   TcpOption_t UintToTcpOption(uint8_t kind) const;
-  vector<TcpOptions*> GetOptions(void) const;
-  void SetOptions(vector<TcpOptions*> opt);
+  const TcpOptionList& GetOptions(void) const;
+  void SetOptions(const TcpOptionList& opt);
   //--------------------------------------------
   /**
    * \brief Enable checksum calculation for TCP
@@ -266,10 +269,9 @@ private:
   bool m_goodChecksum;    //!< Flag to indicate that checksum is correct
 
   // MPTCP related variables------------
-  vector<TcpOptions*> m_option;
+  TcpOptionList m_option;   // Stored inline, copies of the header copy the options
   uint8_t oLen;
   uint8_t pLen;
-  bool original;
   //------------------------------------
 };
 
@@ -24,6 +24,7 @@
 #include "ns3/nstime.h"
 #include "ns3/boolean.h"
 #include "ns3/object-vector.h"
+#include "ns3/uinteger.h"
 
 #include "ns3/packet.h"
 #include "ns3/node.h"
@@ -78,6 +79,11 @@ TcpL4Protocol::GetTypeId(void)
           TypeIdValue(TcpNewReno::GetTypeId()),
           MakeTypeIdAccessor(&TcpL4Protocol::m_socketTypeId),
           MakeTypeIdChecker())
+      .AddAttribute("MpTcpRcvBufLimit",
+          "Bytes that MPTCP connections of this node may add to their receive buffers by auto-tuning, altogether.",
+          UintegerValue(64 << 20),
+          MakeUintegerAccessor(&TcpL4Protocol::m_mpRcvBufLimit),
+          MakeUintegerChecker<uint32_t>())
       .AddAttribute("SocketList", "The list of sockets associated to this protocol.",
           ObjectVectorValue(),
           MakeObjectVectorAccessor(&TcpL4Protocol::m_sockets),
@@ -86,7 +92,7 @@ TcpL4Protocol::GetTypeId(void)
 }
 
 TcpL4Protocol::TcpL4Protocol() :
-    m_endPoints(new Ipv4EndPointDemux()), m_endPoints6(new Ipv6EndPointDemux())
+    m_endPoints(new Ipv4EndPointDemux()), m_endPoints6(new Ipv6EndPointDemux()), m_mpRcvBufUsed(0)
 {
   NS_LOG_FUNCTION_NOARGS (); NS_LOG_LOGIC ("Made a TcpL4Protocol "<<this);
 }
@@ -359,21 +365,19 @@ TcpL4Protocol::Receive(Ptr<Packet> packet, Ipv4Header const &ipHeader, Ptr<Ipv4I
   //
   // MPTCP related modification----------------------------
   // Extract MPTCP options if there is any
-  vector<TcpOptions*> options = tcpHeader.GetOptions();
+  const TcpOptionList& options = tcpHeader.GetOptions();
   uint8_t flags = tcpHeader.GetFlags();
   bool hasSyn = flags & TcpHeader::SYN;
-  TcpOptions *opt;
   uint32_t Token;
-  for (uint32_t j = 0; j < options.size(); j++)
+  for (TcpOptionList::const_iterator opt = options.Begin(); opt != options.End(); ++opt)
     {
-      opt = options[j];
       if ((opt->optName == OPT_MPC) && hasSyn)
         { // In this case the endpoint with destination port and token value of zero need to be find.
           NS_LOG_INFO("TcpL4Protocol::Receive -> OPT_MPC -> Do NOTTING");
         }
       else if ((opt->optName == OPT_JOIN) && hasSyn)
         { // In this case there should be endPoint with this token, so look for a match on all endpoints.
-          Token = ((OptJoinConnection *) opt)->receiverToken;
+          Token = opt->join.receiverToken;
           TokenMaps::iterator it;
           it = m_TokenMap.find(Token);
           if (it != m_TokenMap.end())
@@ -269,6 +269,8 @@ private:
 
   std::vector<Ptr<TcpSocketBase> > m_sockets;      //!< list of sockets
   std::map<uint32_t, Ipv4EndPoint* > m_TokenMap;   //!< list of Token
+  uint32_t m_mpRcvBufLimit;                        //!< Bytes MPTCP receive buffer auto-tuning may add on this node
+  uint32_t m_mpRcvBufUsed;                         //!< Bytes added so far by the connections still open
   IpL4Protocol::DownTargetCallback m_downTarget;   //!< Callback to send packets over IPv4
   IpL4Protocol::DownTargetCallback6 m_downTarget6; //!< Callback to send packets over IPv6
 };
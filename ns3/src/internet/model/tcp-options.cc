@@ -1,95 +1,41 @@
 #include <stdint.h>
-#include <iostream>
-#include "ns3/log.h"
+#include <string.h>
 #include "tcp-options.h"
 
-NS_LOG_COMPONENT_DEFINE ("TcpOptions");
-
 namespace ns3{
 
-//NS_OBJECT_ENSURE_REGISTERED(TcpOptions);
-
-TcpOptions::TcpOptions(void) :
-    optName(OPT_NONE)
-{
-  NS_LOG_FUNCTION_NOARGS();
-}
-
-TcpOptions::~TcpOptions(void)
-{
-  NS_LOG_FUNCTION_NOARGS();
-  optName = OPT_NONE;
-}
-
-OptMultipathCapable::OptMultipathCapable(TcpOption_t oName, uint32_t TxToken)
-{
-  NS_LOG_FUNCTION(this << oName << TxToken);
-  optName = oName;
-  Length = 5; // field "length" is not insert in the packet
-  senderToken = TxToken;
-}
-
-OptMultipathCapable::~OptMultipathCapable()
-{
-  NS_LOG_FUNCTION_NOARGS();
-  optName = OPT_NONE;
-  Length = 0; // field "length" is not insert in the packet
-  senderToken = 0;
-}
-
-OptJoinConnection::OptJoinConnection(TcpOption_t oName, uint32_t RxToken, uint8_t aID)
-{
-  NS_LOG_FUNCTION(this << oName << RxToken << aID);
-  optName = oName;
-  Length = 6;
-  receiverToken = RxToken;
-  addrID = aID;
-}
-
-OptJoinConnection::~OptJoinConnection()
+TcpOptionList::TcpOptionList() :
+    m_size(0)
 {
-  NS_LOG_FUNCTION_NOARGS();
-  optName = OPT_NONE;
-  Length = 0;
-  receiverToken = 0;
-  addrID = 0;
 }
 
-OptAddAddress::OptAddAddress(TcpOption_t oName, uint8_t aID, Ipv4Address address)
+TcpOptionList::TcpOptionList(const TcpOptionList& other) :
+    m_size(other.m_size)
 {
-  NS_LOG_FUNCTION(this << oName << aID << address);
-  optName = oName;
-  Length = 6;
-  addrID = aID;
-  addr = address;
+  // Only the options in use are copied, most headers carry a single DSN option
+  memcpy(m_options, other.m_options, m_size * sizeof(TcpOptions));
 }
 
-OptAddAddress::~OptAddAddress()
+TcpOptionList&
+TcpOptionList::operator=(const TcpOptionList& other)
 {
-  NS_LOG_FUNCTION_NOARGS();
-  optName = OPT_NONE;
-  Length = 0;
-  addrID = 0;
-  addr = Ipv4Address::GetZero();
+  m_size = other.m_size;
+  memmove(m_options, other.m_options, m_size * sizeof(TcpOptions));
+  return *this;
 }
 
-OptDataSeqMapping::OptDataSeqMapping(TcpOption_t oName, uint64_t dSeqNum, uint16_t dLevelLength, uint32_t sfSeqNum)
+bool
+TcpOptionList::Add(const TcpOptions& option)
 {
-  NS_LOG_FUNCTION(this << oName << dSeqNum << dLevelLength << sfSeqNum);
-  optName = oName;
-  Length = 11;
-  dataSeqNumber = dSeqNum;
-  dataLevelLength = dLevelLength;
-  subflowSeqNumber = sfSeqNum;
+  if (m_size == MAX_OPTIONS)
+    return false;
+  m_options[m_size++] = option;
+  return true;
 }
 
-OptDataSeqMapping::~OptDataSeqMapping()
+void
+TcpOptionList::Clear()
 {
-  NS_LOG_FUNCTION_NOARGS();
-  optName = OPT_NONE;
-  Length = 0;
-  dataSeqNumber = 0;
-  dataLevelLength = 0;
-  subflowSeqNumber = 0;
+  m_size = 0;
 }
 }
@@ -2,7 +2,6 @@
 #define TCP_OPTIONS_H
 
 #include <stdint.h>
-#include <vector>
 #include "ns3/ipv4-address.h"
 
 
@@ -14,61 +13,110 @@ namespace ns3
 typedef enum
 {
   OPT_NONE = 0,
+  OPT_WSCALE = 3,
+  OPT_SACK_PERMITTED = 4,
+  OPT_SACK = 5,
   OPT_MPC = 30,
   OPT_JOIN = 31,
   OPT_ADDR = 32,
-  OPT_DSN = 34
+  OPT_DSN = 34,
+  OPT_DATA_ACK = 35
 } TcpOption_t;
 
-class TcpOptions
+struct OptMultipathCapable
 {
-public:
-  TcpOptions();
-  virtual
-  ~TcpOptions();
-
-  TcpOption_t optName;
-  uint8_t Length;
-};
-
-class OptMultipathCapable : public TcpOptions
-{
-public:
-  virtual
-  ~OptMultipathCapable();
   uint32_t senderToken;
-  OptMultipathCapable(TcpOption_t oName, uint32_t TxToken);
 };
 
-class OptJoinConnection : public TcpOptions
+struct OptJoinConnection
 {
-public:
-  virtual
-  ~OptJoinConnection();
   uint32_t receiverToken;
   uint8_t addrID;
-  OptJoinConnection(TcpOption_t oName, uint32_t RxToken, uint8_t aID);
 };
 
-class OptAddAddress : public TcpOptions
+struct OptAddAddress
 {
-public:
-  virtual
-  ~OptAddAddress();
   uint8_t addrID;
-  Ipv4Address addr;
-  OptAddAddress(TcpOption_t oName, uint8_t aID, Ipv4Address address);
+  uint32_t addr;        // Ipv4Address has a constructor, so it cannot be a union member
+  Ipv4Address GetAddress() const { return Ipv4Address(addr); }
 };
 
-class OptDataSeqMapping : public TcpOptions
+struct OptDataSeqMapping
 {
-public:
-  virtual
-  ~OptDataSeqMapping();
   uint64_t dataSeqNumber;
   uint16_t dataLevelLength;
   uint32_t subflowSeqNumber;
-  OptDataSeqMapping(TcpOption_t oName, uint64_t dSeqNum, uint16_t dLevelLength, uint32_t sfSeqNum);
+};
+
+struct OptWindowScale
+{
+  uint8_t shift;        // Window fields after the SYN are in units of 2^shift bytes (RFC 7323)
+};
+
+struct OptDataAck
+{
+  uint64_t dataAck;     // Next data sequence number expected at connection level
+};
+
+/**
+ * SACK blocks (RFC 2018) of a subflow, each [left, right) is a range of subflow
+ * sequence numbers received above the cumulative ACK. Four blocks are what fits
+ * into the option space of a pure ACK.
+ */
+struct OptSack
+{
+  static const uint8_t MAX_BLOCKS = 4;
+  uint8_t count;
+  uint32_t left[MAX_BLOCKS];
+  uint32_t right[MAX_BLOCKS];
+};
+
+/**
+ * TCP option of a TcpHeader, optName tells which member of the union is valid.
+ * Options are plain values stored inline in the header, so neither adding,
+ * deserializing nor copying them touches the heap.
+ */
+struct TcpOptions
+{
+  TcpOption_t optName;
+  union
+  {
+    OptMultipathCapable mpc;
+    OptJoinConnection join;
+    OptAddAddress addAddr;
+    OptDataSeqMapping dsn;
+    OptDataAck dataAck;
+    OptWindowScale wscale;
+    OptSack sack;
+  };
+};
+
+/**
+ * Fixed-capacity list of the options of a TcpHeader. The capacity is what fits
+ * into the 40 bytes of TCP option space, 5 bytes being the smallest MPTCP option.
+ */
+class TcpOptionList
+{
+public:
+  static const uint8_t MAX_OPTIONS = 8;
+  typedef const TcpOptions* const_iterator;
+
+  TcpOptionList();
+  TcpOptionList(const TcpOptionList& other);
+  TcpOptionList& operator=(const TcpOptionList& other);
+
+  bool Add(const TcpOptions& option);  // Returns false if the list is full
+  void Clear();
+
+  uint8_t GetSize() const { return m_size; }
+  bool IsEmpty() const { return m_size == 0; }
+  const TcpOptions& operator[](uint8_t i) const { return m_options[i]; }
+  const_iterator Begin() const { return m_options; }
+  const_iterator End() const { return m_options + m_size; }
+
+private:
+  uint8_t m_size;
+  TcpOptions m_options[MAX_OPTIONS];
 };
 
 }
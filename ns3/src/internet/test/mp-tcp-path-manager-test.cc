@@ -0,0 +1,509 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/mp-tcp-socket-base.h"
+#include "ns3/mp-tcp-subflow.h"
+#include "ns3/mp-tcp-scheduler.h"
+
+using namespace ns3;
+
+/**
+ * Connection with two established subflows, subflow 0 on 10.1.1.1 (interface 1) with an
+ * RTT of 20 ms and subflow 1 on 10.1.2.1 (interface 2) with one of 200 ms. What the peer
+ * acks and what is lost on each subflow is set by the test, the Adaptive path manager
+ * evaluates them every second.
+ */
+class MpTcpPathManagerTestSocket : public MpTcpSocketBase
+{
+public:
+  void Setup (Ptr<Node> node)
+  {
+    SetNode (node);
+    SetTcp (node->GetObject<TcpL4Protocol> ());
+    segmentSize = 1000;
+    m_state = ESTABLISHED;
+    AddTestSubflow ("10.1.1.1", "10.1.1.2", MilliSeconds (20));
+    AddTestSubflow ("10.1.2.1", "10.1.2.2", MilliSeconds (200));
+  }
+
+  void Ack (uint8_t sFlowIdx, uint32_t bytes)
+  {
+    subflows[sFlowIdx]->highestAck += bytes;
+  }
+
+  void Lose (uint8_t sFlowIdx)
+  {
+    subflows[sFlowIdx]->pmLosses++;
+  }
+
+  void SetState (TcpStates_t state)
+  {
+    m_state = state;
+  }
+
+  Ptr<MpTcpSubFlow> GetSubflow (uint8_t sFlowIdx)
+  {
+    return subflows[sFlowIdx];
+  }
+
+  bool IsEvaluating (void) const
+  {
+    return m_pmEvent.IsRunning ();
+  }
+
+  void Start (void)
+  {
+    StartPathManager ();
+  }
+
+private:
+  void AddTestSubflow (const char* local, const char* remote, Time rtt)
+  {
+    Ptr<MpTcpSubFlow> sFlow = CreateObject<MpTcpSubFlow> ();
+    sFlow->routeId = subflows.size ();
+    sFlow->state = ESTABLISHED;
+    sFlow->sAddr = Ipv4Address (local);
+    sFlow->sPort = 5000 + sFlow->routeId;
+    sFlow->dAddr = Ipv4Address (remote);
+    sFlow->dPort = 80;
+    sFlow->MSS = segmentSize;
+    sFlow->TxSeqNumber = 1;
+    sFlow->maxSeqNb = 0;
+    sFlow->highestAck = 0;
+    sFlow->m_endPoint = 0;
+    sFlow->rtt->SetCurrentEstimate (rtt);
+    AddSubflow (sFlow);
+  }
+};
+
+/**
+ * Exposes the check the schedulers make before they use a subflow
+ */
+class MpTcpPathManagerTestScheduler : public MpTcpScheduler
+{
+public:
+  virtual int GetSubflowToUse (Ptr<MpTcpSocketBase> sock)
+  {
+    return GetFastestSubflow (sock);
+  }
+
+  bool Established (Ptr<MpTcpSocketBase> sock, uint8_t sFlowIdx)
+  {
+    return IsEstablished (sock, sFlowIdx);
+  }
+};
+
+
+/**
+ * Base of the path manager tests: runs the evaluations for a number of intervals and
+ * records the decisions of the "PathManager" trace. In interval k, from k to k + 1 s, the
+ * peer acks what Interval (k) sets half-way through it, which the evaluation at k + 1 s sees.
+ */
+class MpTcpPathManagerTest : public TestCase
+{
+public:
+  MpTcpPathManagerTest (std::string name);
+
+protected:
+  struct Decision
+  {
+    Time at;
+    uint32_t sFlowIdx;
+    bool retired;
+  };
+
+  // Evaluates until 'seconds' with RetireIntervals 3 and the given ReprobeTime
+  void Run (uint32_t seconds, Time reprobe);
+  virtual void Interval (uint32_t k) = 0;
+  // The n-th decision is to retire (or reactivate) the subflow at 'seconds'
+  void CheckDecision (uint32_t n, uint32_t seconds, uint32_t sFlowIdx, bool retired);
+
+  Ptr<Node> m_node;
+  Ptr<MpTcpPathManagerTestSocket> m_socket;
+  std::vector<Decision> m_decisions;
+
+private:
+  void Decided (uint8_t sFlowIdx, bool retired);
+};
+
+MpTcpPathManagerTest::MpTcpPathManagerTest (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+MpTcpPathManagerTest::Decided (uint8_t sFlowIdx, bool retired)
+{
+  Decision decision;
+  decision.at = Simulator::Now ();
+  decision.sFlowIdx = sFlowIdx;
+  decision.retired = retired;
+  m_decisions.push_back (decision);
+}
+
+void
+MpTcpPathManagerTest::Run (uint32_t seconds, Time reprobe)
+{
+  m_node = CreateObject<Node> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (CreateObject<SimpleChannel> ());
+      m_node->AddDevice (device);
+      devices.Add (device);
+    }
+  InternetStackHelper internet;
+  internet.Install (m_node);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (NetDeviceContainer (devices.Get (0)));
+  ipv4.SetBase ("10.1.2.0", "255.255.255.0");
+  ipv4.Assign (NetDeviceContainer (devices.Get (1)));
+
+  m_socket = CreateObject<MpTcpPathManagerTestSocket> ();
+  m_socket->SetAttribute ("PathManagement", EnumValue (Adaptive));
+  m_socket->SetAttribute ("PathManagerInterval", TimeValue (Seconds (1)));
+  m_socket->SetAttribute ("RetireIntervals", UintegerValue (3));
+  m_socket->SetAttribute ("ReprobeTime", TimeValue (reprobe));
+  m_socket->Setup (m_node);
+  m_socket->TraceConnectWithoutContext ("PathManager", MakeCallback (&MpTcpPathManagerTest::Decided, this));
+  m_socket->Start ();
+  for (uint32_t k = 1; k < seconds; k++)
+    {
+      Simulator::Schedule (MilliSeconds (1000 * k + 500), &MpTcpPathManagerTest::Interval, this, k);
+    }
+  Simulator::Stop (MilliSeconds (1000 * seconds + 100));
+  Simulator::Run ();
+}
+
+void
+MpTcpPathManagerTest::CheckDecision (uint32_t n, uint32_t seconds, uint32_t sFlowIdx, bool retired)
+{
+  NS_TEST_EXPECT_MSG_GT (m_decisions.size (), n, "decision " << n << " missing");
+  if (m_decisions.size () <= n)
+    {
+      return;
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_decisions[n].at, Seconds (seconds), "decision " << n << " at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (m_decisions[n].sFlowIdx, sFlowIdx, "decision " << n << " on the wrong subflow");
+  NS_TEST_EXPECT_MSG_EQ (m_decisions[n].retired, retired, "decision " << n << " the wrong way");
+}
+
+
+/**
+ * The slow subflow carries 1% of the data: it is retired after three useless intervals in
+ * a row, an interval in which it carried its share starts the count again.
+ */
+class MpTcpPathManagerRetireTest : public MpTcpPathManagerTest
+{
+public:
+  MpTcpPathManagerRetireTest ();
+
+private:
+  virtual void DoRun (void);
+  virtual void Interval (uint32_t k);
+};
+
+MpTcpPathManagerRetireTest::MpTcpPathManagerRetireTest ()
+  : MpTcpPathManagerTest ("Subflow retired after RetireIntervals useless intervals")
+{
+}
+
+void
+MpTcpPathManagerRetireTest::Interval (uint32_t k)
+{
+  m_socket->Ack (0, 100000);
+  if (!m_socket->GetSubflow (1)->retired)
+    {
+      m_socket->Ack (1, k == 2 ? 20000 : 1000);
+    }
+}
+
+void
+MpTcpPathManagerRetireTest::DoRun (void)
+{
+  Run (10, Seconds (0));
+  // Useless at 2 s, useful at 3 s, useless at 4, 5 and 6 s
+  NS_TEST_EXPECT_MSG_EQ (m_decisions.size (), 1, "wrong number of decisions");
+  CheckDecision (0, 6, 1, true);
+  NS_TEST_EXPECT_MSG_EQ (m_socket->GetSubflow (0)->retired, false, "fast subflow retired");
+  NS_TEST_EXPECT_MSG_EQ (m_socket->IsEvaluating (), true, "evaluations stopped");
+  m_socket = 0;
+  Simulator::Destroy ();
+}
+
+
+/**
+ * The fastest subflow that carried data is kept however little it carried, and so is the
+ * last active subflow when both lose everything they send. Once that leaves the remaining
+ * one stalled on losses, the retired subflow is scheduled again.
+ */
+class MpTcpPathManagerKeepTest : public MpTcpPathManagerTest
+{
+public:
+  MpTcpPathManagerKeepTest (bool stalled);
+
+private:
+  virtual void DoRun (void);
+  virtual void Interval (uint32_t k);
+
+  bool m_stalled;
+};
+
+MpTcpPathManagerKeepTest::MpTcpPathManagerKeepTest (bool stalled)
+  : MpTcpPathManagerTest (stalled ? "Last active subflow never retired, retired one back on a stall"
+                                  : "Fastest subflow never retired"),
+    m_stalled (stalled)
+{
+}
+
+void
+MpTcpPathManagerKeepTest::Interval (uint32_t k)
+{
+  if (m_stalled)
+    {
+      m_socket->Lose (0);
+      m_socket->Lose (1);
+    }
+  else
+    {
+      m_socket->Ack (0, 1000);
+      m_socket->Ack (1, 100000);
+    }
+}
+
+void
+MpTcpPathManagerKeepTest::DoRun (void)
+{
+  if (m_stalled)
+    {
+      Run (5, Seconds (0));
+      // Both useless from 2 s on, subflow 0 retired first at 4 s leaves subflow 1 alone
+      NS_TEST_EXPECT_MSG_EQ (m_decisions.size (), 2, "wrong number of decisions");
+      CheckDecision (0, 4, 0, true);
+      CheckDecision (1, 5, 0, false);
+      NS_TEST_EXPECT_MSG_EQ (m_socket->GetSubflow (1)->retired, false, "last active subflow retired");
+    }
+  else
+    {
+      Run (10, Seconds (0));
+      NS_TEST_EXPECT_MSG_EQ (m_decisions.size (), 0, "fastest subflow retired");
+    }
+  m_socket = 0;
+  Simulator::Destroy ();
+}
+
+
+/**
+ * The slow subflow is retired at 4 s, then scheduled again: once the local interface of the
+ * other one goes down, which is retired at the next evaluation once it is not the last
+ * active subflow any more, or once ReprobeTime (3 s) passed, after which it is measured anew.
+ */
+class MpTcpPathManagerReactivateTest : public MpTcpPathManagerTest
+{
+public:
+  MpTcpPathManagerReactivateTest (bool ifDown);
+
+private:
+  virtual void DoRun (void);
+  virtual void Interval (uint32_t k);
+
+  bool m_ifDown;
+};
+
+MpTcpPathManagerReactivateTest::MpTcpPathManagerReactivateTest (bool ifDown)
+  : MpTcpPathManagerTest (ifDown ? "Retired subflow back on an interface change"
+                                 : "Retired subflow back after ReprobeTime"),
+    m_ifDown (ifDown)
+{
+}
+
+void
+MpTcpPathManagerReactivateTest::Interval (uint32_t k)
+{
+  if (m_ifDown && k == 6)
+    {
+      m_node->GetObject<Ipv4> ()->SetDown (1);
+    }
+  if (m_ifDown && k >= 6)
+    {
+      return; // Nothing is acked any more
+    }
+  m_socket->Ack (0, 100000);
+  if (!m_socket->GetSubflow (1)->retired)
+    {
+      m_socket->Ack (1, 1000);
+    }
+}
+
+void
+MpTcpPathManagerReactivateTest::DoRun (void)
+{
+  if (m_ifDown)
+    {
+      Run (10, Seconds (0));
+      NS_TEST_EXPECT_MSG_EQ (m_decisions.size (), 3, "wrong number of decisions");
+      CheckDecision (0, 4, 1, true);
+      CheckDecision (1, 7, 1, false);
+      CheckDecision (2, 8, 0, true);
+    }
+  else
+    {
+      Run (11, Seconds (3));
+      NS_TEST_EXPECT_MSG_EQ (m_decisions.size (), 3, "wrong number of decisions");
+      CheckDecision (0, 4, 1, true);
+      CheckDecision (1, 7, 1, false);
+      CheckDecision (2, 10, 1, true);
+    }
+  m_socket = 0;
+  Simulator::Destroy ();
+}
+
+
+/**
+ * Evaluations keep running until the connection is established and stop once it is closed
+ */
+class MpTcpPathManagerStateTest : public MpTcpPathManagerTest
+{
+public:
+  MpTcpPathManagerStateTest ();
+
+private:
+  virtual void DoRun (void);
+  virtual void Interval (uint32_t k);
+};
+
+MpTcpPathManagerStateTest::MpTcpPathManagerStateTest ()
+  : MpTcpPathManagerTest ("Evaluations wait for the connection and end when it closes")
+{
+}
+
+void
+MpTcpPathManagerStateTest::Interval (uint32_t k)
+{
+  if (k == 1)
+    {
+      m_socket->SetState (TcpSocket::SYN_SENT);
+    }
+  if (k == 3)
+    {
+      m_socket->SetState (TcpSocket::ESTABLISHED);
+    }
+  if (k == 9)
+    {
+      m_socket->SetState (TcpSocket::CLOSED);
+    }
+  m_socket->Ack (0, 100000);
+  if (!m_socket->GetSubflow (1)->retired)
+    {
+      m_socket->Ack (1, 1000);
+    }
+}
+
+void
+MpTcpPathManagerStateTest::DoRun (void)
+{
+  Run (12, Seconds (0));
+  // Not established at 2 and 3 s, useless at 4 (counting what was acked since 1 s), 5 and 6 s
+  NS_TEST_EXPECT_MSG_EQ (m_decisions.size (), 1, "wrong number of decisions");
+  CheckDecision (0, 6, 1, true);
+  NS_TEST_EXPECT_MSG_EQ (m_socket->IsEvaluating (), false, "evaluations still running after the close");
+  m_socket = 0;
+  Simulator::Destroy ();
+}
+
+
+/**
+ * A retired subflow is skipped by the schedulers, except in timeout recovery where it has
+ * to resend what it has outstanding.
+ */
+class MpTcpPathManagerSchedulerTest : public MpTcpPathManagerTest
+{
+public:
+  MpTcpPathManagerSchedulerTest ();
+
+private:
+  virtual void DoRun (void);
+  virtual void Interval (uint32_t k);
+};
+
+MpTcpPathManagerSchedulerTest::MpTcpPathManagerSchedulerTest ()
+  : MpTcpPathManagerTest ("Schedulers use a retired subflow only in timeout recovery")
+{
+}
+
+void
+MpTcpPathManagerSchedulerTest::Interval (uint32_t k)
+{
+}
+
+void
+MpTcpPathManagerSchedulerTest::DoRun (void)
+{
+  Run (1, Seconds (0));
+  Ptr<MpTcpPathManagerTestScheduler> scheduler = CreateObject<MpTcpPathManagerTestScheduler> ();
+  Ptr<MpTcpSubFlow> fast = m_socket->GetSubflow (0);
+  NS_TEST_EXPECT_MSG_EQ (scheduler->Established (m_socket, 0), true, "active subflow skipped");
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetSubflowToUse (m_socket), 0, "fastest subflow not used");
+
+  fast->retired = true;
+  fast->TxSeqNumber = 10001;
+  fast->maxSeqNb = 10000;
+  NS_TEST_EXPECT_MSG_EQ (scheduler->Established (m_socket, 0), false, "retired subflow used");
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetSubflowToUse (m_socket), 1, "retired subflow used");
+
+  // A timeout moved TxSeqNumber back to the first unacked byte
+  fast->TxSeqNumber = 5001;
+  NS_TEST_EXPECT_MSG_EQ (scheduler->Established (m_socket, 0), true, "retired subflow not used in timeout recovery");
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetSubflowToUse (m_socket), 0, "retired subflow not used in timeout recovery");
+
+  fast->state = TcpSocket::CLOSE_WAIT;
+  NS_TEST_EXPECT_MSG_EQ (scheduler->Established (m_socket, 0), false, "closing subflow used");
+  m_socket = 0;
+  Simulator::Destroy ();
+}
+
+
+static class MpTcpPathManagerTestSuite : public TestSuite
+{
+public:
+  MpTcpPathManagerTestSuite ()
+    : TestSuite ("mp-tcp-path-manager", UNIT)
+  {
+    AddTestCase (new MpTcpPathManagerRetireTest, TestCase::QUICK);
+    AddTestCase (new MpTcpPathManagerKeepTest (false), TestCase::QUICK);
+    AddTestCase (new MpTcpPathManagerKeepTest (true), TestCase::QUICK);
+    AddTestCase (new MpTcpPathManagerReactivateTest (true), TestCase::QUICK);
+    AddTestCase (new MpTcpPathManagerReactivateTest (false), TestCase::QUICK);
+    AddTestCase (new MpTcpPathManagerStateTest, TestCase::QUICK);
+    AddTestCase (new MpTcpPathManagerSchedulerTest, TestCase::QUICK);
+  }
+} g_mpTcpPathManagerTestSuite;
@@ -0,0 +1,218 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/error-model.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/mp-tcp-socket-base.h"
+
+using namespace ns3;
+
+/**
+ * Drops the packets it receives while armed, up to a count
+ */
+class MpTcpPersistTestDrop : public ErrorModel
+{
+public:
+  MpTcpPersistTestDrop ()
+    : m_toDrop (0),
+      m_dropped (0)
+  {
+  }
+
+  void Drop (uint32_t count)
+  {
+    m_toDrop = count;
+  }
+
+  uint32_t GetDropped (void) const
+  {
+    return m_dropped;
+  }
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p)
+  {
+    if (m_toDrop == 0)
+      {
+        return false;
+      }
+    m_toDrop--;
+    m_dropped++;
+    return true;
+  }
+
+  virtual void DoReset (void)
+  {
+    m_toDrop = 0;
+  }
+
+  uint32_t m_toDrop;
+  uint32_t m_dropped;
+};
+
+
+/**
+ * The receiving application does not read until the sender has filled the receive buffer and
+ * stopped on the closed window. Once it reads, the window update of the receiver is either
+ * delivered or dropped on the way to the sender, and the transfer has to complete anyway.
+ */
+class MpTcpPersistTest : public TestCase
+{
+public:
+  MpTcpPersistTest (bool dropUpdate, Time deadline, std::string name);
+
+private:
+  virtual void DoRun (void);
+
+  void HandleAccept (Ptr<Socket> socket, const Address& from);
+  void HandleRead (Ptr<Socket> socket);
+  void StartSending (Ptr<MpTcpSocketBase> sender);
+  void StartReading (void);
+
+  bool m_dropUpdate;
+  Time m_deadline;                // The transfer completes before
+  uint32_t m_bytes;
+  uint32_t m_received;
+  bool m_reading;
+  Time m_completed;
+  Ptr<Socket> m_receiver;
+  Ptr<MpTcpPersistTestDrop> m_drop;
+};
+
+MpTcpPersistTest::MpTcpPersistTest (bool dropUpdate, Time deadline, std::string name)
+  : TestCase (name),
+    m_dropUpdate (dropUpdate),
+    m_deadline (deadline),
+    m_bytes (100000),
+    m_received (0),
+    m_reading (false)
+{
+}
+
+void
+MpTcpPersistTest::HandleAccept (Ptr<Socket> socket, const Address& from)
+{
+  m_receiver = socket;
+  socket->SetRecvCallback (MakeCallback (&MpTcpPersistTest::HandleRead, this));
+}
+
+void
+MpTcpPersistTest::HandleRead (Ptr<Socket> socket)
+{
+  if (!m_reading)
+    {
+      return;
+    }
+  m_received += DynamicCast<MpTcpSocketBase> (socket)->Recv (0xffffffff);
+  if (m_received >= m_bytes && m_completed.IsZero ())
+    {
+      m_completed = Simulator::Now ();
+    }
+}
+
+void
+MpTcpPersistTest::StartSending (Ptr<MpTcpSocketBase> sender)
+{
+  sender->FillBuffer (m_bytes);
+  sender->SendBufferedData ();
+}
+
+void
+MpTcpPersistTest::StartReading (void)
+{
+  NS_TEST_ASSERT_MSG_NE (m_receiver, 0, "connection not accepted");
+  if (m_dropUpdate)
+    {
+      m_drop->Drop (1); // Nothing is in flight to the sender but the window update
+    }
+  m_reading = true;
+  HandleRead (m_receiver);
+}
+
+void
+MpTcpPersistTest::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+  m_drop = CreateObject<MpTcpPersistTestDrop> ();
+  DynamicCast<SimpleNetDevice> (devices.Get (0))->SetReceiveErrorModel (m_drop);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+
+  uint16_t port = 9;
+  Ptr<Socket> listener = nodes.Get (1)->GetObject<TcpL4Protocol> ()->CreateSocket (MpTcpSocketBase::GetTypeId ());
+  listener->SetAttribute ("RcvBufSize", UintegerValue (20000));
+  listener->SetAttribute ("RcvBufAutoTuning", BooleanValue (false));
+  listener->Bind (InetSocketAddress (Ipv4Address::GetAny (), port));
+  listener->Listen ();
+  listener->SetRecvCallback (MakeCallback (&MpTcpPersistTest::HandleRead, this));
+  listener->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                               MakeCallback (&MpTcpPersistTest::HandleAccept, this));
+
+  Ptr<MpTcpSocketBase> sender = DynamicCast<MpTcpSocketBase> (
+      nodes.Get (0)->GetObject<TcpL4Protocol> ()->CreateSocket (MpTcpSocketBase::GetTypeId ()));
+  sender->Bind ();
+  sender->Connect (InetSocketAddress (interfaces.GetAddress (1), port));
+
+  Simulator::Schedule (Seconds (0.5), &MpTcpPersistTest::StartSending, this, sender);
+  Simulator::Schedule (Seconds (2), &MpTcpPersistTest::StartReading, this);
+  Simulator::Stop (Seconds (100));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_drop->GetDropped (), (m_dropUpdate ? 1 : 0), "window update not dropped as planned");
+  NS_TEST_EXPECT_MSG_EQ (m_received, m_bytes, "transfer stalled");
+  NS_TEST_EXPECT_MSG_EQ ((!m_completed.IsZero () && m_completed < m_deadline), true,
+                         "transfer completed at " << m_completed.GetSeconds () << " s");
+  Simulator::Destroy ();
+}
+
+
+static class MpTcpPersistTestSuite : public TestSuite
+{
+public:
+  MpTcpPersistTestSuite ()
+    : TestSuite ("mp-tcp-persist", UNIT)
+  {
+    // A delivered window update resumes the transfer at once
+    AddTestCase (new MpTcpPersistTest (false, Seconds (3), "Window update reopens a closed connection window"), TestCase::QUICK);
+    // A lost one leaves it to the first window probe, PersistTimeout (6 s) later
+    AddTestCase (new MpTcpPersistTest (true, Seconds (10), "Window probe recovers a lost window update"), TestCase::QUICK);
+  }
+} g_mpTcpPersistTestSuite;
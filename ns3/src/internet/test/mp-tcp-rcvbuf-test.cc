@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/mp-tcp-socket-base.h"
+#include "ns3/mp-tcp-subflow.h"
+
+using namespace ns3;
+
+/**
+ * Receiving socket with one established subflow, the application reading the data
+ * as soon as it is in order
+ */
+class MpTcpRcvBufTestSocket : public MpTcpSocketBase
+{
+public:
+  void Setup (Ptr<Node> node, Ptr<TcpL4Protocol> tcp, Time rtt)
+  {
+    SetNode (node);
+    SetTcp (tcp);
+    Ptr<MpTcpSubFlow> sFlow = CreateObject<MpTcpSubFlow> ();
+    sFlow->state = ESTABLISHED;
+    sFlow->handshakeRtt = rtt;
+    subflows.push_back (sFlow);
+  }
+
+  // As ReadUnOrderedData, once bytes more are in order
+  void Deliver (uint32_t bytes)
+  {
+    nextRxSequence += bytes;
+    AdjustRcvBuf ();
+  }
+
+  uint32_t GetRcvBuf (void) const
+  {
+    return GetRcvBufSize ();
+  }
+
+  // As done when the connection's endpoint is deallocated
+  void Kill (void)
+  {
+    Destroy ();
+  }
+};
+
+
+class MpTcpRcvBufTest : public TestCase
+{
+public:
+  MpTcpRcvBufTest (std::string name);
+
+protected:
+  Ptr<MpTcpRcvBufTestSocket> CreateReceiver (void);
+  void Advance (Time delay);
+
+  Ptr<Node> m_node;
+  Ptr<TcpL4Protocol> m_tcp;
+  uint32_t m_initialRcvBuf;
+};
+
+MpTcpRcvBufTest::MpTcpRcvBufTest (std::string name)
+  : TestCase (name),
+    m_initialRcvBuf (131072)
+{
+}
+
+Ptr<MpTcpRcvBufTestSocket>
+MpTcpRcvBufTest::CreateReceiver (void)
+{
+  Ptr<MpTcpRcvBufTestSocket> socket = CreateObject<MpTcpRcvBufTestSocket> ();
+  socket->Setup (m_node, m_tcp, MilliSeconds (100));
+  socket->SetAttribute ("RcvBufSize", UintegerValue (m_initialRcvBuf));
+  socket->Deliver (0); // Starts the first measurement period
+  return socket;
+}
+
+void
+MpTcpRcvBufTest::Advance (Time delay)
+{
+  Simulator::Stop (delay);
+  Simulator::Run ();
+}
+
+
+class MpTcpRcvBufGrowthTest : public MpTcpRcvBufTest
+{
+public:
+  MpTcpRcvBufGrowthTest ();
+  virtual void DoRun (void);
+};
+
+MpTcpRcvBufGrowthTest::MpTcpRcvBufGrowthTest ()
+  : MpTcpRcvBufTest ("Receive buffer grows once per RTT up to RcvBufMax")
+{
+}
+
+void
+MpTcpRcvBufGrowthTest::DoRun (void)
+{
+  m_node = CreateObject<Node> ();
+  m_tcp = CreateObject<TcpL4Protocol> ();
+  Ptr<MpTcpRcvBufTestSocket> socket = CreateReceiver ();
+  socket->SetAttribute ("RcvBufMax", UintegerValue (1 << 20));
+
+  // Within the RTT nothing changes, however much data arrives
+  Advance (MilliSeconds (50));
+  socket->Deliver (200000);
+  NS_TEST_EXPECT_MSG_EQ (socket->GetRcvBuf (), m_initialRcvBuf, "buffer grown before an RTT elapsed");
+
+  // Twice what was delivered in the RTT
+  Advance (MilliSeconds (60));
+  socket->Deliver (0);
+  NS_TEST_EXPECT_MSG_EQ (socket->GetRcvBuf (), 400000, "buffer not grown to twice the data of an RTT");
+
+  // Capped by RcvBufMax
+  Advance (MilliSeconds (100));
+  socket->Deliver (2000000);
+  NS_TEST_EXPECT_MSG_EQ (socket->GetRcvBuf (), 1 << 20, "buffer grown beyond RcvBufMax");
+
+  // Less data in the next RTT does not shrink it
+  Advance (MilliSeconds (100));
+  socket->Deliver (1000);
+  NS_TEST_EXPECT_MSG_EQ (socket->GetRcvBuf (), 1 << 20, "buffer shrunk");
+
+  // Nor does auto-tuning change a buffer it is disabled for
+  Ptr<MpTcpRcvBufTestSocket> fixed = CreateReceiver ();
+  fixed->SetAttribute ("RcvBufAutoTuning", BooleanValue (false));
+  Advance (MilliSeconds (100));
+  fixed->Deliver (1000000);
+  Advance (MilliSeconds (100));
+  fixed->Deliver (0);
+  NS_TEST_EXPECT_MSG_EQ (fixed->GetRcvBuf (), m_initialRcvBuf, "buffer grown with auto-tuning disabled");
+
+  socket->Kill ();
+  NS_TEST_EXPECT_MSG_EQ (socket->GetRcvBuf (), m_initialRcvBuf, "growth kept after Destroy");
+  Simulator::Destroy ();
+}
+
+
+class MpTcpRcvBufLimitTest : public MpTcpRcvBufTest
+{
+public:
+  MpTcpRcvBufLimitTest ();
+  virtual void DoRun (void);
+};
+
+MpTcpRcvBufLimitTest::MpTcpRcvBufLimitTest ()
+  : MpTcpRcvBufTest ("Connections of a node share MpTcpRcvBufLimit")
+{
+}
+
+void
+MpTcpRcvBufLimitTest::DoRun (void)
+{
+  const uint32_t limit = 500000;
+  m_node = CreateObject<Node> ();
+  m_tcp = CreateObject<TcpL4Protocol> ();
+  m_tcp->SetAttribute ("MpTcpRcvBufLimit", UintegerValue (limit));
+
+  Ptr<MpTcpRcvBufTestSocket> first = CreateReceiver ();
+  Ptr<MpTcpRcvBufTestSocket> second = CreateReceiver ();
+
+  // The first connection takes the whole budget
+  Advance (MilliSeconds (100));
+  first->Deliver (1000000);
+  NS_TEST_EXPECT_MSG_EQ (first->GetRcvBuf (), m_initialRcvBuf + limit, "first buffer not capped by the node budget");
+
+  // Leaving nothing for the second one
+  second->Deliver (1000000);
+  NS_TEST_EXPECT_MSG_EQ (second->GetRcvBuf (), m_initialRcvBuf, "second buffer grown beyond the node budget");
+
+  // Closing the first returns its share
+  first->Kill ();
+  NS_TEST_EXPECT_MSG_EQ (first->GetRcvBuf (), m_initialRcvBuf, "first buffer kept its growth");
+  Advance (MilliSeconds (100));
+  second->Deliver (1000000);
+  NS_TEST_EXPECT_MSG_EQ (second->GetRcvBuf (), m_initialRcvBuf + limit, "budget not returned by Destroy");
+  first = 0;
+
+  // Releasing the last reference returns the share as well
+  Ptr<MpTcpRcvBufTestSocket> third = CreateReceiver ();
+  Advance (MilliSeconds (100));
+  third->Deliver (1000000);
+  NS_TEST_EXPECT_MSG_EQ (third->GetRcvBuf (), m_initialRcvBuf, "third buffer grown beyond the node budget");
+  second = 0;
+  Advance (MilliSeconds (100));
+  third->Deliver (1000000);
+  NS_TEST_EXPECT_MSG_EQ (third->GetRcvBuf (), m_initialRcvBuf + limit, "budget not returned by the destructor");
+
+  third = 0;
+  Simulator::Destroy ();
+}
+
+
+static class MpTcpRcvBufTestSuite : public TestSuite
+{
+public:
+  MpTcpRcvBufTestSuite ()
+    : TestSuite ("mp-tcp-rcvbuf", UNIT)
+  {
+    AddTestCase (new MpTcpRcvBufGrowthTest, TestCase::QUICK);
+    AddTestCase (new MpTcpRcvBufLimitTest, TestCase::QUICK);
+  }
+} g_mpTcpRcvBufTestSuite;
@@ -0,0 +1,456 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/boolean.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/mp-tcp-socket-base.h"
+#include "ns3/mp-tcp-subflow.h"
+#include "ns3/mp-tcp-pool.h"
+
+using namespace ns3;
+
+static const uint32_t g_segmentSize = 1000;
+static uint16_t g_nextPort = 5000;
+
+// Byte i of the data has a value that depends on its data sequence number
+static uint8_t
+DataByte (uint64_t dsn)
+{
+  return (uint8_t) (dsn % 251);
+}
+
+/**
+ * Connection with two established subflows, subflow 0 on 10.1.1.1 with a slow path
+ * and subflow 1 on 10.1.2.1 with a fast one. Nothing answers on either path, so what
+ * the peer sends is fed in by the test and the retransmission timers are kept beyond it.
+ */
+class MpTcpReinjectionTestSocket : public MpTcpSocketBase
+{
+public:
+  void Setup (Ptr<Node> node, bool sack)
+  {
+    SetNode (node);
+    SetTcp (node->GetObject<TcpL4Protocol> ());
+    segmentSize = g_segmentSize;
+    AddTestSubflow ("10.1.1.1", "10.1.1.2", MilliSeconds (200), 1001, sack);
+    AddTestSubflow ("10.1.2.1", "10.1.2.2", MilliSeconds (20), 5001, sack);
+  }
+
+  // Sender: a segment of new data on a subflow
+  void Send (uint8_t sFlowIdx)
+  {
+    SendDataPacket (sFlowIdx, g_segmentSize, false);
+  }
+
+  // Sender: the peer acked data up to dsn and has window bytes free after it
+  void DataAck (uint64_t dsn, uint32_t window)
+  {
+    highestDataAck = dsn;
+    remoteRecvWnd = window;
+  }
+
+  // Receiver: a segment of data dsn arrives on a subflow at subflowSeq
+  void Receive (uint8_t sFlowIdx, uint64_t dsn, uint32_t subflowSeq)
+  {
+    std::vector<uint8_t> data (g_segmentSize);
+    for (uint32_t i = 0; i < g_segmentSize; i++)
+      {
+        data[i] = DataByte (dsn + i);
+      }
+    TcpHeader header;
+    header.SetFlags (0);
+    header.SetSequenceNumber (SequenceNumber32 (subflowSeq));
+    header.SetAckNumber (SequenceNumber32 (1));
+    header.AddOptDSN (OPT_DSN, dsn, g_segmentSize, subflowSeq);
+    ReceivedData (sFlowIdx, Create<Packet> (&data[0], g_segmentSize), header);
+  }
+
+  // Receiver: everything the application can read
+  std::vector<uint8_t> ReadAll (void)
+  {
+    std::vector<uint8_t> read;
+    while (recvingBuffer.PendingData () > 0)
+      {
+        Ptr<Packet> p = Recv ();
+        uint32_t offset = read.size ();
+        read.resize (offset + p->GetSize ());
+        p->CopyData (&read[offset], p->GetSize ());
+      }
+    return read;
+  }
+
+  Ptr<MpTcpSubFlow> GetSubflow (uint8_t sFlowIdx)
+  {
+    return subflows[sFlowIdx];
+  }
+
+  uint64_t GetNextTxSequence (void) const
+  {
+    return nextTxSequence;
+  }
+
+  uint64_t GetNextRxSequence (void) const
+  {
+    return nextRxSequence;
+  }
+
+  uint32_t GetUnOrdered (void) const
+  {
+    return unOrdered.size ();
+  }
+
+  uint32_t GetUnOrderedBySubflow (void) const
+  {
+    return unOrderedBySubflow.size ();
+  }
+
+private:
+  void AddTestSubflow (const char* local, const char* remote, Time rtt, uint32_t rxSeq, bool sack)
+  {
+    Ptr<MpTcpSubFlow> sFlow = CreateObject<MpTcpSubFlow> ();
+    sFlow->routeId = subflows.size ();
+    sFlow->state = ESTABLISHED;
+    sFlow->sAddr = Ipv4Address (local);
+    sFlow->sPort = g_nextPort++; // Sockets of a test case live side by side, each needs its own 4-tuples
+    sFlow->dAddr = Ipv4Address (remote);
+    sFlow->dPort = 80;
+    sFlow->MSS = g_segmentSize;
+    sFlow->cwnd = 10 * g_segmentSize;
+    sFlow->ssthresh = 20 * g_segmentSize;
+    sFlow->TxSeqNumber = 1;
+    sFlow->maxSeqNb = 0;
+    sFlow->highestAck = 0;
+    sFlow->RxSeqNumber = rxSeq;
+    sFlow->sackPermitted = sack;
+    sFlow->rtt->SetCurrentEstimate (rtt);
+    sFlow->rtt->SetMinRto (Seconds (100));
+    sFlow->m_endPoint = m_tcp->Allocate (sFlow->sAddr, sFlow->sPort, sFlow->dAddr, sFlow->dPort);
+    AddSubflow (sFlow);
+    if (m_endPoint == 0)
+      { // The first subflow's endpoint is the connection's
+        m_endPoint = sFlow->m_endPoint;
+        SetupCallback ();
+      }
+  }
+};
+
+
+class MpTcpReinjectionTest : public TestCase
+{
+public:
+  MpTcpReinjectionTest (std::string name);
+
+protected:
+  Ptr<MpTcpReinjectionTestSocket> CreateSocket (bool sack);
+
+  Ptr<Node> m_node;
+};
+
+MpTcpReinjectionTest::MpTcpReinjectionTest (std::string name)
+  : TestCase (name)
+{
+}
+
+Ptr<MpTcpReinjectionTestSocket>
+MpTcpReinjectionTest::CreateSocket (bool sack)
+{
+  if (m_node == 0)
+    {
+      // One interface per path, each alone on its channel
+      m_node = CreateObject<Node> ();
+      NetDeviceContainer devices;
+      for (uint32_t i = 0; i < 2; i++)
+        {
+          Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetChannel (CreateObject<SimpleChannel> ());
+          m_node->AddDevice (device);
+          devices.Add (device);
+        }
+      InternetStackHelper internet;
+      internet.Install (m_node);
+      Ipv4AddressHelper ipv4;
+      ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+      ipv4.Assign (NetDeviceContainer (devices.Get (0)));
+      ipv4.SetBase ("10.1.2.0", "255.255.255.0");
+      ipv4.Assign (NetDeviceContainer (devices.Get (1)));
+    }
+  Ptr<MpTcpReinjectionTestSocket> socket = CreateObject<MpTcpReinjectionTestSocket> ();
+  socket->Setup (m_node, sack);
+  return socket;
+}
+
+
+/**
+ * The head of the connection-level window sits on the slow subflow: it is reinjected on
+ * the fast one once, however often the sender finds the window full, and the next head
+ * once it moved there.
+ */
+class MpTcpReinjectionOncePerHeadTest : public MpTcpReinjectionTest
+{
+public:
+  MpTcpReinjectionOncePerHeadTest ();
+
+private:
+  virtual void DoRun (void);
+  void Reinjected (uint64_t dsn, uint8_t from, uint8_t to);
+  // The n-th reinjection was of dsn, from subflow 0 to subflow 1
+  void CheckReinjection (uint32_t n, uint64_t dsn);
+
+  std::vector<uint64_t> m_dsns;
+  std::vector<uint8_t> m_from;
+  std::vector<uint8_t> m_to;
+};
+
+MpTcpReinjectionOncePerHeadTest::MpTcpReinjectionOncePerHeadTest ()
+  : MpTcpReinjectionTest ("Reinjection trace fires once per head segment")
+{
+}
+
+void
+MpTcpReinjectionOncePerHeadTest::Reinjected (uint64_t dsn, uint8_t from, uint8_t to)
+{
+  m_dsns.push_back (dsn);
+  m_from.push_back (from);
+  m_to.push_back (to);
+}
+
+void
+MpTcpReinjectionOncePerHeadTest::CheckReinjection (uint32_t n, uint64_t dsn)
+{
+  // Checks go on after a failure, a missing reinjection is reported by the caller
+  if (m_dsns.size () <= n)
+    {
+      return;
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_dsns[n], dsn, "wrong segment reinjected");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) m_from[n], 0, "reinjected from the wrong subflow");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) m_to[n], 1, "reinjected on the wrong subflow");
+}
+
+void
+MpTcpReinjectionOncePerHeadTest::DoRun (void)
+{
+  Ptr<MpTcpReinjectionTestSocket> socket = CreateSocket (true);
+  socket->SetAttribute ("OpportunisticRetransmission", BooleanValue (true));
+  socket->SetAttribute ("Penalization", BooleanValue (false));
+  socket->TraceConnectWithoutContext ("Reinjection", MakeCallback (&MpTcpReinjectionOncePerHeadTest::Reinjected, this));
+
+  // DSN 1 and 1001 on the slow subflow, 2001 on the fast one, which fills a window of three segments
+  socket->FillBuffer (10 * g_segmentSize);
+  socket->DataAck (1, 3 * g_segmentSize);
+  socket->Send (0);
+  socket->Send (0);
+  socket->Send (1);
+  NS_TEST_ASSERT_MSG_EQ (socket->GetNextTxSequence (), 1 + 3 * g_segmentSize, "segments not sent");
+
+  socket->SendBufferedData ();
+  socket->SendBufferedData ();
+  socket->SendBufferedData ();
+  NS_TEST_EXPECT_MSG_EQ (m_dsns.size (), 1, "head not reinjected exactly once");
+  CheckReinjection (0, 1);
+  NS_TEST_EXPECT_MSG_EQ (socket->Reinjections, 1, "Reinjections does not match the trace");
+  NS_TEST_EXPECT_MSG_EQ (socket->GetSubflow (1)->mapDSN.size (), 2, "copy not outstanding on the fast subflow");
+  NS_TEST_EXPECT_MSG_EQ (socket->GetNextTxSequence (), 1 + 3 * g_segmentSize, "new data sent into a full window");
+
+  // The copy got DSN 1 through, the window is full again with DSN 1001 at its head
+  socket->DataAck (1 + g_segmentSize, 2 * g_segmentSize);
+  socket->SendBufferedData ();
+  socket->SendBufferedData ();
+  NS_TEST_EXPECT_MSG_EQ (m_dsns.size (), 2, "next head not reinjected exactly once");
+  CheckReinjection (1, 1 + g_segmentSize);
+
+  // A head on the fastest subflow is not held back by a slower one
+  socket->DataAck (1 + 2 * g_segmentSize, g_segmentSize);
+  socket->SendBufferedData ();
+  NS_TEST_EXPECT_MSG_EQ (m_dsns.size (), 2, "head of the fast subflow reinjected");
+  NS_TEST_EXPECT_MSG_EQ (socket->Reinjections, 2, "Reinjections does not match the trace");
+  Simulator::Destroy ();
+}
+
+
+/**
+ * While the window stays full, the cwnd of the slow subflow holding back its head is
+ * halved at most once per RTT of that subflow (200 ms), down to one segment.
+ */
+class MpTcpReinjectionPenalizationTest : public MpTcpReinjectionTest
+{
+public:
+  MpTcpReinjectionPenalizationTest ();
+
+private:
+  virtual void DoRun (void);
+  void FullWindow (void);
+
+  Ptr<MpTcpReinjectionTestSocket> m_socket;
+  std::vector<uint32_t> m_slowCwnd;
+  std::vector<uint32_t> m_fastCwnd;
+};
+
+MpTcpReinjectionPenalizationTest::MpTcpReinjectionPenalizationTest ()
+  : MpTcpReinjectionTest ("Slow subflow's cwnd halves at most once per RTT")
+{
+}
+
+void
+MpTcpReinjectionPenalizationTest::FullWindow (void)
+{
+  m_socket->SendBufferedData ();
+  m_slowCwnd.push_back (m_socket->GetSubflow (0)->cwnd.Get ());
+  m_fastCwnd.push_back (m_socket->GetSubflow (1)->cwnd.Get ());
+}
+
+void
+MpTcpReinjectionPenalizationTest::DoRun (void)
+{
+  m_socket = CreateSocket (true);
+  m_socket->SetAttribute ("OpportunisticRetransmission", BooleanValue (false));
+  m_socket->SetAttribute ("Penalization", BooleanValue (true));
+  m_socket->FillBuffer (10 * g_segmentSize);
+  m_socket->DataAck (1, 2 * g_segmentSize);
+  m_socket->Send (0);
+  m_socket->Send (1);
+
+  uint32_t times[] = { 300, 300, 350, 499, 500, 550, 700, 900, 1100, 1300 }; // ms
+  uint32_t expected[] = { 5000, 5000, 5000, 5000, 2500, 2500, 1250, 1000, 1000, 1000 };
+  uint32_t n = sizeof (times) / sizeof (times[0]);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Simulator::Schedule (MilliSeconds (times[i]), &MpTcpReinjectionPenalizationTest::FullWindow, this);
+    }
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_slowCwnd.size (), n, "window not checked at every step");
+  for (uint32_t i = 0; i < m_slowCwnd.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_slowCwnd[i], expected[i], "slow cwnd at " << times[i] << " ms");
+      NS_TEST_EXPECT_MSG_EQ (m_fastCwnd[i], 10 * g_segmentSize, "fast subflow penalized at " << times[i] << " ms");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_socket->Reinjections, 0, "reinjected with OpportunisticRetransmission off");
+  m_socket = 0;
+  Simulator::Destroy ();
+}
+
+
+/**
+ * Receiver side: DSN 1 was sent on the slow subflow (at subflow sequence 1001) and DSN 1001
+ * after it, the copy of DSN 1 on the fast subflow (from 5001) arrives before the original.
+ * The application reads each byte exactly once and every segment kept for reordering is
+ * deleted exactly once, whether SACK is used or not.
+ */
+class MpTcpReinjectionDeliveryTest : public MpTcpReinjectionTest
+{
+public:
+  MpTcpReinjectionDeliveryTest (bool sack);
+
+private:
+  virtual void DoRun (void);
+  void Check (Ptr<MpTcpReinjectionTestSocket> socket, uint64_t inUse, std::string scenario);
+
+  bool m_sack;
+};
+
+MpTcpReinjectionDeliveryTest::MpTcpReinjectionDeliveryTest (bool sack)
+  : MpTcpReinjectionTest (sack ? "Reinjected copy and late original are delivered once, with SACK"
+                               : "Reinjected copy and late original are delivered once, without SACK"),
+    m_sack (sack)
+{
+}
+
+void
+MpTcpReinjectionDeliveryTest::Check (Ptr<MpTcpReinjectionTestSocket> socket, uint64_t inUse, std::string scenario)
+{
+  std::vector<uint8_t> read = socket->ReadAll ();
+  NS_TEST_EXPECT_MSG_EQ (read.size (), 2 * g_segmentSize, scenario << ": bytes read");
+  NS_TEST_EXPECT_MSG_EQ (socket->GetNextRxSequence (), 1 + 2 * g_segmentSize, scenario << ": next data sequence");
+  uint32_t wrong = 0;
+  for (uint32_t i = 0; i < read.size (); i++)
+    {
+      if (read[i] != DataByte (1 + i))
+        {
+          wrong++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (wrong, 0, scenario << ": bytes read out of order");
+  NS_TEST_EXPECT_MSG_EQ (socket->GetUnOrdered (), 0, scenario << ": segments left for reordering");
+  NS_TEST_EXPECT_MSG_EQ (socket->GetUnOrderedBySubflow (), 0, scenario << ": segments left behind a subflow hole");
+  NS_TEST_EXPECT_MSG_EQ (socket->GetSubflow (0)->RxSeqNumber, 1001 + 2 * g_segmentSize, scenario << ": slow subflow sequence");
+  // A leak leaves blocks in use, a double delete returns more than were taken
+  NS_TEST_EXPECT_MSG_EQ (MpTcpPool::GetInUse (), inUse, scenario << ": DSN mappings leaked or deleted twice");
+}
+
+void
+MpTcpReinjectionDeliveryTest::DoRun (void)
+{
+  // Both in order on their subflow: the late original is a duplicate at connection level
+  Ptr<MpTcpReinjectionTestSocket> socket = CreateSocket (m_sack);
+  uint64_t inUse = MpTcpPool::GetInUse ();
+  socket->Receive (1, 1001, 5001);
+  socket->Receive (1, 1, 6001);
+  NS_TEST_EXPECT_MSG_EQ (socket->GetNextRxSequence (), 2001, "copy not delivered with the segment after it");
+  socket->Receive (0, 1, 1001);
+  socket->Receive (0, 1001, 2001);
+  Check (socket, inUse, "in order on both subflows");
+
+  // DSN 1001 waits behind the slow subflow's hole, it is read once the copy arrived and
+  // kept without payload until the late original fills the hole
+  socket = CreateSocket (m_sack);
+  inUse = MpTcpPool::GetInUse ();
+  socket->Receive (0, 1001, 2001);
+  socket->Receive (1, 1, 5001);
+  NS_TEST_EXPECT_MSG_EQ (socket->GetNextRxSequence (), 2001, "held segment not read after the copy");
+  NS_TEST_EXPECT_MSG_EQ (socket->GetUnOrdered (), 0, "read segment still held for reordering");
+  NS_TEST_EXPECT_MSG_EQ (socket->GetUnOrderedBySubflow (), 1, "read segment not kept behind the subflow hole");
+  socket->Receive (0, 1, 1001);
+  Check (socket, inUse, "behind a hole of the slow subflow");
+
+  // The copy has a hole of its own in front of it on the fast subflow, DSN 1001 was lost there
+  socket = CreateSocket (m_sack);
+  inUse = MpTcpPool::GetInUse ();
+  socket->Receive (1, 1, 6001);
+  NS_TEST_EXPECT_MSG_EQ (socket->GetNextRxSequence (), 1001, "copy not read ahead of its subflow hole");
+  socket->Receive (0, 1, 1001);
+  socket->Receive (1, 1001, 5001);
+  NS_TEST_EXPECT_MSG_EQ (socket->GetSubflow (1)->RxSeqNumber, 7001, "fast subflow did not pass the copy");
+  socket->Receive (0, 1001, 2001);
+  Check (socket, inUse, "behind a hole of the fast subflow");
+
+  socket = 0;
+  Simulator::Destroy ();
+}
+
+
+static class MpTcpReinjectionTestSuite : public TestSuite
+{
+public:
+  MpTcpReinjectionTestSuite ()
+    : TestSuite ("mp-tcp-reinjection", UNIT)
+  {
+    AddTestCase (new MpTcpReinjectionOncePerHeadTest, TestCase::QUICK);
+    AddTestCase (new MpTcpReinjectionPenalizationTest, TestCase::QUICK);
+    AddTestCase (new MpTcpReinjectionDeliveryTest (false), TestCase::QUICK);
+    AddTestCase (new MpTcpReinjectionDeliveryTest (true), TestCase::QUICK);
+  }
+} g_mpTcpReinjectionTestSuite;
@@ -0,0 +1,305 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-header.h"
+#include "ns3/mp-tcp-socket-base.h"
+#include "ns3/mp-tcp-subflow.h"
+#include "ns3/mp-tcp-typedefs.h"
+
+using namespace ns3;
+
+/**
+ * Socket with a single subflow, exposing the receiver side SACK bookkeeping
+ */
+class MpTcpSackTestSocket : public MpTcpSocketBase
+{
+public:
+  MpTcpSackTestSocket ()
+  {
+    subflows.push_back (CreateObject<MpTcpSubFlow> ());
+  }
+
+  void Receive (uint32_t seq, uint32_t len)
+  {
+    RecordSackBlock (0, seq, len);
+  }
+
+  const map<uint32_t, uint32_t>& GetBlocks (void) const
+  {
+    return subflows[0]->rcvSackBlocks;
+  }
+
+  OptSack BuildSack (uint8_t maxBlocks)
+  {
+    TcpHeader header;
+    uint8_t length = AddOptSack (0, header, maxBlocks);
+    NS_ASSERT (header.GetOptions ().GetSize () == 1);
+    NS_ASSERT (length == header.GetOptionsLength ());
+    return header.GetOptions ()[0].sack;
+  }
+};
+
+
+class MpTcpSackBlockTest : public TestCase
+{
+public:
+  MpTcpSackBlockTest ();
+  virtual void DoRun (void);
+
+private:
+  void CheckBlocks (Ptr<MpTcpSackTestSocket> socket, uint32_t n, const uint32_t* edges, std::string msg);
+};
+
+MpTcpSackBlockTest::MpTcpSackBlockTest ()
+  : TestCase ("Receiver merges out-of-order segments into SACK blocks")
+{
+}
+
+// edges holds the [left, right) pairs expected, in ascending order
+void
+MpTcpSackBlockTest::CheckBlocks (Ptr<MpTcpSackTestSocket> socket, uint32_t n, const uint32_t* edges, std::string msg)
+{
+  const map<uint32_t, uint32_t>& blocks = socket->GetBlocks ();
+  NS_TEST_EXPECT_MSG_EQ (blocks.size (), n, msg << ": number of blocks");
+  uint32_t b = 0;
+  for (map<uint32_t, uint32_t>::const_iterator it = blocks.begin (); it != blocks.end () && b < n; ++it, ++b)
+    {
+      NS_TEST_EXPECT_MSG_EQ (it->first, edges[2 * b], msg << ": left edge of block " << b);
+      NS_TEST_EXPECT_MSG_EQ (it->second, edges[2 * b + 1], msg << ": right edge of block " << b);
+    }
+}
+
+void
+MpTcpSackBlockTest::DoRun (void)
+{
+  Ptr<MpTcpSackTestSocket> socket = CreateObject<MpTcpSackTestSocket> ();
+
+  socket->Receive (2000, 1000);
+  socket->Receive (5000, 1000);
+  const uint32_t disjoint[] = { 2000, 3000, 5000, 6000 };
+  CheckBlocks (socket, 2, disjoint, "disjoint segments");
+
+  // Adjacent on either side
+  socket->Receive (3000, 500);
+  socket->Receive (4500, 500);
+  const uint32_t adjacent[] = { 2000, 3500, 4500, 6000 };
+  CheckBlocks (socket, 2, adjacent, "adjacent segments");
+
+  // Overlapping a block, and a duplicate lying within one
+  socket->Receive (3200, 600);
+  socket->Receive (5200, 300);
+  const uint32_t overlapping[] = { 2000, 3800, 4500, 6000 };
+  CheckBlocks (socket, 2, overlapping, "overlapping segments");
+
+  // Filling the hole joins both blocks
+  socket->Receive (3800, 700);
+  const uint32_t filled[] = { 2000, 6000 };
+  CheckBlocks (socket, 1, filled, "filled hole");
+
+  // A segment spanning several blocks
+  socket->Receive (8000, 1000);
+  socket->Receive (10000, 1000);
+  socket->Receive (7000, 4500);
+  const uint32_t spanning[] = { 2000, 6000, 7000, 11500 };
+  CheckBlocks (socket, 2, spanning, "segment spanning blocks");
+}
+
+
+class MpTcpSackOptionTest : public TestCase
+{
+public:
+  MpTcpSackOptionTest ();
+  virtual void DoRun (void);
+};
+
+MpTcpSackOptionTest::MpTcpSackOptionTest ()
+  : TestCase ("SACK option reports the latest block first, then the lowest ones")
+{
+}
+
+void
+MpTcpSackOptionTest::DoRun (void)
+{
+  Ptr<MpTcpSackTestSocket> socket = CreateObject<MpTcpSackTestSocket> ();
+  socket->Receive (2000, 100);
+  socket->Receive (4000, 100);
+  socket->Receive (6000, 100);
+  socket->Receive (8000, 100);
+  socket->Receive (5000, 100);
+
+  OptSack sack = socket->BuildSack (OptSack::MAX_BLOCKS - 1);
+  NS_TEST_EXPECT_MSG_EQ ((int) sack.count, 3, "blocks beyond maxBlocks reported");
+  NS_TEST_EXPECT_MSG_EQ (sack.left[0], 5000, "latest block not first");
+  NS_TEST_EXPECT_MSG_EQ (sack.left[1], 2000, "lowest block not second");
+  NS_TEST_EXPECT_MSG_EQ (sack.right[1], 2100, "lowest block right edge");
+  NS_TEST_EXPECT_MSG_EQ (sack.left[2], 4000, "second lowest block not third");
+
+  // The latest segment extends a block, the merged block is reported first
+  socket->Receive (2100, 100);
+  sack = socket->BuildSack (OptSack::MAX_BLOCKS);
+  NS_TEST_EXPECT_MSG_EQ ((int) sack.count, 4, "block count");
+  NS_TEST_EXPECT_MSG_EQ (sack.left[0], 2000, "merged block not first");
+  NS_TEST_EXPECT_MSG_EQ (sack.right[0], 2200, "merged block right edge");
+  NS_TEST_EXPECT_MSG_EQ (sack.left[1], 4000, "lowest other block not second");
+  NS_TEST_EXPECT_MSG_EQ (sack.left[2], 5000, "block order");
+  NS_TEST_EXPECT_MSG_EQ (sack.left[3], 6000, "block order");
+
+  // Merging into the block before it keeps the merged block as the latest
+  socket->Receive (4100, 900);
+  sack = socket->BuildSack (OptSack::MAX_BLOCKS - 1);
+  NS_TEST_EXPECT_MSG_EQ (sack.left[0], 4000, "merged block not first");
+  NS_TEST_EXPECT_MSG_EQ (sack.right[0], 5100, "merged block right edge");
+  NS_TEST_EXPECT_MSG_EQ (sack.left[1], 2000, "lowest block not second");
+  NS_TEST_EXPECT_MSG_EQ (sack.left[2], 6000, "block order");
+}
+
+
+class MpTcpScoreboardTest : public TestCase
+{
+public:
+  MpTcpScoreboardTest ();
+  virtual void DoRun (void);
+};
+
+MpTcpScoreboardTest::MpTcpScoreboardTest ()
+  : TestCase ("Sender finds lost segments below the highest SACKed byte")
+{
+}
+
+void
+MpTcpScoreboardTest::DoRun (void)
+{
+  // Ten segments of 100 bytes starting at subflow sequence number 1000
+  DSNMappingTable table;
+  Ptr<Packet> payload = Create<Packet> (100);
+  for (uint32_t n = 0; n < 10; n++)
+    {
+      table.Insert (new DSNMapping (0, 1 + 100 * n, 100, 1000 + 100 * n, 1, payload));
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (table.NextLost (0), 0, "segment lost without SACK");
+
+  // 1200-1400 and 1500-1600 SACKed, 1000 and 1100 are taken as lost, as are 1400
+  table.MarkSacked (1200, 1400);
+  table.MarkSacked (1500, 1600);
+  uint32_t highSacked = 1600;
+  DSNMapping* lost = table.NextLost (highSacked);
+  NS_TEST_ASSERT_MSG_NE (lost, 0, "no lost segment");
+  NS_TEST_EXPECT_MSG_EQ (lost->subflowSeqNumber, 1000, "first lost segment");
+
+  lost->retransmitted = true;
+  lost = table.NextLost (highSacked);
+  NS_TEST_ASSERT_MSG_NE (lost, 0, "no lost segment");
+  NS_TEST_EXPECT_MSG_EQ (lost->subflowSeqNumber, 1100, "retransmitted segment not skipped");
+
+  lost->retransmitted = true;
+  lost = table.NextLost (highSacked);
+  NS_TEST_ASSERT_MSG_NE (lost, 0, "no lost segment");
+  NS_TEST_EXPECT_MSG_EQ (lost->subflowSeqNumber, 1400, "SACKed segments not skipped");
+
+  // Nothing at or above highSacked is lost
+  lost->retransmitted = true;
+  NS_TEST_EXPECT_MSG_EQ (table.NextLost (highSacked), 0, "segment above highSacked taken as lost");
+
+  // A SACK block only marks segments lying within it
+  table.MarkSacked (1650, 1800);
+  NS_TEST_EXPECT_MSG_EQ (table.FindBySeq (1600)->sacked, false, "partly SACKed segment marked");
+  NS_TEST_EXPECT_MSG_EQ (table.FindBySeq (1700)->sacked, true, "SACKed segment not marked");
+  highSacked = 1800;
+  lost = table.NextLost (highSacked);
+  NS_TEST_ASSERT_MSG_NE (lost, 0, "no lost segment");
+  NS_TEST_EXPECT_MSG_EQ (lost->subflowSeqNumber, 1600, "segment below the new highSacked");
+
+  // On RTO the marks are dropped and SACK information is no longer trusted
+  table.ClearSacked ();
+  for (DSNMappingTable::iterator it = table.begin (); it != table.end (); ++it)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((*it)->sacked, false, "SACK mark kept");
+      NS_TEST_EXPECT_MSG_EQ ((*it)->retransmitted, false, "retransmission mark kept");
+    }
+  NS_TEST_EXPECT_MSG_EQ (table.NextLost (0), 0, "segment lost after RTO reset highSacked");
+  lost = table.NextLost (highSacked);
+  NS_TEST_ASSERT_MSG_NE (lost, 0, "no lost segment");
+  NS_TEST_EXPECT_MSG_EQ (lost->subflowSeqNumber, 1000, "retransmission does not restart from the front");
+
+  // Acked segments leave the scoreboard
+  NS_TEST_EXPECT_MSG_EQ (table.DiscardUpTo (1350), 3, "segments discarded");
+  lost = table.NextLost (highSacked);
+  NS_TEST_ASSERT_MSG_NE (lost, 0, "no lost segment");
+  NS_TEST_EXPECT_MSG_EQ (lost->subflowSeqNumber, 1300, "first unacked segment");
+}
+
+
+class MpTcpDataSeqLookupTest : public TestCase
+{
+public:
+  MpTcpDataSeqLookupTest ();
+  virtual void DoRun (void);
+};
+
+MpTcpDataSeqLookupTest::MpTcpDataSeqLookupTest ()
+  : TestCase ("Lookup by data sequence number ignores reinjected copies")
+{
+}
+
+void
+MpTcpDataSeqLookupTest::DoRun (void)
+{
+  DSNMappingTable table;
+  Ptr<Packet> payload = Create<Packet> (100);
+  for (uint32_t n = 0; n < 5; n++)
+    {
+      table.Insert (new DSNMapping (1, 1001 + 100 * n, 100, 1000 + 100 * n, 1, payload));
+    }
+  // A copy of data sequence number 1 reinjected from another subflow
+  DSNMapping* copy = new DSNMapping (1, 1, 100, 1500, 1, payload);
+  copy->reinjection = true;
+  table.Insert (copy);
+  table.Insert (new DSNMapping (1, 1501, 100, 1600, 1, payload));
+
+  NS_TEST_EXPECT_MSG_EQ (table.FindByDataSeq (1), 0, "reinjected copy found");
+  for (uint32_t n = 0; n < 6; n++)
+    {
+      DSNMapping* ptrDSN = table.FindByDataSeq (1001 + 100 * n);
+      NS_TEST_ASSERT_MSG_NE (ptrDSN, 0, "segment not found");
+      NS_TEST_EXPECT_MSG_EQ (ptrDSN->subflowSeqNumber, (n < 5 ? 1000 + 100 * n : 1600), "wrong segment found");
+    }
+  NS_TEST_EXPECT_MSG_EQ (table.FindByDataSeq (1050), 0, "lookup within a segment");
+
+  // Acked segments, the copy among them, are no longer found
+  table.DiscardUpTo (1600);
+  NS_TEST_EXPECT_MSG_EQ (table.size (), 1, "segments discarded");
+  NS_TEST_EXPECT_MSG_EQ (table.FindByDataSeq (1101), 0, "acked segment found");
+  NS_TEST_ASSERT_MSG_NE (table.FindByDataSeq (1501), 0, "unacked segment not found");
+  table.Clear ();
+  NS_TEST_EXPECT_MSG_EQ (table.FindByDataSeq (1501), 0, "segment found after Clear");
+}
+
+
+static class MpTcpSackTestSuite : public TestSuite
+{
+public:
+  MpTcpSackTestSuite ()
+    : TestSuite ("mp-tcp-sack", UNIT)
+  {
+    AddTestCase (new MpTcpSackBlockTest, TestCase::QUICK);
+    AddTestCase (new MpTcpSackOptionTest, TestCase::QUICK);
+    AddTestCase (new MpTcpScoreboardTest, TestCase::QUICK);
+    AddTestCase (new MpTcpDataSeqLookupTest, TestCase::QUICK);
+  }
+} g_mpTcpSackTestSuite;
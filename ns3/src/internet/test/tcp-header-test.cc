@@ -0,0 +1,459 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/buffer.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-header.h"
+
+using namespace ns3;
+
+// Header length in 32-bit words holding the options of header
+static uint8_t
+MinLength (const TcpHeader& header)
+{
+  return 5 + (header.GetOptionsLength () + 3) / 4;
+}
+
+static Buffer
+SerializeHeader (const TcpHeader& header)
+{
+  Buffer buffer;
+  buffer.AddAtStart (header.GetSerializedSize ());
+  header.Serialize (buffer.Begin ());
+  return buffer;
+}
+
+// Fixed header of length words, its options are written by the caller
+static Buffer::Iterator
+WriteFixedHeader (Buffer& buffer, uint8_t length)
+{
+  buffer.AddAtStart (4 * length);
+  Buffer::Iterator i = buffer.Begin ();
+  i.WriteHtonU16 (80);
+  i.WriteHtonU16 (49153);
+  i.WriteHtonU32 (1);
+  i.WriteHtonU32 (2);
+  i.WriteHtonU16 (length << 12 | TcpHeader::ACK);
+  i.WriteHtonU16 (1000);
+  i.WriteHtonU16 (0);
+  i.WriteHtonU16 (0);
+  return i;
+}
+
+static TcpHeader
+MakeHeader (void)
+{
+  TcpHeader header;
+  header.SetSourcePort (49153);
+  header.SetDestinationPort (80);
+  header.SetSequenceNumber (SequenceNumber32 (1000));
+  header.SetAckNumber (SequenceNumber32 (2000));
+  header.SetFlags (TcpHeader::ACK);
+  header.SetWindowSize (4321);
+  return header;
+}
+
+
+class TcpHeaderOptionTest : public TestCase
+{
+public:
+  TcpHeaderOptionTest ();
+  virtual void DoRun (void);
+
+private:
+  // Serializes header with room for its options only, deserializes it and checks the
+  // fixed fields, the option count and the padding, the copy is returned for the option fields
+  TcpHeader RoundTrip (const TcpHeader& header, uint8_t nOptions);
+};
+
+TcpHeaderOptionTest::TcpHeaderOptionTest ()
+  : TestCase ("Serialize and deserialize each TCP option")
+{
+}
+
+TcpHeader
+TcpHeaderOptionTest::RoundTrip (const TcpHeader& header, uint8_t nOptions)
+{
+  Buffer buffer = SerializeHeader (header);
+  Buffer::Iterator i = buffer.Begin ();
+  i.Next (20 + header.GetOptionsLength ());
+  while (i.GetDistanceFrom (buffer.Begin ()) < header.GetSerializedSize ())
+    {
+      NS_TEST_EXPECT_MSG_EQ ((int) i.ReadU8 (), 255, "options not padded up to the header length");
+    }
+
+  TcpHeader copy;
+  uint32_t read = copy.Deserialize (buffer.Begin ());
+  NS_TEST_EXPECT_MSG_EQ (read, header.GetSerializedSize (), "wrong number of bytes deserialized");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSourcePort (), header.GetSourcePort (), "source port");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetDestinationPort (), header.GetDestinationPort (), "destination port");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSequenceNumber (), header.GetSequenceNumber (), "sequence number");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetAckNumber (), header.GetAckNumber (), "ack number");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetFlags (), (int) header.GetFlags (), "flags");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetWindowSize (), header.GetWindowSize (), "window");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ().GetSize (), (int) nOptions, "wrong number of options");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptionsLength (), (int) header.GetOptionsLength (), "options length");
+  return copy;
+}
+
+void
+TcpHeaderOptionTest::DoRun (void)
+{
+  TcpHeader header = MakeHeader ();
+  header.AddOptMPC (OPT_MPC, 0xdeadbeef);
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptionsLength (), 5, "MPC length");
+  header.SetLength (MinLength (header));
+  TcpHeader copy = RoundTrip (header, 1);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].optName, OPT_MPC, "MPC kind");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].mpc.senderToken, 0xdeadbeef, "MPC token");
+
+  header = MakeHeader ();
+  header.AddOptJOIN (OPT_JOIN, 0x01020304, 7);
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptionsLength (), 6, "JOIN length");
+  header.SetLength (MinLength (header));
+  copy = RoundTrip (header, 1);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].optName, OPT_JOIN, "JOIN kind");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].join.receiverToken, 0x01020304, "JOIN token");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ()[0].join.addrID, 7, "JOIN address id");
+
+  header = MakeHeader ();
+  header.AddOptADDR (OPT_ADDR, 3, Ipv4Address ("10.1.2.3"));
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptionsLength (), 6, "ADDR length");
+  header.SetLength (MinLength (header));
+  copy = RoundTrip (header, 1);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].optName, OPT_ADDR, "ADDR kind");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ()[0].addAddr.addrID, 3, "ADDR address id");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].addAddr.GetAddress (), Ipv4Address ("10.1.2.3"), "ADDR address");
+
+  header = MakeHeader ();
+  header.AddOptDSN (OPT_DSN, 0x0123456789abcdefULL, 1400, 0x0badcafe);
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptionsLength (), 15, "DSN length");
+  header.SetLength (MinLength (header));
+  copy = RoundTrip (header, 1);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].optName, OPT_DSN, "DSN kind");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].dsn.dataSeqNumber, 0x0123456789abcdefULL, "DSN data sequence number");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].dsn.dataLevelLength, 1400, "DSN data level length");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].dsn.subflowSeqNumber, 0x0badcafe, "DSN subflow sequence number");
+
+  header = MakeHeader ();
+  header.AddOptDataACK (OPT_DATA_ACK, 0xfedcba9876543210ULL);
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptionsLength (), 9, "DATA_ACK length");
+  header.SetLength (MinLength (header));
+  copy = RoundTrip (header, 1);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].optName, OPT_DATA_ACK, "DATA_ACK kind");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].dataAck.dataAck, 0xfedcba9876543210ULL, "DATA_ACK value");
+
+  header = MakeHeader ();
+  header.AddOptWScale (OPT_WSCALE, 9);
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptionsLength (), 3, "WSCALE length");
+  header.SetLength (MinLength (header));
+  copy = RoundTrip (header, 1);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].optName, OPT_WSCALE, "WSCALE kind");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ()[0].wscale.shift, 9, "WSCALE shift");
+
+  // RFC 7323 caps the shift at 14
+  header = MakeHeader ();
+  header.AddOptWScale (OPT_WSCALE, 20);
+  header.SetLength (MinLength (header));
+  copy = RoundTrip (header, 1);
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ()[0].wscale.shift, 14, "WSCALE shift not capped");
+
+  header = MakeHeader ();
+  header.AddOptSACKPermitted (OPT_SACK_PERMITTED);
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptionsLength (), 2, "SACK_PERMITTED length");
+  header.SetLength (MinLength (header));
+  copy = RoundTrip (header, 1);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].optName, OPT_SACK_PERMITTED, "SACK_PERMITTED kind");
+
+  for (uint8_t count = 1; count <= OptSack::MAX_BLOCKS; count++)
+    {
+      OptSack sack;
+      sack.count = count;
+      for (uint8_t b = 0; b < count; b++)
+        {
+          sack.left[b] = 10000 * (b + 1);
+          sack.right[b] = 10000 * (b + 1) + 1400;
+        }
+      header = MakeHeader ();
+      NS_TEST_EXPECT_MSG_EQ (header.AddOptSACK (OPT_SACK, sack), true, "SACK not added");
+      NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptionsLength (), 2 + 8 * count, "SACK length");
+      header.SetLength (MinLength (header));
+      copy = RoundTrip (header, 1);
+      NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].optName, OPT_SACK, "SACK kind");
+      NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ()[0].sack.count, (int) count, "SACK block count");
+      for (uint8_t b = 0; b < count; b++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].sack.left[b], sack.left[b], "SACK left edge");
+          NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].sack.right[b], sack.right[b], "SACK right edge");
+        }
+    }
+
+  OptSack sack;
+  sack.count = 0;
+  header = MakeHeader ();
+  NS_TEST_EXPECT_MSG_EQ (header.AddOptSACK (OPT_SACK, sack), false, "empty SACK added");
+  sack.count = OptSack::MAX_BLOCKS + 1;
+  NS_TEST_EXPECT_MSG_EQ (header.AddOptSACK (OPT_SACK, sack), false, "SACK beyond MAX_BLOCKS added");
+  NS_TEST_EXPECT_MSG_EQ (header.AddOptMPC (OPT_JOIN, 1), false, "option added under the wrong kind");
+  NS_TEST_EXPECT_MSG_EQ (header.GetOptions ().IsEmpty (), true, "rejected options kept");
+}
+
+
+class TcpHeaderCombinationTest : public TestCase
+{
+public:
+  TcpHeaderCombinationTest ();
+  virtual void DoRun (void);
+
+private:
+  // Sends header in front of a payload and checks what the receiver gets back
+  TcpHeader SendReceive (const TcpHeader& header);
+};
+
+TcpHeaderCombinationTest::TcpHeaderCombinationTest ()
+  : TestCase ("Serialize and deserialize the option combinations sent by MpTcpSocketBase")
+{
+}
+
+TcpHeader
+TcpHeaderCombinationTest::SendReceive (const TcpHeader& header)
+{
+  Ptr<Packet> p = Create<Packet> (536);
+  p->AddHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 536 + header.GetSerializedSize (), "header size");
+
+  TcpHeader copy;
+  uint32_t read = p->RemoveHeader (copy);
+  NS_TEST_EXPECT_MSG_EQ (read, header.GetSerializedSize (), "wrong number of bytes deserialized");
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 536, "payload not left intact");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ().GetSize (), (int) header.GetOptions ().GetSize (),
+                         "wrong number of options");
+  return copy;
+}
+
+void
+TcpHeaderCombinationTest::DoRun (void)
+{
+  // Data segments reserve 20 bytes for the 15 byte DSN option, the padding must not be
+  // parsed as options
+  TcpHeader header = MakeHeader ();
+  header.AddOptDSN (OPT_DSN, 123456789, 536, 1000);
+  header.SetLength (10);
+  TcpHeader copy = SendReceive (header);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSerializedSize (), 40, "DSN header size");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].dsn.dataSeqNumber, 123456789, "DSN data sequence number");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].dsn.subflowSeqNumber, 1000, "DSN subflow sequence number");
+
+  // Pure ACKs carry the DATA_ACK and up to 3 SACK blocks: 9 + 26 bytes
+  OptSack sack;
+  sack.count = 3;
+  sack.left[0] = 5000;
+  sack.right[0] = 6000;
+  sack.left[1] = 2000;
+  sack.right[1] = 3000;
+  sack.left[2] = 4000;
+  sack.right[2] = 4500;
+  header = MakeHeader ();
+  header.AddOptDataACK (OPT_DATA_ACK, 987654321);
+  header.AddOptSACK (OPT_SACK, sack);
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptionsLength (), 35, "DATA_ACK + SACK length");
+  header.SetLength (MinLength (header));
+  copy = SendReceive (header);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSerializedSize (), 56, "DATA_ACK + SACK header size");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].optName, OPT_DATA_ACK, "first option");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].dataAck.dataAck, 987654321, "DATA_ACK value");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[1].optName, OPT_SACK, "second option");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ()[1].sack.count, 3, "SACK block count");
+  for (uint8_t b = 0; b < 3; b++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[1].sack.left[b], sack.left[b], "SACK left edge");
+      NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[1].sack.right[b], sack.right[b], "SACK right edge");
+    }
+
+  // SYN of the first subflow
+  header = MakeHeader ();
+  header.SetFlags (TcpHeader::SYN);
+  header.AddOptMPC (OPT_MPC, 42);
+  header.AddOptSACKPermitted (OPT_SACK_PERMITTED);
+  header.AddOptWScale (OPT_WSCALE, 7);
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptionsLength (), 10, "MPC SYN length");
+  header.SetLength (MinLength (header));
+  copy = SendReceive (header);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].mpc.senderToken, 42, "MPC token");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[1].optName, OPT_SACK_PERMITTED, "second option");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[2].optName, OPT_WSCALE, "third option");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ()[2].wscale.shift, 7, "WSCALE shift");
+
+  // SYN of a joining subflow
+  header = MakeHeader ();
+  header.SetFlags (TcpHeader::SYN);
+  header.AddOptJOIN (OPT_JOIN, 42, 2);
+  header.AddOptSACKPermitted (OPT_SACK_PERMITTED);
+  header.AddOptWScale (OPT_WSCALE, 7);
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptionsLength (), 11, "JOIN SYN length");
+  header.SetLength (MinLength (header));
+  copy = SendReceive (header);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[0].join.receiverToken, 42, "JOIN token");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ()[0].join.addrID, 2, "JOIN address id");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ()[1].optName, OPT_SACK_PERMITTED, "second option");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ()[2].wscale.shift, 7, "WSCALE shift");
+}
+
+
+class TcpHeaderOptionLimitTest : public TestCase
+{
+public:
+  TcpHeaderOptionLimitTest ();
+  virtual void DoRun (void);
+};
+
+TcpHeaderOptionLimitTest::TcpHeaderOptionLimitTest ()
+  : TestCase ("TcpOptionList keeps at most MAX_OPTIONS options")
+{
+}
+
+void
+TcpHeaderOptionLimitTest::DoRun (void)
+{
+  TcpHeader header = MakeHeader ();
+  for (uint8_t n = 0; n < TcpOptionList::MAX_OPTIONS; n++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (header.AddOptSACKPermitted (OPT_SACK_PERMITTED), true, "option not added");
+    }
+  NS_TEST_EXPECT_MSG_EQ (header.AddOptSACKPermitted (OPT_SACK_PERMITTED), false, "option beyond the limit added");
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptions ().GetSize (), (int) TcpOptionList::MAX_OPTIONS, "list size");
+  header.SetLength (MinLength (header));
+
+  Buffer buffer = SerializeHeader (header);
+  TcpHeader copy;
+  NS_TEST_EXPECT_MSG_EQ (copy.Deserialize (buffer.Begin ()), header.GetSerializedSize (), "bytes deserialized");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ().GetSize (), (int) TcpOptionList::MAX_OPTIONS, "options lost");
+
+  // A peer may send more options than the list holds: the first ones are kept and the
+  // whole header is still consumed
+  buffer = Buffer ();
+  Buffer::Iterator i = WriteFixedHeader (buffer, 15);
+  for (uint8_t n = 0; n < 20; n++)
+    {
+      i.WriteU8 (OPT_SACK_PERMITTED);
+      i.WriteU8 (2);
+    }
+  copy = TcpHeader ();
+  NS_TEST_EXPECT_MSG_EQ (copy.Deserialize (buffer.Begin ()), 60, "bytes deserialized");
+  NS_TEST_EXPECT_MSG_EQ ((int) copy.GetOptions ().GetSize (), (int) TcpOptionList::MAX_OPTIONS, "list size");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetAckNumber (), SequenceNumber32 (2), "ack number");
+
+  // Copies hold their own options
+  TcpHeader other = copy;
+  other.AddOptDataACK (OPT_DATA_ACK, 1);
+  copy = MakeHeader ();
+  NS_TEST_EXPECT_MSG_EQ ((int) other.GetOptions ().GetSize (), (int) TcpOptionList::MAX_OPTIONS, "copy size");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetOptions ().IsEmpty (), true, "assigned header kept old options");
+}
+
+
+class TcpHeaderMalformedSackTest : public TestCase
+{
+public:
+  TcpHeaderMalformedSackTest ();
+  virtual void DoRun (void);
+};
+
+TcpHeaderMalformedSackTest::TcpHeaderMalformedSackTest ()
+  : TestCase ("SACK options whose length is not 2 + 8 * MAX_BLOCKS at most")
+{
+}
+
+void
+TcpHeaderMalformedSackTest::DoRun (void)
+{
+  // A trailing partial block is skipped, the option after it is still read
+  Buffer buffer;
+  Buffer::Iterator i = WriteFixedHeader (buffer, 11);
+  i.WriteU8 (OPT_SACK);
+  i.WriteU8 (13);
+  i.WriteHtonU32 (3000);
+  i.WriteHtonU32 (4000);
+  i.WriteU8 (0xaa);
+  i.WriteU8 (0xbb);
+  i.WriteU8 (0xcc);
+  i.WriteU8 (OPT_DATA_ACK);
+  i.WriteU64 (77);
+  i.WriteU8 (255);
+  i.WriteU8 (255);
+  TcpHeader header;
+  NS_TEST_EXPECT_MSG_EQ (header.Deserialize (buffer.Begin ()), 44, "bytes deserialized");
+  NS_TEST_ASSERT_MSG_EQ ((int) header.GetOptions ().GetSize (), 2, "wrong number of options");
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptions ()[0].sack.count, 1, "SACK block count");
+  NS_TEST_EXPECT_MSG_EQ (header.GetOptions ()[0].sack.right[0], 4000, "SACK right edge");
+  NS_TEST_EXPECT_MSG_EQ (header.GetOptions ()[1].optName, OPT_DATA_ACK, "option after the SACK");
+  NS_TEST_EXPECT_MSG_EQ (header.GetOptions ()[1].dataAck.dataAck, 77, "DATA_ACK value");
+
+  // Four blocks and a partial one fill the option space but for a SACK-Permitted
+  buffer = Buffer ();
+  i = WriteFixedHeader (buffer, 15);
+  i.WriteU8 (OPT_SACK);
+  i.WriteU8 (38);
+  for (uint32_t b = 0; b < OptSack::MAX_BLOCKS; b++)
+    {
+      i.WriteHtonU32 (1000 * (b + 1));
+      i.WriteHtonU32 (1000 * (b + 1) + 500);
+    }
+  i.WriteHtonU32 (0xdeadbeef);
+  i.WriteU8 (OPT_SACK_PERMITTED);
+  i.WriteU8 (2);
+  header = TcpHeader ();
+  NS_TEST_EXPECT_MSG_EQ (header.Deserialize (buffer.Begin ()), 60, "bytes deserialized");
+  NS_TEST_ASSERT_MSG_EQ ((int) header.GetOptions ().GetSize (), 2, "wrong number of options");
+  NS_TEST_EXPECT_MSG_EQ ((int) header.GetOptions ()[0].sack.count, 4, "SACK block count");
+  NS_TEST_EXPECT_MSG_EQ (header.GetOptions ()[0].sack.left[3], 4000, "SACK left edge");
+  NS_TEST_EXPECT_MSG_EQ (header.GetOptions ()[1].optName, OPT_SACK_PERMITTED, "option after the SACK");
+
+  // More blocks than the option space holds, or a length too short for the option itself
+  uint8_t lengths[] = { 42, 1, 0 };
+  for (uint8_t n = 0; n < sizeof (lengths); n++)
+    {
+      buffer = Buffer ();
+      i = WriteFixedHeader (buffer, 15);
+      i.WriteU8 (OPT_DATA_ACK);
+      i.WriteU64 (5);
+      i.WriteU8 (OPT_SACK);
+      i.WriteU8 (lengths[n]);
+      for (uint8_t b = 0; b < 29; b++)
+        {
+          i.WriteU8 (OPT_SACK_PERMITTED);
+        }
+      header = TcpHeader ();
+      NS_TEST_EXPECT_MSG_EQ (header.Deserialize (buffer.Begin ()), 60, "bytes deserialized");
+      NS_TEST_ASSERT_MSG_EQ ((int) header.GetOptions ().GetSize (), 1, "malformed SACK length " << (int) lengths[n]);
+      NS_TEST_EXPECT_MSG_EQ (header.GetOptions ()[0].dataAck.dataAck, 5, "DATA_ACK value");
+    }
+}
+
+
+static class TcpHeaderTestSuite : public TestSuite
+{
+public:
+  TcpHeaderTestSuite ()
+    : TestSuite ("tcp-header", UNIT)
+  {
+    AddTestCase (new TcpHeaderOptionTest, TestCase::QUICK);
+    AddTestCase (new TcpHeaderCombinationTest, TestCase::QUICK);
+    AddTestCase (new TcpHeaderOptionLimitTest, TestCase::QUICK);
+    AddTestCase (new TcpHeaderMalformedSackTest, TestCase::QUICK);
+  }
+} g_tcpHeaderTestSuite;
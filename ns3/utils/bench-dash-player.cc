@@ -0,0 +1,226 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// DASH players streaming from one fake DASH server, each over its own access link to
+// a router in front of the server, once with the legacy polling playback loop and once with event-driven playback.
+// Reports the simulator events of both runs and the events per simulated second saved.
+// With --segmentTemplate the server describes segments with a SegmentTemplate instead of a SegmentList.
+// --persistent=0 opens a connection per file, --pipelining requests the next --pipelineDepth segments while the current one arrives;
+// the mean download time of a segment is measured from its request, or from the end of the previous reply if pipelined.
+// --trace writes the DASHPlayerTracer trace of the players to a file, as binary records if its name ends with .bin.
+//
+// The server reads ../content/representations/*.csv, so run it from a directory whose
+// sibling "content" is the content directory of this repository.
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/system-wall-clock-ms.h"
+
+using namespace ns3;
+
+static uint32_t g_consumedSegments;
+static uint64_t g_stallingMs;
+static uint64_t g_downloadBitrate;
+static std::map<Ptr<Application>, Time> g_firstSegmentPlayed;
+static uint32_t g_downloadedSegments;
+static int64_t g_downloadMs;
+
+static void
+SegmentConsumed(Ptr<Application> app, unsigned int userId, unsigned int videoId, unsigned int segmentNr,
+                std::string repId, unsigned int bitrate, unsigned int stallingMs, unsigned int bufferLevel)
+{
+  g_consumedSegments++;
+  g_stallingMs += stallingMs;
+  g_downloadBitrate += bitrate;
+  if (g_firstSegmentPlayed.find(app) == g_firstSegmentPlayed.end())
+  {
+    TimeValue start;
+    app->GetAttribute("StartTime", start);
+    g_firstSegmentPlayed[app] = Simulator::Now() - start.Get();
+  }
+}
+
+static void
+DownloadFinished(Ptr<Application> app, std::string file, double bytesPerSecond, long milliSeconds)
+{
+  if (file.find(".mpd") != std::string::npos)
+    return;
+  g_downloadedSegments++;
+  g_downloadMs += milliSeconds;
+}
+
+static void
+Noop()
+{
+}
+
+static uint64_t
+RunScenario(bool eventDriven, uint32_t players, double duration, std::string rate, std::string delay,
+            double startUpDelay, bool segmentTemplate, bool persistent, bool pipelining, uint32_t pipelineDepth,
+            std::string trace)
+{
+  NodeContainer server;
+  server.Create(1);
+  NodeContainer router;
+  router.Create(1);
+  NodeContainer clients;
+  clients.Create(players);
+
+  PointToPointHelper backbone;
+  backbone.SetDeviceAttribute("DataRate", StringValue("1Gbps"));
+  backbone.SetChannelAttribute("Delay", StringValue("1ms"));
+  PointToPointHelper access;
+  access.SetDeviceAttribute("DataRate", StringValue(rate));
+  access.SetChannelAttribute("Delay", StringValue(delay));
+
+  InternetStackHelper internet;
+  internet.Install(server);
+  internet.Install(router);
+  internet.Install(clients);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.0.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer srvIfs = ipv4.Assign(backbone.Install(router.Get(0), server.Get(0)));
+  std::stringstream ip;
+  srvIfs.GetAddress(1).Print(ip);
+  std::string srvIp = ip.str();
+
+  for (uint32_t i = 0; i < players; i++)
+  {
+    std::stringstream base;
+    base << "10." << 1 + i / 250 << "." << i % 250 << ".0";
+    ipv4.SetBase(base.str().c_str(), "255.255.255.0");
+    ipv4.Assign(access.Install(clients.Get(i), router.Get(0)));
+  }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+  DASHServerHelper dashServer(Ipv4Address::GetAny(), 80, srvIp, "/content/mpds/",
+                              "/content/representations/netflix_vid1.csv", "/content/segments/");
+  dashServer.SetAttribute("SegmentTemplate", BooleanValue(segmentTemplate));
+  ApplicationContainer serverApps = dashServer.Install(server.Get(0));
+  serverApps.Start(Seconds(0.1));
+
+  DASHHttpClientHelper player("http://" + srvIp + "/content/mpds/vid1.mpd.gz");
+  player.SetAttribute("AdaptationLogic", StringValue("dash::player::BufferBasedAdaptationLogic"));
+  player.SetAttribute("StartUpDelay", DoubleValue(startUpDelay));
+  player.SetAttribute("AllowDownscale", BooleanValue(true));
+  player.SetAttribute("AllowUpscale", BooleanValue(true));
+  player.SetAttribute("MaxBufferedSeconds", UintegerValue(30));
+  player.SetAttribute("EventDrivenPlayback", BooleanValue(eventDriven));
+  player.SetAttribute("PersistentConnection", BooleanValue(persistent));
+  player.SetAttribute("PipelineRequests", BooleanValue(pipelining));
+  player.SetAttribute("PipelineDepth", UintegerValue(pipelineDepth));
+  ApplicationContainer clientApps = player.Install(clients);
+  for (uint32_t i = 0; i < clientApps.GetN(); i++)
+  {
+    clientApps.Get(i)->TraceConnectWithoutContext("PlayerTracer", MakeCallback(&SegmentConsumed));
+    clientApps.Get(i)->TraceConnectWithoutContext("FileDownloadFinished", MakeCallback(&DownloadFinished));
+    clientApps.Get(i)->SetStartTime(Seconds(1.0 + 0.01 * i));
+  }
+  clientApps.Stop(Seconds(duration));
+  if (!trace.empty())
+    DASHPlayerTracer::Install(clients, trace);
+
+  g_consumedSegments = 0;
+  g_stallingMs = 0;
+  g_downloadBitrate = 0;
+  g_firstSegmentPlayed.clear();
+  g_downloadedSegments = 0;
+  g_downloadMs = 0;
+  SystemWallClockMs clock;
+  clock.Start();
+  Simulator::Stop(Seconds(duration));
+  Simulator::Run();
+  DASHPlayerTracer::Destroy();
+  uint64_t elapsed = clock.End();
+
+  // Every scheduled event gets the next uid (the first four are reserved), so the uid
+  // of one more event tells how many events this run has scheduled
+  uint64_t events = Simulator::ScheduleNow(&Noop).GetUid() - 4;
+
+  int64_t startupMs = 0;
+  for (std::map<Ptr<Application>, Time>::iterator it = g_firstSegmentPlayed.begin(); it != g_firstSegmentPlayed.end(); ++it)
+    startupMs += it->second.GetMilliSeconds();
+  if (!g_firstSegmentPlayed.empty())
+    startupMs /= (int64_t) g_firstSegmentPlayed.size();
+
+  std::cout << (eventDriven ? "  event-driven: " : "  polling:      ") << events << " events, "
+            << events / duration << " events/s, " << elapsed << " ms, "
+            << g_consumedSegments << " segments played, downloaded at "
+            << (g_consumedSegments > 0 ? g_downloadBitrate / g_consumedSegments / 1000 : 0) << " kbit/s, " << g_stallingMs << " ms stalled, "
+            << startupMs << " ms to first segment, "
+            << (g_downloadedSegments > 0 ? g_downloadMs / g_downloadedSegments : 0) << " ms per segment download" << std::endl;
+  Simulator::Destroy();
+  return events;
+}
+
+int
+main(int argc, char *argv[])
+{
+  uint32_t players = 20;
+  double duration = 120.0;
+  std::string rate = "2Mbps";
+  std::string delay = "5ms";
+  double startUpDelay = 0.5;
+  bool segmentTemplate = false;
+  bool persistent = true;
+  bool pipelining = false;
+  uint32_t pipelineDepth = 1;
+  std::string trace;
+
+  CommandLine cmd;
+  cmd.AddValue("players", "Number of DASH players", players);
+  cmd.AddValue("duration", "Simulated seconds", duration);
+  cmd.AddValue("rate", "Data rate of the link of each player", rate);
+  cmd.AddValue("delay", "Delay of the link of each player", delay);
+  cmd.AddValue("startUpDelay", "Seconds the players buffer before they start playing", startUpDelay);
+  cmd.AddValue("segmentTemplate", "Serve MPDs with a SegmentTemplate instead of a SegmentList", segmentTemplate);
+  cmd.AddValue("persistent", "Download all files of a player over one keep-alive connection", persistent);
+  cmd.AddValue("pipelining", "Request the next segments while the current one is being received", pipelining);
+  cmd.AddValue("pipelineDepth", "Number of segments requested ahead with --pipelining", pipelineDepth);
+  cmd.AddValue("trace", "File of the player trace, binary if it ends with .bin", trace);
+  cmd.Parse(argc, argv);
+
+  Config::SetDefault("ns3::TcpSocket::SegmentSize", UintegerValue(1400));
+  Config::SetDefault("ns3::TcpSocket::DelAckCount", UintegerValue(0));
+  Config::SetDefault("ns3::DropTailQueue::Mode", StringValue("QUEUE_MODE_PACKETS"));
+  Config::SetDefault("ns3::DropTailQueue::MaxPackets", UintegerValue(100));
+  Config::SetDefault("ns3::TcpL4Protocol::SocketType", TypeIdValue(MpTcpSocketBase::GetTypeId()));
+  Config::SetDefault("ns3::MpTcpSocketBase::MaxSubflows", UintegerValue(8));
+
+  std::cout << "bench-dash-player players=" << players << " duration=" << duration << "s rate=" << rate
+            << " delay=" << delay << " startUpDelay=" << startUpDelay << "s"
+            << (segmentTemplate ? " segmentTemplate" : "") << (persistent ? " persistent" : "")
+            << (pipelining ? " pipelining" : "");
+  if (pipelining)
+    std::cout << " pipelineDepth=" << pipelineDepth;
+  std::cout << std::endl;
+
+  RngSeedManager::SetSeed(3);
+  uint64_t polling = RunScenario(false, players, duration, rate, delay, startUpDelay, segmentTemplate, persistent, pipelining, pipelineDepth, trace);
+  RngSeedManager::SetSeed(3);
+  uint64_t eventDriven = RunScenario(true, players, duration, rate, delay, startUpDelay, segmentTemplate, persistent, pipelining, pipelineDepth, trace);
+
+  std::cout << "  saved:        " << ((double) polling - eventDriven) / duration << " events/s ("
+            << 100.0 * ((double) polling - eventDriven) / polling << "%)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// MPTCP transfer over two point-to-point paths that drop data segments at random,
+// once with NewReno recovery only and once with SACK recovery on the subflows.
+// Reports the simulated time to deliver the transfer to the receiving application,
+// the goodput and the recovery counters of the sender, averaged over --runs runs.
+// Segments reinjected on the faster path are those that held back the receive window,
+// --reinject=0 turns opportunistic retransmission and penalization off as they are by default.
+// --rate1 and --delay1 set the second path, e.g. to a poor one the Adaptive path manager retires;
+// --pm selects the path manager, Adaptive by default once either of them is given, FullMesh otherwise.
+
+#include <iostream>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+
+using namespace ns3;
+
+static uint64_t g_received;
+static uint32_t g_retired;
+static uint64_t g_bytes;
+static Time g_completed;
+
+static void
+HandleRead(Ptr<Socket> socket)
+{
+  Ptr<MpTcpSocketBase> mpSocket = DynamicCast<MpTcpSocketBase>(socket);
+  g_received += mpSocket->Recv(0xffffffff);
+  if (g_received >= g_bytes && g_completed.IsZero())
+    {
+      g_completed = Simulator::Now();
+      Simulator::Stop();
+    }
+}
+
+static void
+HandleAccept(Ptr<Socket> socket, const Address& from)
+{
+  socket->SetRecvCallback(MakeCallback(&HandleRead));
+}
+
+static void
+PathManagerDecision(uint8_t sFlowIdx, bool retired)
+{
+  if (retired)
+    g_retired++;
+}
+
+static void
+TracePathManager(Ptr<Application> app)
+{
+  DynamicCast<MpTcpBulkSendApplication>(app)->m_socket->TraceConnectWithoutContext("PathManager",
+      MakeCallback(&PathManagerDecision));
+}
+
+static Ptr<RateErrorModel>
+InstallLoss(Ptr<NetDevice> device, double loss)
+{
+  Ptr<RateErrorModel> em = CreateObject<RateErrorModel>();
+  em->SetUnit(RateErrorModel::ERROR_UNIT_PACKET);
+  em->SetRate(loss);
+  em->Disable();
+  device->SetAttribute("ReceiveErrorModel", PointerValue(em));
+  // Only data segments of the established subflows are dropped, SYN losses are not recovered
+  Simulator::Schedule(Seconds(1.0), &ErrorModel::Enable, em);
+  return em;
+}
+
+static std::string g_rate1 = "5Mbps";
+static std::string g_delay1 = "40ms";
+
+static double
+RunTransfer(bool sack, uint32_t run, uint32_t megaBytes, double loss, double* fastRetx, double* timeouts, double* reinjections,
+    double* retired)
+{
+  Config::SetDefault("ns3::MpTcpSocketBase::Sack", BooleanValue(sack));
+  RngSeedManager::SetRun(run);
+
+  NodeContainer nodes;
+  nodes.Create(2);
+
+  PointToPointHelper p2p0;
+  p2p0.SetDeviceAttribute("DataRate", StringValue("10Mbps"));
+  p2p0.SetChannelAttribute("Delay", StringValue("20ms"));
+  PointToPointHelper p2p1;
+  p2p1.SetDeviceAttribute("DataRate", StringValue(g_rate1));
+  p2p1.SetChannelAttribute("Delay", StringValue(g_delay1));
+  NetDeviceContainer d0 = p2p0.Install(nodes);
+  NetDeviceContainer d1 = p2p1.Install(nodes);
+
+  InternetStackHelper internet;
+  internet.Install(nodes);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer i0 = ipv4.Assign(d0);
+  ipv4.SetBase("10.1.2.0", "255.255.255.0");
+  ipv4.Assign(d1);
+
+  InstallLoss(d0.Get(1), loss);
+  InstallLoss(d1.Get(1), loss);
+
+  uint16_t port = 9;
+  Ptr<Socket> listener = Socket::CreateSocket(nodes.Get(1), TcpSocketFactory::GetTypeId());
+  listener->Bind(InetSocketAddress(Ipv4Address::GetAny(), port));
+  listener->Listen();
+  listener->SetRecvCallback(MakeCallback(&HandleRead));
+  listener->SetAcceptCallback(MakeNullCallback<bool, Ptr<Socket>, const Address &>(), MakeCallback(&HandleAccept));
+
+  MpTcpBulkSendHelper source("ns3::TcpSocketFactory", InetSocketAddress(i0.GetAddress(1), port));
+  source.SetAttribute("MaxBytes", UintegerValue(megaBytes * 1000000));
+  ApplicationContainer sourceApps = source.Install(nodes.Get(0));
+  sourceApps.Start(Seconds(0.0));
+  Simulator::Schedule(Seconds(0.5), &TracePathManager, sourceApps.Get(0));
+
+  g_received = 0;
+  g_bytes = megaBytes * 1000000;
+  g_completed = Seconds(0);
+  g_retired = 0;
+  Simulator::Stop(Seconds(1000.0));
+  Simulator::Run();
+
+  Ptr<MpTcpSocketBase> sender = DynamicCast<MpTcpBulkSendApplication>(sourceApps.Get(0))->m_socket;
+  *fastRetx += sender->FastReTxs;
+  *timeouts += sender->TimeOuts;
+  *reinjections += sender->Reinjections;
+  *retired += g_retired;
+  double seconds = g_completed.IsZero() ? 0 : g_completed.GetSeconds();
+  Simulator::Destroy();
+  return seconds;
+}
+
+int
+main(int argc, char *argv[])
+{
+  uint32_t megaBytes = 5;
+  double loss = 0.01;
+  uint32_t runs = 5;
+  bool reinject = true;
+  std::string pm;
+  std::string rate1 = g_rate1;
+  std::string delay1 = g_delay1;
+
+  CommandLine cmd;
+  cmd.AddValue("mb", "Megabytes to transfer", megaBytes);
+  cmd.AddValue("loss", "Probability that a segment is dropped on either path", loss);
+  cmd.AddValue("runs", "Number of runs, each with its own random losses", runs);
+  cmd.AddValue("reinject", "Opportunistic retransmission and penalization of the subflow holding back the window", reinject);
+  cmd.AddValue("rate1", "Data rate of the second path", g_rate1);
+  cmd.AddValue("delay1", "One-way delay of the second path", g_delay1);
+  cmd.AddValue("pm", "Path manager: FullMesh, NdiffPorts or Adaptive", pm);
+  cmd.Parse(argc, argv);
+  if (pm.empty())
+    pm = (g_rate1 != rate1 || g_delay1 != delay1) ? "Adaptive" : "FullMesh";
+
+  Config::SetDefault("ns3::TcpSocket::SegmentSize", UintegerValue(1400));
+  Config::SetDefault("ns3::TcpSocket::DelAckCount", UintegerValue(0));
+  Config::SetDefault("ns3::DropTailQueue::Mode", StringValue("QUEUE_MODE_PACKETS"));
+  Config::SetDefault("ns3::DropTailQueue::MaxPackets", UintegerValue(100));
+  Config::SetDefault("ns3::TcpL4Protocol::SocketType", TypeIdValue(MpTcpSocketBase::GetTypeId()));
+  Config::SetDefault("ns3::MpTcpSocketBase::MaxSubflows", UintegerValue(8));
+  Config::SetDefault("ns3::MpTcpSocketBase::OpportunisticRetransmission", BooleanValue(reinject));
+  Config::SetDefault("ns3::MpTcpSocketBase::Penalization", BooleanValue(reinject));
+  Config::SetDefault("ns3::MpTcpSocketBase::PathManagement", StringValue(pm));
+
+  std::cout << "bench-mptcp-loss mb=" << megaBytes << " loss=" << loss << " runs=" << runs << " reinject=" << reinject
+            << " pm=" << pm << std::endl;
+  for (int sack = 0; sack <= 1; sack++)
+    {
+      double seconds = 0;
+      double fastRetx = 0;
+      double timeouts = 0;
+      double reinjections = 0;
+      double retired = 0;
+      uint32_t completed = 0;
+      for (uint32_t run = 1; run <= runs; run++)
+        {
+          double s = RunTransfer(sack, run, megaBytes, loss, &fastRetx, &timeouts, &reinjections, &retired);
+          if (s > 0)
+            {
+              seconds += s;
+              completed++;
+            }
+        }
+      std::cout << (sack ? "  sack:    " : "  newreno: ") << completed << "/" << runs << " completed, "
+                << (completed > 0 ? seconds / completed : 0) << " s, "
+                << (seconds > 0 ? 8.0 * megaBytes * completed / seconds : 0) << " Mbit/s goodput, "
+                << fastRetx / runs << " fast retransmits, " << timeouts / runs << " timeouts, "
+                << reinjections / runs << " reinjections, " << retired / runs << " subflows retired" << std::endl;
+    }
+  return 0;
+}
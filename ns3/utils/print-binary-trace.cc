@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Converts a binary trace of DASHPlayerTracer or NodeThroughputTracer (installed with a
+// file name ending in .bin) to the text columns those tracers write to other files.
+//
+//   print-binary-trace --input=dash-trace.bin [--output=dash-trace.txt]
+
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#include "ns3/core-module.h"
+#include "ns3/applications-module.h"
+
+using namespace ns3;
+
+int
+main(int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue("input", "Binary trace file", input);
+  cmd.AddValue("output", "Text trace file, standard output if empty", output);
+  cmd.Parse(argc, argv);
+
+  BinaryTraceReader reader(input);
+  if (!reader.IsOpen())
+  {
+    std::cerr << "Cannot read binary trace '" << input << "'" << std::endl;
+    return 1;
+  }
+
+  std::ofstream file;
+  if (!output.empty())
+  {
+    file.open(output.c_str(), std::ios_base::out | std::ios_base::trunc);
+    if (!file.is_open())
+    {
+      std::cerr << "Cannot write '" << output << "'" << std::endl;
+      return 1;
+    }
+  }
+  std::ostream& os = output.empty() ? std::cout : file;
+
+  uint8_t type;
+  uint8_t lastType = BinaryTraceFile::STRING_RECORD;
+  std::vector<uint8_t> payload;
+  uint64_t records = 0;
+  while (reader.Next(&type, &payload))
+  {
+    if (type == DASHPlayerTracer::RECORD_TYPE && payload.size() == sizeof(DASHPlayerTracer::Record))
+    {
+      if (type != lastType)
+      {
+        DASHPlayerTracer::PrintHeader(os);
+        os << "\n";
+      }
+      DASHPlayerTracer::Record record;
+      memcpy(&record, &payload[0], sizeof(record));
+      DASHPlayerTracer::PrintRecord(os, record, reader.GetString(record.node), reader.GetString(record.representationId));
+    }
+    else if (type == NodeThroughputTracer::RECORD_TYPE && payload.size() == sizeof(NodeThroughputTracer::Record))
+    {
+      if (type != lastType)
+      {
+        NodeThroughputTracer::PrintHeader(os);
+        os << "\n";
+      }
+      NodeThroughputTracer::Record record;
+      memcpy(&record, &payload[0], sizeof(record));
+      NodeThroughputTracer::PrintRecord(os, record, reader.GetString(record.node));
+    }
+    else
+    {
+      std::cerr << "Skipping record of unknown type " << (int) type << " and size " << payload.size() << std::endl;
+      continue;
+    }
+    lastType = type;
+    records++;
+  }
+
+  std::cerr << records << " records converted" << std::endl;
+  return 0;
+}